@@ -25,10 +25,14 @@
 #ifndef __csvdata_h
 #define __csvdata_h
 
+#include <wx/arrstr.h>
 #include <wx/string.h>
 #include <wx/stream.h>
 
+#include <string>
+#include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 using std::unordered_map;
 #pragma warning(disable: 4290)  // ignore warning: 'C++ exception specification ignored except to indicate a function is not __declspec(nothrow)'
@@ -38,8 +42,208 @@ using std::unordered_map;
 
 class wxGrid;
 
+/*
+ * One parsed row of a CSV file. Cell text is unescaped UTF-8 that is only
+ * valid during wxCSVRowHandler::OnRow.
+ */
+class wxCSVRow {
+public:
+    wxCSVRow(const char *text, const size_t *ends, size_t start, size_t count)
+            : m_text(text), m_ends(ends), m_start(start), m_count(count) {}
+
+    size_t Count() const { return m_count; }
+
+    const char *Text(size_t c, size_t *len) const;
+
+    wxString Get(size_t c) const;
+
+    // false for empty cells and cells that are not entirely a number
+    bool GetNumber(size_t c, double *value) const;
+
+private:
+    const char *m_text;
+    const size_t *m_ends;
+    size_t m_start, m_count;
+};
+
+class wxCSVRowHandler {
+public:
+    virtual ~wxCSVRowHandler() {}
+
+    // return false to stop reading
+    virtual bool OnRow(size_t row, const wxCSVRow &cells) = 0;
+};
+
+/*
+ * Streams rows of a CSV file to a handler without storing the table.
+ * Fields follow RFC 4180: quoted fields may contain separators, doubled
+ * quotes and line breaks, and records end with LF, CRLF or CR.  The
+ * separator must be an ASCII character.
+ */
+class wxCSVReader {
+public:
+    wxCSVReader(wxUniChar sep = ',');
+
+    void SetSeparator(wxUniChar sep) { m_sep = sep; }
+
+    bool Read(wxInputStream &in, wxCSVRowHandler &handler);
+
+    bool ReadFile(const wxString &file, wxCSVRowHandler &handler);
+
+    bool ReadString(const wxString &data, wxCSVRowHandler &handler);
+
+    // negative one based row of the first formatting error, 0 if none
+    int GetErrorLine() { return m_errorLine; }
+
+private:
+    wxUniChar m_sep;
+    int m_errorLine;
+};
+
+/*
+ * Reads numeric CSV data into a row-major matrix without keeping the text.
+ * Cells that do not start with a number read as 0, like wxAtof.  The input
+ * is scanned once for record boundaries, so large inputs can be split
+ * between threads.
+ */
+class wxCSVNumericReader {
+public:
+    wxCSVNumericReader(wxUniChar sep = ',');
+
+    void SetSeparator(wxUniChar sep) { m_sep = sep; }
+
+    // lines to skip, and whether the line after them names the columns.
+    // nothing is skipped if that would leave no data.
+    void SetSkip(size_t nskip, bool header = false);
+
+    // zero based data rows to read, inclusive
+    void SetRows(size_t first, size_t last = (size_t) -1);
+
+    // columns to read in this order, by index or by header name
+    void SetColumns(const std::vector<size_t> &cols);
+
+    void SetColumns(const wxArrayString &names);
+
+    // threads used for inputs larger than a few MB, 0 for one per core
+    void SetThreads(int n) { m_threads = n; }
+
+    bool Read(const char *data, size_t len);
+
+    bool ReadFile(const wxString &file);
+
+    bool ReadString(const wxString &data);
+
+    size_t NumRows() const { return m_nrows; }
+
+    size_t NumCols() const { return m_ncols; }
+
+    double At(size_t r, size_t c) const { return m_values[r * m_ncols + c]; }
+
+    // names of the columns read, if a header line was requested
+    const wxArrayString &GetColumnNames() const { return m_names; }
+
+    int GetErrorLine() { return m_errorLine; }
+
+private:
+    wxUniChar m_sep;
+    size_t m_nskip;
+    bool m_header;
+    size_t m_firstRow, m_lastRow;
+    std::vector<size_t> m_cols;
+    wxArrayString m_colNames;
+    int m_threads;
+
+    size_t m_nrows, m_ncols;
+    std::vector<double> m_values;
+    wxArrayString m_names;
+    int m_errorLine;
+
+    friend class wxCSVNumericWorker;
+
+    // record boundaries of the input and the number of cells in each record
+    const char *m_data;
+    size_t m_len;
+    std::vector<size_t> m_starts, m_counts;
+    std::vector<int> m_colMap; // output column of each input column, or -1
+    size_t m_firstRecord;
+
+    void ScanRecords();
+
+    int ParseRecords(size_t first, size_t last);
+};
+
+/*
+ * Buffers CSV output and writes it in large blocks, quoting text cells
+ * that contain the separator, quotes or line breaks.  Without an output
+ * stream the text is kept in the buffer.  With strict quoting off only
+ * cells that contain the separator are quoted, which is the format older
+ * versions of wxCSVData wrote.
+ */
+class wxCSVWriter {
+public:
+    wxCSVWriter(wxOutputStream *out, wxUniChar sep = ',');
+
+    ~wxCSVWriter();
+
+    void Text(const wxString &text);
+
+    // UTF-8 text
+    void Text(const char *text, size_t len);
+
+    void Number(double value, int precision = 15);
+
+    void EndRow();
+
+    void Flush();
+
+    void SetStrictQuoting(bool b) { m_strict = b; }
+
+    const std::string &GetBuffer() const { return m_buf; }
+
+private:
+    wxOutputStream *m_out;
+    char m_sep;
+    bool m_strict;
+    size_t m_cells;
+    std::string m_buf;
+
+    void NextCell();
+};
+
+/*
+ * A table of text cells.  Read() keeps the parsed text in a single buffer
+ * with the end offset of each cell, and cells changed afterwards through
+ * Set() or the non-const operator() are held separately and take
+ * precedence, so reading a large file does not allocate a string per cell.
+ *
+ * Write() quotes only the cells that contain the separator unless strict
+ * quoting is turned on, so cells with quotes or line breaks are written as
+ * they are and the output is the same as in earlier versions.
+ */
 class wxCSVData {
 public:
+    // cell of the non-const operator(): reads do not copy the parsed text,
+    // only an assignment stores the cell
+    class Cell {
+    public:
+        Cell(wxCSVData &data, size_t r, size_t c) : m_data(data), m_row(r), m_col(c) {}
+
+        operator wxString() const { return m_data.Get(m_row, m_col); }
+
+        Cell &operator=(const wxString &val) {
+            m_data.Set(m_row, m_col, val);
+            return *this;
+        }
+
+        Cell &operator=(const Cell &cell) { return operator=(wxString(cell)); }
+
+        Cell &operator+=(const wxString &val) { return operator=(wxString(*this) + val); }
+
+    private:
+        wxCSVData &m_data;
+        size_t m_row, m_col;
+    };
+
     wxCSVData();
 
     wxCSVData(const wxCSVData &copy);
@@ -52,11 +256,14 @@ public:
 
     void Set(size_t r, size_t c, const wxString &val);
 
-    wxString &operator()(size_t r, size_t c);
+    Cell operator()(size_t r, size_t c);
 
-    const wxString &Get(size_t r, size_t c) const;
+    wxString Get(size_t r, size_t c) const;
 
-    const wxString &operator()(size_t r, size_t c) const;
+    wxString operator()(size_t r, size_t c) const;
+
+    // false for empty cells and cells that are not entirely a number
+    bool GetNumber(size_t r, size_t c, double *value) const;
 
     size_t NumCells() const;
 
@@ -86,22 +293,40 @@ public:
 
     void SetSeparator(wxUniChar sep) { m_sep = sep; }
 
-    wxUniChar GetSeparator();
+    wxUniChar GetSeparator() { return m_sep; }
+
+    // also quote cells with quotes or line breaks, as RFC 4180 requires
+    void SetStrictQuoting(bool b) { m_strictQuoting = b; }
 
 protected:
     wxUniChar m_sep;
+    bool m_strictQuoting;
     bool m_invalidated;
     size_t m_nrows, m_ncols;
     typedef unordered_map<wxUint64, wxString> cell_hash;
-    cell_hash m_cells;
+    cell_hash m_cells; // cells set after reading
+    std::unordered_set<wxUint64> m_cleared; // parsed cells that were cleared
     int m_errorLine;
-    wxString m_emptyStr;
+
+    // parsed cells: text of all cells back to back, the end of each cell
+    // in m_text in row order, and the first cell of each row plus one past the last
+    std::string m_text;
+    std::vector<size_t> m_cellEnds;
+    std::vector<size_t> m_rowCells;
+
+    friend class wxCSVTableHandler;
 
     wxUint64 Encode(size_t r, size_t c) const;
 
     void Decode(wxUint64 idx, size_t *r, size_t *c) const;
 
     void RecalculateDimensions();
+
+    bool IsParsed(size_t r, size_t c) const;
+
+    const char *ParsedText(size_t r, size_t c, size_t *len) const;
+
+    void WriteTo(wxCSVWriter &writer);
 };
 
 #endif
@@ -0,0 +1,172 @@
+/***********************************************************************************************************************
+*  WEX, Copyright (c) 2008-2017, Alliance for Sustainable Energy, LLC. All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+*  following conditions are met:
+*
+*  (1) Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+*  disclaimer.
+*
+*  (2) Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+*  following disclaimer in the documentation and/or other materials provided with the distribution.
+*
+*  (3) Neither the name of the copyright holder nor the names of any contributors may be used to endorse or promote
+*  products derived from this software without specific prior written permission from the respective party.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+*  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER, THE UNITED STATES GOVERNMENT, OR ANY CONTRIBUTORS BE LIABLE FOR
+*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+*  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+*  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+*  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************************************************************/
+
+#ifndef __DVCompute_h
+#define __DVCompute_h
+
+/*
+ * wxDVComputePool
+ *
+ * Runs the derived data computations of the DView tabs (profiles, CDFs)
+ * on a small pool of worker threads, so that selecting a channel doesn't
+ * block the UI while a large data set is processed.
+ *
+ * Jobs are keyed by their data set, its revision and a parameter string,
+ * so a data set that changed in place misses the cache and the results
+ * computed from its old values are dropped when they arrive.  When a job is
+ * done, a wxEVT_DVCOMPUTE_DONE command event is queued to the owner, whose
+ * handler passes the event to Collect() to get the finished job.  Collected
+ * jobs are kept in a small most-recently-used cache, so going back to a
+ * channel doesn't compute it again.
+ *
+ * All the methods of the pool must be called from the UI thread.  A job
+ * copies its data set when it is made, and Compute() must only read that
+ * snapshot and write its own results; it should poll IsCancelled() in long
+ * loops.
+ */
+
+#include <atomic>
+#include <deque>
+#include <list>
+#include <vector>
+
+#include <wx/event.h>
+#include <wx/string.h>
+#include <wx/thread.h>
+
+class wxDVTimeSeriesDataSet;
+
+class wxDVArrayDataSet;
+
+BEGIN_DECLARE_EVENT_TYPES()
+DECLARE_EVENT_TYPE(wxEVT_DVCOMPUTE_DONE, 0)
+END_DECLARE_EVENT_TYPES()
+
+#define EVT_DVCOMPUTE_DONE(id, func) EVT_COMMAND(id, wxEVT_DVCOMPUTE_DONE, func)
+
+class wxDVComputeJob {
+public:
+    // takes the snapshot of ds, so it must be made on the UI thread
+    wxDVComputeJob(wxDVTimeSeriesDataSet *ds, const wxString &params);
+
+    virtual ~wxDVComputeJob();
+
+    // called on a worker thread
+    virtual void Compute() = 0;
+
+    // the live data set, only a key: workers read GetSnapshot() instead
+    wxDVTimeSeriesDataSet *GetDataSet() const { return m_dataSet; }
+
+    // copy of the data set values when the job was made, NULL once
+    // the job is collected
+    wxDVTimeSeriesDataSet *GetSnapshot() const;
+
+    const wxString &GetParams() const { return m_params; }
+
+    unsigned long GetRevision() const { return m_revision; }
+
+    // compares the revision with the current one of ds
+    bool Matches(wxDVTimeSeriesDataSet *ds, const wxString &params) const;
+
+    // the data set changed since the snapshot was taken
+    bool IsStale() const;
+
+    void Cancel() { m_cancelled = true; }
+
+    bool IsCancelled() const { return m_cancelled; }
+
+private:
+    friend class wxDVComputePool;
+
+    // the cached results don't need the copy any more
+    void FreeSnapshot();
+
+    wxDVTimeSeriesDataSet *m_dataSet;
+    wxDVArrayDataSet *m_snapshot;
+    wxString m_params;
+    unsigned long m_revision;
+    std::atomic<bool> m_cancelled;
+};
+
+class wxDVComputePool {
+public:
+    wxDVComputePool(wxEvtHandler *owner, int id = wxID_ANY, size_t maxCached = 32);
+
+    // cancels all jobs and waits for the workers to exit
+    ~wxDVComputePool();
+
+    // a finished job of the current revision of ds, or NULL if it isn't
+    // cached.  the job is owned by the pool and stays valid until the next
+    // Lookup, Collect, Invalidate or Clear
+    wxDVComputeJob *Lookup(wxDVTimeSeriesDataSet *ds, const wxString &params);
+
+    bool IsPending(wxDVTimeSeriesDataSet *ds, const wxString &params) const;
+
+    // takes ownership of the job and queues it, unless an equal job is
+    // already pending, in which case the job is deleted and false returned
+    bool Submit(wxDVComputeJob *job);
+
+    // cancels the pending jobs of a data set, or all pending jobs
+    void Cancel(wxDVTimeSeriesDataSet *ds);
+
+    void CancelAll();
+
+    // cancels the jobs of a data set, waits until no worker uses it any
+    // more and drops its cached results.  call before removing a data set
+    void Invalidate(wxDVTimeSeriesDataSet *ds);
+
+    void Clear();
+
+    // from the wxEVT_DVCOMPUTE_DONE handler: returns the finished job,
+    // or NULL if it was cancelled or its data set changed in the mean time
+    wxDVComputeJob *Collect(wxCommandEvent &evt);
+
+private:
+    class Worker;
+
+    friend class Worker;
+
+    void StartWorkers();
+
+    void CancelQueued(wxDVTimeSeriesDataSet *ds);
+
+    void WaitForRunning(wxDVTimeSeriesDataSet *ds);
+
+    wxEvtHandler *m_owner;
+    int m_id;
+    size_t m_maxCached;
+
+    // the queue and the running jobs are shared with the workers
+    wxMutex m_lock;
+    wxCondition m_queued, m_finished;
+    std::deque<wxDVComputeJob *> m_queue;
+    std::vector<wxDVComputeJob *> m_running;
+    bool m_quit;
+
+    std::vector<Worker *> m_workers;
+    std::vector<wxDVComputeJob *> m_pending; // submitted and not collected yet
+    std::list<wxDVComputeJob *> m_cache; // most recently used first
+};
+
+#endif
@@ -0,0 +1,125 @@
+/***********************************************************************************************************************
+*  WEX, Copyright (c) 2008-2017, Alliance for Sustainable Energy, LLC. All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+*  following conditions are met:
+*
+*  (1) Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+*  disclaimer.
+*
+*  (2) Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+*  following disclaimer in the documentation and/or other materials provided with the distribution.
+*
+*  (3) Neither the name of the copyright holder nor the names of any contributors may be used to endorse or promote
+*  products derived from this software without specific prior written permission from the respective party.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+*  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER, THE UNITED STATES GOVERNMENT, OR ANY CONTRIBUTORS BE LIABLE FOR
+*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+*  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+*  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+*  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************************************************************/
+
+#ifndef __DVFileCache_h
+#define __DVFileCache_h
+
+/*
+ * wxDVFileCache.h
+ *
+ * Binary columnar sidecar cache for data sets read by wxDVFileReader.
+ *
+ * The cache is off unless the application enables it.  Once enabled, the
+ * series of a parsed text file are written to a cache file in the cache
+ * directory, by default "dvcache" in the user data directory, named after
+ * the source file and a hash of its full path.  The cache records the size
+ * and modification time of the source file; on later opens a matching cache
+ * is memory-mapped and each column is exposed through wxDVMappedDataSet,
+ * which reads values straight out of the mapping instead of copying them
+ * into the heap.  The number of missing values found in each column when
+ * the source was parsed is kept, so they can be reported again on a hit.
+ *
+ * Layout (native byte order, all offsets in bytes from the start of the file):
+ *   header:  magic "wxDVCach", uint32 version, uint32 byte order mark,
+ *            uint64 source size, int64 source mtime, uint32 column count
+ *   columns: per column, three length-prefixed UTF-8 strings (title, units, group),
+ *            double offset, double start hour, double timestep,
+ *            uint64 value count, uint64 missing value count, uint64 data offset
+ *   data:    per column, 8-byte aligned contiguous doubles
+ */
+
+#include <vector>
+
+#include <wx/string.h>
+
+#include "wex/dview/dvtimeseriesdataset.h"
+
+class wxDVMappedFile;
+
+class wxDVMappedDataSet : public wxDVTimeSeriesDataSet {
+public:
+    // the data set holds a reference on the mapping, which is released
+    // once the last data set using it is deleted
+    wxDVMappedDataSet(wxDVMappedFile *map, const double *values, size_t len,
+                      const wxString &title, const wxString &units,
+                      double offset, double start, double timestep);
+
+    virtual ~wxDVMappedDataSet();
+
+    virtual wxRealPoint At(size_t i) const;
+
+    virtual size_t Length() const;
+
+    virtual double GetTimeStep() const;
+
+    virtual double GetOffset() const;
+
+    virtual wxString GetSeriesTitle() const;
+
+    virtual wxString GetUnits() const;
+
+protected:
+    // the mapping is copy-on-write, so modified pages are private to this
+    // process and the cache file on disk is never changed
+    virtual void DoSetY(size_t i, double y);
+
+private:
+    wxDVMappedFile *m_map;
+    double *m_values;
+    size_t m_len;
+    wxString m_varLabel;
+    wxString m_varUnits;
+    double m_offset;
+    double m_start;
+    double m_timestep;
+};
+
+class wxDVFileCache {
+public:
+    // the cache is disabled by default
+    static void Enable(bool b);
+
+    static bool IsEnabled();
+
+    // directory for the cache files, created on the first write
+    static void SetDirectory(const wxString &dir);
+
+    static wxString GetDirectory();
+
+    static wxString GetCacheFileName(const wxString &filename);
+
+    // Returns false if the cache is disabled, there is no cache for this file, or
+    // the source file has changed since the cache was written.  On success the
+    // caller owns the data sets, and missing receives the missing value count per data set.
+    static bool Read(const wxString &filename, std::vector<wxDVTimeSeriesDataSet *> &dataSets,
+                     std::vector<size_t> *missing = 0);
+
+    // Writes the cache for the source file, with the missing value count of each
+    // data set if given.  Failures (read only directories, cache file in use)
+    // are not errors, the cache is simply skipped.
+    static bool Write(const wxString &filename, const std::vector<wxDVTimeSeriesDataSet *> &dataSets,
+                      const std::vector<size_t> &missing = std::vector<size_t>());
+};
+
+#endif
@@ -38,6 +38,10 @@ class wxChoice;
 
 class wxComboBox;
 
+class wxDVComputeJob;
+
+class wxDVComputePool;
+
 class wxDVSelectionListCtrl;
 
 class wxPLLinePlot;
@@ -86,8 +90,11 @@ public:
 
     void SetYMax(double max);
 
-    void ReadCdfFrom(wxDVTimeSeriesDataSet &d, std::vector<wxRealPoint> *cdfArray);
+    // summary of the values of d for its CDF, stops early if job is cancelled
+    static void BuildDistribution(wxDVTimeSeriesDataSet &d, wxPLDistribution &dist, wxDVComputeJob *job = 0);
 
+    // the distributions are cached per data set revision, so a forced
+    // refresh only recomputes them when the values of d changed
     void ChangePlotDataTo(wxDVTimeSeriesDataSet *d, bool forceDataRefresh = false);
 
     void RebuildPlotSurface(double maxYPercent);
@@ -113,10 +120,12 @@ public:
 
     void OnPlotTypeSelection(wxCommandEvent &);
 
+    void OnComputeDone(wxCommandEvent &);
+
 private:
     std::vector<wxDVTimeSeriesDataSet *> m_dataSets;
     int m_selectedDataSetIndex;
-    std::vector<std::vector<wxRealPoint> *> m_cdfPlotData; //We track cdf plots since they take long to calculate.
+    wxDVComputePool *m_compute; //CDFs take long to calculate, so they are summarized in the background and cached.
 
     wxTextCtrl *m_maxTextBox;
 
@@ -133,6 +142,10 @@ private:
 
     void UpdateYAxisLabel();
 
+    void UpdateDistributionPlots(wxDVTimeSeriesDataSet *d);
+
+    void ShowDistribution(const wxPLDistribution &dist);
+
     void InvalidatePlot();
 
     void EnterYMax();
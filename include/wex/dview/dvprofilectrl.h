@@ -36,6 +36,10 @@ class wxPLLinePlot;
 
 class wxDVSelectionListCtrl;
 
+class wxDVComputeJob;
+
+class wxDVComputePool;
+
 class wxDVTimeSeriesDataSet;
 
 class wxGridSizer;
@@ -102,19 +106,46 @@ private:
 
     void OnSearch(wxCommandEvent &e);
 
+    void OnComputeDone(wxCommandEvent &e);
+
+    void OnShowBands(wxCommandEvent &e);
+
     struct PlotSet {
         PlotSet(wxDVTimeSeriesDataSet *ds);
 
         ~PlotSet();
 
-        void CalculateProfileData();
+        // the profiles (or bands) exist and match the current data set revision
+        bool IsCalculated() const;
+
+        bool HasBands() const;
+
+        // 12 monthly and the annual average day of ds, empty if the job was cancelled.
+        // lower and upper receive the p10 and p90 of each step of day when given.
+        static void ComputeProfileData(wxDVTimeSeriesDataSet *ds, std::vector<std::vector<wxRealPoint> > &plotData,
+                                       wxDVComputeJob *job = 0,
+                                       std::vector<std::vector<wxRealPoint> > *lower = 0,
+                                       std::vector<std::vector<wxRealPoint> > *upper = 0);
+
+        void SetProfileData(const std::vector<std::vector<wxRealPoint> > &plotData,
+                            const std::vector<std::vector<wxRealPoint> > &lower = std::vector<std::vector<wxRealPoint> >(),
+                            const std::vector<std::vector<wxRealPoint> > &upper = std::vector<std::vector<wxRealPoint> >());
+
+        // removes the average and band plots of a month from its surface
+        void RemoveFrom(wxPLPlotCtrl *surface, int month);
 
         wxDVTimeSeriesDataSet *dataset;
         wxPLLinePlot *plots[13];
+        wxPLLinePlot *bands[13][2]; // p10 and p90, null until calculated
+        unsigned long revision, bandsRevision; // of the data set the plots were computed from
         wxPLPlotCtrl::AxisPos axisPosition;
     };
 
+    friend class wxDVProfileJob;
+
     std::vector<PlotSet *> m_plots; //12 months of a day of data for each added data set.
+    wxDVComputePool *m_compute; //profiles of newly selected data sets are calculated in the background
+    bool m_showBands;
     wxDVSelectionListCtrl *m_dataSelector;
     wxSearchCtrl *m_srchCtrl;
     wxCheckBox *m_monthCheckBoxes[13];
@@ -129,6 +160,8 @@ private:
 
     void MonthSelection(unsigned index);
 
+    void ShowBands(int i, bool show);
+
     void OnTimer(wxTimerEvent &event);
 
     wxTimer *m_timer;
@@ -39,6 +39,8 @@ class wxSearchCtrl;
 
 class wxPLPlotCtrl;
 
+class wxPLColourMap;
+
 class wxDVScatterPlotCtrl : public wxPanel {
 public:
     wxDVScatterPlotCtrl(wxWindow *parent, wxWindowID id = wxID_ANY, const wxPoint &pos = wxDefaultPosition,
@@ -89,6 +91,7 @@ private:
     wxPLPlotCtrl *m_plotSurface;
     wxCheckBox *m_showPerfAgreeLine;
     bool m_showLine;
+    wxPLColourMap *m_densityColourMap;
 
     void SetXAxisChannel(int index);
 
@@ -98,6 +101,8 @@ private:
 
     void UpdatePlotWithChannelSelections();
 
+    void UpdateDensityLegend(size_t npoints);
+
     void RefreshDisabledCheckBoxes();
 
     void ShowLine();
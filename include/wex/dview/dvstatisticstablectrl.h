@@ -207,6 +207,9 @@ private:
 
     void ShowMonths();
 
+    // computes the statistics of the data sets added since the last rebuild
+    void ComputeStatistics();
+
     // event handlers
     void OnCollapse(wxCommandEvent &event);
 
@@ -188,6 +188,11 @@ public:
 
     void SetStyle(wxDVTimeSeriesStyle sty);
 
+    // draw only the first/min/max/last point per pixel column (default on)
+    void SetDecimation(bool b);
+
+    bool GetDecimation() const { return m_decimate; }
+
     void GetVisibleDataMinAndMax(double *min, double *max, const std::vector<int> &selectedChannelIndices);
 
     void GetAllDataMinAndMax(double *min, double *max, const std::vector<int> &selectedChannelIndices);
@@ -236,6 +241,8 @@ public:
 
     void Invalidate();
 
+    void InvalidateView();
+
     void ReadState(std::string filename);
 
     void WriteState(std::string filename);
@@ -303,6 +310,7 @@ private:
     bool m_topAutoScale, m_top2AutoScale, m_bottomAutoScale, m_bottom2AutoScale;
     wxDVTimeSeriesStyle m_style; // line, stepped
     bool m_stackingOnYLeft;
+    bool m_decimate;
     wxDVTimeSeriesType m_seriesType;
     wxDVStatType m_statType;
 
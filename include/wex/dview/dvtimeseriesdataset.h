@@ -45,14 +45,109 @@
 
 #include <wx/gdicmn.h>
 #include <wx/string.h>
+#include <wx/thread.h>
 #include <math.h>
 
+class wxDVTimeSeriesDataSet;
+
+/*
+ * Calendar position of the samples of a series, by day: the first sample,
+ * year, month and day of year of every day from the first to the last
+ * sample.  Years have 8760 hours unless a calendar year is given for the
+ * first year of data, in which case leap years have 8784.  The profile,
+ * heat map and statistics tabs use it instead of converting each x value.
+ */
+class wxDVCalendarIndex {
+public:
+    struct Day {
+        size_t first; // first sample at or after 00:00
+        int year; // zero based year of the data
+        int month; // 0-11
+        int dayOfYear;
+        double start; // x of 00:00
+    };
+
+    wxDVCalendarIndex();
+
+    void Build(const wxDVTimeSeriesDataSet &d, int firstCalendarYear = 0);
+
+    void Clear();
+
+    int GetFirstCalendarYear() const { return m_firstCalendarYear; }
+
+    size_t Days() const { return m_days.size(); }
+
+    const Day &At(size_t i) const { return m_days[i]; }
+
+    // one past the last sample of day i
+    size_t End(size_t i) const { return i + 1 < m_days.size() ? m_days[i + 1].first : m_length; }
+
+    // index of the day that contains x, which may be outside of [0, Days())
+    long DayOf(double x) const { return (long) floor(x / 24.0) - m_firstDay; }
+
+    // x of Jan 1 00:00 of a zero based year, and its length in hours
+    double YearStart(int year) const;
+
+    double YearHours(int year) const;
+
+    static bool IsLeapYear(int calendarYear);
+
+    // cumulative days before each month, 13 entries
+    static const int *MonthStarts(bool leap);
+
+    // a calendar year for series that span a leap year of 8784 hours, 0 otherwise
+    static int CalendarYearFor(const wxDVTimeSeriesDataSet &d);
+
+private:
+    int m_firstCalendarYear;
+    long m_firstDay;
+    size_t m_length;
+    std::vector<Day> m_days;
+};
+
 class wxDVTimeSeriesDataSet {
     wxString m_metaData, m_groupName;
+
+    // Min/max/sum pyramid over blocks of samples, built on the first range query.
+    // Level 0 summarizes RANGE_INDEX_BLOCK samples per entry, each level above pairs
+    // up the entries below it, so range queries touch O(log n) entries.
+    struct RangeIndexLevel {
+        std::vector<double> min, max, sum;
+    };
+    std::vector<RangeIndexLevel> m_rangeIndex;
+    bool m_rangeIndexValid;
+    size_t m_rangeIndexLength; // Length() when the index was built
+
+    void BuildRangeIndex();
+
+    void ScanRange(size_t startIndex, size_t endIndex, double *min, double *max, double *sum);
+
+    void QueryRange(size_t startIndex, size_t endIndex, double *min, double *max, double *sum);
+
+    wxDVCalendarIndex m_calendarIndex;
+    bool m_calendarIndexValid;
+    size_t m_calendarIndexLength;
+
+    unsigned long m_revision;
+
+    // guards both indexes, their valid flags and the revision, which views
+    // on worker threads read while the UI thread changes the data
+    mutable wxCriticalSection m_indexLock;
+
 protected:
     /*Constructors and Destructors*/
     wxDVTimeSeriesDataSet();
 
+    // SetY() calls this, and both indexes are rebuilt when Length() changes.
+    // Subclasses that change their y values in any other way must call it.
+    void InvalidateRangeIndex();
+
+    // Subclasses must call this whenever their x values change in place.
+    void InvalidateCalendarIndex();
+
+    // stores a y value for SetY(), the default ignores it
+    virtual void DoSetY(size_t i, double y);
+
 public:
     virtual ~wxDVTimeSeriesDataSet();
 
@@ -88,8 +183,20 @@ public:
 
     void GetDataMinAndMax(double *min, double *max);
 
+    double GetSumInRange(size_t startIndex, size_t endIndex);
+
     std::vector<wxRealPoint> GetDataVector();
 
+    // changes y value i, for the subclasses that support it
+    void SetY(size_t i, double y);
+
+    // calendar of the samples, built on first use and returned as a copy.
+    // safe to call from worker threads
+    wxDVCalendarIndex GetCalendarIndex();
+
+    // changes whenever the data changes, for views that cache values derived from it
+    unsigned long GetRevision() const;
+
     virtual void SetMetaData(const wxString &meta) { m_metaData = meta; }
 
     virtual wxString GetMetaData() { return m_metaData; }
@@ -101,6 +208,17 @@ public:
 
 class wxDVArrayDataSet : public wxDVTimeSeriesDataSet {
 public:
+    /*
+     * STORE_POINTS keeps an (x,y) pair per sample and allows irregular x values.
+     * The compact modes keep only y values and compute x as offset + i*timestep,
+     * which halves (STORE_Y_DOUBLE) or quarters (STORE_Y_FLOAT) the memory used.
+     * In compact mode Append() and Set() switch the data set to STORE_POINTS
+     * when given an x value that is not on that grid.
+     */
+    enum Storage {
+        STORE_POINTS = 0, STORE_Y_DOUBLE, STORE_Y_FLOAT
+    };
+
     wxDVArrayDataSet();
 
     wxDVArrayDataSet(const wxString &var, const std::vector<double> &data);
@@ -135,9 +253,19 @@ public:
 
     void Append(const wxRealPoint &p);
 
-    void Set(size_t i, double x, double y);
+    void AppendY(double y);
 
-    void SetY(size_t i, double y);
+    // resizes STORE_Y_DOUBLE storage to n samples and returns the y values
+    // for filling in place, or 0 for the other storage modes
+    double *ResizeY(size_t n);
+
+    void SetStorage(Storage st);
+
+    Storage GetStorage() const { return m_storage; }
+
+    size_t GetMemoryUsage() const;
+
+    void Set(size_t i, double x, double y);
 
     void SetSeriesTitle(const wxString &title);
 
@@ -149,12 +277,18 @@ public:
 
     void RecomputeXData();
 
+protected:
+    virtual void DoSetY(size_t i, double y);
+
 private:
     wxString m_varLabel;
     wxString m_varUnits;
     double m_timestep; // timestep in hours - fractional hours okay
     double m_offset; // offset in hours from Jan1 00:00 - fractional hours okay
+    Storage m_storage;
     std::vector<wxRealPoint> m_pData;
+    std::vector<double> m_yData;
+    std::vector<float> m_yFloat;
 };
 
 enum StatisticsType {
@@ -173,9 +307,100 @@ struct StatisticsPoint {
     double StDev;
 };
 
+/*
+ * Single pass statistics of a time series over calendar buckets.
+ *
+ * Samples must be added in time order, x in hours from Jan 1 00:00 of the
+ * first year.  When a calendar year is given for the first year of data,
+ * leap years have 8784 hours, otherwise every year has 8760 hours as
+ * elsewhere in DView.  Standard deviations use Welford's update, and the
+ * daily min/max averages are over the days that have samples in a bucket.
+ */
+class wxDVStatisticsAggregator {
+public:
+    enum Bucket {
+        MONTH = 0, WEEK, DAY, HOUR_OF_DAY
+    };
+
+    struct Stats {
+        int year; // zero based year of the data, -1 for HOUR_OF_DAY buckets and the total
+        int index; // month 0-11, week 0-52, day of year, or hour of day 0-23
+        double start, end; // hours covered by the bucket
+        size_t count;
+        double sum, min, max, mean, m2;
+        size_t days;
+        double dailyMinSum, dailyMaxSum;
+
+        // the day being accumulated
+        long curDay;
+        double dayMin, dayMax;
+
+        double StDev() const;
+
+        double AvgDailyMin() const;
+
+        double AvgDailyMax() const;
+    };
+
+    wxDVStatisticsAggregator(Bucket bucket = MONTH, int firstCalendarYear = 0);
+
+    void Reset();
+
+    void Add(double x, double y);
+
+    void Add(wxDVTimeSeriesDataSet *d);
+
+    // completes the daily statistics, call once after the last Add
+    void Finish();
+
+    size_t Count() const { return m_buckets.size(); }
+
+    const Stats &At(size_t i) const { return m_buckets[i]; }
+
+    const Stats &Total() const { return m_total; }
+
+private:
+    void Locate(double x);
+
+    void SetYear(int year, double yearStart, long yearFirstDay);
+
+    void AddLocated(double y, long day);
+
+    Stats *GetBucket(int year, int index, double start, double end);
+
+    static void InitStats(Stats &s, int year, int index, double start, double end);
+
+    static void Accumulate(Stats &s, double y, long day);
+
+    static void FoldDay(Stats &s);
+
+    Bucket m_bucket;
+    int m_firstCalendarYear;
+    std::vector<Stats> m_buckets;
+    Stats m_total;
+    bool m_finished;
+
+    // calendar position of the last sample
+    int m_year;
+    double m_yearStart, m_yearHours;
+    long m_yearFirstDay;
+    const int *m_monthStarts;
+    int m_dayOfYear;
+    double m_hourOfYear;
+};
+
 class wxDVStatisticsDataSet {
 public:
-    wxDVStatisticsDataSet(wxDVTimeSeriesDataSet *d);
+    // monthly and total statistics of d.  if compute is false, they are
+    // computed on the first call to Compute(), or by ComputeAll()
+    wxDVStatisticsDataSet(wxDVTimeSeriesDataSet *d, bool compute = true);
+
+    void Compute();
+
+    bool IsComputed() const { return m_computed; }
+
+    // computes the data sets that are not computed yet, in parallel
+    static void ComputeAll(const std::vector<wxDVStatisticsDataSet *> &list);
 
     double RoundSignificant(double ValueToRound, size_t NumSignifDigits = 4);
 
@@ -211,6 +436,7 @@ public:
 private:
     std::vector<StatisticsPoint> m_sData;
     wxDVTimeSeriesDataSet *baseDataset;
+    bool m_computed;
 };
 
 #endif
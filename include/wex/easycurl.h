@@ -38,7 +38,7 @@ END_DECLARE_EVENT_TYPES()
 class wxEasyCurlEvent : public wxEvent {
 public:
     enum {
-        STARTED, PROGRESS, FINISHED
+        STARTED, PROGRESS, FINISHED, BATCH_FINISHED
     };
 
     wxEasyCurlEvent(int id, wxEventType type, int code, const wxString &msg = wxEmptyString,
@@ -51,6 +51,7 @@ public:
         m_url = url;
         m_bytes = bytes;
         m_total = total;
+        m_index = -1;
     }
 
     wxEasyCurlEvent(const wxEasyCurlEvent &evt)
@@ -60,7 +61,8 @@ public:
               m_dt(evt.m_dt),
               m_url(evt.m_url),
               m_bytes(evt.m_bytes),
-              m_total(evt.m_total) {}
+              m_total(evt.m_total),
+              m_index(evt.m_index) {}
 
     int GetStatusCode() const { return m_code; }
 
@@ -74,12 +76,18 @@ public:
 
     double GetBytesTotal() const { return m_total; }
 
+    // index of the transfer for events sent by wxEasyCurlBatch, -1 otherwise
+    int GetIndex() const { return m_index; }
+
+    void SetIndex(int i) { m_index = i; }
+
 protected:
     int m_code;
     wxString m_msg;
     wxDateTime m_dt;
     wxString m_url;
     double m_bytes, m_total;
+    int m_index;
 };
 
 typedef void (wxEvtHandler::*wxEasyCurlEventFunction)(wxEasyCurlEvent &);
@@ -174,6 +182,72 @@ protected:
     wxArrayString m_httpHeaders;
 };
 
+// downloads many urls concurrently on one background thread using
+// a libcurl multi handle, so that connections and TLS sessions to the
+// same hosts are reused.  per-transfer STARTED, PROGRESS and FINISHED
+// events carry the transfer index (wxEasyCurlEvent::GetIndex), and a
+// BATCH_FINISHED event is sent when all transfers are done.
+class wxEasyCurlBatch : public wxObject {
+public:
+    wxEasyCurlBatch(wxEvtHandler *handler = 0, int id = wxID_ANY);
+
+    virtual ~wxEasyCurlBatch();
+
+    void SetEventHandler(wxEvtHandler *hh, int id);
+
+    // maximum number of simultaneous transfers, default 8
+    void SetMaxConnections(int n) { m_maxConnections = n > 0 ? n : 1; }
+
+    void AddHttpHeader(const wxString &s) { m_httpHeaders.Add(s); }
+
+    // queue a download and return its index.  if a file is given,
+    // the data is written to it as it arrives instead of kept in memory.
+    // downloads cannot be added while the batch is running: (size_t)-1 is returned
+    size_t Add(const wxString &url, const wxString &file = wxEmptyString);
+
+    size_t Count() const { return m_transfers.size(); }
+
+    // asynchronous operation: downloads everything queued so far
+    void Start();
+
+    bool Wait(bool yield = false); // returns true if all transfers succeeded
+    bool IsFinished();
+
+    void Cancel(); // returns immediately
+
+    // results of a single transfer, available once it is finished
+    bool IsFinished(size_t i);
+
+    bool Ok(size_t i);
+
+    wxString GetLastError(size_t i);
+
+    wxString GetDataAsString(size_t i);
+
+    wxImage GetDataAsImage(size_t i, wxBitmapType bittype = wxBITMAP_TYPE_JPEG);
+
+    bool WriteDataToFile(size_t i, const wxString &file);
+
+    struct Transfer;
+
+    class MultiThread;
+
+protected:
+    friend class MultiThread;
+
+    Transfer *GetFinished(size_t i);
+
+    void Clear();
+
+    std::vector<Transfer *> m_transfers;
+    wxMutex m_transfersLock;
+    MultiThread *m_thread;
+    wxEvtHandler *m_handler;
+    int m_id;
+    int m_maxConnections;
+    wxArrayString m_httpHeaders;
+};
+
 class wxEasyCurlDialog {
 public:
     wxEasyCurlDialog(const wxString &message = wxEmptyString, int nthreads = 0, wxWindow *parent = NULL);
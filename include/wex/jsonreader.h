@@ -14,6 +14,7 @@
 #include <wx/stream.h>
 #include <wx/string.h>
 #include <wx/arrstr.h>
+#include <wx/buffer.h>
 
 #include "wex/json_defs.h"
 #include "wex/jsonval.h"
@@ -35,6 +36,53 @@ enum {
     wxJSONREADER_COMMENTS_BEFORE = wxJSONREADER_ALLOW_COMMENTS | wxJSONREADER_STORE_COMMENTS
 };
 
+//! Receives the values read by wxJSONReader::Parse( const char*, size_t, wxJSONHandler& )
+/*!
+ The reader calls these functions in document order while scanning the
+ JSON text, without building a wxJSONValue tree.  Inside objects, Key() is
+ called just before the value it names.  Every StartObject() / StartArray()
+ is matched by an EndObject() / EndArray() unless parsing is stopped.
+ Return FALSE from any function to stop the parser.
+ */
+class WXDLLIMPEXP_JSON  wxJSONHandler {
+public:
+    virtual ~wxJSONHandler() {}
+
+    virtual bool StartObject() { return true; }
+
+    virtual bool EndObject() { return true; }
+
+    virtual bool StartArray() { return true; }
+
+    virtual bool EndArray() { return true; }
+
+    virtual bool Key(const wxString &) { return true; }
+
+    virtual bool Null() { return true; }
+
+    virtual bool Bool(bool) { return true; }
+
+#if defined( wxJSON_64BIT_INT )
+
+    virtual bool Int(wxInt64) { return true; }
+
+    virtual bool UInt(wxUint64) { return true; }
+
+#else
+    virtual bool Int( int ) { return true; }
+
+    virtual bool UInt( unsigned int ) { return true; }
+#endif
+
+    virtual bool Double(double) { return true; }
+
+    virtual bool String(const wxString &) { return true; }
+
+    virtual bool MemoryBuff(const wxMemoryBuffer &) { return true; }
+};
+
+struct wxJSONToken;
+
 class WXDLLIMPEXP_JSON  wxJSONReader {
 public:
     wxJSONReader(int flags = wxJSONREADER_TOLERANT, int maxErrors = 30);
@@ -45,6 +93,12 @@ public:
 
     int Parse(wxInputStream &doc, wxJSONValue *val);
 
+    int Parse(const char *data, size_t len, wxJSONHandler &handler);
+
+    int Parse(const wxString &doc, wxJSONHandler &handler);
+
+    int Parse(wxInputStream &doc, wxJSONHandler &handler);
+
     int GetDepth() const;
 
     int GetErrorCount() const;
@@ -74,6 +128,8 @@ public:
 
 protected:
 
+    int DoParse(wxInputStream &doc, wxJSONValue *val);
+
     int DoRead(wxInputStream &doc, wxJSONValue &val);
 
     void AddError(const wxString &descr);
@@ -114,6 +170,34 @@ protected:
 
     int ReadMemoryBuff(wxInputStream &is, wxJSONValue &val);
 
+    // the event parser: same grammar and messages as above, but reading
+    // a byte span and reporting values to m_handler instead of a tree
+    static bool ReadAll(wxInputStream &is, wxMemoryBuffer &buff);
+
+    inline int SpanReadChar();
+
+    inline int SpanPeekChar();
+
+    bool Emit(bool ok);
+
+    bool EmitValue(const wxJSONToken &value);
+
+    int SpanGetStart();
+
+    int SpanRead(bool isObject);
+
+    void SpanStoreValue(int ch, const wxString &key, wxJSONToken &value, bool isObject);
+
+    int SpanSkipWhiteSpace();
+
+    int SpanSkipComment();
+
+    int SpanReadString(wxJSONToken &val);
+
+    int SpanReadValue(int ch, wxJSONToken &val);
+
+    int SpanReadMemoryBuff(wxJSONToken &val);
+
     //! Flag that control the parser behaviour,
     int m_flags;
 
@@ -161,6 +245,15 @@ protected:
 
     //! skip non-escaped double quotes in strings
     bool m_skip_string_double_quotes;
+
+    //! The byte span read by the event parser.
+    const char *m_ptr, *m_end;
+
+    //! The receiver of the event parser's values.
+    wxJSONHandler *m_handler;
+
+    //! Set when the handler asked to stop parsing.
+    bool m_stopped;
 };
 
 #endif            // not defined _WX_JSONREADER_H
@@ -18,6 +18,8 @@
 #include <wx/dynarray.h>
 #include <wx/arrstr.h>
 
+#include <vector>
+
 #include "json_defs.h"
 
 // forward declarations
@@ -55,6 +57,13 @@ enum {
     wxJSONVALUE_COMMENT_INLINE,
 };
 
+//! The element type of packed integer arrays (see wxJSONValue::IsPacked())
+#if defined( wxJSON_64BIT_INT )
+typedef wxInt64 wxJSONPackedInt;
+#else
+typedef long int wxJSONPackedInt;
+#endif
+
 /***********************************************************************
 
 						class wxJSONValue
@@ -273,6 +282,21 @@ public:
 
     bool Cat(const wxMemoryBuffer &buff);
 
+    // packed arrays of numbers
+    bool IsPacked() const;
+
+    bool Pack();
+
+    void Unpack();
+
+    void AppendPackedInt(wxJSONPackedInt i);
+
+    void AppendPackedDouble(double d);
+
+    const wxJSONPackedInt *GetPackedInts() const;
+
+    const double *GetPackedDoubles() const;
+
     // retrieve an item
     wxJSONValue &Item(unsigned index);
 
@@ -407,6 +431,14 @@ WX_DECLARE_OBJARRAY(wxJSONValue, wxJSONInternalArray);
 
 WX_DECLARE_STRING_HASH_MAP(wxJSONValue, wxJSONInternalMap);
 
+//! The contiguous storage of an array that only contains INT or DOUBLE values
+struct wxJSONPackedArray {
+    //! Either wxJSONTYPE_INT or wxJSONTYPE_DOUBLE
+    wxJSONType m_type;
+    std::vector<wxJSONPackedInt> m_ints;
+    std::vector<double> m_doubles;
+};
+
 /***********************************************************************
 
 						class wxJSONRefData
@@ -530,6 +562,13 @@ public:
      */
     wxMemoryBuffer *m_memBuff;
 
+    //! The packed elements of an array type, if any
+    /*!
+     When this pointer is not NULL the elements of the array are stored here
+     and \c m_valArray is empty (see wxJSONValue::Pack()).
+     */
+    wxJSONPackedArray *m_packed;
+
     // used for debugging purposes: only in debug builds.
 #if defined( WXJSON_USE_VALUE_COUNTER )
     int         m_progr;
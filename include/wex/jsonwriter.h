@@ -76,6 +76,12 @@ protected:
 
     int WriteMemoryBuff(wxOutputStream &os, const wxMemoryBuffer &buff);
 
+    int WritePackedArray(wxOutputStream &os, const wxJSONValue &value);
+
+    static size_t FormatInt(char *buffer, wxJSONPackedInt i);
+
+    size_t FormatDouble(char *buffer, double d);
+
     int WriteInvalid(wxOutputStream &os);
 
     int WriteSeparator(wxOutputStream &os);
@@ -110,6 +116,9 @@ private:
 
     // The format string for printing doubles
     char *m_fmt;
+
+    // TRUE if m_fmt is the default "%.10g" format
+    bool m_defaultFmt;
 };
 
 #endif            // not defined _WX_JSONWRITER_H
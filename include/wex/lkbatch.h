@@ -0,0 +1,118 @@
+/***********************************************************************************************************************
+*  WEX, Copyright (c) 2008-2017, Alliance for Sustainable Energy, LLC. All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+*  following conditions are met:
+*
+*  (1) Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+*  disclaimer.
+*
+*  (2) Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+*  following disclaimer in the documentation and/or other materials provided with the distribution.
+*
+*  (3) Neither the name of the copyright holder nor the names of any contributors may be used to endorse or promote
+*  products derived from this software without specific prior written permission from the respective party.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+*  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER, THE UNITED STATES GOVERNMENT, OR ANY CONTRIBUTORS BE LIABLE FOR
+*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+*  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+*  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+*  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************************************************************/
+
+#ifndef __lkbatch_h
+#define __lkbatch_h
+
+#include <wx/string.h>
+#include <wx/arrstr.h>
+
+#include <vector>
+
+#include "wex/lkscript.h" // defines LK_USE_WXWIDGETS
+
+class wxCSVData;
+
+// the libraries that may be used from several threads at once
+#define wxLK_STDLIB_THREADSAFE (wxLK_STDLIB_MATH|wxLK_STDLIB_STRING|wxLK_STDLIB_FILE)
+
+/*
+ * Runs one script over many cases without a user interface, e.g. the post
+ * processing of a parameter sweep.  The script is compiled once, and each
+ * case runs on a pool of worker threads in its own environment that starts
+ * out with the input variables of the case.  The output variables are
+ * read back from the environment when the case is done.
+ */
+class wxLKBatchRunner {
+public:
+    // libraries not in wxLK_STDLIB_THREADSAFE are ignored
+    wxLKBatchRunner(unsigned long libs = wxLK_STDLIB_THREADSAFE);
+
+    // the functions must be safe to call from several threads at once
+    void RegisterLibrary(lk::fcall_t *funcs, void *user_data = 0);
+
+    bool Compile(const wxString &script, const wxString &workdir = wxEmptyString);
+
+    wxString GetCompileErrors() { return m_errors; }
+
+    // a case is a table of input variable names and values
+    size_t AddCase(const lk::vardata_t &inputs);
+
+    // one case per row after the header row of variable names, numeric
+    // cells become numbers, empty cells are left out
+    size_t AddCases(wxCSVData &csv);
+
+    void ClearCases();
+
+    size_t NumCases() { return m_cases.size(); }
+
+    void SetOutputs(const wxArrayString &names) { m_outputs = names; }
+
+    wxArrayString GetOutputs() { return m_outputs; }
+
+    // runs all cases on nthreads threads, 0 for one per core, and returns
+    // the number of cases that completed without error
+    size_t Run(int nthreads = 0);
+
+    bool Ok(size_t icase) { return m_cases[icase].ok; }
+
+    wxString GetError(size_t icase) { return m_cases[icase].error; }
+
+    // table of the output variables of a case, missing outputs are left out
+    lk::vardata_t &GetResult(size_t icase) { return m_cases[icase].result; }
+
+    // a header row of "case", the output names and "error", then one row per case
+    void GetResults(wxCSVData &csv);
+
+    bool WriteResults(const wxString &file);
+
+    // of the last Run()
+    long GetElapsedMillis() { return m_elapsed; }
+
+    int GetThreadCount() { return m_threads; }
+
+private:
+    friend class wxLKBatchWorker;
+
+    struct Case {
+        lk::vardata_t inputs;
+        lk::vardata_t result;
+        bool ok;
+        wxString error;
+    };
+
+    void RunCase(lk::vm &vm, lk::bytecode &bc, Case &c);
+
+    std::vector<lk::fcall_t *> m_libs;
+    std::vector<void *> m_userData;
+    lk::bytecode m_bc;
+    bool m_compiled;
+    wxString m_errors;
+    wxArrayString m_outputs;
+    std::vector<Case> m_cases;
+    long m_elapsed;
+    int m_threads;
+};
+
+#endif
@@ -28,6 +28,10 @@
 #include <wx/wx.h>
 #include <wx/thread.h>
 
+#include <atomic>
+#include <exception>
+#include <vector>
+
 #define LK_USE_WXWIDGETS 1
 
 #include <lk/absyn.h>
@@ -70,6 +74,11 @@ wxPLPlotCtrl *wxLKGetPlotTarget();
 
 class wxLKDebugger;
 
+class wxEventLoop;
+
+template<int N>
+struct wxLKMainThreadCall;
+
 class wxLKScriptCtrl :
         public wxCodeEditCtrl,
         public wxThreadHelper {
@@ -87,9 +96,16 @@ public:
 
     virtual void OnOutput(const wxString &);
 
+    // calls OnOutput, queued for the main thread without waiting when
+    // called from a script that runs on a worker thread
+    void PostOutput(const wxString &);
+
     virtual void OnSyntaxCheck(int line = -1, const wxString &error = wxEmptyString);
 
-    void RegisterLibrary(lk::fcall_t *funcs, const wxString &group = "Miscellaneous", void *user_data = 0);
+    // functions of libraries registered with main_thread=true are always
+    // called on the main thread, see SetThreaded()
+    void RegisterLibrary(lk::fcall_t *funcs, const wxString &group = "Miscellaneous", void *user_data = 0,
+                         bool main_thread = false);
 
     wxString GetHtmlDocs();
 
@@ -101,6 +117,22 @@ public:
 
     void Stop();
 
+    // Runs scripts on a worker thread instead of yielding to the UI during
+    // execution.  Calls to main_thread libraries, OnEval and OnOutput are
+    // queued to the main thread, and Execute() processes events until the
+    // script is done.  OnEval is called at most about 10 times a second.
+    // While the script runs the other top level windows are disabled.  A
+    // control that registered main thread functions beyond the first 128 of
+    // the process runs its scripts on the main thread instead.
+    void SetThreaded(bool b) { m_threaded = b; }
+
+    bool IsThreaded() { return m_threaded; }
+
+    // of the last script run
+    size_t GetInstructionCount();
+
+    double GetInstructionsPerSecond() { return m_instructionRate; }
+
     void SetWorkDir(const wxString &path);
 
     wxString GetWorkDir();
@@ -150,24 +182,66 @@ private:
     wxTimer m_timer;
 
     std::vector<libdata> m_libs;
+    std::vector<std::vector<lk::fcall_t> > m_mainThreadLibs;
     lk::env_t *m_env;
 
     class my_vm : public lk::vm {
         wxLKScriptCtrl *m_lcs;
         size_t m_counter;
+        wxLongLong m_lastEval;
     public:
         my_vm(wxLKScriptCtrl *lcs);
 
+        void reset_counter() { m_counter = 0; }
+
+        size_t counter() const { return m_counter; }
+
         virtual bool on_run(const lk::srcpos_t &sp);
     };
 
+    // a call from the script worker thread to the main thread
+    struct MainThreadCall {
+        lk::fcall_t func;
+        lk::invoke_t *cxt;
+        wxString output;
+        int line;
+        bool eval, async, done;
+        std::exception_ptr error;
+
+        MainThreadCall() : func(0), cxt(0), line(0), eval(false), async(false), done(false) {}
+    };
+
+    template<int N>
+    friend struct wxLKMainThreadCall;
+
+    friend class wxLKScriptWorker;
+
+    bool m_threaded;
+    bool m_unforwarded; // main thread functions that did not get a forwarder
+    wxMutex m_callLock;
+    wxCondition m_callDone;
+    std::vector<MainThreadCall *> m_calls;
+    wxEventLoop *m_workerLoop;
+    bool m_workerDone;
+    double m_instructionRate;
+
+    void CallOnMainThread(MainThreadCall *call);
+
+    void ProcessMainThreadCalls();
+
+    bool EvalOnMainThread(int line);
+
+    bool RunOnWorker();
+
+    void OnWorkerFinished();
+
     lk::bytecode m_bc;
     my_vm m_vm;
 
     wxString m_assemblyText;
 
     bool m_scriptRunning;
-    bool m_stopScriptFlag;
+    std::atomic<bool> m_stopScriptFlag;
     wxLKDebugger *m_debugger;
     bool m_debuggerFirstShow;
 
@@ -248,7 +322,7 @@ protected:
 
     MyScriptCtrl *m_script;
     wxTextCtrl *m_output;
-    wxMetroButton *m_runBtn, *m_stopBtn;
+    wxMetroButton *m_runBtn, *m_stopBtn, *m_closeBtn;
     wxString m_fileName;
     wxString m_lastTitle;
 
@@ -70,6 +70,26 @@ public:
 
     virtual wxColour ColourForValue(double val);
 
+    // Maps n values to colours packed as 0xRRGGBBAA through a lookup table
+    // sampled from the colour list, built on first use.  Gives the same
+    // colours as ColourForValue unless interpolation is on, in which case
+    // the colours blend smoothly between neighbouring entries of the list.
+    // It does not call ColourForValue, so a subclass that overrides that
+    // must override this too; ColoursForValuesSlow() is a fallback for it.
+    virtual void ColoursForValues(const double *values, size_t n, wxUint32 *rgba);
+
+    void SetInterpolation(bool b);
+
+    bool GetInterpolation() const { return m_interpolate; }
+
+    static wxUint32 PackColour(const wxColour &c) {
+        return ((wxUint32) c.Red() << 24) | ((wxUint32) c.Green() << 16) | ((wxUint32) c.Blue() << 8) | c.Alpha();
+    }
+
+    static wxColour UnpackColour(wxUint32 rgba) {
+        return wxColour((rgba >> 24) & 0xff, (rgba >> 16) & 0xff, (rgba >> 8) & 0xff, rgba & 0xff);
+    }
+
     void SetReversed(bool r = true) { m_reversed = r; }
 
     bool IsReversed();
@@ -86,6 +106,15 @@ protected:
     double m_max;
     wxArrayString m_labels;
     std::vector<wxColour> m_colourList;
+    bool m_interpolate;
+
+    // packs ColourForValue of each value, one virtual call per value
+    void ColoursForValuesSlow(const double *values, size_t n, wxUint32 *rgba);
+
+private:
+    void BuildLookupTable();
+
+    std::vector<wxUint32> m_lut;
 };
 
 class wxPLCoarseRainbowColourMap : public wxPLColourMap {
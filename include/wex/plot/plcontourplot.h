@@ -63,7 +63,8 @@ public:
             const std::vector<double> &z,
             const wxMatrix<double> &xq,
             const wxMatrix<double> &yq,
-            wxMatrix<double> &zinterp);
+            wxMatrix<double> &zinterp,
+            bool linear_search = false); // linear_search: old triangle scan, for benchmarks
 
     static void Peaks(size_t n,
                       wxMatrix<double> &xx, wxMatrix<double> &yy, wxMatrix<double> &zz,
@@ -27,6 +27,64 @@
 
 #include "wex/plot/plplot.h"
 
+/*
+ * One pass summary of the distribution of a series.  Up to exactLimit
+ * values are kept and sorted, beyond that they are counted in a fine equal
+ * width histogram whose bins double in width whenever a value falls outside
+ * of it.  Histograms of any number of bins, CDF curves and quantiles are
+ * then derived from the summary without going back to the data.  In the
+ * sketch mode, values are placed within a fine bin, 1/fineBins to
+ * 2/fineBins of the data range.  Zeros are counted apart so that they
+ * can be excluded.
+ */
+class wxPLDistribution {
+public:
+    wxPLDistribution(size_t exactLimit = 100000, size_t fineBins = 8192);
+
+    void Clear();
+
+    // non finite values are skipped
+    void Add(double y);
+
+    void Add(const std::vector<wxRealPoint> &data);
+
+    // call after the last Add
+    void Finish();
+
+    bool IsExact() const { return m_exact; }
+
+    size_t Count(bool ignoreZeros = false) const;
+
+    double Min() const { return m_min; }
+
+    double Max() const { return m_max; }
+
+    // counts of the values in nbins equal bins over [Min, Max], as
+    // wxPLHistogramPlot bins them, and the range of the values in each bin
+    void Histogram(size_t nbins, bool ignoreZeros, std::vector<double> &counts,
+                   std::vector<wxRealPoint> *ranges = 0) const;
+
+    // (value, percent) points of the empirical CDF
+    void Cdf(bool ignoreZeros, std::vector<wxRealPoint> &cdf) const;
+
+    // p in [0,1]
+    double Quantile(double p, bool ignoreZeros = false) const;
+
+private:
+    void ToSketch();
+
+    void AddFine(double y);
+
+    size_t m_exactLimit, m_fineBins;
+    bool m_exact;
+    size_t m_count, m_zeros;
+    double m_min, m_max;
+
+    std::vector<double> m_values; // exact mode, sorted by Finish
+    std::vector<double> m_fine; // sketch mode, non zero values
+    double m_origin, m_width;
+};
+
 class wxPLHistogramPlot : public wxPLPlottable {
 public:
     wxPLHistogramPlot();
@@ -42,6 +100,12 @@ public:
 
     void SetData(const std::vector<wxRealPoint> &data);
 
+    // histogram of a summary built elsewhere, e.g. on a worker thread.
+    // the plot keeps no data points in this case
+    void SetDistribution(const wxPLDistribution &dist);
+
+    const wxPLDistribution &GetDistribution() const { return m_dist; }
+
     //Getters and Setters
     void SetLineStyle(const wxColour &c, double width);
 
@@ -107,6 +171,7 @@ private:
     double m_dataMin, m_dataMax;
 
     std::vector<wxRealPoint> m_data;
+    wxPLDistribution m_dist;
 };
 
 #endif
@@ -69,6 +69,14 @@ public:
 
     void SetData(const std::vector<wxRealPoint> &data) { m_data = data; }
 
+    // reduce the line to the first/min/max/last point of each
+    // output pixel column before drawing; markers are unaffected
+    void SetDecimation(bool b) { m_decimate = b; }
+
+    bool GetDecimation() const { return m_decimate; }
+
+    static void Decimate(const std::vector<wxRealPoint> &points, std::vector<wxRealPoint> &out, double pixel);
+
 protected:
     void Init();
 
@@ -80,8 +88,11 @@ protected:
 
     void DrawMarkers(wxPLOutputDevice &dc, std::vector<wxRealPoint> &points, double size);
 
+    void DrawLines(wxPLOutputDevice &dc, std::vector<wxRealPoint> &points);
+
 private:
     bool m_ignoreZeros;
+    bool m_decimate;
 };
 
 #endif
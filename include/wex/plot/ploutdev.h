@@ -29,6 +29,7 @@
 #include <wx/gdicmn.h>
 #include <wx/string.h>
 #include <wx/graphics.h>
+#include <wx/image.h>
 
 #include <wex/pdf/pdfdoc.h>
 #include <wex/pdf/pdfshape.h>
@@ -107,6 +108,11 @@ public:
 
     virtual void Measure(const wxString &text, double *width, double *height) = 0;
 
+    // draws the image stretched to the given rectangle without smoothing;
+    // the default fills one rectangle per pixel, devices override it
+    // with a native bitmap call
+    virtual void Image(const wxImage &img, double x, double y, double width, double height);
+
     // API variants and helpers;
     virtual void NoPen() { Pen(*wxBLACK, 1.0, NONE); }
 
@@ -119,6 +125,10 @@ public:
     virtual void Circle(const wxRealPoint &p, double radius) { Circle(p.x, p.y, radius); }
 
     virtual void Text(const wxString &text, const wxRealPoint &p, double angle = 0) { Text(text, p.x, p.y, angle); }
+
+    // width of one output pixel in device units, used by plottables
+    // that decimate large data sets before drawing them
+    virtual double PixelSize() const { return 1.0; }
 };
 
 class wxPLPdfOutputDevice : public wxPLOutputDevice {
@@ -126,6 +136,8 @@ class wxPLPdfOutputDevice : public wxPLOutputDevice {
     bool m_pen, m_brush;
     wxPdfDocument &m_pdf;
     wxPdfShape m_shape;
+    int m_imageCount;
+    unsigned char m_fillAlpha;
 
 public:
     wxPLPdfOutputDevice(wxPdfDocument &doc, double fontpts);
@@ -172,6 +184,10 @@ public:
 
     virtual void Measure(const wxString &text, double *width, double *height);
 
+    virtual void Image(const wxImage &img, double x, double y, double width, double height);
+
+    virtual double PixelSize() const;
+
 private:
     int GetDrawingStyle();
 };
@@ -263,6 +279,10 @@ public:
     virtual void Text(const wxString &text, double x, double y, double angle = 0);
 
     virtual void Measure(const wxString &text, double *width, double *height);
+
+    virtual void Image(const wxImage &img, double x, double y, double width, double height);
+
+    virtual double PixelSize() const;
 };
 
 #endif
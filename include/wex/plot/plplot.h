@@ -161,6 +161,14 @@ public:
     enum LegendPos {
         FLOATING, NORTHWEST, SOUTHWEST, NORTHEAST, SOUTHEAST, NORTH, SOUTH, EAST, WEST, BOTTOM, RIGHT
     };
+    // parts of the plot that can be rendered separately, from bottom to top
+    enum Layer {
+        LAYER_GRID = 0x01, // plot area background, grid lines and annotations behind the plots
+        LAYER_DATA = 0x02,
+        LAYER_AXES = 0x04, // axes, labels, title, borders and side widgets
+        LAYER_LEGEND = 0x08, // legend and annotations in front of the plots
+        LAYER_ALL = 0x0f
+    };
 
     void AddPlot(wxPLPlottable *p, AxisPos xap = X_BOTTOM, AxisPos yap = Y_LEFT, PlotPos ppos = PLOT_TOP,
                  bool update_axes = true);
@@ -189,6 +197,8 @@ public:
 
     void DeleteAllAnnotations();
 
+    size_t GetAnnotationCount() const { return m_annotations.size(); }
+
     wxPLAxis *GetXAxis1() { return m_x1.axis; }
 
     wxPLAxis &X1() { return Axis(X_BOTTOM); }
@@ -295,7 +305,8 @@ public:
 
     void Invalidate(); // erases all cached positions and layouts, but does not issue refresh
     void Render(wxPLOutputDevice &dc,
-                wxPLRealRect geom); // note: does not draw the background.  DC should be cleared with desired bg color already
+                wxPLRealRect geom,
+                int layers = LAYER_ALL); // note: does not draw the background.  DC should be cleared with desired bg color already
 
     static bool AddPdfFontDir(const wxString &path);
 
@@ -327,6 +338,10 @@ protected:
 
 private:
 
+    void RenderAxes(wxPLOutputDevice &dc, const wxPLRealRect &box, const wxPLRealRect &plotbox,
+                    size_t nyaxes, bool is_cartesian, double pp_radius, const wxRealPoint &pp_center,
+                    double yleft_max_label_width, double yright_max_label_width);
+
     void DrawAnnotations(wxPLOutputDevice &dc, const wxPLRealRect &plotarea, wxPLAnnotation::ZOrder zo);
 
     void DrawGrid(wxPLOutputDevice &dc, wxPLAxis::TickData::TickSize size);
@@ -30,12 +30,9 @@
 #include <wx/menu.h>
 #include <wx/stream.h>
 #include <wx/graphics.h>
-/*
-#ifdef __WXOSX__
-#define PL_USE_OVERLAY 1
-#include <wx/overlay.h>
-#endif
-*/
+#include <wx/bitmap.h>
+#include <wx/image.h>
+
 #include "wex/plot/plplot.h"
 
 BEGIN_DECLARE_EVENT_TYPES()
@@ -88,7 +85,16 @@ public:
 
     wxBitmap GetBitmap(int width = -1, int height = -1);
 
-    void Render(wxGraphicsContext &gc, wxRect geom, double fontpoints = -1);
+    void Render(wxGraphicsContext &gc, wxRect geom, double fontpoints = -1, int layers = LAYER_ALL);
+
+    // The layers of the plot are cached in bitmaps between paints, and the
+    // highlight and legend drag feedback is drawn over them.  Refresh()
+    // redraws every layer, RefreshLayers() only the given ones, e.g.
+    // LAYER_DATA when only the data of the plottables changed, or
+    // LAYER_GRID|LAYER_DATA|LAYER_AXES after panning or zooming.
+    virtual void Refresh(bool eraseBackground = true, const wxRect *rect = NULL);
+
+    void RefreshLayers(int layers);
 
 protected:
     virtual wxSize DoGetBestSize() const;
@@ -113,29 +119,44 @@ protected:
 
     void UpdateHighlightRegion();
 
-    void DrawLegendOutline();
+    void DrawHighlightRegion(wxGraphicsContext &gc);
+
+    void DrawLegendOutline(wxGraphicsContext &gc);
+
+    bool RenderOpaqueLayers(wxGraphicsRenderer *renderer, wxBitmap &bitmap, const wxSize &size, int layers);
+
+    bool RenderLayers(wxGraphicsRenderer *renderer, const wxSize &size);
 
 private:
     bool m_scaleTextSize;
     bool m_includeLegendOnExport;
 
     bool m_moveLegendMode;
-    bool m_moveLegendErase;
+    bool m_moveLegendDragged;
     wxPoint m_anchorPoint;
     wxPoint m_currentPoint;
     wxMenu m_contextMenu;
     bool m_highlightMode;
 
-#ifdef PL_USE_OVERLAY
-    wxOverlay m_overlay;
-#endif
-    bool m_highlightErase;
+    bool m_highlightDragged;
+    std::vector<wxRect> m_highlightRects;
     double m_highlightLeftPercent;
     double m_highlightRightPercent;
     double m_highlightTopPercent;
     double m_highlightBottomPercent;
     HighlightMode m_highlighting;
 
+    enum {
+        NLAYERS = 4
+    };
+    wxBitmap m_layers[NLAYERS]; // bottom to top, only the first is opaque
+    wxImage m_layerImages[NLAYERS]; // drawing buffers of the transparent layers
+    wxBitmap m_composite;
+    wxSize m_layerSize;
+    double m_layerScale;
+    bool m_layersSplit; // the layer bitmaps are up to date, not only the composite
+    int m_dirtyLayers;
+
 DECLARE_EVENT_TABLE();
 };
 
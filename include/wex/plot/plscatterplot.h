@@ -31,6 +31,13 @@ class wxPLColourMap;
 
 class wxPLScatterPlot : public wxPLPlottable {
 public:
+    enum DensityMode {
+        DENSITY_OFF, DENSITY_AUTO, DENSITY_ON
+    };
+    enum DensityCell {
+        CELL_SQUARE, CELL_HEX
+    };
+
     wxPLScatterPlot();
 
     wxPLScatterPlot(const std::vector<wxRealPoint> &data,
@@ -64,7 +71,38 @@ public:
 
     void SetLineOfPerfectAgreementFlag(bool flagValue);
 
+    // In density mode the visible points are binned into screen cells that are
+    // coloured by the number of points in them, through the density colour map
+    // if one is set or in translucent shades of the plot colour otherwise, so
+    // that the cells of several series blend.  DENSITY_AUTO switches to it
+    // above 'threshold' visible points.  Points in cells with no more than
+    // 'outliers' points are still drawn as markers.
+    void SetDensityMode(DensityMode mode, size_t threshold = 20000);
+
+    DensityMode GetDensityMode() const { return m_densityMode; }
+
+    size_t GetDensityThreshold() const { return m_densityThreshold; }
+
+    void SetDensityCells(DensityCell shape, double pixels = 5, size_t outliers = 2);
+
+    // the scale of the colour map is log10 of the number of points in a cell,
+    // e.g. 0 to 4 for 1 to 10000 points.  the cells are opaque, so this is
+    // meant for a single series, with the colour map shown as its legend
+    void SetDensityColourMap(wxPLColourMap *cmap); // does not take ownership of colour map
+
 protected:
+    // zrgba holds the colours of all points when they have their own colours,
+    // pen and brush are only changed when the colour differs from 'current'
+    void DrawMarker(wxPLOutputDevice &dc, const wxPLDeviceMapping &map, size_t i,
+                    const wxUint32 *zrgba, wxUint32 &current, bool has_sizes);
+
+    // packed colours of the points from the colour map, or NULL if they have none
+    const wxUint32 *MapColours(std::vector<wxUint32> &rgba);
+
+    // returns false if the points should be drawn as markers instead
+    bool DrawDensity(wxPLOutputDevice &dc, const wxPLDeviceMapping &map);
+
+
     wxColour m_colour;
     double m_radius;
     bool m_scale;
@@ -73,6 +111,16 @@ protected:
     std::vector<wxRealPoint> m_data;
     std::vector<double> m_colours, m_sizes;
     wxPLColourMap *m_cmap;
+
+    DensityMode m_densityMode;
+    size_t m_densityThreshold;
+    DensityCell m_densityCell;
+    double m_densityCellSize;
+    size_t m_densityOutliers;
+    wxPLColourMap *m_densityCmap;
+
+private:
+    void InitDensity();
 };
 
 #endif
@@ -99,6 +99,13 @@ int wxFreeTypeFindFont(const wxString &font);
 
 unsigned char *wxFreeTypeFontData(int ifnt, size_t *len);
 
+// rendered glyphs and measured strings are cached across calls
+void wxFreeTypeEnableCache(bool enable);
+
+void wxFreeTypeClearCache();
+
+size_t wxFreeTypeCacheMemory(); // bytes of glyph atlas pages
+
 wxSize wxFreeTypeMeasure(int ifnt, double points, unsigned int dpi, const wxString &text);
 
 void wxFreeTypeDraw(wxImage *img, bool init_img, const wxPoint &pos,
@@ -26,9 +26,12 @@
 #define __uiform_h
 
 #include <vector>
+#include <unordered_map>
 
 #include <wx/wx.h>
 #include <wx/clrpicker.h>
+#include <wx/buffer.h>
+#include <wx/hashmap.h>
 
 #define wxUI_USE_OVERLAY 1
 
@@ -36,6 +39,10 @@
 
 class wxUIProperty;
 
+class wxUIFormWriter;
+
+class wxUIFormReader;
+
 class wxUIPropertyUpdateInterface {
 public:
     virtual void OnPropertyChanged(const wxString &id, wxUIProperty *p) = 0;
@@ -117,6 +124,11 @@ public:
 
     bool Read_text(wxInputStream &, wxString &);
 
+    // version 2 form format, see wxUIFormData::WriteV2
+    void WriteBuffer(wxUIFormWriter &);
+
+    bool ReadBuffer(wxUIFormReader &);
+
     void AddUpdateInterface(const wxString &name, wxUIPropertyUpdateInterface *pui);
 
     void RemoveUpdateInterface(wxUIPropertyUpdateInterface *pui);
@@ -135,11 +147,16 @@ private:
     wxColour m_colour;
     wxString m_string;
     wxImage m_image;
+    wxMemoryBuffer m_imageData; // PNG data not decoded into m_image yet
     wxArrayString m_strList;
     wxArrayString m_namedOptions;
 
     void ValueChanged();
 
+    void SetImageData(const void *png, size_t len);
+
+    wxMemoryBuffer GetImageData();
+
     struct puidata {
         wxUIPropertyUpdateInterface *pui;
         wxString id;
@@ -147,6 +164,8 @@ private:
     std::vector<puidata> m_updateInterfaceList;
 };
 
+class wxUIFormData;
+
 class wxUIObject : public wxUIPropertyUpdateInterface {
 public:
     wxUIObject();
@@ -189,6 +208,12 @@ public:
 
     wxString GetName();
 
+    // the form that holds this object, set by wxUIFormData::Add().  the form
+    // is told about changes of the "Name" property to keep its index current
+    void SetOwnerForm(wxUIFormData *form);
+
+    wxUIFormData *GetOwnerForm() { return m_ownerForm; }
+
     void SetGeometry(const wxRect &r);
 
     wxRect GetGeometry();
@@ -217,6 +242,12 @@ public:
 
     virtual bool Read_text(wxInputStream &, wxString &);
 
+    // version 2 form format.  types that override Write/Read to save more
+    // than their properties must override these as well
+    virtual void WriteBuffer(wxUIFormWriter &);
+
+    virtual bool ReadBuffer(wxUIFormReader &);
+
 protected:
     void AddProperty(const wxString &name, wxUIProperty *prop);
 
@@ -225,12 +256,19 @@ private:
 
     bool m_visible;
     wxString m_toolTip;
+    wxUIFormData *m_ownerForm;
     struct propdata {
         wxString name, lowered;
         wxUIProperty *prop;
     };
     std::vector<propdata> m_properties;
 
+    // property index by name as added and by lowered name, so lookups
+    // with the usual spelling neither lower the name nor scan the list
+    std::unordered_map<wxString, size_t, wxStringHash, wxStringEqual> m_propertyIndex;
+
+    wxUIProperty *FindProperty(const wxString &name);
+
 protected:
     wxWindow *AssignNative(wxWindow *win);
 
@@ -289,7 +327,7 @@ public:
     static wxUIObject *Create(const wxString &type);
 };
 
-class wxUIFormData {
+class wxUIFormData : public wxUIPropertyUpdateInterface {
 public:
     explicit wxUIFormData();
 
@@ -308,9 +346,14 @@ public:
 
     wxWindow *GetWindow() { return m_formWindow; }
 
-    // load/save form definition
+    // load/save form definition.  Write produces the version 1 format that
+    // every build reads.  WriteV2 produces the version 2 format, which Read
+    // decodes from a single memory buffer with images decoded on first use,
+    // but which builds from before it was added cannot read.
     virtual void Write(wxOutputStream &);
 
+    virtual void WriteV2(wxOutputStream &);
+
     virtual bool Read(wxInputStream &);
 
     virtual void Write_text(wxOutputStream &, wxString &);
@@ -355,6 +398,9 @@ public:
     virtual bool GetMetaData(const wxString &name,
                              wxString *label, wxString *units, wxColour *colour);
 
+    // keeps the object name index current when objects are renamed
+    virtual void OnPropertyChanged(const wxString &id, wxUIProperty *p);
+
 protected:
     wxString m_name;
     int m_width;
@@ -362,6 +408,13 @@ protected:
     std::vector<wxUIObject *> m_objects;
 
     wxWindow *m_formWindow;
+
+private:
+    // first object with each name, rebuilt on the next Find() after objects
+    // are added, removed, reordered or renamed.  renames arrive through the
+    // "Name" property of each object, see wxUIObject::SetOwnerForm()
+    std::unordered_map<wxString, wxUIObject *, wxStringHash, wxStringEqual> m_nameIndex;
+    bool m_nameIndexValid;
 };
 
 class wxUIObjectCopyBuffer {
@@ -22,17 +22,596 @@
 *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 **********************************************************************************************************************/
 
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <wx/ffile.h>
+#include <wx/thread.h>
 #include <wx/wfstream.h>
-#include <wx/txtstrm.h>
 #include <wx/sstream.h>
 
 #include "wex/csv.h"
 
+static const size_t CSV_CHUNK = 1 << 20;
+
+static char SeparatorByte(wxUniChar sep) {
+    return sep.IsAscii() ? (char) sep.GetValue() : ',';
+}
+
+static wxString DecodeText(const char *p, size_t len) {
+    if (len == 0) return wxEmptyString;
+    wxString s(wxString::FromUTF8(p, len));
+    if (s.IsEmpty()) // not valid UTF-8, as read by wxConvAuto before
+        s = wxString(p, wxConvISO8859_1, len);
+    return s;
+}
+
+static bool ParseNumber(const char *p, size_t len, double *value) {
+    char buf[64];
+    while (len > 0 && (*p == ' ' || *p == '\t')) {
+        p++;
+        len--;
+    }
+    while (len > 0 && (p[len - 1] == ' ' || p[len - 1] == '\t'))
+        len--;
+    if (len == 0 || len >= sizeof(buf)) return false;
+    memcpy(buf, p, len);
+    buf[len] = 0;
+    char *end = 0;
+    *value = strtod(buf, &end);
+    return end == buf + len;
+}
+
+// leading number of a cell like wxAtof, 0 if there is none
+static double ToNumber(const char *p, size_t len) {
+    char buf[64];
+    if (len >= sizeof(buf)) len = sizeof(buf) - 1;
+    memcpy(buf, p, len);
+    buf[len] = 0;
+    return strtod(buf, 0);
+}
+
+/*
+ * RFC 4180 state machine over byte buffers.  Unescaped cell text is
+ * appended to text with the end of each cell in ends, and each completed
+ * row is passed to the handler.  When recycle is set the buffers are
+ * emptied after each row.
+ */
+class wxCSVParser {
+public:
+    wxCSVParser(char sep, std::string &text, std::vector<size_t> &ends,
+                wxCSVRowHandler &handler, bool recycle)
+            : m_sep(sep), m_text(text), m_ends(ends), m_handler(handler), m_recycle(recycle),
+              m_state(ROW_START), m_skipLF(false), m_started(false), m_stopped(false),
+              m_row(0), m_errorLine(0) {
+        m_rowFirst = m_ends.size();
+        m_rowStart = m_text.size();
+    }
+
+    // false when the handler stopped reading
+    bool Feed(const char *p, size_t n) {
+        const char *end = p + n;
+        if (!m_started && n > 0) {
+            m_started = true;
+            if (n >= 3 && (unsigned char) p[0] == 0xEF && (unsigned char) p[1] == 0xBB
+                && (unsigned char) p[2] == 0xBF)
+                p += 3; // UTF-8 byte order mark
+        }
+
+        while (p < end && !m_stopped) {
+            if (m_skipLF) {
+                m_skipLF = false;
+                if (*p == '\n') {
+                    ++p;
+                    continue;
+                }
+            }
+
+            switch (m_state) {
+                case ROW_START:
+                    if (*p == '\n' || *p == '\r') {
+                        // an empty line is a row without cells
+                        m_skipLF = (*p == '\r');
+                        ++p;
+                        EndRow();
+                        break;
+                    }
+                    m_state = FIELD_START;
+                    // fall through
+                case FIELD_START:
+                    if (*p == '"') {
+                        m_state = QUOTED;
+                        ++p;
+                        break;
+                    }
+                    m_state = UNQUOTED;
+                    // fall through
+                case UNQUOTED: {
+                    const char *q = p;
+                    while (q < end && *q != m_sep && *q != '\n' && *q != '\r')
+                        ++q;
+                    m_text.append(p, q - p);
+                    p = q;
+                    if (p == end) break; // continued in the next buffer
+
+                    m_ends.push_back(m_text.size());
+                    if (*p == m_sep) {
+                        m_state = FIELD_START;
+                    } else {
+                        m_skipLF = (*p == '\r');
+                        EndRow();
+                    }
+                    ++p;
+                    break;
+                }
+                case QUOTED: {
+                    const char *q = (const char *) memchr(p, '"', end - p);
+                    if (!q) q = end;
+                    m_text.append(p, q - p);
+                    p = q;
+                    if (p < end) {
+                        m_state = QUOTE_IN_QUOTED;
+                        ++p;
+                    }
+                    break;
+                }
+                case QUOTE_IN_QUOTED:
+                    if (*p == '"') {
+                        m_text += '"';
+                        m_state = QUOTED;
+                        ++p;
+                    } else {
+                        // text after the closing quote is kept as is
+                        if (*p != m_sep && *p != '\n' && *p != '\r')
+                            Error();
+                        m_state = UNQUOTED;
+                    }
+                    break;
+            }
+        }
+
+        return !m_stopped;
+    }
+
+    bool Finish() {
+        if (m_stopped) return false;
+        if (m_state == QUOTED)
+            Error(); // unterminated quote
+        if (m_state != ROW_START) {
+            m_ends.push_back(m_text.size());
+            EndRow();
+        }
+        return !m_stopped;
+    }
+
+    int GetErrorLine() { return m_errorLine; }
+
+private:
+    enum State {
+        ROW_START, FIELD_START, UNQUOTED, QUOTED, QUOTE_IN_QUOTED
+    };
+
+    char m_sep;
+    std::string &m_text;
+    std::vector<size_t> &m_ends;
+    wxCSVRowHandler &m_handler;
+    bool m_recycle;
+    State m_state;
+    bool m_skipLF, m_started, m_stopped;
+    size_t m_row, m_rowFirst, m_rowStart;
+    int m_errorLine;
+
+    void EndRow() {
+        wxCSVRow row(m_text.data(), m_ends.data() + m_rowFirst, m_rowStart, m_ends.size() - m_rowFirst);
+        if (!m_handler.OnRow(m_row++, row))
+            m_stopped = true;
+        if (m_recycle) {
+            m_text.clear();
+            m_ends.clear();
+        }
+        m_rowFirst = m_ends.size();
+        m_rowStart = m_text.size();
+        m_state = ROW_START;
+    }
+
+    void Error() {
+        // flag error on the first row with a formatting problem
+        if (m_errorLine == 0)
+            m_errorLine = -((int) m_row + 1);
+    }
+};
+
+static void ParseStream(wxInputStream &in, wxCSVParser &parser) {
+    std::vector<char> buf(CSV_CHUNK);
+    while (true) {
+        in.Read(&buf[0], buf.size());
+        size_t n = in.LastRead();
+        if (n == 0 || !parser.Feed(&buf[0], n))
+            break;
+    }
+    parser.Finish();
+}
+
+const char *wxCSVRow::Text(size_t c, size_t *len) const {
+    size_t begin = c == 0 ? m_start : m_ends[c - 1];
+    *len = m_ends[c] - begin;
+    return m_text + begin;
+}
+
+wxString wxCSVRow::Get(size_t c) const {
+    if (c >= m_count) return wxEmptyString;
+    size_t len;
+    const char *p = Text(c, &len);
+    return DecodeText(p, len);
+}
+
+bool wxCSVRow::GetNumber(size_t c, double *value) const {
+    if (c >= m_count) return false;
+    size_t len;
+    const char *p = Text(c, &len);
+    return ParseNumber(p, len, value);
+}
+
+wxCSVReader::wxCSVReader(wxUniChar sep)
+        : m_sep(sep), m_errorLine(0) {
+}
+
+bool wxCSVReader::Read(wxInputStream &in, wxCSVRowHandler &handler) {
+    std::string text;
+    std::vector<size_t> ends;
+    wxCSVParser parser(SeparatorByte(m_sep), text, ends, handler, true);
+    ParseStream(in, parser);
+    m_errorLine = parser.GetErrorLine();
+    return (0 == m_errorLine);
+}
+
+bool wxCSVReader::ReadFile(const wxString &file, wxCSVRowHandler &handler) {
+    wxFFileInputStream in(file);
+    if (!in.IsOk()) return false;
+    return Read(in, handler);
+}
+
+bool wxCSVReader::ReadString(const wxString &data, wxCSVRowHandler &handler) {
+    std::string text;
+    std::vector<size_t> ends;
+    wxScopedCharBuffer utf8(data.utf8_str());
+    wxCSVParser parser(SeparatorByte(m_sep), text, ends, handler, true);
+    parser.Feed(utf8.data(), utf8.length());
+    parser.Finish();
+    m_errorLine = parser.GetErrorLine();
+    return (0 == m_errorLine);
+}
+
+wxCSVWriter::wxCSVWriter(wxOutputStream *out, wxUniChar sep)
+        : m_out(out), m_sep(SeparatorByte(sep)), m_strict(true), m_cells(0) {
+}
+
+wxCSVWriter::~wxCSVWriter() {
+    Flush();
+}
+
+void wxCSVWriter::NextCell() {
+    if (m_cells++ > 0) m_buf += m_sep;
+}
+
+void wxCSVWriter::Text(const wxString &text) {
+    wxScopedCharBuffer utf8(text.utf8_str());
+    Text(utf8.data(), utf8.length());
+}
+
+void wxCSVWriter::Text(const char *p, size_t len) {
+    NextCell();
+    bool quote = false;
+    for (size_t i = 0; i < len && !quote; i++)
+        quote = (p[i] == m_sep || (m_strict && (p[i] == '"' || p[i] == '\n' || p[i] == '\r')));
+    if (!quote) {
+        m_buf.append(p, len);
+        return;
+    }
+    m_buf += '"';
+    for (size_t i = 0; i < len; i++) {
+        if (p[i] == '"') m_buf += '"';
+        m_buf += p[i];
+    }
+    m_buf += '"';
+}
+
+void wxCSVWriter::Number(double value, int precision) {
+    NextCell();
+    char buf[40];
+    int n = snprintf(buf, sizeof(buf), "%.*g", precision, value);
+    if (n > 0) m_buf.append(buf, std::min((size_t) n, sizeof(buf) - 1));
+}
+
+void wxCSVWriter::EndRow() {
+    m_buf += '\n';
+    m_cells = 0;
+    if (m_out && m_buf.size() >= CSV_CHUNK)
+        Flush();
+}
+
+void wxCSVWriter::Flush() {
+    if (m_out && !m_buf.empty()) {
+        m_out->Write(m_buf.data(), m_buf.size());
+        m_buf.clear();
+    }
+}
+
+// stores the numbers of the rows of one range of records
+class wxCSVNumberHandler : public wxCSVRowHandler {
+    double *m_out;
+    size_t m_ncols;
+    const std::vector<int> &m_colMap;
+public:
+    wxCSVNumberHandler(double *out, size_t ncols, const std::vector<int> &colMap)
+            : m_out(out), m_ncols(ncols), m_colMap(colMap) {}
+
+    virtual bool OnRow(size_t row, const wxCSVRow &cells) {
+        double *dst = m_out + row * m_ncols;
+        size_t n = std::min(cells.Count(), m_colMap.size());
+        for (size_t c = 0; c < n; c++) {
+            if (m_colMap[c] < 0) continue;
+            size_t len;
+            const char *p = cells.Text(c, &len);
+            dst[m_colMap[c]] = len > 0 ? ToNumber(p, len) : 0.0;
+        }
+        return true;
+    }
+};
+
+class wxCSVNamesHandler : public wxCSVRowHandler {
+public:
+    wxArrayString names;
+
+    virtual bool OnRow(size_t, const wxCSVRow &cells) {
+        for (size_t c = 0; c < cells.Count(); c++)
+            names.Add(cells.Get(c));
+        return true;
+    }
+};
+
+class wxCSVNumericWorker : public wxThread {
+    wxCSVNumericReader &m_reader;
+    size_t m_first, m_last;
+public:
+    int errorLine;
+
+    wxCSVNumericWorker(wxCSVNumericReader &reader, size_t first, size_t last)
+            : wxThread(wxTHREAD_JOINABLE), m_reader(reader), m_first(first), m_last(last), errorLine(0) {}
+
+    virtual void *Entry() {
+        errorLine = m_reader.ParseRecords(m_first, m_last);
+        return 0;
+    }
+};
+
+wxCSVNumericReader::wxCSVNumericReader(wxUniChar sep)
+        : m_sep(sep), m_nskip(0), m_header(false), m_firstRow(0), m_lastRow((size_t) -1),
+          m_threads(0), m_nrows(0), m_ncols(0), m_errorLine(0),
+          m_data(0), m_len(0), m_firstRecord(0) {
+}
+
+void wxCSVNumericReader::SetSkip(size_t nskip, bool header) {
+    m_nskip = nskip;
+    m_header = header;
+}
+
+void wxCSVNumericReader::SetRows(size_t first, size_t last) {
+    m_firstRow = first;
+    m_lastRow = last;
+}
+
+void wxCSVNumericReader::SetColumns(const std::vector<size_t> &cols) {
+    m_cols = cols;
+    m_colNames.Clear();
+}
+
+void wxCSVNumericReader::SetColumns(const wxArrayString &names) {
+    m_colNames = names;
+    m_cols.clear();
+}
+
+void wxCSVNumericReader::ScanRecords() {
+    // follows the states of wxCSVParser, quotes only count at the start of a field
+    enum {
+        FIELD_START, UNQUOTED, QUOTED, QUOTE_IN_QUOTED
+    } state = FIELD_START;
+    char sep = SeparatorByte(m_sep);
+    size_t start = 0, cells = 0;
+    bool empty = true;
+
+    m_starts.clear();
+    m_counts.clear();
+    for (size_t i = 0; i < m_len; i++) {
+        char ch = m_data[i];
+        if (state == QUOTED) {
+            if (ch == '"') state = QUOTE_IN_QUOTED;
+            continue;
+        }
+        if (state == QUOTE_IN_QUOTED && ch == '"') {
+            state = QUOTED;
+            continue;
+        }
+        if (ch == sep) {
+            cells++;
+            empty = false;
+            state = FIELD_START;
+        } else if (ch == '\n' || ch == '\r') {
+            m_starts.push_back(start);
+            m_counts.push_back(empty ? 0 : cells + 1);
+            if (ch == '\r' && i + 1 < m_len && m_data[i + 1] == '\n') i++;
+            start = i + 1;
+            cells = 0;
+            empty = true;
+            state = FIELD_START;
+        } else {
+            empty = false;
+            if (state == FIELD_START)
+                state = (ch == '"') ? QUOTED : UNQUOTED;
+            else if (state == QUOTE_IN_QUOTED)
+                state = UNQUOTED;
+        }
+    }
+    if (start < m_len) {
+        m_starts.push_back(start);
+        m_counts.push_back(cells + 1);
+    }
+}
+
+int wxCSVNumericReader::ParseRecords(size_t first, size_t last) {
+    if (first >= last) return 0;
+    size_t begin = m_starts[first];
+    size_t end = last < m_starts.size() ? m_starts[last] : m_len;
+    std::string text;
+    std::vector<size_t> ends;
+    wxCSVNumberHandler handler(&m_values[(first - m_firstRecord) * m_ncols], m_ncols, m_colMap);
+    wxCSVParser parser(SeparatorByte(m_sep), text, ends, handler, true);
+    parser.Feed(m_data + begin, end - begin);
+    parser.Finish();
+    // error line of the whole input
+    int err = parser.GetErrorLine();
+    return err == 0 ? 0 : err - (int) first;
+}
+
+bool wxCSVNumericReader::Read(const char *data, size_t len) {
+    m_nrows = m_ncols = 0;
+    m_values.clear();
+    m_names.Clear();
+    m_errorLine = 0;
+    if (len >= 3 && (unsigned char) data[0] == 0xEF && (unsigned char) data[1] == 0xBB
+        && (unsigned char) data[2] == 0xBF) {
+        data += 3;
+        len -= 3;
+    }
+    m_data = data;
+    m_len = len;
+    ScanRecords();
+
+    // trailing empty lines are not rows
+    size_t nr = m_starts.size();
+    while (nr > 0 && m_counts[nr - 1] == 0)
+        nr--;
+    if (nr == 0) return true;
+
+    size_t nskip = m_nskip;
+    if (nskip + (m_header ? 1 : 0) >= nr) nskip = 0;
+
+    wxArrayString header;
+    if (m_header) {
+        size_t end = nskip + 1 < m_starts.size() ? m_starts[nskip + 1] : m_len;
+        wxCSVReader reader(m_sep);
+        wxCSVNamesHandler names;
+        reader.ReadString(wxString::FromUTF8(m_data + m_starts[nskip], end - m_starts[nskip]), names);
+        header = names.names;
+    }
+
+    size_t maxCells = 0;
+    for (size_t i = 0; i < nr; i++)
+        maxCells = std::max(maxCells, m_counts[i]);
+
+    // output column of each input column
+    std::vector<size_t> cols(m_cols);
+    for (size_t i = 0; i < m_colNames.size(); i++) {
+        int idx = header.Index(m_colNames[i]);
+        if (idx != wxNOT_FOUND) cols.push_back((size_t) idx);
+    }
+    if (cols.empty() && m_cols.empty() && m_colNames.empty())
+        for (size_t c = 0; c < maxCells; c++)
+            cols.push_back(c);
+    m_colMap.assign(maxCells, -1);
+    for (size_t k = 0; k < cols.size(); k++) {
+        if (cols[k] >= m_colMap.size()) m_colMap.resize(cols[k] + 1, -1);
+        m_colMap[cols[k]] = (int) k;
+        m_names.Add(cols[k] < header.size() ? header[cols[k]] : wxString());
+    }
+    m_ncols = cols.size();
+
+    m_firstRecord = nskip + (m_header ? 1 : 0) + m_firstRow;
+    size_t lastRecord = nr; // one past the last
+    if (m_lastRow != (size_t) -1)
+        lastRecord = std::min(nr, nskip + (m_header ? 1 : 0) + m_lastRow + 1);
+    if (m_firstRecord >= lastRecord || m_ncols == 0) {
+        m_firstRecord = lastRecord;
+        return true;
+    }
+    m_nrows = lastRecord - m_firstRecord;
+    m_values.assign(m_nrows * m_ncols, 0.0);
+
+    // split the records between threads for large inputs
+    size_t nthreads = 1;
+    if (m_len > 4 * CSV_CHUNK && m_threads != 1) {
+        nthreads = m_threads > 0 ? (size_t) m_threads : (size_t) wxThread::GetCPUCount();
+        nthreads = std::max((size_t) 1, std::min(nthreads, m_nrows / 4096));
+    }
+
+    std::vector<wxCSVNumericWorker *> workers;
+    size_t per = m_nrows / nthreads;
+    size_t first = m_firstRecord;
+    for (size_t t = 0; t + 1 < nthreads; t++) {
+        wxCSVNumericWorker *w = new wxCSVNumericWorker(*this, first, first + per);
+        if (w->Create() == wxTHREAD_NO_ERROR && w->Run() == wxTHREAD_NO_ERROR) {
+            workers.push_back(w);
+            first += per;
+        } else
+            delete w; // the remaining records are parsed below
+    }
+
+    m_errorLine = ParseRecords(first, lastRecord);
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t]->Wait();
+        // flag error on the first row with a formatting problem, the
+        // workers have the earlier records
+        if (workers[t]->errorLine != 0 && (m_errorLine == 0 || workers[t]->errorLine > m_errorLine))
+            m_errorLine = workers[t]->errorLine;
+        delete workers[t];
+    }
+
+    m_data = 0;
+    m_len = 0;
+    return (0 == m_errorLine);
+}
+
+bool wxCSVNumericReader::ReadFile(const wxString &file) {
+    wxFFile fp(file, "rb");
+    if (!fp.IsOpened()) return false;
+    wxFileOffset size = fp.Length();
+    if (size < 0) return false;
+    std::vector<char> buf((size_t) size + 1);
+    size_t n = fp.Read(&buf[0], (size_t) size);
+    return Read(&buf[0], n);
+}
+
+bool wxCSVNumericReader::ReadString(const wxString &data) {
+    wxScopedCharBuffer utf8(data.utf8_str());
+    return Read(utf8.data(), utf8.length());
+}
+
+// appends the rows of a parse to the parsed cells of a wxCSVData
+class wxCSVTableHandler : public wxCSVRowHandler {
+    wxCSVData &m_data;
+public:
+    wxCSVTableHandler(wxCSVData &data) : m_data(data) {
+        m_data.m_rowCells.push_back(0);
+    }
+
+    virtual bool OnRow(size_t row, const wxCSVRow &cells) {
+        m_data.m_rowCells.push_back(m_data.m_cellEnds.size());
+        if (cells.Count() > 0) {
+            m_data.m_nrows = row + 1;
+            if (cells.Count() > m_data.m_ncols) m_data.m_ncols = cells.Count();
+        }
+        return true;
+    }
+};
+
 wxCSVData::wxCSVData() {
     m_nrows = m_ncols = 0;
     m_invalidated = false;
     m_errorLine = 0;
     m_sep = ',';
+    m_strictQuoting = false;
 }
 
 wxCSVData::wxCSVData(const wxCSVData &copy) {
@@ -49,7 +628,12 @@ void wxCSVData::Copy(const wxCSVData &copy) {
         m_nrows = copy.m_nrows;
         m_ncols = copy.m_ncols;
         m_cells = copy.m_cells;
+        m_cleared = copy.m_cleared;
+        m_text = copy.m_text;
+        m_cellEnds = copy.m_cellEnds;
+        m_rowCells = copy.m_rowCells;
         m_sep = copy.m_sep;
+        m_strictQuoting = copy.m_strictQuoting;
         m_errorLine = 0;
     }
 }
@@ -63,28 +647,59 @@ void wxCSVData::Set(size_t r, size_t c, const wxString &val) {
     // rows, cols remain valid
     if (r + 1 > m_nrows) m_nrows = r + 1;
     if (c + 1 > m_ncols) m_ncols = c + 1;
-    m_cells[Encode(r, c)] = val;
+    wxUint64 key = Encode(r, c);
+    m_cells[key] = val;
+    if (!m_cleared.empty()) m_cleared.erase(key);
 }
 
-wxString &wxCSVData::operator()(size_t r, size_t c) {
-    // rows, cols remain valid
-    if (r + 1 > m_nrows) m_nrows = r + 1;
-    if (c + 1 > m_ncols) m_ncols = c + 1;
-    return m_cells[Encode(r, c)];
+wxCSVData::Cell wxCSVData::operator()(size_t r, size_t c) {
+    return Cell(*this, r, c);
 }
 
-const wxString &wxCSVData::Get(size_t r, size_t c) const {
-    cell_hash::const_iterator it = m_cells.find(Encode(r, c));
-    if (it != m_cells.end()) return it->second;
-    else return m_emptyStr;
+wxString wxCSVData::Get(size_t r, size_t c) const {
+    wxUint64 key = Encode(r, c);
+    if (!m_cells.empty()) {
+        cell_hash::const_iterator it = m_cells.find(key);
+        if (it != m_cells.end()) return it->second;
+    }
+    if (!m_cleared.empty() && m_cleared.count(key))
+        return wxEmptyString;
+    size_t len;
+    if (const char *p = ParsedText(r, c, &len))
+        return DecodeText(p, len);
+    return wxEmptyString;
 }
 
-const wxString &wxCSVData::operator()(size_t r, size_t c) const {
+wxString wxCSVData::operator()(size_t r, size_t c) const {
     return Get(r, c);
 }
 
+bool wxCSVData::GetNumber(size_t r, size_t c, double *value) const {
+    wxUint64 key = Encode(r, c);
+    if (!m_cells.empty()) {
+        cell_hash::const_iterator it = m_cells.find(key);
+        if (it != m_cells.end()) {
+            wxScopedCharBuffer utf8(it->second.utf8_str());
+            return ParseNumber(utf8.data(), utf8.length(), value);
+        }
+    }
+    if (!m_cleared.empty() && m_cleared.count(key))
+        return false;
+    size_t len;
+    const char *p = ParsedText(r, c, &len);
+    return p != 0 && ParseNumber(p, len, value);
+}
+
 size_t wxCSVData::NumCells() const {
-    return m_cells.size();
+    size_t n = m_cellEnds.size() - m_cleared.size();
+    for (cell_hash::const_iterator it = m_cells.begin();
+         it != m_cells.end();
+         ++it) {
+        size_t r, c;
+        Decode(it->first, &r, &c);
+        if (!IsParsed(r, c)) n++;
+    }
+    return n;
 }
 
 size_t wxCSVData::NumRows() {
@@ -99,16 +714,30 @@ size_t wxCSVData::NumCols() {
 
 void wxCSVData::Clear() {
     m_cells.clear();
+    m_cleared.clear();
+    m_text.clear();
+    m_cellEnds.clear();
+    m_rowCells.clear();
     m_nrows = m_ncols = 0;
     m_invalidated = false;
 }
 
 void wxCSVData::Clear(size_t r, size_t c) {
-    cell_hash::iterator it = m_cells.find(Encode(r, c));
-    if (it != m_cells.end()) {
-        m_cells.erase(it);
+    wxUint64 key = Encode(r, c);
+    bool found = m_cells.erase(key) > 0;
+    if (IsParsed(r, c) && m_cleared.insert(key).second)
+        found = true;
+    if (found)
         m_invalidated = true;
-    }
+}
+
+bool wxCSVData::IsEmpty(size_t r, size_t c) {
+    wxUint64 key = Encode(r, c);
+    cell_hash::const_iterator it = m_cells.find(key);
+    if (it != m_cells.end()) return it->second.IsEmpty();
+    if (m_cleared.count(key)) return true;
+    size_t len;
+    return ParsedText(r, c, &len) == 0 || len == 0;
 }
 
 bool wxCSVData::Read(wxInputStream &in) {
@@ -122,105 +751,20 @@ bool wxCSVData::Read(wxInputStream &in) {
 
     */
     Clear(); // erase the csv data first
-    wxTextInputStream txt(in, "\n", wxConvAuto(wxFONTENCODING_UTF8));
-
-//	wxTextInputStream txt(in);
-
-    m_errorLine = 0;
-    size_t max_row = 0;
-    size_t max_col = 0;
-
-    while (!txt.GetInputStream().Eof()) {
-        wxString buf = txt.ReadLine();
-        size_t cur_col = 0;
-        wxString::iterator it = buf.begin();
-        while (it < buf.end() && *it != wxUniChar('\n') && *it != wxUniChar('\r')) {
-            //	csvcell *cell = new csvcell;
-            //	cell->r = max_row;
-            //	cell->c = cur_col;
-            //	cells.push_back( cell );
-
-            wxString text;
-
-            if (*it == '"') {
-                ++it; // skip the initial quote
-
-                // read a quoted cell
-                while (it < buf.end()) {
-                    if (*it == '"') {
-                        if (it + 1 < buf.end()) {
-                            wxUniChar next = *(++it);
-                            --it;
-                            if (next == '"') {
-                                text += '"';
-                                ++it;
-                                if (it < buf.end()) ++it;
-                            } else {
-                                ++it; // skip current quote
-                                break; // end of quoted cell
-                            }
-                        } else {
-                            ++it;
-                            break;
-                        }
-                    } else {
-                        text += *(it++);
-                    }
-                }
-            } else {
-                // read a normal cell
-                wxUniChar prev = 0;
-                while (it < buf.end() && *it != m_sep && *it != '\n' && *it != '\r') {
-                    if (*it == '"' && prev == '"') {
-                        text += '"';
-                        prev = *it;
-                        ++it;
-                    } else {
-                        text += *it;
-                        prev = *it;
-                        ++it;
-                    }
-                }
-            }
-
-            // store the cell
-            Set(max_row, cur_col, text);
-
-            if (it >= buf.end() || *it == m_sep || *it == '\n' || *it == '\r') {
-                if (it < buf.end()) ++it; // skip over the comma
-                cur_col++;
-                if (cur_col > max_col)
-                    max_col = cur_col;
-            } else {
-                // flag error on the first row with a formatting problem
-                if (m_errorLine == 0)
-                    m_errorLine = -((int) max_row + 1);
-            }
-        }
-
-        max_row++;
-    }
+    wxFileOffset size = in.GetLength();
+    if (size > 0) m_text.reserve((size_t) size);
 
+    wxCSVTableHandler table(*this);
+    wxCSVParser parser(SeparatorByte(m_sep), m_text, m_cellEnds, table, false);
+    ParseStream(in, parser);
+    m_errorLine = parser.GetErrorLine();
     return (0 == m_errorLine);
 }
 
 void wxCSVData::Write(wxOutputStream &out) {
-    wxTextOutputStream txt(out, wxEOL_UNIX);
-    if (m_invalidated) RecalculateDimensions();
-
-    for (size_t r = 0; r < m_nrows; r++) {
-        for (size_t c = 0; c < m_ncols; c++) {
-            wxString cell = Get(r, c);
-            if (cell.Find(wxUniChar(m_sep)) >= 0) {
-                cell.Replace("\"", "\"\"");
-                txt << '"' << cell << '"';
-            } else txt << cell;
-
-            if (c < m_ncols - 1) txt << ((wxChar) m_sep);
-        }
-
-        txt << endl;
-    }
+    wxCSVWriter writer(&out, m_sep);
+    writer.SetStrictQuoting(m_strictQuoting);
+    WriteTo(writer);
 }
 
 bool wxCSVData::ReadFile(const wxString &file) {
@@ -237,15 +781,55 @@ bool wxCSVData::WriteFile(const wxString &file) {
 }
 
 bool wxCSVData::ReadString(const wxString &data) {
-    wxStringInputStream ss(data);
-    return Read(ss);
+    Clear();
+    wxScopedCharBuffer utf8(data.utf8_str());
+    m_text.reserve(utf8.length());
+
+    wxCSVTableHandler table(*this);
+    wxCSVParser parser(SeparatorByte(m_sep), m_text, m_cellEnds, table, false);
+    parser.Feed(utf8.data(), utf8.length());
+    parser.Finish();
+    m_errorLine = parser.GetErrorLine();
+    return (0 == m_errorLine);
 }
 
 wxString wxCSVData::WriteString() {
-    wxString buf;
-    wxStringOutputStream ss(&buf);
-    Write(ss);
-    return buf;
+    wxCSVWriter writer(0, m_sep);
+    writer.SetStrictQuoting(m_strictQuoting);
+    WriteTo(writer);
+    return DecodeText(writer.GetBuffer().data(), writer.GetBuffer().size());
+}
+
+void wxCSVData::WriteTo(wxCSVWriter &writer) {
+    if (m_invalidated) RecalculateDimensions();
+
+    for (size_t r = 0; r < m_nrows; r++) {
+        for (size_t c = 0; c < m_ncols; c++) {
+            wxUint64 key = Encode(r, c);
+            cell_hash::const_iterator it = m_cells.empty() ? m_cells.end() : m_cells.find(key);
+            size_t len = 0;
+            const char *p = 0;
+            if (it != m_cells.end())
+                writer.Text(it->second);
+            else if ((m_cleared.empty() || !m_cleared.count(key)) && (p = ParsedText(r, c, &len)) != 0)
+                writer.Text(p, len);
+            else
+                writer.Text(0, 0);
+        }
+        writer.EndRow();
+    }
+}
+
+bool wxCSVData::IsParsed(size_t r, size_t c) const {
+    return r + 1 < m_rowCells.size() && c < m_rowCells[r + 1] - m_rowCells[r];
+}
+
+const char *wxCSVData::ParsedText(size_t r, size_t c, size_t *len) const {
+    if (!IsParsed(r, c)) return 0;
+    size_t idx = m_rowCells[r] + c;
+    size_t begin = idx > 0 ? m_cellEnds[idx - 1] : 0;
+    *len = m_cellEnds[idx] - begin;
+    return m_text.data() + begin;
 }
 
 wxUint64 wxCSVData::Encode(size_t r, size_t c) const {
@@ -259,6 +843,16 @@ void wxCSVData::Decode(wxUint64 idx, size_t *r, size_t *c) const {
 
 void wxCSVData::RecalculateDimensions() {
     m_nrows = m_ncols = 0;
+    for (size_t r = 0; r + 1 < m_rowCells.size(); r++) {
+        size_t n = m_rowCells[r + 1] - m_rowCells[r];
+        while (n > 0 && !m_cleared.empty() && m_cleared.count(Encode(r, n - 1)))
+            n--;
+        if (n > 0) {
+            m_nrows = r + 1;
+            if (n > m_ncols) m_ncols = n;
+        }
+    }
+
     for (cell_hash::const_iterator it = m_cells.begin();
          it != m_cells.end();
          ++it) {
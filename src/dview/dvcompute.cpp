@@ -0,0 +1,292 @@
+/***********************************************************************************************************************
+*  WEX, Copyright (c) 2008-2017, Alliance for Sustainable Energy, LLC. All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+*  following conditions are met:
+*
+*  (1) Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+*  disclaimer.
+*
+*  (2) Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+*  following disclaimer in the documentation and/or other materials provided with the distribution.
+*
+*  (3) Neither the name of the copyright holder nor the names of any contributors may be used to endorse or promote
+*  products derived from this software without specific prior written permission from the respective party.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+*  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER, THE UNITED STATES GOVERNMENT, OR ANY CONTRIBUTORS BE LIABLE FOR
+*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+*  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+*  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+*  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************************************************************/
+
+#include <algorithm>
+
+#include "wex/dview/dvcompute.h"
+#include "wex/dview/dvtimeseriesdataset.h"
+
+DEFINE_EVENT_TYPE(wxEVT_DVCOMPUTE_DONE)
+
+wxDVComputeJob::wxDVComputeJob(wxDVTimeSeriesDataSet *ds, const wxString &params)
+        : m_dataSet(ds), m_params(params), m_revision(ds->GetRevision()), m_cancelled(false) {
+    // the UI thread may change ds while a worker computes, so the
+    // workers get a private copy of its values
+    m_snapshot = new wxDVArrayDataSet(ds->GetSeriesTitle(), ds->GetDataVector());
+    m_snapshot->SetUnits(ds->GetUnits());
+    m_snapshot->SetTimeStep(ds->GetTimeStep(), false);
+    m_snapshot->SetOffset(ds->GetOffset(), false);
+}
+
+wxDVComputeJob::~wxDVComputeJob() {
+    delete m_snapshot;
+}
+
+wxDVTimeSeriesDataSet *wxDVComputeJob::GetSnapshot() const {
+    return m_snapshot;
+}
+
+void wxDVComputeJob::FreeSnapshot() {
+    delete m_snapshot;
+    m_snapshot = 0;
+}
+
+bool wxDVComputeJob::Matches(wxDVTimeSeriesDataSet *ds, const wxString &params) const {
+    return m_dataSet == ds && m_params == params && m_revision == ds->GetRevision();
+}
+
+bool wxDVComputeJob::IsStale() const {
+    return m_revision != m_dataSet->GetRevision();
+}
+
+class wxDVComputePool::Worker : public wxThread {
+    wxDVComputePool *m_pool;
+public:
+    Worker(wxDVComputePool *pool)
+            : wxThread(wxTHREAD_JOINABLE), m_pool(pool) {
+    }
+
+    virtual void *Entry() {
+        for (;;) {
+            wxDVComputeJob *job = 0;
+            {
+                wxMutexLocker _lock(m_pool->m_lock);
+                while (!m_pool->m_quit && m_pool->m_queue.empty())
+                    m_pool->m_queued.Wait();
+
+                if (m_pool->m_quit)
+                    break;
+
+                job = m_pool->m_queue.front();
+                m_pool->m_queue.pop_front();
+                m_pool->m_running.push_back(job);
+            }
+
+            if (!job->IsCancelled())
+                job->Compute();
+
+            {
+                wxMutexLocker _lock(m_pool->m_lock);
+                m_pool->m_running.erase(std::find(m_pool->m_running.begin(), m_pool->m_running.end(), job));
+                m_pool->m_finished.Broadcast();
+            }
+
+            wxCommandEvent *evt = new wxCommandEvent(wxEVT_DVCOMPUTE_DONE, m_pool->m_id);
+            evt->SetClientData(job);
+            wxQueueEvent(m_pool->m_owner, evt);
+        }
+
+        return 0;
+    }
+};
+
+wxDVComputePool::wxDVComputePool(wxEvtHandler *owner, int id, size_t maxCached)
+        : m_owner(owner), m_id(id), m_maxCached(maxCached),
+          m_queued(m_lock), m_finished(m_lock), m_quit(false) {
+}
+
+wxDVComputePool::~wxDVComputePool() {
+    CancelAll();
+
+    m_lock.Lock();
+    m_quit = true;
+    m_queued.Broadcast();
+    m_lock.Unlock();
+
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        m_workers[i]->Wait();
+        delete m_workers[i];
+    }
+
+    // the done events still queued to the owner refer to these jobs, but
+    // Collect() only accepts pointers that are still in m_pending
+    for (size_t i = 0; i < m_pending.size(); i++)
+        delete m_pending[i];
+
+    for (std::list<wxDVComputeJob *>::iterator it = m_cache.begin(); it != m_cache.end(); ++it)
+        delete *it;
+}
+
+void wxDVComputePool::StartWorkers() {
+    if (!m_workers.empty()) return;
+
+    // leave a core to the UI thread
+    int n = std::max(1, wxThread::GetCPUCount() - 1);
+    for (int i = 0; i < n; i++) {
+        Worker *w = new Worker(this);
+        if (w->Run() != wxTHREAD_NO_ERROR) {
+            delete w;
+            break;
+        }
+        m_workers.push_back(w);
+    }
+}
+
+wxDVComputeJob *wxDVComputePool::Lookup(wxDVTimeSeriesDataSet *ds, const wxString &params) {
+    wxDVComputeJob *found = 0;
+    for (std::list<wxDVComputeJob *>::iterator it = m_cache.begin(); it != m_cache.end();) {
+        if ((*it)->GetDataSet() == ds && (*it)->IsStale()) {
+            // computed from values that changed since
+            delete *it;
+            it = m_cache.erase(it);
+        } else {
+            if (!found && (*it)->Matches(ds, params))
+                found = *it;
+            ++it;
+        }
+    }
+
+    if (found) {
+        m_cache.remove(found);
+        m_cache.push_front(found);
+    }
+
+    return found;
+}
+
+bool wxDVComputePool::IsPending(wxDVTimeSeriesDataSet *ds, const wxString &params) const {
+    for (size_t i = 0; i < m_pending.size(); i++)
+        if (!m_pending[i]->IsCancelled() && m_pending[i]->Matches(ds, params))
+            return true;
+
+    return false;
+}
+
+bool wxDVComputePool::Submit(wxDVComputeJob *job) {
+    if (IsPending(job->GetDataSet(), job->GetParams())) {
+        delete job;
+        return false;
+    }
+
+    StartWorkers();
+
+    if (m_workers.empty()) {
+        // no threads: compute here, the event is delivered as usual
+        m_pending.push_back(job);
+        job->Compute();
+        wxCommandEvent *evt = new wxCommandEvent(wxEVT_DVCOMPUTE_DONE, m_id);
+        evt->SetClientData(job);
+        wxQueueEvent(m_owner, evt);
+        return true;
+    }
+
+    m_pending.push_back(job);
+
+    wxMutexLocker _lock(m_lock);
+    m_queue.push_back(job);
+    m_queued.Signal();
+    return true;
+}
+
+void wxDVComputePool::CancelQueued(wxDVTimeSeriesDataSet *ds) {
+    std::vector<wxDVComputeJob *> dropped;
+    {
+        wxMutexLocker _lock(m_lock);
+        for (std::deque<wxDVComputeJob *>::iterator it = m_queue.begin(); it != m_queue.end();) {
+            if (ds == 0 || (*it)->GetDataSet() == ds) {
+                dropped.push_back(*it);
+                it = m_queue.erase(it);
+            } else
+                ++it;
+        }
+    }
+
+    // jobs that never started have no done event coming: delete them now
+    for (size_t i = 0; i < dropped.size(); i++) {
+        m_pending.erase(std::find(m_pending.begin(), m_pending.end(), dropped[i]));
+        delete dropped[i];
+    }
+
+    for (size_t i = 0; i < m_pending.size(); i++)
+        if (ds == 0 || m_pending[i]->GetDataSet() == ds)
+            m_pending[i]->Cancel();
+}
+
+void wxDVComputePool::Cancel(wxDVTimeSeriesDataSet *ds) {
+    if (ds != 0)
+        CancelQueued(ds);
+}
+
+void wxDVComputePool::CancelAll() {
+    CancelQueued(0);
+}
+
+void wxDVComputePool::WaitForRunning(wxDVTimeSeriesDataSet *ds) {
+    wxMutexLocker _lock(m_lock);
+    for (;;) {
+        bool busy = false;
+        for (size_t i = 0; i < m_running.size(); i++)
+            if (ds == 0 || m_running[i]->GetDataSet() == ds)
+                busy = true;
+
+        if (!busy) break;
+        m_finished.Wait();
+    }
+}
+
+void wxDVComputePool::Invalidate(wxDVTimeSeriesDataSet *ds) {
+    CancelQueued(ds);
+    WaitForRunning(ds);
+
+    for (std::list<wxDVComputeJob *>::iterator it = m_cache.begin(); it != m_cache.end();) {
+        if ((*it)->GetDataSet() == ds) {
+            delete *it;
+            it = m_cache.erase(it);
+        } else
+            ++it;
+    }
+}
+
+void wxDVComputePool::Clear() {
+    CancelQueued(0);
+    WaitForRunning(0);
+
+    for (std::list<wxDVComputeJob *>::iterator it = m_cache.begin(); it != m_cache.end(); ++it)
+        delete *it;
+    m_cache.clear();
+}
+
+wxDVComputeJob *wxDVComputePool::Collect(wxCommandEvent &evt) {
+    wxDVComputeJob *job = static_cast<wxDVComputeJob *>(evt.GetClientData());
+
+    std::vector<wxDVComputeJob *>::iterator it = std::find(m_pending.begin(), m_pending.end(), job);
+    if (it == m_pending.end())
+        return 0;
+
+    m_pending.erase(it);
+
+    if (job->IsCancelled() || job->IsStale()) {
+        delete job;
+        return 0;
+    }
+
+    job->FreeSnapshot();
+    m_cache.push_front(job);
+    while (m_cache.size() > m_maxCached) {
+        delete m_cache.back();
+        m_cache.pop_back();
+    }
+
+    return job;
+}
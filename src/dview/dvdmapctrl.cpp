@@ -23,12 +23,16 @@
 **********************************************************************************************************************/
 
 #include <algorithm>
+#include <limits>
 #include <sstream>
 #include <string>
+#include <string.h>
 
 
 #include <wx/choice.h>
 #include <wx/config.h>
+#include <wx/image.h>
+#include <wx/math.h>
 #include <wx/scrolbar.h>
 #include "wx/srchctrl.h"
 #include <wx/textctrl.h>
@@ -52,17 +56,25 @@ class wxDVDMapPlot : public wxPLPlottable {
 private:
     wxDVTimeSeriesDataSet *m_data;
     wxPLColourMap *m_colourMap;
+    bool m_raster;
 public:
     wxDVDMapPlot() : wxPLPlottable() {
         m_antiAliasing = false; // turn off AA for this plottable
         m_data = 0;
         m_colourMap = 0;
+        m_raster = true;
     }
 
     void SetData(wxDVTimeSeriesDataSet *d) { m_data = d; }
 
     void SetColourMap(wxPLColourMap *c) { m_colourMap = c; }
 
+    // when set, the map is rendered into an image with one pixel per
+    // cell and drawn with a single blit instead of one rect per sample
+    void SetRasterMode(bool b) { m_raster = b; }
+
+    bool GetRasterMode() const { return m_raster; }
+
     virtual wxString GetXDataLabel(wxPLPlot *) const {
         return _("Hours since 00:00 Jan 1");
     }
@@ -84,6 +96,16 @@ public:
         else return m_data->Length();
     }
 
+    // first sample of the day that contains x, so that panning through long
+    // series doesn't scan all of the samples before the visible range
+    size_t FirstSampleOfDay(double x) {
+        const wxDVCalendarIndex &cal = m_data->GetCalendarIndex();
+        long day = cal.DayOf(x);
+        if (day <= 0 || cal.Days() == 0) return 0;
+        if ((size_t) day >= cal.Days()) return m_data->Length();
+        return cal.At(day).first;
+    }
+
     virtual void Draw(wxPLOutputDevice &dc, const wxPLDeviceMapping &map) {
         if (!m_data || !m_colourMap) return;
 
@@ -107,7 +129,15 @@ public:
         double dRectWidth = size.x / (xlen / 24); //Rect width does not depend on data.
         double dRectHeight = size.y / ylen * m_data->GetTimeStep();
 
-        for (size_t i = 0; i < m_data->Length(); i++) {
+        if (m_raster) {
+            DrawRaster(dc, pos, size, wmin, wmax, dRectWidth, dRectHeight);
+            return;
+        }
+
+        std::vector<wxRealPoint> rects;
+        std::vector<double> values;
+
+        for (size_t i = FirstSampleOfDay(wmin.x); i < m_data->Length(); i++) {
             if (m_data->At(i).x < wmin.x)
                 continue;
             if (m_data->At(i).x >=
@@ -129,13 +159,86 @@ public:
             double y = pos.y + size.y - dRectHeight * (worldY / m_data->GetTimeStep() +
                                                        1); //+1 is because we have top corner, not bottom.
 
-            dc.Brush(m_colourMap->ColourForValue(m_data->At(i).y));
+            rects.push_back(wxRealPoint(x, y));
+            values.push_back(m_data->At(i).y);
+        }
+
+        // colour all of the visible cells in one call, and only
+        // change the brush between cells of different colours
+        std::vector<wxUint32> rgba(values.size());
+        if (values.size() > 0)
+            m_colourMap->ColoursForValues(&values[0], values.size(), &rgba[0]);
+
+        for (size_t k = 0; k < rects.size(); k++) {
+            if (k == 0 || rgba[k] != rgba[k - 1])
+                dc.Brush(wxPLColourMap::UnpackColour(rgba[k]));
 
             // increase rect dimensions by about 0.5 point to
             // make sure they render overlapped without white space
             // showing in between
-            dc.Rect(x, y, ceil(dRectWidth + 0.5), ceil(dRectHeight + 0.5)); //+1s cover empty spaces between rects.
+            dc.Rect(rects[k].x, rects[k].y, ceil(dRectWidth + 0.5),
+                    ceil(dRectHeight + 0.5)); //+1s cover empty spaces between rects.
+        }
+    }
+
+    void DrawRaster(wxPLOutputDevice &dc, const wxRealPoint &pos, const wxRealPoint &size,
+                    const wxRealPoint &wmin, const wxRealPoint &wmax,
+                    double dRectWidth, double dRectHeight) {
+        double timeStep = m_data->GetTimeStep();
+        if (timeStep <= 0) return;
+
+        // one image column per day and one row per time step in the visible range
+        int day0 = (int) floor(wmin.x / 24);
+        int ncols = (int) ceil(wmax.x / 24) - day0;
+        int row0 = (int) ceil(wmin.y / timeStep - 1e-9);
+        int row1 = (int) ceil(wmax.y / timeStep - 1e-9) - 1;
+        int nrows = row1 - row0 + 1;
+        if (ncols < 1 || nrows < 1) return;
+
+        // cells without data stay transparent so the hatched background shows through
+        wxImage img(ncols, nrows);
+        img.InitAlpha();
+        unsigned char *rgb = img.GetData();
+        unsigned char *alpha = img.GetAlpha();
+        memset(alpha, 0, (size_t) ncols * nrows);
+
+        // collect the visible cells, then colour them all in one call
+        std::vector<size_t> cells;
+        std::vector<double> values;
+
+        size_t len = m_data->Length();
+        for (size_t i = FirstSampleOfDay(wmin.x); i < len; i++) {
+            wxRealPoint pt(m_data->At(i));
+            if (pt.x < wmin.x) continue;
+            if (pt.x >= wmax.x) break;
+
+            double worldY = fmod(pt.x, 24.0);
+            worldY -= fmod(worldY, timeStep);
+            if (worldY < wmin.y || worldY >= wmax.y) continue;
+
+            int col = int(pt.x) / 24 - day0;
+            int row = row1 - wxRound(worldY / timeStep);
+            if (col < 0 || col >= ncols || row < 0 || row >= nrows) continue;
+
+            cells.push_back((size_t) row * ncols + col);
+            values.push_back(pt.y);
         }
+
+        std::vector<wxUint32> rgba(values.size());
+        if (values.size() > 0)
+            m_colourMap->ColoursForValues(&values[0], values.size(), &rgba[0]);
+
+        for (size_t k = 0; k < cells.size(); k++) {
+            unsigned char *px = rgb + 3 * cells[k];
+            px[0] = (rgba[k] >> 24) & 0xff;
+            px[1] = (rgba[k] >> 16) & 0xff;
+            px[2] = (rgba[k] >> 8) & 0xff;
+            alpha[cells[k]] = 255;
+        }
+
+        double x = pos.x + (day0 - wmin.x / 24) * dRectWidth;
+        double y = pos.y + size.y - dRectHeight * ((row1 * timeStep - wmin.y) / timeStep + 1);
+        dc.Image(img, x, y, ncols * dRectWidth, nrows * dRectHeight);
     }
 
     virtual void DrawInLegend(wxPLOutputDevice &, const wxPLRealRect &) {
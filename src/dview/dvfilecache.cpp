@@ -0,0 +1,427 @@
+/***********************************************************************************************************************
+*  WEX, Copyright (c) 2008-2017, Alliance for Sustainable Energy, LLC. All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+*  following conditions are met:
+*
+*  (1) Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+*  disclaimer.
+*
+*  (2) Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+*  following disclaimer in the documentation and/or other materials provided with the distribution.
+*
+*  (3) Neither the name of the copyright holder nor the names of any contributors may be used to endorse or promote
+*  products derived from this software without specific prior written permission from the respective party.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+*  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER, THE UNITED STATES GOVERNMENT, OR ANY CONTRIBUTORS BE LIABLE FOR
+*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+*  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+*  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+*  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************************************************************/
+
+#include <math.h>
+#include <string.h>
+
+#ifdef __WXMSW__
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <wx/datetime.h>
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <wx/stdpaths.h>
+
+#include "wex/dview/dvfilecache.h"
+
+static const char s_cacheMagic[8] = {'w', 'x', 'D', 'V', 'C', 'a', 'c', 'h'};
+static const wxUint32 s_cacheVersion = 2;
+static const wxUint32 s_cacheByteOrder = 0x01020304;
+
+// Read-only, copy-on-write mapping of a whole file, shared by all the data
+// sets created from it and reference counted so the last one unmaps it.
+class wxDVMappedFile {
+public:
+    static wxDVMappedFile *Open(const wxString &file) {
+        wxDVMappedFile *map = new wxDVMappedFile;
+#ifdef __WXMSW__
+        map->m_file = ::CreateFileW(file.wc_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        LARGE_INTEGER size;
+        if (map->m_file != INVALID_HANDLE_VALUE && ::GetFileSizeEx(map->m_file, &size) && size.QuadPart > 0) {
+            map->m_mapping = ::CreateFileMappingW(map->m_file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+            if (map->m_mapping != NULL) {
+                map->m_data = (char *) ::MapViewOfFile(map->m_mapping, FILE_MAP_COPY, 0, 0, 0);
+                map->m_size = (size_t) size.QuadPart;
+            }
+        }
+#else
+        int fd = ::open(file.fn_str(), O_RDONLY);
+        struct stat st;
+        if (fd >= 0 && ::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *p = ::mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                map->m_data = (char *) p;
+                map->m_size = (size_t) st.st_size;
+            }
+        }
+        if (fd >= 0)
+            ::close(fd); // the mapping stays valid after the descriptor is closed
+#endif
+        if (!map->m_data) {
+            delete map;
+            return 0;
+        }
+        return map;
+    }
+
+    void Ref() { m_refCount++; }
+
+    void Unref() {
+        if (--m_refCount <= 0)
+            delete this;
+    }
+
+    char *GetData() { return m_data; }
+
+    size_t GetSize() const { return m_size; }
+
+private:
+    wxDVMappedFile() : m_data(0), m_size(0), m_refCount(0) {
+#ifdef __WXMSW__
+        m_file = INVALID_HANDLE_VALUE;
+        m_mapping = NULL;
+#endif
+    }
+
+    ~wxDVMappedFile() {
+#ifdef __WXMSW__
+        if (m_data) ::UnmapViewOfFile(m_data);
+        if (m_mapping != NULL) ::CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) ::CloseHandle(m_file);
+#else
+        if (m_data) ::munmap(m_data, m_size);
+#endif
+    }
+
+    char *m_data;
+    size_t m_size;
+    int m_refCount;
+#ifdef __WXMSW__
+    HANDLE m_file;
+    HANDLE m_mapping;
+#endif
+};
+
+// ******** Mapped data set *********** //
+
+wxDVMappedDataSet::wxDVMappedDataSet(wxDVMappedFile *map, const double *values, size_t len,
+                                     const wxString &title, const wxString &units,
+                                     double offset, double start, double timestep)
+        : m_map(map), m_values(const_cast<double *>(values)), m_len(len),
+          m_varLabel(title), m_varUnits(units),
+          m_offset(offset), m_start(start), m_timestep(timestep) {
+    m_map->Ref();
+}
+
+wxDVMappedDataSet::~wxDVMappedDataSet() {
+    m_map->Unref();
+}
+
+wxRealPoint wxDVMappedDataSet::At(size_t i) const {
+    if (i < m_len)
+        return wxRealPoint(m_start + i * m_timestep, m_values[i]);
+    else
+        return wxRealPoint(m_start + i * m_timestep, 0.0);
+}
+
+size_t wxDVMappedDataSet::Length() const {
+    return m_len;
+}
+
+double wxDVMappedDataSet::GetTimeStep() const {
+    return m_timestep;
+}
+
+double wxDVMappedDataSet::GetOffset() const {
+    return m_offset;
+}
+
+wxString wxDVMappedDataSet::GetSeriesTitle() const {
+    return m_varLabel;
+}
+
+wxString wxDVMappedDataSet::GetUnits() const {
+    return m_varUnits;
+}
+
+void wxDVMappedDataSet::DoSetY(size_t i, double y) {
+    if (i < m_len)
+        m_values[i] = y;
+}
+
+// ******** Cache file *********** //
+
+static bool GetSourceKey(const wxString &filename, wxUint64 *size, wxInt64 *mtime) {
+    wxFileName fn(filename);
+    if (!fn.FileExists())
+        return false;
+
+    wxULongLong sz = fn.GetSize();
+    wxDateTime mt = fn.GetModificationTime();
+    if (sz == wxInvalidSize || !mt.IsValid())
+        return false;
+
+    *size = sz.GetValue();
+    *mtime = (wxInt64) mt.GetTicks();
+    return true;
+}
+
+template<typename T>
+static void PutValue(std::vector<char> &buf, const T &val) {
+    const char *p = (const char *) &val;
+    buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+static void PutString(std::vector<char> &buf, const wxString &str) {
+    wxScopedCharBuffer utf8 = str.utf8_str();
+    wxUint32 len = (wxUint32) utf8.length();
+    PutValue(buf, len);
+    buf.insert(buf.end(), utf8.data(), utf8.data() + len);
+}
+
+// bounds-checked reader over the mapped header
+class CacheCursor {
+    const char *m_p, *m_end;
+public:
+    CacheCursor(const char *p, const char *end) : m_p(p), m_end(end) {}
+
+    template<typename T>
+    bool Get(T *val) {
+        if ((size_t) (m_end - m_p) < sizeof(T)) return false;
+        memcpy(val, m_p, sizeof(T));
+        m_p += sizeof(T);
+        return true;
+    }
+
+    bool GetString(wxString *str) {
+        wxUint32 len;
+        if (!Get(&len) || (size_t) (m_end - m_p) < len) return false;
+        *str = wxString::FromUTF8(m_p, len);
+        m_p += len;
+        return true;
+    }
+};
+
+static bool s_cacheEnabled = false;
+static wxString s_cacheDir;
+
+void wxDVFileCache::Enable(bool b) {
+    s_cacheEnabled = b;
+}
+
+bool wxDVFileCache::IsEnabled() {
+    return s_cacheEnabled;
+}
+
+void wxDVFileCache::SetDirectory(const wxString &dir) {
+    s_cacheDir = dir;
+}
+
+wxString wxDVFileCache::GetDirectory() {
+    if (!s_cacheDir.IsEmpty())
+        return s_cacheDir;
+
+    return wxStandardPaths::Get().GetUserDataDir() + wxFILE_SEP_PATH + "dvcache";
+}
+
+wxString wxDVFileCache::GetCacheFileName(const wxString &filename) {
+    // files of the same name in different directories get their own cache
+    wxFileName fn(filename);
+    fn.MakeAbsolute();
+    wxScopedCharBuffer path = fn.GetFullPath().utf8_str();
+    wxUint64 hash = 14695981039346656037ULL; // FNV-1a
+    for (size_t i = 0; i < path.length(); i++) {
+        hash ^= (unsigned char) path.data()[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return GetDirectory() + wxFILE_SEP_PATH + fn.GetFullName()
+           + wxString::Format("-%08x%08x.dvcache", (unsigned) (hash >> 32), (unsigned) (hash & 0xffffffff));
+}
+
+bool wxDVFileCache::Read(const wxString &filename, std::vector<wxDVTimeSeriesDataSet *> &dataSets,
+                         std::vector<size_t> *missing) {
+    if (!s_cacheEnabled)
+        return false;
+
+    wxString cachefile = GetCacheFileName(filename);
+    wxUint64 srcSize;
+    wxInt64 srcTime;
+    if (!wxFileExists(cachefile) || !GetSourceKey(filename, &srcSize, &srcTime))
+        return false;
+
+    wxDVMappedFile *map = wxDVMappedFile::Open(cachefile);
+    if (!map)
+        return false;
+
+    // hold a reference while the data sets are created so that a
+    // failure part way through unmaps the file when they are deleted
+    map->Ref();
+
+    char *base = map->GetData();
+    size_t size = map->GetSize();
+    CacheCursor cur(base, base + size);
+
+    char magic[8];
+    wxUint32 version = 0, byteOrder = 0, ncols = 0;
+    wxUint64 cachedSize = 0;
+    wxInt64 cachedTime = 0;
+    bool ok = cur.Get(&magic)
+              && memcmp(magic, s_cacheMagic, sizeof(magic)) == 0
+              && cur.Get(&version) && version == s_cacheVersion
+              && cur.Get(&byteOrder) && byteOrder == s_cacheByteOrder
+              && cur.Get(&cachedSize) && cachedSize == srcSize
+              && cur.Get(&cachedTime) && cachedTime == srcTime
+              && cur.Get(&ncols);
+
+    std::vector<wxDVTimeSeriesDataSet *> list;
+    std::vector<size_t> missingList;
+    for (wxUint32 i = 0; ok && i < ncols; i++) {
+        wxString title, units, group;
+        double offset, start, timestep;
+        wxUint64 len, nmissing, dataOffset;
+        ok = cur.GetString(&title) && cur.GetString(&units) && cur.GetString(&group)
+             && cur.Get(&offset) && cur.Get(&start) && cur.Get(&timestep)
+             && cur.Get(&len) && cur.Get(&nmissing) && cur.Get(&dataOffset)
+             && dataOffset % sizeof(double) == 0
+             && dataOffset <= size
+             && len <= (size - dataOffset) / sizeof(double);
+        if (ok) {
+            wxDVMappedDataSet *ds = new wxDVMappedDataSet(map, (const double *) (base + dataOffset), (size_t) len,
+                                                          title, units, offset, start, timestep);
+            ds->SetGroupName(group);
+            list.push_back(ds);
+            missingList.push_back((size_t) nmissing);
+        }
+    }
+
+    if (!ok) {
+        for (size_t i = 0; i < list.size(); i++)
+            delete list[i];
+        list.clear();
+    }
+
+    map->Unref();
+
+    dataSets.insert(dataSets.end(), list.begin(), list.end());
+    if (missing != 0)
+        missing->insert(missing->end(), missingList.begin(), missingList.end());
+    return ok;
+}
+
+bool wxDVFileCache::Write(const wxString &filename, const std::vector<wxDVTimeSeriesDataSet *> &dataSets,
+                          const std::vector<size_t> &missing) {
+    if (!s_cacheEnabled)
+        return false;
+
+    wxUint64 srcSize;
+    wxInt64 srcTime;
+    if (!GetSourceKey(filename, &srcSize, &srcTime))
+        return false;
+
+    // only data sets on a uniform time step can be stored, since
+    // the x values are recomputed from the start hour and timestep
+    for (size_t i = 0; i < dataSets.size(); i++) {
+        wxDVTimeSeriesDataSet *ds = dataSets[i];
+        size_t n = ds->Length();
+        if (n > 1) {
+            double start = ds->At(0).x;
+            double ts = ds->GetTimeStep();
+            for (size_t j = 1; j < n; j++)
+                if (fabs(ds->At(j).x - (start + j * ts)) > 1e-6 * (1.0 + fabs(start + j * ts)))
+                    return false;
+        }
+    }
+
+    std::vector<char> header;
+    header.insert(header.end(), s_cacheMagic, s_cacheMagic + sizeof(s_cacheMagic));
+    PutValue(header, s_cacheVersion);
+    PutValue(header, s_cacheByteOrder);
+    PutValue(header, srcSize);
+    PutValue(header, srcTime);
+    PutValue(header, (wxUint32) dataSets.size());
+
+    // the data offsets depend on the header length, so lay out the column
+    // descriptors first with placeholders and patch the offsets afterwards
+    std::vector<size_t> offsetPos;
+    for (size_t i = 0; i < dataSets.size(); i++) {
+        wxDVTimeSeriesDataSet *ds = dataSets[i];
+        PutString(header, ds->GetSeriesTitle());
+        PutString(header, ds->GetUnits());
+        PutString(header, ds->GetGroupName());
+        PutValue(header, ds->GetOffset());
+        PutValue(header, ds->Length() > 0 ? ds->At(0).x : ds->GetOffset());
+        PutValue(header, ds->GetTimeStep());
+        PutValue(header, (wxUint64) ds->Length());
+        PutValue(header, (wxUint64) (i < missing.size() ? missing[i] : 0));
+        offsetPos.push_back(header.size());
+        PutValue(header, (wxUint64) 0);
+    }
+
+    while (header.size() % sizeof(double) != 0)
+        header.push_back(0);
+
+    wxUint64 pos = header.size();
+    for (size_t i = 0; i < dataSets.size(); i++) {
+        memcpy(&header[offsetPos[i]], &pos, sizeof(pos));
+        pos += dataSets[i]->Length() * sizeof(double);
+    }
+
+    // write to a temporary file first so an interrupted write never leaves a valid looking cache
+    wxLogNull nolog; // an unwritable cache directory just means no cache
+    wxString dir = GetDirectory();
+    if (!wxDirExists(dir) && !wxFileName::Mkdir(dir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL))
+        return false;
+
+    wxString cachefile = GetCacheFileName(filename);
+    wxString tmpfile = cachefile + ".tmp";
+    bool ok = false;
+    {
+        wxFFile fp(tmpfile, "wb");
+        if (!fp.IsOpened())
+            return false;
+
+        ok = fp.Write(&header[0], header.size()) == header.size();
+
+        std::vector<double> column;
+        for (size_t i = 0; ok && i < dataSets.size(); i++) {
+            wxDVTimeSeriesDataSet *ds = dataSets[i];
+            size_t n = ds->Length();
+            if (n == 0) continue;
+            column.resize(n);
+            for (size_t j = 0; j < n; j++)
+                column[j] = ds->At(j).y;
+            ok = fp.Write(&column[0], n * sizeof(double)) == n * sizeof(double);
+        }
+
+        ok = fp.Close() && ok;
+    }
+
+    if (ok)
+        ok = wxRenameFile(tmpfile, cachefile, true);
+
+    if (!ok)
+        wxRemoveFile(tmpfile);
+
+    return ok;
+}
@@ -25,9 +25,11 @@
 #include <algorithm>
 #include <iostream>
 #include <map>
+#include <math.h>
 #include <sstream>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <tuple>
 #include <vector>
 
@@ -36,6 +38,7 @@
 #include <wx/filename.h>
 #include <wx/msgdlg.h>
 #include <wx/string.h>
+#include <wx/thread.h>
 #include <wx/time.h>
 #include <wx/tokenzr.h>
 #include <wx/tokenzr.h>
@@ -45,6 +48,7 @@
 
 #include <lk/sqlite3.h>
 
+#include "wex/dview/dvfilecache.h"
 #include "wex/dview/dvfilereader.h"
 #include "wex/dview/dvplotctrl.h"
 #include "wex/dview/dvtimeseriesdataset.h"
@@ -453,6 +457,251 @@ static bool ReadWeatherFileLine(FILE *fp, int type,
         return false;
 }
 
+// atof() on a copy of the field, as the line-based reader did for every value
+static double AtofField(const char *p, const char *end) {
+    char buf[128];
+    size_t n = std::min((size_t) (end - p), sizeof(buf) - 1);
+    memcpy(buf, p, n);
+    buf[n] = '\0';
+    return atof(buf);
+}
+
+// Locale-independent decimal parser used by the block reader in FastRead.
+// Accepts the same prefix syntax as atof() for ordinary numbers ([+-]digits[.digits][(e|E)[+-]digits]).
+// Anything else (nan, inf, hexadecimal, or text that yields 0) is handed to atof() so the values
+// match the line-based reader.  Values with at most 15-16 significant digits and a small exponent
+// are converted exactly (Clinger's fast path); longer mantissas go through long double, which is
+// well within the precision DView displays.
+static const double s_exactPow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static double FastParseDouble(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+
+    const char *start = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = (*p++ == '-');
+
+    unsigned long long mantissa = 0;
+    int ndigits = 0, exp10 = 0;
+    bool anydigits = false;
+
+    while (p < end && *p >= '0' && *p <= '9') {
+        anydigits = true;
+        if (ndigits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa > 0) ndigits++;
+        } else
+            exp10++; // digits beyond what fits in 64 bits only scale the value
+        p++;
+    }
+
+    if (!anydigits || (p < end && (*p == 'x' || *p == 'X')))
+        return AtofField(start, end);
+
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (ndigits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa > 0) ndigits++;
+                exp10--;
+            }
+            p++;
+        }
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        bool expnegative = false;
+        if (q < end && (*q == '-' || *q == '+'))
+            expnegative = (*q++ == '-');
+        if (q < end && *q >= '0' && *q <= '9') {
+            int e = 0;
+            while (q < end && *q >= '0' && *q <= '9') {
+                if (e < 10000) e = e * 10 + (*q - '0');
+                q++;
+            }
+            exp10 += expnegative ? -e : e;
+        }
+    }
+
+    double value;
+    if (mantissa == 0)
+        value = 0.0;
+    else if (mantissa <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22)
+        value = exp10 < 0 ? (double) mantissa / s_exactPow10[-exp10] : (double) mantissa * s_exactPow10[exp10];
+    else
+        value = (double) ((long double) mantissa * powl(10.0L, exp10));
+
+    return negative ? -value : value;
+}
+
+// One contiguous run of complete data rows from the text buffer.  Chunks are first
+// scanned for their row counts, so that the columns can be sized for the whole file,
+// and are then parsed independently of each other straight into the column storage.
+//
+// Rows are split the way the line-based reader split each fgets() buffer: the line
+// ending is part of the last field, so a trailing delimiter or a blank line yields a
+// 0 value rather than a missing one.
+struct FastReadChunk {
+    const char *begin;
+    const char *end;
+    size_t columns;
+    bool commaDelimiters;
+
+    size_t rows;
+    bool foundEOF;
+
+    size_t firstRow;                // row index of this chunk in the columns
+    std::vector<size_t> count;      // values parsed per column, less than rows for short rows
+    std::vector<size_t> missing;
+
+    FastReadChunk(const char *b, const char *e, size_t ncols, bool comma)
+            : begin(b), end(e), columns(ncols), commaDelimiters(comma), rows(0), foundEOF(false), firstRow(0) {
+    }
+
+    static bool IsEOFRow(const char *row, const char *rowend) {
+        return rowend - row >= 3 && row[0] == 'E' && row[1] == 'O' && row[2] == 'F';
+    }
+
+    void CountRows() {
+        const char *row = begin;
+        while (row < end) {
+            const char *eol = (const char *) memchr(row, '\n', end - row);
+            const char *next = eol ? eol + 1 : end;
+            if (IsEOFRow(row, next)) {
+                foundEOF = true;
+                break;
+            }
+            rows++;
+            row = next;
+        }
+    }
+
+    // cols[c] points at the first value to be parsed from the file in column c
+    void Parse(double *const *cols) {
+        count.assign(columns, 0);
+        missing.assign(columns, 0);
+
+        const char *row = begin;
+        for (size_t r = 0; r < rows; r++) {
+            const char *eol = (const char *) memchr(row, '\n', end - row);
+            const char *rowend = eol ? eol + 1 : end;
+
+            const char *p = row;
+            size_t ncol = 0;
+            while (p < rowend && ncol < columns) {
+                while (p < rowend && (*p == ' ' || *p == '\t')) p++; // skip white space
+                const char *field = p;
+                while (p < rowend && *p != ',' && (commaDelimiters || (*p != '\t' && *p != ' ')))
+                    p++;
+
+                double value = 0.0;
+                if (p > field)
+                    value = FastParseDouble(field, p);
+                else
+                    missing[ncol]++; // in event that data is missing, what to do?  For now, set to 0
+
+                cols[ncol][firstRow + count[ncol]++] = value;
+
+                if (p < rowend) p++; // skip the comma or delimiter
+                ncol++;
+            }
+
+            row = rowend;
+        }
+    }
+};
+
+class FastReadChunkThread : public wxThread {
+    FastReadChunk *m_chunk;
+    double *const *m_cols;
+public:
+    // counts the rows of the chunk when no columns are given, otherwise parses it
+    FastReadChunkThread(FastReadChunk *chunk, double *const *cols)
+            : wxThread(wxTHREAD_JOINABLE), m_chunk(chunk), m_cols(cols) {
+    }
+
+    virtual void *Entry() {
+        if (m_cols) m_chunk->Parse(m_cols);
+        else m_chunk->CountRows();
+        return 0;
+    }
+};
+
+// Runs the row count or parse pass over the chunks, the calling thread taking the first one
+static void RunDataChunks(std::vector<FastReadChunk> &chunks, size_t nchunks, double *const *cols) {
+    std::vector<FastReadChunkThread *> threads;
+    for (size_t i = 1; i < nchunks; i++) {
+        FastReadChunkThread *t = new FastReadChunkThread(&chunks[i], cols);
+        if (t->Run() == wxTHREAD_NO_ERROR)
+            threads.push_back(t);
+        else {
+            delete t;
+            if (cols) chunks[i].Parse(cols);
+            else chunks[i].CountRows();
+        }
+    }
+
+    if (nchunks > 0) {
+        if (cols) chunks[0].Parse(cols);
+        else chunks[0].CountRows();
+    }
+
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i]->Wait();
+        delete threads[i];
+    }
+}
+
+// Splits the data block on row boundaries, one chunk per core for large blocks.
+static void SplitDataBlock(const char *data, size_t len, size_t columns, bool commaDelimiters,
+                           std::vector<FastReadChunk> &chunks) {
+    static const size_t min_chunk_bytes = 1048576;
+
+    size_t nchunks = 1;
+    if (len > min_chunk_bytes) {
+        int ncpu = wxThread::GetCPUCount();
+        nchunks = std::max(1, std::min(ncpu, (int) (len / min_chunk_bytes)));
+    }
+
+    const char *end = data + len;
+    const char *p = data;
+    for (size_t i = 0; i < nchunks && p < end; i++) {
+        const char *chunkend = (i == nchunks - 1) ? end : data + (len * (i + 1)) / nchunks;
+        if (chunkend < p) chunkend = p;
+        if (chunkend < end) {
+            const char *nl = (const char *) memchr(chunkend, '\n', end - chunkend);
+            chunkend = nl ? nl + 1 : end;
+        }
+        chunks.push_back(FastReadChunk(p, chunkend, columns, commaDelimiters));
+        p = chunkend;
+    }
+}
+
+// tells the user which columns had missing values that were read as 0
+static void ShowMissingData(const std::vector<wxDVTimeSeriesDataSet *> &dataSets,
+                            const std::vector<size_t> &missing, wxWindow *parent) {
+    wxString missingCols;
+    for (size_t c = 0; c < dataSets.size() && c < missing.size(); c++)
+        if (missing[c] > 0)
+            missingCols += wxString::Format(wxT("\n'%s' (%d values)"), dataSets[c]->GetSeriesTitle(),
+                                            (int) missing[c]);
+
+    if (!missingCols.IsEmpty()) {
+        wxString message;
+        message.Printf(
+                wxT("The following columns contain missing data:%s\n\nReplacing missing data with 0's, please correct your file"),
+                missingCols);
+        wxShowTextMessageDialog(message, wxEmptyString, parent, wxSize(400, 150));
+    }
+}
+
 bool
 wxDVFileReader::FastRead(wxDVPlotCtrl *plotWin, const wxString &filename, int prealloc_data, int prealloc_lnchars) {
     wxString fExtension = filename.Right(3);
@@ -467,6 +716,25 @@ wxDVFileReader::FastRead(wxDVPlotCtrl *plotWin, const wxString &filename, int pr
     wxStopWatch sw;
     sw.Start();
 
+    // Reuse the binary cache from an earlier parse if the file has not changed since.
+    std::vector<wxDVTimeSeriesDataSet *> cachedSets;
+    std::vector<size_t> cachedMissing;
+    if (wxDVFileCache::Read(filename, cachedSets, &cachedMissing)) {
+        ShowMissingData(cachedSets, cachedMissing, plotWin);
+
+        plotWin->Freeze();
+        for (size_t i = 0; i < cachedSets.size(); i++)
+            plotWin->AddDataSet(cachedSets[i], (i == cachedSets.size() - 1) /* update_ui ? */);
+        plotWin->GetStatisticsTable()->RebuildDataViewCtrl();    //We must do this only after all datasets have been added
+        plotWin->Thaw();
+
+        plotWin->ReadState(filename.ToStdString());
+
+        wxLogDebug("wxDVFileReader::FastRead [ncol=%d] mapped from cache %s = %d msec\n", (int) cachedSets.size(),
+                   wxDVFileCache::GetCacheFileName(filename), (int) sw.Time());
+        return true;
+    }
+
     FILE *inFile = fopen(filename.c_str(), "r"); //r is for read mode.
     if (!inFile)
         return false;
@@ -476,7 +744,6 @@ wxDVFileReader::FastRead(wxDVPlotCtrl *plotWin, const wxString &filename, int pr
 
     std::vector<wxDVArrayDataSet *> dataSets;
     std::vector<wxString> groupNames;
-    std::vector<double> timeCounters;
     int columns = 0;
     bool CommaDelimiters = false;
 
@@ -509,10 +776,11 @@ wxDVFileReader::FastRead(wxDVPlotCtrl *plotWin, const wxString &filename, int pr
                && tkz_tStep.HasMoreTokens()
                && tkz_units.HasMoreTokens()) {
             wxDVArrayDataSet *ds = new wxDVArrayDataSet();
+            ds->SetStorage(wxDVArrayDataSet::STORE_Y_DOUBLE);
             wxString titleToken = tkz_titles.GetNextToken();
             ds->SetSeriesTitle(titleToken.AfterLast('|'));
             tkz_offsets.GetNextToken().ToDouble(&entry);
-            timeCounters.push_back(entry);
+            ds->SetOffset(entry, false);
             tkz_tStep.GetNextToken().ToDouble(&entry);
             ds->SetTimeStep(entry);
             ds->SetUnits(tkz_units.GetNextToken());
@@ -564,17 +832,17 @@ wxDVFileReader::FastRead(wxDVPlotCtrl *plotWin, const wxString &filename, int pr
         double entry;
 
         wxDVArrayDataSet *ds = new wxDVArrayDataSet();
+        ds->SetStorage(wxDVArrayDataSet::STORE_Y_DOUBLE);
+        ds->SetOffset(0.5, false);
         dataSets.push_back(ds);
         wxString title = tkz_names.GetNextToken();
-        timeCounters.push_back(0.5);
         if (IsNumeric(title) || IsDate(title)) {
             firstRowContainsTitles = false;
             isEnergyPlusOutput = false;
             ds->SetSeriesTitle(wxT("-no name-"));
             groupNames.push_back("");
             title.ToDouble(&entry);
-            ds->Append(wxRealPoint(timeCounters[0], entry));
-            timeCounters[0] += 1.0;
+            ds->AppendY(entry);
         } else {
             ds->SetSeriesTitle(title.AfterLast('|'));
             groupNames.push_back(title.BeforeLast('|'));
@@ -590,8 +858,7 @@ wxDVFileReader::FastRead(wxDVPlotCtrl *plotWin, const wxString &filename, int pr
                 secondRowContainsUnits = false;
                 ds->SetUnits(wxT("-no units-"));
                 units_tmp.ToDouble(&entry);
-                ds->Append(wxRealPoint(timeCounters[0], entry));
-                timeCounters[0] += 1.0;
+                ds->AppendY(entry);
             } else {
                 isEnergyPlusOutput = false;
                 ds->SetUnits(units_tmp);
@@ -602,8 +869,9 @@ wxDVFileReader::FastRead(wxDVPlotCtrl *plotWin, const wxString &filename, int pr
 
         columns = 1;
         while (columns < count_names) {
-            timeCounters.push_back(0.5);
-            wxDVArrayDataSet *ds_tmp = new wxDVArrayDataSet();
+                wxDVArrayDataSet *ds_tmp = new wxDVArrayDataSet();
+            ds_tmp->SetStorage(wxDVArrayDataSet::STORE_Y_DOUBLE);
+            ds_tmp->SetOffset(0.5, false);
             wxString titleToken = tkz_names.GetNextToken();
             if (isEnergyPlusOutput) {
                 wxString tt = titleToken.AfterLast('|');
@@ -623,8 +891,7 @@ wxDVFileReader::FastRead(wxDVPlotCtrl *plotWin, const wxString &filename, int pr
             else {
                 titleToken.ToDouble(&entry);
                 ds_tmp->SetSeriesTitle(wxT("-no name-"));
-                ds_tmp->Append(wxRealPoint(timeCounters[columns], entry));
-                timeCounters[columns] += 1.0;
+                ds_tmp->AppendY(entry);
             }
 
             if (secondRowContainsUnits) {
@@ -636,8 +903,7 @@ wxDVFileReader::FastRead(wxDVPlotCtrl *plotWin, const wxString &filename, int pr
             } else if (!isEnergyPlusOutput) {
                 tkz_units.GetNextToken().ToDouble(&entry);
                 ds_tmp->SetUnits(wxT("-no units-"));
-                ds_tmp->Append(wxRealPoint(timeCounters[columns], entry));
-                timeCounters[columns] += 1.0;
+                ds_tmp->AppendY(entry);
             }
             ds_tmp->SetTimeStep(1.0, false);
             dataSets.push_back(ds_tmp);
@@ -646,72 +912,118 @@ wxDVFileReader::FastRead(wxDVPlotCtrl *plotWin, const wxString &filename, int pr
         }
     }
 
-    if (prealloc_data > 0) {
-        // preallocate data
-        for (size_t i = 0; i < dataSets.size(); i++)
-            dataSets[i]->Alloc(prealloc_data);
+    // Read the remaining data rows as one block and parse it in parallel
+    // chunks, rather than line by line through the FILE stream.
+    static const size_t read_block_bytes = 16 * 1048576;
+    std::vector<char> block;
+    size_t nbytes = 0;
+
+    // the remaining file size bounds the text read, so the block is allocated once
+    long datapos = ftell(inFile);
+    if (datapos >= 0 && fseek(inFile, 0, SEEK_END) == 0) {
+        long fileend = ftell(inFile);
+        fseek(inFile, datapos, SEEK_SET);
+        if (fileend > datapos)
+            block.reserve((size_t) (fileend - datapos) + read_block_bytes);
     }
 
-    int line = 0, ncol, ndbuf;
-    char dblbuf[128], *p, *bp; //Position, buffer position
-    char *buf = new char[lnchars];
-    char *ret = NULL;
-    while (true) {
-        ret = fgets(buf, lnchars - 1, inFile);
-        if (ret == NULL)
-            break; //EOF
-        if (buf[0] == 'E' && buf[1] == 'O' && buf[2] == 'F')
+    while (!feof(inFile) && !ferror(inFile)) {
+        block.resize(nbytes + read_block_bytes);
+        size_t nread = fread(&block[nbytes], 1, read_block_bytes, inFile);
+        if (nread == 0)
             break;
+        nbytes += nread;
+    }
 
-        p = buf;
-        ncol = 0;
-        while (*p && ncol < columns) {
-            bp = dblbuf;
-            ndbuf = 0;
-            while (*p && (*p == ' ' || *p == '\t')) p++; // skip white space
-            while (*p && *p != ',' && (CommaDelimiters || (*p != '\t' && *p != ' ')) && ++ndbuf < 127)
-                *bp++ = *p++; // read in number
-            *bp = '\0'; // terminate string
-            if (strlen(dblbuf) > 0) {
-                dataSets[ncol]->Append(
-                        wxRealPoint(timeCounters[ncol], atof(dblbuf))); // convert number and add data point.
-                timeCounters[ncol] += dataSets[ncol]->GetTimeStep();
-            }
-                // in event that data is missing, what to do?  For now, set to 0
-            else {
-                wxString message;
-                message.Printf(
-                        wxT("Column '%s' contains missing data!\nReplacing missing data with 0's, please correct your file"),
-                        dataSets[ncol]->GetSeriesTitle());
-                wxShowTextMessageDialog(message, wxEmptyString, plotWin, wxSize(400, 150));
-                dataSets[ncol]->Append(wxRealPoint(timeCounters[ncol], 0));
-                timeCounters[ncol] += dataSets[ncol]->GetTimeStep();
-            }
-            if (*p) p++; // skip the comma or delimiter
-            ncol++;
+    fclose(inFile);
+
+    wxStopWatch swparse;
+    swparse.Start();
+
+    std::vector<FastReadChunk> chunks;
+    if (nbytes > 0 && columns > 0)
+        SplitDataBlock(&block[0], nbytes, (size_t) columns, CommaDelimiters, chunks);
+
+    // count the rows up to the first EOF marker
+    RunDataChunks(chunks, chunks.size(), 0);
+    size_t nused = 0, nrows = 0;
+    while (nused < chunks.size()) {
+        chunks[nused].firstRow = nrows;
+        nrows += chunks[nused].rows;
+        if (chunks[nused++].foundEOF) break;
+    }
+    int line = (int) nrows;
+
+    // size the columns for every row and parse the chunks directly into them
+    std::vector<size_t> colStart(columns);
+    std::vector<double *> cols(columns);
+    for (int c = 0; c < columns; c++) {
+        colStart[c] = dataSets[c]->Length();
+        size_t n = colStart[c] + nrows;
+        dataSets[c]->Alloc(prealloc_data > 0 && (size_t) prealloc_data > n ? (size_t) prealloc_data : n);
+
+        // the columns are filled in place, which only the STORE_Y_DOUBLE storage allows
+        double *y = dataSets[c]->ResizeY(n);
+        wxASSERT_MSG(y != 0, wxT("FastRead data sets must use STORE_Y_DOUBLE"));
+        if (y == 0) {
+            for (size_t i = 0; i < dataSets.size(); i++)
+                delete dataSets[i];
+            return false;
         }
-        line++;
+        cols[c] = y + colStart[c]; // x values are implicit in the compact storage
     }
 
-    delete[] buf;
+    if (nrows > 0)
+        RunDataChunks(chunks, nused, &cols[0]);
+
+    // rows with fewer values than columns leave gaps at the end of their chunk
+    // in the columns concerned; close them up so later values follow on
+    std::vector<size_t> colMissing(columns, 0);
+    for (int c = 0; c < columns; c++) {
+        if (nrows == 0) continue;
+        size_t n = 0;
+        for (size_t k = 0; k < nused; k++) {
+            const FastReadChunk &ch = chunks[k];
+            if (n != ch.firstRow && ch.count[c] > 0)
+                memmove(cols[c] + n, cols[c] + ch.firstRow, ch.count[c] * sizeof(double));
+            n += ch.count[c];
+            colMissing[c] += ch.missing[c];
+        }
+        if (n < nrows)
+            dataSets[c]->ResizeY(colStart[c] + n);
+    }
 
-    fclose(inFile);
+    long parse_ms = swparse.Time();
+    size_t nchunks = chunks.size();
+    chunks.clear();
+    std::vector<char>().swap(block);
+
+    std::vector<wxDVTimeSeriesDataSet *> cacheSets(dataSets.begin(), dataSets.end());
+    ShowMissingData(cacheSets, colMissing, plotWin);
 
     //Done reading data; add it to the plotCtrl.
 
-    plotWin->Freeze();
-    for (size_t i = 0; i < dataSets.size(); i++) {
+    for (size_t i = 0; i < dataSets.size(); i++)
         dataSets[i]->SetGroupName(groupNames[i].size() > 1 ? groupNames[i] : wxFileNameFromPath(filename));
+
+    // small files parse quickly enough that a cache isn't worth the disk space
+    static const size_t min_cache_bytes = 4 * 1048576;
+    if (nbytes >= min_cache_bytes && wxDVFileCache::IsEnabled())
+        wxDVFileCache::Write(filename, cacheSets, colMissing);
+
+    plotWin->Freeze();
+    for (size_t i = 0; i < dataSets.size(); i++)
         plotWin->AddDataSet(dataSets[i], (i == dataSets.size() - 1) /* update_ui ? */);
-    }
     plotWin->GetStatisticsTable()->RebuildDataViewCtrl();    //We must do this only after all datasets have been added
     plotWin->Thaw();
 
     plotWin->ReadState(filename.ToStdString());
 
     wxLogStatus("Read %i lines of data points.\n", line);
-    wxLogDebug("wxDVFileReader::FastRead [ncol=%d nalloc = %d lnchars=%d] = %d msec\n", columns, prealloc_data, lnchars,
-               (int) sw.Time());
+    long total_ms = sw.Time();
+    wxLogDebug("wxDVFileReader::FastRead [ncol=%d nalloc = %d lnchars=%d] = %d msec, parse %d msec (%.1lf MB/s), nthreads=%d\n",
+               columns, prealloc_data, lnchars, (int) total_ms, (int) parse_ms,
+               parse_ms > 0 ? nbytes / 1048576.0 / (0.001 * parse_ms) : 0.0, (int) nchunks);
     return true;
 }
 
@@ -854,8 +1166,12 @@ bool wxDVFileReader::ReadWeatherFile(wxDVPlotCtrl *plotWin, const wxString &file
     ds->SetUnits("cm");
     dataSets.push_back(ds);
 
-    for (size_t i = 0; i < dataSets.size(); i++)
+    for (size_t i = 0; i < dataSets.size(); i++) {
+        dataSets.at(i)->SetStorage(wxDVArrayDataSet::STORE_Y_DOUBLE);
+        dataSets.at(i)->SetOffset(0.5, false); //Values are at the middle of each hour.
         dataSets.at(i)->SetTimeStep(1.0); //All have 1 hr tstep.
+        dataSets.at(i)->Alloc(8760);
+    }
 
     //int year, month, day, hour;
     //double gh, dn, df, wind, drytemp, dewtemp, relhum, pressure, winddir, snowdepth;
@@ -1178,7 +1494,6 @@ bool wxDVFileReader::ReadSQLFile(wxDVPlotCtrl *plotWin, const wxString &filename
         // Transfer from dataDictionary into DView
         std::vector<wxDVArrayDataSet *> dataSets;
         std::vector<wxString> groupNames;
-        std::vector<double> timeCounters;
 
         for (size_t i = 0; i < dataDictionary.size(); i++) {
             double timeStep = 1;
@@ -1213,21 +1528,17 @@ bool wxDVFileReader::ReadSQLFile(wxDVPlotCtrl *plotWin, const wxString &filename
                 assert(false);
             }
 
+            // the first value is reported at the end of the first timestep
             wxDVArrayDataSet *ds = new wxDVArrayDataSet();
+            ds->SetStorage(wxDVArrayDataSet::STORE_Y_DOUBLE);
             ds->SetSeriesTitle(dataDictionary[i].keyValue);
+            ds->SetOffset(timeStep, false);
             ds->SetTimeStep(timeStep);
             ds->SetUnits(dataDictionary[i].units);
+            ds->Copy(dataDictionary[i].stdValues);
             dataSets.push_back(ds);
 
-            timeCounters.push_back(timeStep);
-
             groupNames.push_back(dataDictionary[i].name);
-
-            for (size_t j = 0; j < dataDictionary[i].stdValues.size(); j++) {
-                dataSets[i]->Append(wxRealPoint(timeCounters[i],
-                                                dataDictionary[i].stdValues[j])); // convert number and add data point.
-                timeCounters[i] += dataSets[i]->GetTimeStep(); // convert number and add data point.
-            }
         }
 
         // Done reading data; add it to the plotCtrl.
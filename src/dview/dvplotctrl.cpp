@@ -80,6 +80,10 @@ wxDVPlotCtrl::~wxDVPlotCtrl() {
         WriteState(m_filename);
     }
 
+    // stop the background computations that read the data sets
+    m_profilePlots->RemoveAllDataSets();
+    m_pnCdf->RemoveAllDataSets();
+
     for (size_t i = 0; i < m_dataSets.size(); i++)
         delete m_dataSets[i];
 }
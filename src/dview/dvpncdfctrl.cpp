@@ -27,7 +27,6 @@
 #include <sstream>
 
 #include <wx/wx.h>
-#include <wx/busyinfo.h>
 #include "wx/srchctrl.h"
 #include <wx/tokenzr.h>
 #include <wx/config.h>
@@ -36,6 +35,7 @@
 #include "wex/plot/plhistplot.h"
 #include "wex/plot/pllineplot.h"
 
+#include "wex/dview/dvcompute.h"
 #include "wex/dview/dvselectionlist.h"
 #include "wex/dview/dvpncdfctrl.h"
 
@@ -44,7 +44,22 @@ enum {
     wxID_BIN_COMBO,
     wxID_NORMALIZE_CHOICE,
     wxID_Y_MAX_TB,
-    wxID_PLOT_TYPE
+    wxID_PLOT_TYPE,
+    ID_COMPUTE
+};
+
+class wxDVCdfJob : public wxDVComputeJob {
+public:
+    // serves the CDF with or without zeros
+    wxPLDistribution dist;
+
+    wxDVCdfJob(wxDVTimeSeriesDataSet *d)
+            : wxDVComputeJob(d, "distribution") {
+    }
+
+    virtual void Compute() {
+        wxDVPnCdfCtrl::BuildDistribution(*GetSnapshot(), dist, this);
+    }
 };
 
 BEGIN_EVENT_TABLE(wxDVPnCdfCtrl, wxPanel)
@@ -56,12 +71,14 @@ BEGIN_EVENT_TABLE(wxDVPnCdfCtrl, wxPanel)
                 EVT_CHECKBOX(wxID_ANY, wxDVPnCdfCtrl::OnShowZerosClick)
                 EVT_CHOICE(wxID_PLOT_TYPE, wxDVPnCdfCtrl::OnPlotTypeSelection)
                 EVT_TEXT(wxID_ANY, wxDVPnCdfCtrl::OnSearch)
+                EVT_DVCOMPUTE_DONE(ID_COMPUTE, wxDVPnCdfCtrl::OnComputeDone)
 END_EVENT_TABLE()
 
 wxDVPnCdfCtrl::wxDVPnCdfCtrl(wxWindow *parent, wxWindowID id, const wxPoint &pos,
                              const wxSize &size, long style, const wxString &name)
         : wxPanel(parent, id, pos, size, style, name) {
     m_srchCtrl = NULL;
+    m_compute = new wxDVComputePool(this, ID_COMPUTE);
     m_plotSurface = new wxPLPlotCtrl(this, wxID_ANY);
     m_plotSurface->SetBackgroundColour(*wxWHITE);
     m_pdfPlot = new wxPLHistogramPlot();
@@ -139,8 +156,7 @@ wxDVPnCdfCtrl::wxDVPnCdfCtrl(wxWindow *parent, wxWindowID id, const wxPoint &pos
 }
 
 wxDVPnCdfCtrl::~wxDVPnCdfCtrl() {
-    for (size_t i = 0; i < m_cdfPlotData.size(); i++)
-        delete m_cdfPlotData[i];
+    delete m_compute;
 }
 
 void wxDVPnCdfCtrl::ReadState(std::string filename) {
@@ -253,9 +269,6 @@ void wxDVPnCdfCtrl::AddDataSet(wxDVTimeSeriesDataSet *d, bool update_ui) {
     m_dataSets.push_back(d);
     m_selector->Append(d->GetTitleWithUnits(), d->GetGroupName());
 
-    //Add new plot data array, but leave it empty until we use it.  We'll fill it with sorted values then.
-    m_cdfPlotData.push_back(new std::vector<wxRealPoint>());
-
     if (update_ui)
         Layout();
 }
@@ -279,8 +292,7 @@ void wxDVPnCdfCtrl::RemoveDataSet(wxDVTimeSeriesDataSet *d) {
     if (index < 0) return;
 
     m_dataSets.erase(m_dataSets.begin() + index);
-    delete m_cdfPlotData[index];
-    m_cdfPlotData.erase(m_cdfPlotData.begin() + index);
+    m_compute->Invalidate(d);
 
     m_selector->RemoveAt(index);
 
@@ -291,10 +303,7 @@ void wxDVPnCdfCtrl::RemoveAllDataSets() {
     ChangePlotDataTo(NULL);
 
     m_dataSets.clear();
-
-    for (size_t i = 0; i < m_cdfPlotData.size(); i++)
-        delete m_cdfPlotData[i];
-    m_cdfPlotData.clear();
+    m_compute->Clear();
     m_selector->RemoveAll();
 
     InvalidatePlot();
@@ -393,14 +402,13 @@ void wxDVPnCdfCtrl::RebuildPlotSurface(double maxYPercent) {
     m_plotSurface->GetXAxis1()->SetLabel(label);
 }
 
-void wxDVPnCdfCtrl::ChangePlotDataTo(wxDVTimeSeriesDataSet *d, bool forceDataRefresh) {
+void wxDVPnCdfCtrl::ChangePlotDataTo(wxDVTimeSeriesDataSet *d, bool WXUNUSED(forceDataRefresh)) {
     if (d) {
         if (m_binsCombo->GetSelection() == 0) //Sturge's
             m_pdfPlot->SetNumberOfBins(m_pdfPlot->GetSturgesBinsFor(d->Length()));
         else if (m_binsCombo->GetSelection() == 1) //SQRT
             m_pdfPlot->SetNumberOfBins(m_pdfPlot->GetSqrtBinsFor(d->Length()));
 
-        m_pdfPlot->SetData(d->GetDataVector()); //inefficient?
         m_pdfPlot->SetLabel(d->GetSeriesTitle());
         m_pdfPlot->SetXDataLabel(m_plotSurface->GetXAxis1()->GetLabel());
         m_pdfPlot->SetYDataLabel(d->GetSeriesTitle());
@@ -417,18 +425,13 @@ void wxDVPnCdfCtrl::ChangePlotDataTo(wxDVTimeSeriesDataSet *d, bool forceDataRef
             index = i;
 
     if (index < 0) {
+        m_pdfPlot->SetData(std::vector<wxRealPoint>());
         m_cdfPlot->SetData(std::vector<wxRealPoint>()); //clear the data
         m_cdfPlot->SetLabel(wxEmptyString);
         m_cdfPlot->SetXDataLabel(wxEmptyString);
         m_cdfPlot->SetYDataLabel(wxEmptyString);
     } else {
-        // Read Cdf Data (requires sort) if not already sorted.
-        if (m_cdfPlotData[index]->size() == 0 || forceDataRefresh) {
-            if (forceDataRefresh) { m_cdfPlotData[index]->clear(); }
-            ReadCdfFrom(*d, m_cdfPlotData[index]);
-        }
-
-        m_cdfPlot->SetData(*m_cdfPlotData[index]);
+        UpdateDistributionPlots(d);
         m_cdfPlot->SetLabel(d->GetSeriesTitle() + " " + _("Percentile"));
         m_cdfPlot->SetXDataLabel(m_plotSurface->GetXAxis1()->GetLabel());
         m_cdfPlot->SetYDataLabel(m_cdfPlot->GetLabel());
@@ -438,34 +441,54 @@ void wxDVPnCdfCtrl::ChangePlotDataTo(wxDVTimeSeriesDataSet *d, bool forceDataRef
         RebuildPlotSurface(m_pdfPlot->GetNiceYMax());
 }
 
-void wxDVPnCdfCtrl::ReadCdfFrom(wxDVTimeSeriesDataSet &d, std::vector<wxRealPoint> *cdfArray) {
-    // This does not use bins.  It is an empirical CDF.  See wikipedia for empirical CDF explanation.
-    // This can take a long time because of sorting.
-
-    wxBeginBusyCursor();
-    wxBusyInfo wait("Please wait, calculating CDF...");
+// both the PDF histogram and the CDF come from the distribution summary built on the compute pool
+void wxDVPnCdfCtrl::UpdateDistributionPlots(wxDVTimeSeriesDataSet *d) {
+    wxString params = "distribution";
 
-    std::vector<double> sortedValues;
+    if (wxDVCdfJob *done = static_cast<wxDVCdfJob *>(m_compute->Lookup(d, params))) {
+        ShowDistribution(done->dist);
+        return;
+    }
 
-    for (size_t i = 0; i < d.Length(); i++) {
-        if (!m_cdfPlot->GetIgnoreZeros() || d.At(i).y != 0.0) { sortedValues.push_back(d.At(i).y); }
+    // the plots stay empty until the summary is built in the background
+    m_pdfPlot->SetData(std::vector<wxRealPoint>());
+    m_cdfPlot->SetData(std::vector<wxRealPoint>());
+    if (!m_compute->IsPending(d, params)) {
+        m_compute->CancelAll();
+        m_compute->Submit(new wxDVCdfJob(d));
     }
+}
 
-    if (sortedValues.size() > 0) {
-        std::sort(sortedValues.begin(), sortedValues.end());
+void wxDVPnCdfCtrl::OnComputeDone(wxCommandEvent &e) {
+    wxDVCdfJob *job = static_cast<wxDVCdfJob *>(m_compute->Collect(e));
+    if (!job) return;
 
-        //double dataMin = sortedValues[0];
-        //double dataMax = sortedValues[sortedValues.size() - 1];
-    }
+    if (m_selectedDataSetIndex < 0 || m_selectedDataSetIndex >= static_cast<int>(m_dataSets.size())
+        || job->GetDataSet() != m_dataSets[m_selectedDataSetIndex])
+        return;
 
-    cdfArray->reserve(sortedValues.size());
-    for (size_t i = 0; i < sortedValues.size(); i++) {
-        double x = sortedValues[i];
-        double percent = 100 * double(i) / double(sortedValues.size() - 1);
-        cdfArray->push_back(wxRealPoint(x, percent));
-    }
+    ShowDistribution(job->dist);
+    RebuildPlotSurface(m_pdfPlot->GetNiceYMax());
+    InvalidatePlot();
+}
+
+void wxDVPnCdfCtrl::ShowDistribution(const wxPLDistribution &dist) {
+    m_pdfPlot->SetDistribution(dist);
+
+    std::vector<wxRealPoint> cdf;
+    dist.Cdf(m_cdfPlot->GetIgnoreZeros(), cdf);
+    m_cdfPlot->SetData(cdf);
+}
 
-    wxEndBusyCursor();
+void wxDVPnCdfCtrl::BuildDistribution(wxDVTimeSeriesDataSet &d, wxPLDistribution &dist, wxDVComputeJob *job) {
+    // This does not use bins.  It is an empirical CDF.  See wikipedia for empirical CDF explanation.
+    // Small data sets are sorted, larger ones are summarized in a fine histogram in one pass.
+    dist.Clear();
+    for (size_t i = 0; i < d.Length(); i++) {
+        if (job && i % 65536 == 0 && job->IsCancelled()) return;
+        dist.Add(d.At(i).y);
+    }
+    dist.Finish();
 }
 
 void wxDVPnCdfCtrl::UpdateYAxisLabel() {
@@ -575,10 +598,8 @@ void wxDVPnCdfCtrl::ShowZerosClick() {
     m_pdfPlot->SetIgnoreZeros(ignoreZeros);
     m_cdfPlot->SetIgnoreZeros(ignoreZeros);
 
-    if (m_selectedDataSetIndex > -1 && m_selectedDataSetIndex < static_cast<int>(m_cdfPlotData.size())) {
-        m_cdfPlotData[m_selectedDataSetIndex]->clear();
-        ReadCdfFrom(*m_dataSets[m_selectedDataSetIndex], m_cdfPlotData[m_selectedDataSetIndex]);
-        m_cdfPlot->SetData(*m_cdfPlotData[m_selectedDataSetIndex]);
+    if (m_selectedDataSetIndex > -1 && m_selectedDataSetIndex < static_cast<int>(m_dataSets.size())) {
+        UpdateDistributionPlots(m_dataSets[m_selectedDataSetIndex]);
 
         m_plotSurface->GetYAxis1()->SetWorldMax(m_pdfPlot->GetNiceYMax());
         m_maxTextBox->SetValue(wxString::Format("%lg", m_pdfPlot->GetNiceYMax()));
@@ -35,6 +35,7 @@
 #include <wx/tokenzr.h>
 #include <wx/timer.h>
 
+#include "wex/dview/dvcompute.h"
 #include "wex/dview/dvprofilectrl.h"
 #include "wex/dview/dvplothelper.h"
 #include "wex/dview/dvselectionlist.h"
@@ -176,8 +177,21 @@ enum {
     ID_DATA_SELECTOR,
     ID_JAN_CHECK, ID_FEB_CHECK, ID_MAR_CHECK, ID_APR_CHECK, ID_MAY_CHECK, ID_JUN_CHECK,
     ID_JUL_CHECK, ID_AUG_CHECK, ID_SEP_CHECK, ID_OCT_CHECK, ID_NOV_CHECK, ID_DEC_CHECK,
-    ID_ANNUAL_CHECK, ID_SEL_ALL_CHECK,
-    ID_Timer
+    ID_ANNUAL_CHECK, ID_SEL_ALL_CHECK, ID_BANDS_CHECK,
+    ID_Timer,
+    ID_COMPUTE
+};
+
+class wxDVProfileJob : public wxDVComputeJob {
+public:
+    bool bands;
+    std::vector<std::vector<wxRealPoint> > plotData, lower, upper;
+
+    wxDVProfileJob(wxDVTimeSeriesDataSet *ds, bool withBands)
+            : wxDVComputeJob(ds, withBands ? "profile+bands" : "profile"), bands(withBands) {
+    }
+
+    virtual void Compute();
 };
 
 BEGIN_EVENT_TABLE(wxDVProfileCtrl, wxPanel)
@@ -185,17 +199,21 @@ BEGIN_EVENT_TABLE(wxDVProfileCtrl, wxPanel)
                 EVT_COMMAND_RANGE(ID_JAN_CHECK, ID_ANNUAL_CHECK, wxEVT_COMMAND_CHECKBOX_CLICKED,
                                   wxDVProfileCtrl::OnMonthSelection)
                 EVT_CHECKBOX(ID_SEL_ALL_CHECK, wxDVProfileCtrl::OnSelAllMonths)
+                EVT_CHECKBOX(ID_BANDS_CHECK, wxDVProfileCtrl::OnShowBands)
                 EVT_TEXT(wxID_ANY, wxDVProfileCtrl::OnSearch)
                 EVT_TIMER(ID_Timer, wxDVProfileCtrl::OnTimer)
+                EVT_DVCOMPUTE_DONE(ID_COMPUTE, wxDVProfileCtrl::OnComputeDone)
 END_EVENT_TABLE()
 
 wxDVProfileCtrl::wxDVProfileCtrl(wxWindow *parent, wxWindowID id, const wxPoint &pos,
                                  const wxSize &size, long style, const wxString &name)
         : wxPanel(parent, id, pos, size, style, name),
+          m_showBands(false),
           m_timer(nullptr),
           m_counter(0) {
     //wxFileConfig configFile("DView", "NREL");
     m_srchCtrl = NULL;
+    m_compute = new wxDVComputePool(this, ID_COMPUTE, 4);
     wxScrolledWindow *monthSelector = new wxScrolledWindow(this, wxID_ANY,
                                                            wxDefaultPosition, wxDefaultSize, wxHSCROLL);
     wxBoxSizer *monthSizer = new wxBoxSizer(wxHORIZONTAL);
@@ -213,6 +231,8 @@ wxDVProfileCtrl::wxDVProfileCtrl(wxWindow *parent, wxWindowID id, const wxPoint
     monthSizer->Add(m_monthCheckBoxes[12], 0, wxALL, 5);
     monthSizer->Add(new wxCheckBox(monthSelector, ID_SEL_ALL_CHECK,
                                    wxT("Select All")), 0, wxALL, 5);
+    monthSizer->Add(new wxCheckBox(monthSelector, ID_BANDS_CHECK,
+                                   wxT("p10/p90")), 0, wxALL, 5);
     for (int i = 0; i < 12; i++) {
         m_plotSurfaces[i] = new wxPLPlotCtrl(this, wxID_ANY);
         m_plotSurfaces[i]->SetIncludeLegendOnExport(true);
@@ -259,12 +279,13 @@ wxDVProfileCtrl::wxDVProfileCtrl(wxWindow *parent, wxWindowID id, const wxPoint
 }
 
 wxDVProfileCtrl::~wxDVProfileCtrl() {
+    delete m_compute;
     // remove all the plots manually from the 13 plot surface widgets
     // this regains ownership of the plots that are shown so that they can
     // be deleted in the destructor  ~PlotSet
     for (size_t i = 0; i < m_plots.size(); i++)
         for (int j = 0; j < 13; j++)
-            m_plotSurfaces[j]->RemovePlot(m_plots[i]->plots[j]);
+            m_plots[i]->RemoveFrom(m_plotSurfaces[j], j);
     // now delete all the plotsets
     for (int i = m_plots.size() - 1; i >= 0; i--)
         delete m_plots[i];
@@ -383,6 +404,7 @@ bool wxDVProfileCtrl::RemoveDataSet(wxDVTimeSeriesDataSet *d) {
         }
     }
     if (index < 0) return false;
+    m_compute->Invalidate(d);
     std::vector<int> currently_shown = m_dataSelector->GetSelectionsInCol();
     if (std::find(currently_shown.begin(), currently_shown.end(), index) != currently_shown.end())
         HidePlotAtIndex(index);
@@ -393,6 +415,7 @@ bool wxDVProfileCtrl::RemoveDataSet(wxDVTimeSeriesDataSet *d) {
 }
 
 void wxDVProfileCtrl::RemoveAllDataSets() {
+    m_compute->Clear();
     HideAllPlots(false);
     for (int i = m_plots.size() - 1; i >= 0; i--) {
         m_dataSelector->RemoveAt(i);
@@ -405,70 +428,145 @@ wxDVProfileCtrl::PlotSet::PlotSet(wxDVTimeSeriesDataSet *ds) {
     dataset = ds;
     axisPosition = wxPLPlotCtrl::Y_LEFT;
     for (int i = 0; i < 13; i++)
-        plots[i] = 0;
+        plots[i] = bands[i][0] = bands[i][1] = 0;
+    revision = bandsRevision = 0;
 }
 
 wxDVProfileCtrl::PlotSet::~PlotSet() {
-    for (int i = 0; i < 13; i++)
+    for (int i = 0; i < 13; i++) {
         if (plots[i] != 0)
             delete plots[i];
+        if (bands[i][0] != 0) delete bands[i][0];
+        if (bands[i][1] != 0) delete bands[i][1];
+    }
+}
+
+bool wxDVProfileCtrl::PlotSet::HasBands() const {
+    for (int i = 0; i < 13; i++)
+        if (bands[i][0] == 0 || bands[i][1] == 0)
+            return false;
+    return bandsRevision == dataset->GetRevision();
 }
 
-void wxDVProfileCtrl::PlotSet::CalculateProfileData() {
+void wxDVProfileCtrl::PlotSet::RemoveFrom(wxPLPlotCtrl *surface, int month) {
+    surface->RemovePlot(plots[month]);
+    surface->RemovePlot(bands[month][0]);
+    surface->RemovePlot(bands[month][1]);
+}
+
+bool wxDVProfileCtrl::PlotSet::IsCalculated() const {
+    for (int i = 0; i < 13; i++)
+        if (plots[i] == 0)
+            return false;
+    return revision == dataset->GetRevision();
+}
+
+void wxDVProfileJob::Compute() {
+    wxDVProfileCtrl::PlotSet::ComputeProfileData(GetSnapshot(), plotData, this,
+                                                 bands ? &lower : 0, bands ? &upper : 0);
+}
+
+// linear interpolation between the closest ranks, reorders v
+static double Percentile(std::vector<double> &v, double p) {
+    if (v.empty()) return 0;
+    double rank = p * (v.size() - 1);
+    size_t lo = (size_t) rank;
+    std::nth_element(v.begin(), v.begin() + lo, v.end());
+    double value = v[lo];
+    if (lo + 1 < v.size()) {
+        double next = *std::min_element(v.begin() + lo + 1, v.end());
+        value += (rank - lo) * (next - value);
+    }
+    return value;
+}
+
+void wxDVProfileCtrl::PlotSet::ComputeProfileData(wxDVTimeSeriesDataSet *dataset,
+                                                  std::vector<std::vector<wxRealPoint> > &plotData,
+                                                  wxDVComputeJob *job,
+                                                  std::vector<std::vector<wxRealPoint> > *lower,
+                                                  std::vector<std::vector<wxRealPoint> > *upper) {
+    plotData.clear();
+    if (lower) lower->clear();
+    if (upper) upper->clear();
     if (!dataset || dataset->Length() < 2)
         return;
-    bool already_calculated = true;
-    for (int i = 0; i < 13; i++)
-        already_calculated = already_calculated && (plots[i] != 0);
-    if (already_calculated) return;
-    // Holds all of the data points we read at each interval so we can average them.
-    // We have to store each months data instead of reusing our array because the data could be multi-year.
-    dvMatrix<double> dailyData(12, 24.0 / dataset->GetTimeStep(), 0.0);
-    // For averaging
-    dvMatrix<int> dataPointCount(12, 24.0 / dataset->GetTimeStep(), 0.0);
-    wxDateTime timeKeeper(01, wxDateTime::Jan, 1970, 00, 00, 00);
-    double hours = dataset->At(0).x;
-    double offsetFraction = fmod(dataset->At(0).x,
-                                 dataset->GetTimeStep()); //Non int offsets get chopped off without this.
-    timeKeeper.Add(wxTimeSpan::Hours(hours));
-    int k = (timeKeeper.GetHour() + (double) timeKeeper.GetMinute() / 60.0) /
-            dataset->GetTimeStep(); //Account for initial offset.
-    //Read data points into the correct month array.
     //This code requires a uniform time step. (Otherwise we have to re-define how we compute the average).
-    //This will handle multiple years and data that starts mid-year correctly.
     //Multi-year data will all get averaged into the same plots (if there are 2 Jan months in the data, we average over 62 days).
-    for (size_t i = 0; i < dataset->Length(); i++) {
-        wxDateTime::Month currentMonth = timeKeeper.GetMonth();
-        dailyData.at(currentMonth, k) = dailyData.at(currentMonth, k) + dataset->At(i).y;
-        dataPointCount.at(currentMonth, k) += 1;
-        k = (k + 1) % int(24 / dataset->GetTimeStep());
-        timeKeeper.Add(wxTimeSpan::Minutes(dataset->GetTimeStep() * 60));
-        currentMonth = timeKeeper.GetMonth();
-        hours += dataset->GetTimeStep();
-    }
-    std::vector<std::vector<wxRealPoint> > plotData(13);
-    //Compute average, and then set plottable data.
-    for (size_t i = 0; i < dailyData.nrows(); i++) {
-        plotData[i].reserve(dailyData.ncols());
-        for (size_t j = 0; j < dailyData.ncols(); j++) {
-            dailyData.at(i, j) = dataPointCount.at(i, j) > 0 ? dailyData.at(i, j) / dataPointCount.at(i, j)
-                                                             : 0; //Do avarage. Don't /0.
-            plotData[i].push_back(wxRealPoint(offsetFraction + j * dataset->GetTimeStep(), dailyData.at(i, j)));
+    double ts = dataset->GetTimeStep();
+    size_t steps = (size_t) (24.0 / ts);
+    if (steps < 1) steps = 1;
+    double offsetFraction = fmod(dataset->At(0).x, ts); //Non int offsets get chopped off without this.
+    dvMatrix<double> dailyData(12, steps, 0.0);
+    dvMatrix<int> dataPointCount(12, steps, 0);
+    bool bands = lower && upper;
+    std::vector<std::vector<double> > values; // 12 x steps samples for the percentile bands
+    if (bands) values.resize(12 * steps);
+
+    // the calendar index gives the month and the first sample of each day,
+    // so the step of day is an offset from midnight instead of a date walk
+    const wxDVCalendarIndex &cal = dataset->GetCalendarIndex();
+    for (size_t k = 0; k < cal.Days(); k++) {
+        if (job && job->IsCancelled())
+            return;
+        const wxDVCalendarIndex::Day &day = cal.At(k);
+        for (size_t i = day.first; i < cal.End(k); i++) {
+            wxRealPoint pt = dataset->At(i);
+            double s = floor((pt.x - day.start) / ts + 1e-6);
+            size_t step = s < 0 ? 0 : std::min((size_t) s, steps - 1);
+            dailyData.at(day.month, step) += pt.y;
+            dataPointCount.at(day.month, step)++;
+            if (bands) values[day.month * steps + step].push_back(pt.y);
         }
     }
-    // Average again into annual profile:
-    // Right now we are averaging across 12 months.
-    // This is more efficient than averaging across days since we already have the monthly averages
-    // But, this is slightly less accurate.  (days in Feb have bigger weight than in March because feb has 28 days).
-    for (size_t i = 0; i < plotData[0].size(); i++) {
-        double average = 0;
-        for (int j = 0; j < 12; j++) {
-            average += plotData[j][i].y;
+
+    plotData.resize(13);
+    for (size_t i = 0; i < 13; i++)
+        plotData[i].reserve(steps);
+    for (size_t j = 0; j < steps; j++) {
+        double x = offsetFraction + j * ts;
+        // the annual profile averages all days, so months are weighted by their length
+        double sum = 0;
+        int count = 0;
+        for (size_t i = 0; i < 12; i++) {
+            int n = dataPointCount.at(i, j);
+            plotData[i].push_back(wxRealPoint(x, n > 0 ? dailyData.at(i, j) / n : 0)); //Do average. Don't /0.
+            sum += dailyData.at(i, j);
+            count += n;
         }
-        average /= 12;
-        plotData[12].push_back(wxRealPoint(plotData[0][i].x,
-                                           average));
+        plotData[12].push_back(wxRealPoint(x, count > 0 ? sum / count : 0));
     }
+
+    if (!bands) return;
+    if (job && job->IsCancelled()) {
+        plotData.clear();
+        return;
+    }
+    lower->resize(13);
+    upper->resize(13);
+    std::vector<double> annual;
+    for (size_t j = 0; j < steps; j++) {
+        double x = offsetFraction + j * ts;
+        annual.clear();
+        for (size_t i = 0; i < 12; i++) {
+            std::vector<double> &v = values[i * steps + j];
+            annual.insert(annual.end(), v.begin(), v.end());
+            (*lower)[i].push_back(wxRealPoint(x, Percentile(v, 0.1)));
+            (*upper)[i].push_back(wxRealPoint(x, Percentile(v, 0.9)));
+        }
+        (*lower)[12].push_back(wxRealPoint(x, Percentile(annual, 0.1)));
+        (*upper)[12].push_back(wxRealPoint(x, Percentile(annual, 0.9)));
+    }
+}
+
+void wxDVProfileCtrl::PlotSet::SetProfileData(const std::vector<std::vector<wxRealPoint> > &plotData,
+                                              const std::vector<std::vector<wxRealPoint> > &lower,
+                                              const std::vector<std::vector<wxRealPoint> > &upper) {
+    if (plotData.size() != 13)
+        return;
+    bool withBands = lower.size() == 13 && upper.size() == 13;
+    // the compute pool only hands out results of the current revision
+    revision = dataset->GetRevision();
+    if (withBands) bandsRevision = revision;
     for (int i = 0; i < 13; i++) //12 months and annual
     {
         wxString month;
@@ -486,10 +584,47 @@ void wxDVProfileCtrl::PlotSet::CalculateProfileData() {
         plots[i]->SetYDataLabel(text);
         plots[i]->SetXDataLabel(_("Time of day")
                                 + " (" + month + " " + _("average") + wxString(")"));
+        if (!withBands) continue;
+        for (int b = 0; b < 2; b++) {
+            if (bands[i][b] == 0) bands[i][b] = new wxPLLinePlot;
+            bands[i][b]->SetThickness(1);
+            bands[i][b]->SetStyle(wxPLLinePlot::DASHED);
+            bands[i][b]->SetData(b == 0 ? lower[i] : upper[i]);
+            wxString pct(b == 0 ? "p10" : "p90");
+            bands[i][b]->SetLabel(text + " " + pct);
+            bands[i][b]->SetYDataLabel(text + " " + pct);
+            bands[i][b]->SetXDataLabel(_("Time of day") + " (" + month + " " + pct + wxString(")"));
+        }
     }
 }
 
 /*Event Handlers*/
+void wxDVProfileCtrl::OnComputeDone(wxCommandEvent &e) {
+    wxDVProfileJob *job = static_cast<wxDVProfileJob *>(m_compute->Collect(e));
+    if (!job) return;
+    for (size_t i = 0; i < m_plots.size(); i++) {
+        if (m_plots[i]->dataset != job->GetDataSet())
+            continue;
+        bool wasCalculated = m_plots[i]->IsCalculated();
+        if (wasCalculated && (!job->bands || m_plots[i]->HasBands()))
+            break;
+        m_plots[i]->SetProfileData(job->plotData, job->lower, job->upper);
+        // the selection may have changed while this was calculated
+        if (!m_dataSelector->IsSelected(i, 0))
+            break;
+        if (!wasCalculated)
+            ShowPlotAtIndex(i);
+        else if (m_showBands) {
+            // the averages are already shown, only the bands were missing
+            ShowBands(i, true);
+            AutoScaleYAxes();
+            for (int j = 0; j < 13; j++)
+                m_plotSurfaces[j]->Refresh();
+        }
+        break;
+    }
+}
+
 void wxDVProfileCtrl::OnDataChannelSelection(wxCommandEvent &) {
     int row;
     bool isChecked;
@@ -531,6 +666,37 @@ void wxDVProfileCtrl::OnSelAllMonths(wxCommandEvent &e) {
     Refresh();
 }
 
+void wxDVProfileCtrl::OnShowBands(wxCommandEvent &e) {
+    m_showBands = dynamic_cast<wxCheckBox *>(e.GetEventObject())->IsChecked();
+    std::vector<int> currently_shown = m_dataSelector->GetSelectionsInCol();
+    for (size_t j = 0; j < currently_shown.size(); j++) {
+        int index = currently_shown[j];
+        if (!m_plots[index]->IsCalculated())
+            continue; // bands are requested with the averages when they are shown
+        if (m_showBands && !m_plots[index]->HasBands())
+            m_compute->Submit(new wxDVProfileJob(m_plots[index]->dataset, true));
+        else
+            ShowBands(index, m_showBands);
+    }
+    AutoScaleYAxes();
+    for (int j = 0; j < 13; j++)
+        m_plotSurfaces[j]->Refresh();
+}
+
+void wxDVProfileCtrl::ShowBands(int i, bool show) {
+    PlotSet *ps = m_plots[i];
+    for (int j = 0; j < 13; j++) {
+        for (int b = 0; b < 2; b++) {
+            if (!ps->bands[j][b]) continue;
+            m_plotSurfaces[j]->RemovePlot(ps->bands[j][b]);
+            if (show && ps->plots[j]) {
+                ps->bands[j][b]->SetColour(m_dataSelector->GetColourForIndex(i));
+                m_plotSurfaces[j]->AddPlot(ps->bands[j][b], wxPLPlotCtrl::X_BOTTOM, ps->axisPosition);
+            }
+        }
+    }
+}
+
 void wxDVProfileCtrl::OnSearch(wxCommandEvent &) {
     m_dataSelector->Filter(m_srchCtrl->GetValue().Lower());
 }
@@ -578,7 +744,11 @@ void wxDVProfileCtrl::ShowPlotAtIndex(int i) {
     wxString YLabelText;
     size_t NumY1AxisSelections = 0;
     size_t NumY2AxisSelections = 0;
-    m_plots[i]->CalculateProfileData();
+    if (!m_plots[i]->IsCalculated() && m_plots[i]->dataset->Length() >= 2) {
+        // shown from OnComputeDone when the profiles are ready
+        m_compute->Submit(new wxDVProfileJob(m_plots[i]->dataset, m_showBands));
+        return;
+    }
     wxPLPlotCtrl::AxisPos yap = wxPLPlotCtrl::Y_LEFT;
     double yaxisMax = 0, yaxisMin = 0;
     for (int j = 0; j < 13; j++) {
@@ -600,6 +770,8 @@ void wxDVProfileCtrl::ShowPlotAtIndex(int i) {
             yap = wxPLPlotCtrl::Y_LEFT;
         else
             yap = wxPLPlotCtrl::Y_RIGHT;
+        // still on the surface when its profiles were recomputed while shown
+        m_plotSurfaces[j]->RemovePlot(m_plots[i]->plots[j]);
         m_plotSurfaces[j]->AddPlot(m_plots[i]->plots[j], wxPLPlotCtrl::X_BOTTOM, yap);
         m_plotSurfaces[j]->GetAxis(yap)->SetUnits(units);
         YLabelText = units;
@@ -624,6 +796,12 @@ void wxDVProfileCtrl::ShowPlotAtIndex(int i) {
             m_plotSurfaces[j]->GetYAxis2()->ShowLabel(false);
     }
     m_plots[i]->axisPosition = yap;
+    if (m_showBands) {
+        if (m_plots[i]->HasBands())
+            ShowBands(i, true);
+        else if (m_plots[i]->dataset->Length() >= 2)
+            m_compute->Submit(new wxDVProfileJob(m_plots[i]->dataset, true));
+    }
     for (int j = 0; j < 13; j++) {
         if (m_plotSurfaces[j]->GetAxis(yap)) {
             m_plotSurfaces[j]->GetAxis(yap)->SetWorld(yaxisMin, yaxisMax);
@@ -654,6 +832,7 @@ void wxDVProfileCtrl::HidePlotAtIndex(int i, bool update) {
     wxString y1Units = NO_UNITS, y2Units = NO_UNITS;
     //int SelIndex = -1;
     wxString units = m_plots[i]->dataset->GetUnits();
+    m_compute->Cancel(m_plots[i]->dataset);
     if (m_plotSurfaces[0]->GetYAxis1())
         y1Units = m_plotSurfaces[0]->GetYAxis1()->GetUnits();
     if (m_plotSurfaces[0]->GetYAxis2())
@@ -707,12 +886,19 @@ void wxDVProfileCtrl::HidePlotAtIndex(int i, bool update) {
         {
             for (size_t j = 0; j < currently_shown.size(); j++) {
                 int index = currently_shown[j];
-                m_plots[index]->CalculateProfileData();
+                // profiles still being computed are placed by ShowPlotAtIndex
+                // from OnComputeDone, so nothing is calculated here
+                if (!m_plots[index]->IsCalculated() && m_plots[index]->dataset->Length() >= 2)
+                    m_compute->Submit(new wxDVProfileJob(m_plots[index]->dataset, m_showBands));
+                if (m_plots[index]->plots[0] == 0)
+                    continue;
                 m_plots[index]->axisPosition = wxPLPlotCtrl::Y_LEFT;
                 for (int k = 0; k < 13; k++) {
                     m_plotSurfaces[k]->RemovePlot(m_plots[index]->plots[k]);
                     m_plotSurfaces[k]->AddPlot(m_plots[index]->plots[k], wxPLPlotCtrl::X_BOTTOM, wxPLPlotCtrl::Y_LEFT);
                 }
+                if (m_showBands)
+                    ShowBands(index, true);
             }
             YLabelText = y2Units;
             if (NumY2AxisSelections == 1 && FirstY2AxisSelectionIndex >
@@ -741,7 +927,7 @@ void wxDVProfileCtrl::HidePlotAtIndex(int i, bool update) {
     AutoScaleYAxes();
     RefreshDisabledCheckBoxes();
     for (int j = 0; j < 13; j++)
-        m_plotSurfaces[j]->RemovePlot(m_plots[i]->plots[j]);
+        m_plots[i]->RemoveFrom(m_plotSurfaces[j], j);
     if (update) {
         Refresh();
         Layout();
@@ -751,7 +937,7 @@ void wxDVProfileCtrl::HidePlotAtIndex(int i, bool update) {
 void wxDVProfileCtrl::HideAllPlots(bool update) {
     for (size_t i = 0; i < m_plots.size(); i++)
         for (size_t j = 0; j < 13; j++)
-            m_plotSurfaces[j]->RemovePlot(m_plots[i]->plots[j]);
+            m_plots[i]->RemoveFrom(m_plotSurfaces[j], j);
     for (size_t k = 0; k < 13; k++) {
         m_plotSurfaces[k]->SetYAxis1(0);
         m_plotSurfaces[k]->SetYAxis2(0);
@@ -770,19 +956,27 @@ void wxDVProfileCtrl::AutoScaleYAxes() {
     double leftYAxisMax = 0, leftYAxisMin = 1000000000, rightYAxisMin = 1000000000, rightYAxisMax = 0;
     for (int i = 0; i < 13; i++) {
         for (size_t j = 0; j < currently_shown.size(); j++) {
-            if (!m_plots[currently_shown[j]]->plots[i]) continue;
-            switch (m_plots[currently_shown[j]]->axisPosition) {
-                case wxPLPlotCtrl::Y_LEFT:
-                    m_plots[currently_shown[j]]->plots[i]->ExtendMinMax(NULL, NULL, &leftYAxisMin, &leftYAxisMax, true);
-                    break;
-                case wxPLPlotCtrl::Y_RIGHT:
-                    m_plots[currently_shown[j]]->plots[i]->ExtendMinMax(NULL, NULL, &rightYAxisMin, &rightYAxisMax,
-                                                                        true);
-                    break;
-                    //We don't care about x-axis.  It WILL be Y.
-                case wxPLPlotCtrl::X_BOTTOM:
-                case wxPLPlotCtrl::X_TOP:
-                    break;
+            PlotSet *ps = m_plots[currently_shown[j]];
+            if (!ps->plots[i]) continue;
+            wxPLLinePlot *extents[3] = {ps->plots[i], 0, 0};
+            if (m_showBands) {
+                extents[1] = ps->bands[i][0];
+                extents[2] = ps->bands[i][1];
+            }
+            for (int b = 0; b < 3; b++) {
+                if (!extents[b]) continue;
+                switch (ps->axisPosition) {
+                    case wxPLPlotCtrl::Y_LEFT:
+                        extents[b]->ExtendMinMax(NULL, NULL, &leftYAxisMin, &leftYAxisMax, true);
+                        break;
+                    case wxPLPlotCtrl::Y_RIGHT:
+                        extents[b]->ExtendMinMax(NULL, NULL, &rightYAxisMin, &rightYAxisMax, true);
+                        break;
+                        //We don't care about x-axis.  It WILL be Y.
+                    case wxPLPlotCtrl::X_BOTTOM:
+                    case wxPLPlotCtrl::X_TOP:
+                        break;
+                }
             }
         }
     }
@@ -23,6 +23,7 @@
 **********************************************************************************************************************/
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
 #include <numeric>
 #include <sstream>
@@ -37,6 +38,7 @@
 #include "wex/dview/dvselectionlist.h"
 #include "wex/dview/dvtimeseriesdataset.h"
 
+#include "wex/plot/plcolourmap.h"
 #include "wex/plot/plplotctrl.h"
 #include "wex/plot/plscatterplot.h"
 
@@ -117,9 +119,14 @@ wxDVScatterPlotCtrl::wxDVScatterPlotCtrl(wxWindow *parent, wxWindowID id, const
     m_xDataIndex = -1;
 
     m_showLine = false;
+
+    m_densityColourMap = new wxPLParulaColourMap(0, 1);
 }
 
 wxDVScatterPlotCtrl::~wxDVScatterPlotCtrl() {
+    // the density legend is owned here, not by the plot surface
+    m_plotSurface->ReleaseSideWidget(wxPLPlotCtrl::Y_RIGHT);
+    delete m_densityColourMap;
 }
 
 void wxDVScatterPlotCtrl::ReadState(std::string filename) {
@@ -281,6 +288,7 @@ void wxDVScatterPlotCtrl::RemoveYAxisChannel(int index) {
 void wxDVScatterPlotCtrl::UpdatePlotWithChannelSelections() {
     m_plotSurface->DeleteAllPlots();
     m_plotSurface->DeleteAxes();
+    m_plotSurface->ReleaseSideWidget(wxPLPlotCtrl::Y_RIGHT);
 
     if (m_xDataIndex < 0 || (size_t) m_xDataIndex >= m_dataSets.size())
         return;
@@ -296,6 +304,18 @@ void wxDVScatterPlotCtrl::UpdatePlotWithChannelSelections() {
             p->SetSize(2);
             p->SetColour(m_dataSelectionList->GetColourForIndex(m_yDataIndices[i]));
 
+            // a year of subhourly data is too many points to draw one by one, show
+            // their density instead.  with several series the cells are shaded in
+            // the series colours so they can be told apart and blend where they
+            // overlap.  a single series uses the colour map, shown as the legend
+            p->SetDensityMode(wxPLScatterPlot::DENSITY_AUTO);
+            p->SetDensityCells(wxPLScatterPlot::CELL_HEX);
+            if (m_yDataIndices.size() == 1 && p->Len() > p->GetDensityThreshold()) {
+                p->SetDensityColourMap(m_densityColourMap);
+                UpdateDensityLegend(p->Len());
+                m_plotSurface->SetSideWidget(m_densityColourMap, wxPLPlotCtrl::Y_RIGHT);
+            }
+
             wxString units = m_dataSets[m_yDataIndices[i]]->GetUnits();
 
             wxPLPlotCtrl::AxisPos yap = wxPLPlotCtrl::Y_LEFT;
@@ -342,6 +362,21 @@ void wxDVScatterPlotCtrl::UpdatePlotWithChannelSelections() {
                                              " (" + m_dataSets[m_xDataIndex]->GetUnits() + ")");
 }
 
+void wxDVScatterPlotCtrl::UpdateDensityLegend(size_t npoints) {
+    // the density colour map is in log10 of the points per cell, label it in
+    // powers of ten up to the most there can be
+    int decades = (int) ceil(log10((double) npoints));
+    if (decades < 1) decades = 1;
+
+    wxArrayString labels;
+    double count = 1;
+    for (int i = 0; i <= decades; i++, count *= 10)
+        labels.Add(wxString::Format("%lg", count));
+
+    m_densityColourMap->SetScaleMinMax(0, decades);
+    m_densityColourMap->SetLabels(labels);
+}
+
 void wxDVScatterPlotCtrl::RefreshDisabledCheckBoxes() {
     wxString axis1Label = NO_UNITS;
     wxString axis2Label = NO_UNITS;
@@ -471,9 +471,19 @@ void wxDVStatisticsTableCtrl::Invalidate() {
     //m_plotSurface->Refresh();
 }
 
+void wxDVStatisticsTableCtrl::ComputeStatistics() {
+    std::vector<wxDVStatisticsDataSet *> list;
+    for (size_t i = 0; i < m_variableStatistics.size(); i++)
+        list.push_back(m_variableStatistics[i]->GetDataSet());
+
+    wxDVStatisticsDataSet::ComputeAll(list);
+}
+
 void wxDVStatisticsTableCtrl::RebuildDataViewCtrl() {
     wxDataViewTextRenderer *tr;
 
+    ComputeStatistics();
+
     m_StatisticsModel->Refresh(m_variableStatistics, m_showMonths);
     m_ctrl->ClearColumns();
     m_ctrl->AssociateModel(m_StatisticsModel.get());
@@ -519,7 +529,8 @@ void wxDVStatisticsTableCtrl::RebuildDataViewCtrl() {
 }
 
 void wxDVStatisticsTableCtrl::AddDataSet(wxDVTimeSeriesDataSet *d) {
-    wxDVStatisticsDataSet *s = new wxDVStatisticsDataSet(d);
+    // statistics are computed together when the table is rebuilt
+    wxDVStatisticsDataSet *s = new wxDVStatisticsDataSet(d, false);
     wxDVVariableStatistics *p = new wxDVVariableStatistics(s, d->GetGroupName(), true);
     m_variableStatistics.push_back(p); //Add to data sets list.
 }
@@ -567,6 +578,8 @@ void wxDVStatisticsTableCtrl::RemoveAllDataSets() {
 void wxDVStatisticsTableCtrl::WriteDataAsText(wxUniChar sep, wxOutputStream &os, bool, bool) {
     if (m_variableStatistics.size() == 0) { return; }
 
+    ComputeStatistics();
+
     wxTextOutputStream tt(os);
     wxString sepstr(sep);
     wxDVStatisticsDataSet *stats;
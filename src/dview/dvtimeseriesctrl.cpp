@@ -47,6 +47,7 @@
 
 #include <wex/radiochoice.h>
 
+#include "wex/dview/dvfilecache.h"
 #include "wex/dview/dvselectionlist.h"
 #include "wex/dview/dvtimeseriesctrl.h"
 #include "wex/dview/dvtimeseriesdataset.h"
@@ -80,14 +81,24 @@ private:
     bool m_ownsDataset;
     wxDVTimeSeriesPlot *m_stackedOnTopOf;
     bool m_stacked;
+    bool m_decimate;
+
+    mutable std::vector<double> m_stackTops;
+    mutable bool m_stackValid;
+    mutable unsigned long m_stackRevision; // data revision the tops were built from
+    mutable unsigned long m_stackSerial; // identifies this build of the tops
+    mutable unsigned long m_stackBaseSerial; // build of the base tops they include
+    static unsigned long s_stackSerial;
 
 public:
     wxDVTimeSeriesPlot(wxDVTimeSeriesDataSet *ds, wxDVTimeSeriesType seriesType, bool OwnsDataset = false)
-            : m_data(ds), m_stackedOnTopOf(0) {
+            : m_data(ds), m_stackedOnTopOf(0),
+              m_stackValid(false), m_stackRevision(0), m_stackSerial(0), m_stackBaseSerial(0) {
         assert(ds != 0);
 
         // Note: defaulting to false really happens in wxDVTimeSeriesCtrl::ReadState
         m_stacked = false;
+        m_decimate = true;
         m_colour = *wxRED;
         m_seriesType = seriesType;
         m_style = (seriesType == wxDV_RAW || seriesType == wxDV_HOURLY) ? wxDV_NORMAL : wxDV_STEPPED;
@@ -125,6 +136,8 @@ public:
 
     void SetStyle(wxDVTimeSeriesStyle ss) { m_style = ss; }
 
+    void SetDecimation(bool b) { m_decimate = b; }
+
     void SetColour(const wxColour &col) { m_colour = col; }
 
     virtual wxString GetXDataLabel(wxPLPlot *) const {
@@ -158,15 +171,45 @@ public:
         if (i >= m_data->Length())
             return wxRealPoint(std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN());
 
+        const std::vector<double> &tops(GetStackTops());
+        const std::vector<double> *bases = GetStackBases();
+        if (ybase) *ybase = bases != 0 && i < bases->size() ? (*bases)[i] : 0;
+        return wxRealPoint(m_data->At(i).x, i < tops.size() ? tops[i] : std::numeric_limits<double>::quiet_NaN());
+    }
+
+    // Cumulative y values of this plot and all of the plots below it in the
+    // stack, by sample.  Built on first use and rebuilt only when the stack
+    // changes or the data of this plot or one below it changes, so stacked
+    // drawing doesn't walk the whole stack for every sample.
+    const std::vector<double> &GetStackTops() const {
+        const std::vector<double> *bases = 0;
+        unsigned long baseSerial = 0;
         if (m_stackedOnTopOf != 0 && m_stackedOnTopOf != this) {
-            wxRealPoint base(m_stackedOnTopOf->StackedAt(i, ybase));
-            if (ybase) *ybase = base.y;
-            wxRealPoint cur(m_data->At(i));
-            return wxRealPoint(cur.x, base.y + cur.y);
-        } else {
-            if (ybase) *ybase = 0;
-            return m_data->At(i);
+            bases = &m_stackedOnTopOf->GetStackTops();
+            baseSerial = m_stackedOnTopOf->m_stackSerial;
+        }
+
+        if (!m_stackValid
+            || m_stackRevision != m_data->GetRevision()
+            || m_stackBaseSerial != baseSerial) {
+            size_t len = m_data->Length();
+            m_stackTops.resize(len);
+            for (size_t i = 0; i < len; i++)
+                m_stackTops[i] = m_data->At(i).y + (bases != 0 && i < bases->size() ? (*bases)[i] : 0);
+
+            m_stackValid = true;
+            m_stackRevision = m_data->GetRevision();
+            m_stackBaseSerial = baseSerial;
+            m_stackSerial = ++s_stackSerial;
         }
+
+        return m_stackTops;
+    }
+
+    // tops of the plot below this one, or NULL at the bottom of the stack.
+    // only valid after GetStackTops()
+    const std::vector<double> *GetStackBases() const {
+        return (m_stackedOnTopOf != 0 && m_stackedOnTopOf != this) ? &m_stackedOnTopOf->m_stackTops : 0;
     }
 
     virtual size_t Len() const {
@@ -192,68 +235,63 @@ public:
         // if a plot is checked for both left and right Y axes,
         // since this wxDVTimeSeriesPlot instance is the same for both
         if (m_stacked && map.IsPrimaryXAxis()) {
-            len = m_data->Length();
+            const std::vector<double> &tops(GetStackTops());
+            const std::vector<double> *bases = GetStackBases();
+            len = tops.size();
 
             size_t reserve_len = len;
             if (m_style == wxDV_STEPPED)
                 reserve_len *= 2;
 
-            // reserve double the baseline need since will
-            // use this array to create the wraparound polygon
-            // for the stacked area
-            points.reserve(reserve_len * 2);
+            std::vector<wxRealPoint> top, base;
+            top.reserve(reserve_len);
+            base.reserve(reserve_len);
 
             double timeStep = m_data->GetTimeStep();
             double lowX;
             double highX;
 
-            if (m_stackedOnTopOf != 0) {
-                std::vector<wxRealPoint> base;
-                base.reserve(reserve_len);
-                for (size_t i = 0; i < len; i++) {
-                    double yb = 0;
-                    wxRealPoint p(StackedAt(i, &yb));
-                    if (p.x < wmin.x || p.x > wmax.x) continue;
-
-                    if (m_style == wxDV_STEPPED) {
-                        lowX = GetPeriodLowerBoundary(p.x, timeStep);
-                        highX = GetPeriodUpperBoundary(p.x, timeStep);
-                        points.push_back(map.ToDevice(lowX, p.y));
-                        points.push_back(map.ToDevice(highX, p.y));
-                        base.push_back(wxRealPoint(lowX, yb));
-                        base.push_back(wxRealPoint(highX, yb));
-                    } else {
-                        base.push_back(wxRealPoint(p.x, yb));
-                        points.push_back(map.ToDevice(p));
-                    }
-                }
-
-                for (size_t i = 0; i < base.size(); i++)
-                    points.push_back(map.ToDevice(base[base.size() - i - 1]));
-            } else {
-                for (size_t i = 0; i < len; i++) {
-                    wxRealPoint p(At(i));
-                    if (p.x < wmin.x || p.x > wmax.x) continue;
-                    if (m_style == wxDV_STEPPED) {
-                        lowX = GetPeriodLowerBoundary(p.x, timeStep);
-                        highX = GetPeriodUpperBoundary(p.x, timeStep);
-                        points.push_back(map.ToDevice(lowX, p.y));
-                        points.push_back(map.ToDevice(highX, p.y));
-                    } else
-                        points.push_back(map.ToDevice(p));
+            for (size_t i = 0; i < len; i++) {
+                double x = m_data->At(i).x;
+                if (x < wmin.x || x > wmax.x) continue;
+
+                double yb = bases != 0 && i < bases->size() ? (*bases)[i] : 0;
+                if (m_style == wxDV_STEPPED) {
+                    lowX = GetPeriodLowerBoundary(x, timeStep);
+                    highX = GetPeriodUpperBoundary(x, timeStep);
+                    top.push_back(map.ToDevice(lowX, tops[i]));
+                    top.push_back(map.ToDevice(highX, tops[i]));
+                    base.push_back(map.ToDevice(lowX, yb));
+                    base.push_back(map.ToDevice(highX, yb));
+                } else {
+                    top.push_back(map.ToDevice(x, tops[i]));
+                    base.push_back(map.ToDevice(x, yb));
                 }
-
-                points.push_back(wxRealPoint(points[points.size() - 1].x, map.ToDevice(wxRealPoint(0, 0)).y));
-                points.push_back(wxRealPoint(points[0].x, map.ToDevice(wxRealPoint(0, 0)).y));
             }
 
+            if (top.size() < 2) return;
+
             wxRealPoint pos, size;
             map.GetDeviceExtents(&pos, &size);
-            if (static_cast<int>(points.size()) > (int) (3.0 * size.x)) {
-                dc.Text("too many data points: please zoom in", pos);
-                return; // quit if 3x more x coord points than pixels
+
+            if (m_decimate) {
+                // reduce both edges of the area to the visible pixel columns
+                std::vector<wxRealPoint> reduced;
+                wxPLLinePlot::Decimate(top, reduced, dc.PixelSize());
+                points.swap(reduced);
+                wxPLLinePlot::Decimate(base, reduced, dc.PixelSize());
+                base.swap(reduced);
+            } else {
+                if (static_cast<int>(top.size()) > (int) (3.0 * size.x)) {
+                    dc.Text("too many data points: please zoom in", pos);
+                    return; // quit if 3x more x coord points than pixels
+                }
+                points.swap(top);
             }
 
+            // wrap around along the base to close the polygon
+            points.insert(points.end(), base.rbegin(), base.rend());
+
             dc.Pen(*wxBLACK, 0, wxPLOutputDevice::NONE);
             dc.Brush(m_colour);
             dc.Polygon(points.size(), &points[0], wxPLOutputDevice::WINDING_RULE);
@@ -284,6 +322,22 @@ public:
                 // this is a much needed rendering optimization for large datasets
                 size_t i = 0;
                 size_t len_tmp = m_data->Length();
+                if (m_decimate) {
+                    // keep first/min/max/last per output pixel column, which draws
+                    // the same as the full polyline (also used for PDF export)
+                    std::vector<wxRealPoint> visible;
+                    visible.reserve(len_tmp);
+                    for (; i < len_tmp; i++) {
+                        rpt = m_data->At(i);
+                        if (rpt.x >= wmin.x && rpt.x <= wmax.x)
+                            visible.push_back(map.ToDevice(rpt));
+                    }
+
+                    std::vector<wxRealPoint> reduced;
+                    wxPLLinePlot::Decimate(visible, reduced, dc.PixelSize());
+                    points.insert(points.end(), reduced.begin(), reduced.end());
+                }
+
                 while (i < len_tmp) {
                     rpt = m_data->At(i);
                     if (rpt.x < wmin.x || rpt.x > wmax.x) {
@@ -421,7 +475,18 @@ public:
             wxRealPoint devpos, devsize;
             map.GetDeviceExtents(&devpos, &devsize);
 
-            if (points.size() > 4 * devsize.x) {
+            // the stepped outline is decimated once it is built.  Decimate falls back
+            // to every point if the x coordinates ever decrease, so the point limit
+            // still applies when nothing was reduced
+            bool limit = !m_decimate;
+            if (m_decimate && m_style == wxDV_STEPPED) {
+                std::vector<wxRealPoint> reduced;
+                wxPLLinePlot::Decimate(points, reduced, dc.PixelSize());
+                limit = reduced.size() == points.size();
+                points.swap(reduced);
+            }
+
+            if (limit && points.size() > 4 * devsize.x) {
                 dc.Text("too many data points: please zoom in", devpos);
                 return; // quit if 4x more x coord points than integer device units
             }
@@ -522,16 +587,16 @@ public:
                 factor = m_data->GetTimeStep();
             }
 
-            if (wxDVArrayDataSet *arrdata = dynamic_cast<wxDVArrayDataSet *>(m_data)) {
-                if (divide) arrdata->SetY(i, m_data->At(i).y / factor);
-                else arrdata->SetY(i, m_data->At(i).y * factor);
-            }
+            if (divide) m_data->SetY(i, m_data->At(i).y / factor);
+            else m_data->SetY(i, m_data->At(i).y * factor);
         }
     }
 
     wxDVTimeSeriesDataSet *GetDataSet() const { return m_data; }
 };
 
+unsigned long wxDVTimeSeriesPlot::s_stackSerial = 0;
+
 BEGIN_EVENT_TABLE(wxDVTimeSeriesSettingsDialog, wxDialog)
                 EVT_CHECKBOX(ID_TopCheckbox, wxDVTimeSeriesSettingsDialog::OnClickTopHandler)
                 EVT_CHECKBOX(ID_BottomCheckbox, wxDVTimeSeriesSettingsDialog::OnClickBottomHandler)
@@ -778,6 +843,7 @@ wxDVTimeSeriesCtrl::wxDVTimeSeriesCtrl(wxWindow *parent, wxWindowID id, wxDVTime
     SetBackgroundColour(*wxWHITE);
     m_srchCtrl = NULL;
     m_stackingOnYLeft = false;
+    m_decimate = true;
     m_topAutoScale = false;
     m_top2AutoScale = false;
     m_bottomAutoScale = false;
@@ -1091,6 +1157,12 @@ void wxDVTimeSeriesCtrl::Invalidate() {
     m_plotSurface->Refresh();
 }
 
+void wxDVTimeSeriesCtrl::InvalidateView() {
+    // panning and zooming only move the data against the axes
+    m_plotSurface->Invalidate();
+    m_plotSurface->RefreshLayers(wxPLPlot::LAYER_GRID | wxPLPlot::LAYER_DATA | wxPLPlot::LAYER_AXES);
+}
+
 wxDVTimeSeriesType wxDVTimeSeriesCtrl::GetTimeSeriesType() {
     return m_seriesType;
 }
@@ -1180,7 +1252,8 @@ void wxDVTimeSeriesCtrl::OnSettings(wxCommandEvent &) {
                 m_plots[i]->SetStyle((wxDVTimeSeriesStyle) m_style);
                 m_plots[i]->UpdateSummaryData(m_statType == wxDV_AVERAGE ? true : false);
 
-                if (0 == dynamic_cast<wxDVArrayDataSet *>(m_plots[i]->GetDataSet()))
+                if (0 == dynamic_cast<wxDVArrayDataSet *>(m_plots[i]->GetDataSet())
+                    && 0 == dynamic_cast<wxDVMappedDataSet *>(m_plots[i]->GetDataSet()))
                     nonmodifiables += m_plots[i]->GetDataSet()->GetSeriesTitle() + "\n";
             }
 
@@ -1286,7 +1359,7 @@ void wxDVTimeSeriesCtrl::OnMouseWheel(wxMouseEvent &e) {
     if (update_view) {
         AutoscaleYAxis();
         UpdateScrollbarPosition();
-        Invalidate();
+        InvalidateView();
     }
 }
 
@@ -1312,7 +1385,7 @@ void wxDVTimeSeriesCtrl::OnGraphScroll(wxScrollEvent &e) {
     wxDVPlotHelper::SetRangeEndpointsToDays(&min, &max);
     m_xAxis->SetWorld(min, max);
     if (m_topAutoScale || m_top2AutoScale || m_bottomAutoScale || m_bottom2AutoScale) { AutoscaleYAxis(true); }
-    Invalidate();
+    InvalidateView();
 }
 
 //Scrolling the graph a line up or a line down occurs when the user clicks the left or right button on the scrollbar.
@@ -1561,6 +1634,7 @@ void wxDVTimeSeriesCtrl::AddDataSet(wxDVTimeSeriesDataSet *d, bool refresh_ui) {
         }
 
         p->SetStyle(m_style);
+        p->SetDecimation(m_decimate);
         m_plots.push_back(p); //Add to data sets list.
         m_dataSelector->Append(d->GetTitleWithUnits(), d->GetGroupName());
 
@@ -1652,14 +1726,14 @@ void wxDVTimeSeriesCtrl::SetViewMin(double min) {
     m_xAxis->SetWorldMin(min);
     AutoscaleYAxis();
     UpdateScrollbarPosition();
-    Invalidate();
+    InvalidateView();
 }
 
 void wxDVTimeSeriesCtrl::SetViewMax(double max) {
     m_xAxis->SetWorldMax(max);
     AutoscaleYAxis();
     UpdateScrollbarPosition();
-    Invalidate();
+    InvalidateView();
 }
 
 //This setter also sets endpoints to days.
@@ -1668,7 +1742,7 @@ void wxDVTimeSeriesCtrl::SetViewRange(double min, double max) {
     m_xAxis->SetWorld(min, max);
     if (m_topAutoScale || m_top2AutoScale || m_bottomAutoScale || m_bottom2AutoScale) { AutoscaleYAxis(true); }
     UpdateScrollbarPosition();
-    Invalidate();
+    InvalidateView();
 }
 
 void wxDVTimeSeriesCtrl::SetStyle(wxDVTimeSeriesStyle sty) {
@@ -1679,6 +1753,13 @@ void wxDVTimeSeriesCtrl::SetStyle(wxDVTimeSeriesStyle sty) {
     Invalidate();
 }
 
+void wxDVTimeSeriesCtrl::SetDecimation(bool b) {
+    m_decimate = b;
+    for (size_t i = 0; i < m_plots.size(); i++)
+        m_plots[i]->SetDecimation(m_decimate);
+    Invalidate();
+}
+
 void
 wxDVTimeSeriesCtrl::GetVisibleDataMinAndMax(double *min, double *max, const std::vector<int> &selectedChannelIndices) {
     *min = 1000000000;
@@ -1696,14 +1777,16 @@ wxDVTimeSeriesCtrl::GetVisibleDataMinAndMax(double *min, double *max, const std:
 
         for (size_t i = 0; i < selectedChannelIndices.size(); i++) {
             wxDVTimeSeriesPlot *plot = m_plots[selectedChannelIndices[i]];
-            for (size_t j = 0; j < plot->Len(); j++) {
-                wxRealPoint p(plot->StackedAt(j));
-                if (p.x < worldMin || p.x > worldMax)
+            wxDVTimeSeriesDataSet *ds = plot->GetDataSet();
+            const std::vector<double> &tops(plot->GetStackTops());
+            for (size_t j = 0; j < tops.size(); j++) {
+                double x = ds->At(j).x;
+                if (x < worldMin || x > worldMax)
                     continue;
-                if (p.y > *max)
-                    *max = p.y;
-                if (p.y < *min)
-                    *min = p.y;
+                if (tops[j] > *max)
+                    *max = tops[j];
+                if (tops[j] < *min)
+                    *min = tops[j];
             }
         }
 
@@ -1748,13 +1831,12 @@ void wxDVTimeSeriesCtrl::GetAllDataMinAndMax(double *min, double *max, const std
 
     if (has_stacking) {
         for (size_t i = 0; i < selectedChannelIndices.size(); i++) {
-            wxDVTimeSeriesPlot *plot = m_plots[selectedChannelIndices[i]];
-            for (size_t j = 0; j < plot->Len(); j++) {
-                wxRealPoint p(plot->StackedAt(j));
-                if (p.y > *max)
-                    *max = p.y;
-                if (p.y < *min)
-                    *min = p.y;
+            const std::vector<double> &tops(m_plots[selectedChannelIndices[i]]->GetStackTops());
+            for (size_t j = 0; j < tops.size(); j++) {
+                if (tops[j] > *max)
+                    *max = tops[j];
+                if (tops[j] < *min)
+                    *min = tops[j];
             }
         }
 
@@ -1900,7 +1982,7 @@ void wxDVTimeSeriesCtrl::ZoomFactorAndUpdate(double factor, double shiftPercent)
     m_xAxis->SetWorld(min, max);
     if (m_topAutoScale || m_top2AutoScale || m_bottomAutoScale || m_bottom2AutoScale) { AutoscaleYAxis(true); }
     UpdateScrollbarPosition();
-    Invalidate();
+    InvalidateView();
 }
 
 void wxDVTimeSeriesCtrl::ZoomToFit() {
@@ -1947,7 +2029,7 @@ void wxDVTimeSeriesCtrl::PanByPercent(double p) {
 
     SetViewRange(newMin, newMax);
     if (m_topAutoScale || m_top2AutoScale || m_bottomAutoScale || m_bottom2AutoScale) { AutoscaleYAxis(true); }
-    Invalidate();
+    InvalidateView();
 }
 
 void wxDVTimeSeriesCtrl::UpdateScrollbarPosition() {
@@ -2235,6 +2317,7 @@ void wxDVTimeSeriesCtrl::StackUp(wxPLPlotCtrl::AxisPos yap, wxPLPlotCtrl::PlotPo
                 && tyap == yap && tppos == ppos) {
                 cur->SetStackingMode(true);
                 cur->StackOnTopOf(stack.size() > 0 ? stack.back() : NULL);
+                cur->GetStackTops(); // build the cumulative values bottom up
                 stack.push_back(cur);
             }
         }
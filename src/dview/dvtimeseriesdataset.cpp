@@ -22,9 +22,17 @@
 *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 **********************************************************************************************************************/
 
+#include <algorithm>
+
+#include <wx/thread.h>
+
 #include "wex/dview/dvtimeseriesdataset.h"
 
-wxDVTimeSeriesDataSet::wxDVTimeSeriesDataSet() {
+#define RANGE_INDEX_BLOCK 64
+
+wxDVTimeSeriesDataSet::wxDVTimeSeriesDataSet()
+        : m_rangeIndexValid(false), m_rangeIndexLength(0),
+          m_calendarIndexValid(false), m_calendarIndexLength(0), m_revision(0) {
 }
 
 wxDVTimeSeriesDataSet::~wxDVTimeSeriesDataSet() {
@@ -57,6 +65,134 @@ double wxDVTimeSeriesDataSet::GetTotalHours() {
     return GetMaxHours() - GetMinHours();
 }
 
+void wxDVTimeSeriesDataSet::InvalidateRangeIndex() {
+    wxCriticalSectionLocker _lock(m_indexLock);
+    m_rangeIndexValid = false;
+    m_revision++;
+}
+
+void wxDVTimeSeriesDataSet::InvalidateCalendarIndex() {
+    wxCriticalSectionLocker _lock(m_indexLock);
+    m_calendarIndexValid = false;
+    m_revision++;
+}
+
+void wxDVTimeSeriesDataSet::DoSetY(size_t, double) {
+    /* read only data */
+}
+
+void wxDVTimeSeriesDataSet::SetY(size_t i, double y) {
+    DoSetY(i, y);
+    InvalidateRangeIndex();
+}
+
+unsigned long wxDVTimeSeriesDataSet::GetRevision() const {
+    wxCriticalSectionLocker _lock(m_indexLock);
+    return m_revision;
+}
+
+wxDVCalendarIndex wxDVTimeSeriesDataSet::GetCalendarIndex() {
+    wxCriticalSectionLocker _lock(m_indexLock);
+    size_t len = Length();
+    if (!m_calendarIndexValid || m_calendarIndexLength != len) {
+        m_calendarIndex.Build(*this, wxDVCalendarIndex::CalendarYearFor(*this));
+        m_calendarIndexValid = true;
+        m_calendarIndexLength = len;
+    }
+    return m_calendarIndex;
+}
+
+void wxDVTimeSeriesDataSet::BuildRangeIndex() {
+    m_rangeIndex.clear();
+
+    size_t nblocks = Length() / RANGE_INDEX_BLOCK;
+    if (nblocks > 0) {
+        m_rangeIndex.push_back(RangeIndexLevel());
+        RangeIndexLevel &base = m_rangeIndex.back();
+        base.min.resize(nblocks);
+        base.max.resize(nblocks);
+        base.sum.resize(nblocks);
+        for (size_t b = 0; b < nblocks; b++)
+            ScanRange(b * RANGE_INDEX_BLOCK, (b + 1) * RANGE_INDEX_BLOCK, &base.min[b], &base.max[b], &base.sum[b]);
+
+        // an unpaired last entry is not carried up, queries never need it at the next level
+        while (m_rangeIndex.back().min.size() > 1) {
+            size_t n = m_rangeIndex.back().min.size() / 2;
+            RangeIndexLevel next;
+            next.min.resize(n);
+            next.max.resize(n);
+            next.sum.resize(n);
+            const RangeIndexLevel &prev = m_rangeIndex.back();
+            for (size_t j = 0; j < n; j++) {
+                next.min[j] = std::min(prev.min[2 * j], prev.min[2 * j + 1]);
+                next.max[j] = std::max(prev.max[2 * j], prev.max[2 * j + 1]);
+                next.sum[j] = prev.sum[2 * j] + prev.sum[2 * j + 1];
+            }
+            m_rangeIndex.push_back(next);
+        }
+    }
+
+    m_rangeIndexValid = true;
+    m_rangeIndexLength = Length();
+}
+
+void wxDVTimeSeriesDataSet::ScanRange(size_t startIndex, size_t endIndex, double *min, double *max, double *sum) {
+    double myMin = *min, myMax = *max, mySum = 0.0;
+    for (size_t i = startIndex; i < endIndex; i++) {
+        double y = At(i).y;
+        if (y < myMin)
+            myMin = y;
+        if (y > myMax)
+            myMax = y;
+        mySum += y;
+    }
+    *min = myMin;
+    *max = myMax;
+    *sum = mySum;
+}
+
+void wxDVTimeSeriesDataSet::QueryRange(size_t startIndex, size_t endIndex, double *min, double *max, double *sum) {
+    *min = At(startIndex).y;
+    *max = *min;
+    *sum = 0.0;
+
+    // whole blocks covered by the range
+    size_t bs = (startIndex + RANGE_INDEX_BLOCK - 1) / RANGE_INDEX_BLOCK;
+    size_t be = endIndex / RANGE_INDEX_BLOCK;
+    if (bs + 1 >= be) {
+        ScanRange(startIndex, endIndex, min, max, sum);
+        return;
+    }
+
+    wxCriticalSectionLocker _lock(m_indexLock);
+    if (!m_rangeIndexValid || m_rangeIndexLength != Length())
+        BuildRangeIndex();
+
+    double partial;
+    ScanRange(startIndex, bs * RANGE_INDEX_BLOCK, min, max, &partial);
+    *sum += partial;
+    ScanRange(be * RANGE_INDEX_BLOCK, endIndex, min, max, &partial);
+    *sum += partial;
+
+    for (size_t level = 0; bs < be && level < m_rangeIndex.size(); level++) {
+        const RangeIndexLevel &idx = m_rangeIndex[level];
+        if (bs & 1) {
+            *min = std::min(*min, idx.min[bs]);
+            *max = std::max(*max, idx.max[bs]);
+            *sum += idx.sum[bs];
+            bs++;
+        }
+        if (be & 1) {
+            be--;
+            *min = std::min(*min, idx.min[be]);
+            *max = std::max(*max, idx.max[be]);
+            *sum += idx.sum[be];
+        }
+        bs /= 2;
+        be /= 2;
+    }
+}
+
 void wxDVTimeSeriesDataSet::GetMinAndMaxInRange(double *min, double *max,
                                                 size_t startIndex, size_t endIndex) {
     if (endIndex > Length())
@@ -64,13 +200,10 @@ void wxDVTimeSeriesDataSet::GetMinAndMaxInRange(double *min, double *max,
 
     double myMin = At(startIndex).y;
     double myMax = At(startIndex).y;
+    double mySum;
 
-    for (size_t i = startIndex + 1; i < endIndex; i++) {
-        if (At(i).y < myMin)
-            myMin = At(i).y;
-        if (At(i).y > myMax)
-            myMax = At(i).y;
-    }
+    if (startIndex + 1 < endIndex)
+        QueryRange(startIndex, endIndex, &myMin, &myMax, &mySum);
 
     if (min)
         *min = myMin;
@@ -78,6 +211,18 @@ void wxDVTimeSeriesDataSet::GetMinAndMaxInRange(double *min, double *max,
         *max = myMax;
 }
 
+double wxDVTimeSeriesDataSet::GetSumInRange(size_t startIndex, size_t endIndex) {
+    if (endIndex > Length())
+        endIndex = Length();
+
+    if (startIndex >= endIndex)
+        return 0.0;
+
+    double myMin, myMax, mySum;
+    QueryRange(startIndex, endIndex, &myMin, &myMax, &mySum);
+    return mySum;
+}
+
 void wxDVTimeSeriesDataSet::GetMinAndMaxInRange(double *min, double *max, double startHour, double endHour) {
     if (startHour < At(0).x)
         startHour = At(0).x;
@@ -109,43 +254,57 @@ std::vector<wxRealPoint> wxDVTimeSeriesDataSet::GetDataVector() {
 // ******** Array data set *********** //
 
 wxDVArrayDataSet::wxDVArrayDataSet()
-        : m_timestep(1), m_offset(0) {
+        : m_timestep(1), m_offset(0), m_storage(STORE_POINTS) {
 }
 
 wxDVArrayDataSet::wxDVArrayDataSet(const wxString &var, const std::vector<double> &data)
-        : m_varLabel(var), m_timestep(1), m_offset(0) {
+        : m_varLabel(var), m_timestep(1), m_offset(0), m_storage(STORE_POINTS) {
     Copy(data);
 }
 
 wxDVArrayDataSet::wxDVArrayDataSet(const wxString &var, const std::vector<wxRealPoint> &data)
-        : m_varLabel(var), m_timestep(1), m_offset(0), m_pData(data) {
+        : m_varLabel(var), m_timestep(1), m_offset(0), m_storage(STORE_POINTS), m_pData(data) {
 }
 
 wxDVArrayDataSet::wxDVArrayDataSet(const wxString &var, const wxString &units, const double &timestep)
-        : m_varLabel(var), m_varUnits(units), m_timestep(timestep), m_offset(0) {
+        : m_varLabel(var), m_varUnits(units), m_timestep(timestep), m_offset(0), m_storage(STORE_POINTS) {
 }
 
 wxDVArrayDataSet::wxDVArrayDataSet(const wxString &var, const wxString &units, const double &timestep,
                                    const std::vector<double> &data)
-        : m_varLabel(var), m_varUnits(units), m_timestep(timestep), m_offset(0) {
+        : m_varLabel(var), m_varUnits(units), m_timestep(timestep), m_offset(0), m_storage(STORE_POINTS) {
     Copy(data);
 }
 
 wxDVArrayDataSet::wxDVArrayDataSet(const wxString &var, const wxString &units, const double &offset,
                                    const double &timestep, const std::vector<double> &data)
-        : m_varLabel(var), m_varUnits(units), m_timestep(timestep), m_offset(offset) {
+        : m_varLabel(var), m_varUnits(units), m_timestep(timestep), m_offset(offset), m_storage(STORE_POINTS) {
     Copy(data);
 }
 
 wxRealPoint wxDVArrayDataSet::At(size_t i) const {
-    if (i < m_pData.size())
-        return wxRealPoint(m_pData[i].x, m_pData[i].y);
-    else
-        return wxRealPoint(m_offset + i * m_timestep, 0.0);
+    switch (m_storage) {
+        case STORE_Y_DOUBLE:
+            return wxRealPoint(m_offset + i * m_timestep, i < m_yData.size() ? m_yData[i] : 0.0);
+        case STORE_Y_FLOAT:
+            return wxRealPoint(m_offset + i * m_timestep, i < m_yFloat.size() ? (double) m_yFloat[i] : 0.0);
+        default:
+            if (i < m_pData.size())
+                return wxRealPoint(m_pData[i].x, m_pData[i].y);
+            else
+                return wxRealPoint(m_offset + i * m_timestep, 0.0);
+    }
 }
 
 size_t wxDVArrayDataSet::Length() const {
-    return m_pData.size();
+    switch (m_storage) {
+        case STORE_Y_DOUBLE:
+            return m_yData.size();
+        case STORE_Y_FLOAT:
+            return m_yFloat.size();
+        default:
+            return m_pData.size();
+    }
 }
 
 double wxDVArrayDataSet::GetTimeStep() const {
@@ -165,34 +324,138 @@ wxString wxDVArrayDataSet::GetUnits() const {
 }
 
 void wxDVArrayDataSet::Clear() {
+    InvalidateRangeIndex();
+    InvalidateCalendarIndex();
     m_pData.clear();
+    m_yData.clear();
+    m_yFloat.clear();
 }
 
 void wxDVArrayDataSet::Copy(const std::vector<double> &data) {
-    m_pData.clear();
-    if (data.size() > 0) {
-        m_pData.resize(data.size());
-        for (size_t i = 0; i < data.size(); i++)
-            m_pData[i] = wxRealPoint(m_offset + i * m_timestep, data[i]);
+    Clear();
+    switch (m_storage) {
+        case STORE_Y_DOUBLE:
+            m_yData = data;
+            break;
+        case STORE_Y_FLOAT:
+            m_yFloat.assign(data.begin(), data.end());
+            break;
+        default:
+            if (data.size() > 0) {
+                m_pData.resize(data.size());
+                for (size_t i = 0; i < data.size(); i++)
+                    m_pData[i] = wxRealPoint(m_offset + i * m_timestep, data[i]);
+            }
     }
 }
 
 void wxDVArrayDataSet::Alloc(size_t n) {
-    m_pData.reserve(n);
+    switch (m_storage) {
+        case STORE_Y_DOUBLE:
+            m_yData.reserve(n);
+            break;
+        case STORE_Y_FLOAT:
+            m_yFloat.reserve(n);
+            break;
+        default:
+            m_pData.reserve(n);
+    }
+}
+
+// whether x lies on the offset + i*timestep grid of the compact storage
+static bool OnImplicitGrid(double x, double offset, double timestep, size_t i) {
+    double grid = offset + i * timestep;
+    return fabs(x - grid) <= 1e-6 * (1.0 + fabs(grid));
 }
 
 void wxDVArrayDataSet::Append(const wxRealPoint &p) {
-    m_pData.push_back(p);
+    InvalidateRangeIndex();
+    InvalidateCalendarIndex();
+
+    // an x value off the grid can only be kept with explicit points
+    if (m_storage != STORE_POINTS && !OnImplicitGrid(p.x, m_offset, m_timestep, Length()))
+        SetStorage(STORE_POINTS);
+
+    if (m_storage == STORE_POINTS)
+        m_pData.push_back(p);
+    else
+        AppendY(p.y);
+}
+
+void wxDVArrayDataSet::AppendY(double y) {
+    InvalidateRangeIndex();
+    InvalidateCalendarIndex();
+    switch (m_storage) {
+        case STORE_Y_DOUBLE:
+            m_yData.push_back(y);
+            break;
+        case STORE_Y_FLOAT:
+            m_yFloat.push_back((float) y);
+            break;
+        default:
+            m_pData.push_back(wxRealPoint(m_offset + m_pData.size() * m_timestep, y));
+    }
+}
+
+double *wxDVArrayDataSet::ResizeY(size_t n) {
+    if (m_storage != STORE_Y_DOUBLE)
+        return 0;
+
+    InvalidateRangeIndex();
+    InvalidateCalendarIndex();
+    m_yData.resize(n);
+    return m_yData.data();
 }
 
 void wxDVArrayDataSet::Set(size_t i, double x, double y) {
-    if (i < m_pData.size())
-        m_pData[i] = wxRealPoint(x, y);
+    InvalidateRangeIndex();
+    InvalidateCalendarIndex();
+    if (m_storage != STORE_POINTS && i < Length() && !OnImplicitGrid(x, m_offset, m_timestep, i))
+        SetStorage(STORE_POINTS);
+
+    if (m_storage == STORE_POINTS) {
+        if (i < m_pData.size())
+            m_pData[i] = wxRealPoint(x, y);
+    } else
+        SetY(i, y);
+}
+
+void wxDVArrayDataSet::DoSetY(size_t i, double y) {
+    switch (m_storage) {
+        case STORE_Y_DOUBLE:
+            if (i < m_yData.size()) m_yData[i] = y;
+            break;
+        case STORE_Y_FLOAT:
+            if (i < m_yFloat.size()) m_yFloat[i] = (float) y;
+            break;
+        default:
+            if (i < m_pData.size()) m_pData[i].y = y;
+    }
 }
 
-void wxDVArrayDataSet::SetY(size_t i, double y) {
-    if (i < m_pData.size())
-        m_pData[i].y = y;
+void wxDVArrayDataSet::SetStorage(Storage st) {
+    if (st == m_storage)
+        return;
+
+    // convert the existing samples; switching to a compact mode
+    // places them on the regular offset + i*timestep grid
+    std::vector<double> y(Length());
+    for (size_t i = 0; i < y.size(); i++)
+        y[i] = At(i).y;
+
+    Clear();
+    m_pData.shrink_to_fit();
+    m_yData.shrink_to_fit();
+    m_yFloat.shrink_to_fit();
+
+    m_storage = st;
+    Copy(y);
+}
+
+size_t wxDVArrayDataSet::GetMemoryUsage() const {
+    return m_pData.capacity() * sizeof(wxRealPoint)
+           + m_yData.capacity() * sizeof(double)
+           + m_yFloat.capacity() * sizeof(float);
 }
 
 void wxDVArrayDataSet::SetSeriesTitle(const wxString &title) {
@@ -204,382 +467,444 @@ void wxDVArrayDataSet::SetUnits(const wxString &units) {
 }
 
 void wxDVArrayDataSet::SetTimeStep(double ts, bool recompute_x) {
+    InvalidateCalendarIndex();
     m_timestep = ts;
     if (recompute_x) RecomputeXData();
 }
 
 void wxDVArrayDataSet::SetOffset(double off, bool recompute_x) {
+    InvalidateCalendarIndex();
     m_offset = off;
     if (recompute_x) RecomputeXData();
 }
 
 void wxDVArrayDataSet::RecomputeXData() {
+    // compact storage has no x data, it is always computed from the offset and timestep
     for (size_t i = 0; i < m_pData.size(); i++)
         m_pData[i].x = m_offset + i * m_timestep;
 }
 
-// ******** Statistics data set *********** //
+// ******** Calendar index *********** //
 
-wxDVStatisticsDataSet::wxDVStatisticsDataSet(wxDVTimeSeriesDataSet *d) {
-    baseDataset = d;
-
-    double MinHrs = d->GetMinHours();
-    double MaxHrs = d->GetMaxHours();
-    double Offset = d->GetOffset();
-
-    //Create monthly and total statistics from m_data - start with very large number (2 billion) for Min variables and -2 billion for Max's, since we'll be looking for anything lower than this in the data.
-    wxString name = "";
-    double nextDay = 0.0;
-    double nextMonth = 0.0;
-    double currentMonth = 0.0;
-    double year = 0.0;
-    double counter = 0.0;
-    double sum = 0.0;
-    double avg = 0.0;
-    double min = 2000000000.0;
-    double max = -2000000000.0;
-    double StDev = 0.0;
-    double AvgDailyMin = 2000000000.0;
-    double AvgDailyMax = -2000000000.0;
-    int DayNumber = 0;
-    double DayCounter = 0.0;
-    double StDevCounter = 0.0;
-    double DayMins[31] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0,
-                          0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
-    double DayMaxs[31] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0,
-                          0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
-    int FirstOrdinalOfMonth = 0;
-    double totalcounter = 0.0;
-    double totalsum = 0.0;
-    double totalmin = 2000000000.0;
-    double totalmax = -2000000000.0;
-    std::vector<wxRealPoint> totalDayStats;
-    StatisticsPoint sp;
-    bool MultiYear = false;
-    int yrNum = 1;
-
-    while (MinHrs > 8760.0) {
-        year += 8760.0;
-        MinHrs -= 8760.0;
-        MaxHrs -= 8760.0;
-    }
+static const int s_monthStarts[13] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365};
+static const int s_leapMonthStarts[13] = {0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366};
 
-    if (MaxHrs > 8760) { MultiYear = true; }    //Determine if the dataset contains data for more than one year
+wxDVCalendarIndex::wxDVCalendarIndex() {
+    Clear();
+}
 
-    while (nextDay <= MinHrs) {
-        nextDay += 24.0;
-    }
+void wxDVCalendarIndex::Clear() {
+    m_firstCalendarYear = 0;
+    m_firstDay = 0;
+    m_length = 0;
+    m_days.clear();
+}
 
-    if (MinHrs >= 0.0 && MinHrs < 744.0) {
-        currentMonth = year;
-        nextMonth = year + 744.0;
-        name = "Jan";
-    }
-    else if (MinHrs >= 744.0 && MinHrs < 1416.0) {
-        currentMonth = year + 744.0;
-        nextMonth = year + 1416.0;
-        name = "Feb";
-    }
-    else if (MinHrs >= 1416.0 && MinHrs < 2160.0) {
-        currentMonth = year + 1416.0;
-        nextMonth = year + 2160.0;
-        name = "Mar";
-    }
-    else if (MinHrs >= 2160.0 && MinHrs < 2880.0) {
-        currentMonth = year + 2160.0;
-        nextMonth = year + 2880.0;
-        name = "Apr";
-    }
-    else if (MinHrs >= 2880.0 && MinHrs < 3624.0) {
-        currentMonth = year + 2880.0;
-        nextMonth = year + 3624.0;
-        name = "May";
-    }
-    else if (MinHrs >= 3624.0 && MinHrs < 4344.0) {
-        currentMonth = year + 3624.0;
-        nextMonth = year + 4344.0;
-        name = "Jun";
-    }
-    else if (MinHrs >= 4344.0 && MinHrs < 5088.0) {
-        currentMonth = year + 4344.0;
-        nextMonth = year + 5088.0;
-        name = "Jul";
+bool wxDVCalendarIndex::IsLeapYear(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+const int *wxDVCalendarIndex::MonthStarts(bool leap) {
+    return leap ? s_leapMonthStarts : s_monthStarts;
+}
+
+double wxDVCalendarIndex::YearHours(int year) const {
+    return m_firstCalendarYear > 0 && IsLeapYear(m_firstCalendarYear + year) ? 8784.0 : 8760.0;
+}
+
+double wxDVCalendarIndex::YearStart(int year) const {
+    double start = 0.0;
+    for (int y = 0; y < year; y++)
+        start += YearHours(y);
+    for (int y = -1; y >= year; y--)
+        start -= YearHours(y);
+    return start;
+}
+
+int wxDVCalendarIndex::CalendarYearFor(const wxDVTimeSeriesDataSet &d) {
+    // a single year of 8784 hours is a leap year; DView doesn't otherwise
+    // know the calendar year of the data
+    double span = d.Length() * d.GetTimeStep();
+    return fabs(span - 8784.0) < 0.5 * d.GetTimeStep() ? 2000 : 0;
+}
+
+void wxDVCalendarIndex::Build(const wxDVTimeSeriesDataSet &d, int firstCalendarYear) {
+    Clear();
+    m_firstCalendarYear = firstCalendarYear;
+    m_length = d.Length();
+    if (m_length == 0) return;
+
+    m_firstDay = (long) floor(d.At(0).x / 24.0);
+    long lastDay = (long) floor(d.At(m_length - 1).x / 24.0);
+    if (lastDay < m_firstDay) lastDay = m_firstDay;
+    m_days.resize(lastDay - m_firstDay + 1);
+
+    // year and day of year of the first day, then step through the days
+    int year = 0;
+    long yearFirstDay = 0;
+    while (m_firstDay >= yearFirstDay + (long) (YearHours(year) / 24)) {
+        yearFirstDay += (long) (YearHours(year) / 24);
+        year++;
     }
-    else if (MinHrs >= 5088.0 && MinHrs < 5832.0) {
-        currentMonth = year + 5088.0;
-        nextMonth = year + 5832.0;
-        name = "Aug";
+    while (m_firstDay < yearFirstDay) {
+        year--;
+        yearFirstDay -= (long) (YearHours(year) / 24);
     }
-    else if (MinHrs >= 5832.0 && MinHrs < 6552.0) {
-        currentMonth = year + 5832.0;
-        nextMonth = year + 6552.0;
-        name = "Sep";
+
+    // x is increasing, so the first sample of each day is found in one scan
+    size_t i = 0;
+    for (size_t k = 0; k < m_days.size(); k++) {
+        long serial = m_firstDay + (long) k;
+        int ndays = (int) (YearHours(year) / 24);
+        if (serial - yearFirstDay >= ndays) {
+            yearFirstDay += ndays;
+            year++;
+        }
+
+        Day &day = m_days[k];
+        day.year = year;
+        day.dayOfYear = (int) (serial - yearFirstDay);
+        day.start = 24.0 * serial;
+
+        const int *starts = MonthStarts(YearHours(year) > 8760.0);
+        int m = 0;
+        while (m < 11 && day.dayOfYear >= starts[m + 1])
+            m++;
+        day.month = m;
+
+        while (i < m_length && d.At(i).x < day.start)
+            i++;
+        day.first = i;
     }
-    else if (MinHrs >= 6552.0 && MinHrs < 7296.0) {
-        currentMonth = year + 6552.0;
-        nextMonth = year + 7296.0;
-        name = "Oct";
+}
+
+// ******** Statistics aggregator *********** //
+
+double wxDVStatisticsAggregator::Stats::StDev() const {
+    return count > 0 ? sqrt(m2 / count) : 0.0;
+}
+
+double wxDVStatisticsAggregator::Stats::AvgDailyMin() const {
+    return days > 0 ? dailyMinSum / days : 0.0;
+}
+
+double wxDVStatisticsAggregator::Stats::AvgDailyMax() const {
+    return days > 0 ? dailyMaxSum / days : 0.0;
+}
+
+wxDVStatisticsAggregator::wxDVStatisticsAggregator(Bucket bucket, int firstCalendarYear)
+        : m_bucket(bucket), m_firstCalendarYear(firstCalendarYear) {
+    Reset();
+}
+
+void wxDVStatisticsAggregator::Reset() {
+    m_buckets.clear();
+    InitStats(m_total, -1, 0, 0.0, 0.0);
+    m_finished = false;
+
+    SetYear(0, 0.0, 0);
+    m_dayOfYear = 0;
+    m_hourOfYear = 0.0;
+
+    if (m_bucket == HOUR_OF_DAY) {
+        for (int h = 0; h < 24; h++) {
+            Stats st;
+            InitStats(st, -1, h, h, h + 1);
+            m_buckets.push_back(st);
+        }
     }
-    else if (MinHrs >= 7296.0 && MinHrs < 8016.0) {
-        currentMonth = year + 7296.0;
-        nextMonth = year + 8016.0;
-        name = "Nov";
+}
+
+void wxDVStatisticsAggregator::SetYear(int year, double yearStart, long yearFirstDay) {
+    bool leap = m_firstCalendarYear > 0 && wxDVCalendarIndex::IsLeapYear(m_firstCalendarYear + year);
+    m_year = year;
+    m_yearStart = yearStart;
+    m_yearFirstDay = yearFirstDay;
+    m_yearHours = leap ? 8784.0 : 8760.0;
+    m_monthStarts = wxDVCalendarIndex::MonthStarts(leap);
+}
+
+void wxDVStatisticsAggregator::InitStats(Stats &s, int year, int index, double start, double end) {
+    s.year = year;
+    s.index = index;
+    s.start = start;
+    s.end = end;
+    s.count = 0;
+    s.sum = s.mean = s.m2 = 0.0;
+    s.min = s.max = 0.0;
+    s.days = 0;
+    s.dailyMinSum = s.dailyMaxSum = 0.0;
+    s.curDay = 0;
+    s.dayMin = s.dayMax = 0.0;
+}
+
+void wxDVStatisticsAggregator::Locate(double x) {
+    // move year by year from the year of the previous sample, which is
+    // at most one step for ordered data
+    while (x >= m_yearStart + m_yearHours)
+        SetYear(m_year + 1, m_yearStart + m_yearHours, m_yearFirstDay + (long) (m_yearHours / 24.0));
+
+    while (x < m_yearStart && m_year > 0) {
+        bool leap = m_firstCalendarYear > 0 && wxDVCalendarIndex::IsLeapYear(m_firstCalendarYear + m_year - 1);
+        double hours = leap ? 8784.0 : 8760.0;
+        SetYear(m_year - 1, m_yearStart - hours, m_yearFirstDay - (long) (hours / 24.0));
     }
-    else if (MinHrs >= 8016.0 && MinHrs < 8760.0) {
-        currentMonth = year + 8016.0;
-        nextMonth = year + 8760.0;
-        name = "Dec";
+
+    m_hourOfYear = x - m_yearStart;
+    if (m_hourOfYear < 0.0) m_hourOfYear = 0.0; // data before the first year
+    m_dayOfYear = (int) (m_hourOfYear / 24.0);
+    int ndays = (int) (m_yearHours / 24.0);
+    if (m_dayOfYear >= ndays) m_dayOfYear = ndays - 1;
+}
+
+wxDVStatisticsAggregator::Stats *wxDVStatisticsAggregator::GetBucket(int year, int index, double start, double end) {
+    if (m_buckets.empty() || m_buckets.back().year != year || m_buckets.back().index != index) {
+        Stats st;
+        InitStats(st, year, index, start, end);
+        m_buckets.push_back(st);
     }
+    return &m_buckets.back();
+}
 
-    if (MultiYear) {
-        name = "Year 1, " + name;
-    }    //If the dataset contains data for more than one year then append the year number to the name
-
-    for (size_t i = 0; i < d->Length(); i++) {
-        if (d->At(i).x >= nextDay) {
-            if (i != 0) {
-                DayMins[DayNumber] = (AvgDailyMin == 2000000000.0) ? 0.0 : AvgDailyMin;
-                DayMaxs[DayNumber] = (AvgDailyMax == -2000000000.0) ? 0.0 : AvgDailyMax;
-                totalDayStats.push_back(wxRealPoint(AvgDailyMin, AvgDailyMax));
-                DayNumber++;
-                AvgDailyMin = 2000000000.0;
-                AvgDailyMax = -2000000000.0;
-                nextDay += 24.0;
-            }
-        }
+void wxDVStatisticsAggregator::FoldDay(Stats &s) {
+    s.days++;
+    s.dailyMinSum += s.dayMin;
+    s.dailyMaxSum += s.dayMax;
+}
 
-        if (d->At(i).x >= nextMonth) {
-            if (i != 0 && counter != 0) {
-                AvgDailyMin = 0.0;
-                AvgDailyMax = 0.0;
-                avg = sum / counter;
-
-                //Calculate standard deviation for the month's data
-                StDev = 0.0;
-                StDevCounter = 0.0;
-                for (size_t j = FirstOrdinalOfMonth; j < i; j++) {
-                    StDev += (d->At(j).y - avg) * (d->At(j).y - avg);
-                    StDevCounter += 1.0;
-                }
-                if (StDevCounter > 0.0) {
-                    StDev = StDev / StDevCounter;
-                    StDev = sqrt(StDev);
-                }
-
-                //Summarize the daily Min and Max values into average daily min and max values for the month.
-                for (size_t j = 0; j < 31; j++) {
-                    if (DayMaxs[j] >
-                        0)    //Not every month will have 31 days and endpoints may be missing some days in the month, as denoted by a 0 maximum value
-                    {
-                        AvgDailyMin += DayMins[j];
-                        AvgDailyMax += DayMaxs[j];
-                        DayCounter += 1.0;
-                    }
-                }
-                if (DayCounter > 0.0) {
-                    AvgDailyMax = AvgDailyMax / DayCounter;
-                    AvgDailyMin = AvgDailyMin / DayCounter;
-                }
-
-                sp = StatisticsPoint();
-                if (Offset < 672.0 && Offset > 0.0)    //xOffset is within number of hours in the shortest month
-                {
-                    sp.x = currentMonth + Offset;
-                } else {
-                    sp.x = currentMonth + ((nextMonth - currentMonth) / 2.0);    //Make x the middle of the month
-                }
-                sp.name = name;
-                sp.Max = RoundSignificant(max);
-                sp.Min = RoundSignificant(min);
-                sp.Sum = RoundSignificant(sum);
-                sp.Mean = RoundSignificant(avg);
-                sp.StDev = RoundSignificant(StDev);
-                sp.AvgDailyMax = RoundSignificant(AvgDailyMax);
-                sp.AvgDailyMin = RoundSignificant(AvgDailyMin);
-
-                Append(sp);
-
-                currentMonth = nextMonth;
-                if (nextMonth == 744.0 + year) {
-                    nextMonth = 1416.0 + year;
-                    name = "Feb";
-                }
-                else if (nextMonth == 1416.0 + year) {
-                    nextMonth = 2160.0 + year;
-                    name = "Mar";
-                }
-                else if (nextMonth == 2160.0 + year) {
-                    nextMonth = 2880.0 + year;
-                    name = "Apr";
-                }
-                else if (nextMonth == 2880.0 + year) {
-                    nextMonth = 3624.0 + year;
-                    name = "May";
-                }
-                else if (nextMonth == 3624.0 + year) {
-                    nextMonth = 4344.0 + year;
-                    name = "Jun";
-                }
-                else if (nextMonth == 4344.0 + year) {
-                    nextMonth = 5088.0 + year;
-                    name = "Jul";
-                }
-                else if (nextMonth == 5088.0 + year) {
-                    nextMonth = 5832.0 + year;
-                    name = "Aug";
-                }
-                else if (nextMonth == 5832.0 + year) {
-                    nextMonth = 6552.0 + year;
-                    name = "Sep";
-                }
-                else if (nextMonth == 6552.0 + year) {
-                    nextMonth = 7296.0 + year;
-                    name = "Oct";
-                }
-                else if (nextMonth == 7296.0 + year) {
-                    nextMonth = 8016.0 + year;
-                    name = "Nov";
-                }
-                else if (nextMonth == 8016.0 + year) {
-                    nextMonth = 8760.0 + year;
-                    name = "Dec";
-                }
-                else if (nextMonth == 8760.0 + year) {
-                    year += 8760.0;
-                    nextMonth = 744.0 + year;
-                    name = "Jan";
-                    yrNum += 1;
-                }
-
-                if (MultiYear) {
-                    name = "Year " + wxString::Format("%d", yrNum) + ", " + name;
-                }    //If the dataset contains data for more than one year then prepend the year number to the name
-            }
+void wxDVStatisticsAggregator::Accumulate(Stats &s, double y, long day) {
+    if (s.count == 0) {
+        s.min = s.max = y;
+        s.curDay = day;
+        s.dayMin = s.dayMax = y;
+    } else {
+        if (y < s.min) s.min = y;
+        if (y > s.max) s.max = y;
 
-            counter = 0.0;
-            sum = 0.0;
-            avg = 0.0;
-            min = 2000000000.0;
-            max = -2000000000.0;
-            StDev = 0.0;
-            AvgDailyMin = 2000000000.0;
-            AvgDailyMax = -2000000000.0;
-            DayNumber = 0;
-            DayCounter = 0.0;
-            FirstOrdinalOfMonth = i;
+        if (day != s.curDay) {
+            FoldDay(s);
+            s.curDay = day;
+            s.dayMin = s.dayMax = y;
+        } else {
+            if (y < s.dayMin) s.dayMin = y;
+            if (y > s.dayMax) s.dayMax = y;
         }
-
-        counter += 1.0;
-        totalcounter += 1.0;
-        sum += d->At(i).y;
-        totalsum += d->At(i).y;
-        if (min > d->At(i).y) { min = d->At(i).y; }
-        if (totalmin > d->At(i).y) { totalmin = d->At(i).y; }
-        if (max < d->At(i).y) { max = d->At(i).y; }
-        if (totalmax < d->At(i).y) { totalmax = d->At(i).y; }
-        if (AvgDailyMin > d->At(i).y) { AvgDailyMin = d->At(i).y; }
-        if (AvgDailyMax < d->At(i).y) { AvgDailyMax = d->At(i).y; }
     }
 
-    if (MaxHrs > 0.0 && fmod(MaxHrs, 8760.0) !=
-                        0)    //Prevent appending the final point if it represents 12/31 24:00, which the system interprets as 1/1 0:00 and creates a point for January of the next year
-    {
-        DayMins[DayNumber] = AvgDailyMin;
-        DayMaxs[DayNumber] = AvgDailyMax;
-        totalDayStats.push_back(wxRealPoint(AvgDailyMin, AvgDailyMax));
-        AvgDailyMin = 0.0;
-        AvgDailyMax = 0.0;
-
-        avg = sum / counter;
-
-        //Calculate standard deviation for the month's data
-        StDev = 0.0;
-        StDevCounter = 0.0;
-        for (size_t j = FirstOrdinalOfMonth; j < d->Length(); j++) {
-            StDev += (d->At(j).y - avg) * (d->At(j).y - avg);
-            StDevCounter += 1.0;
+    s.count++;
+    s.sum += y;
+    double delta = y - s.mean;
+    s.mean += delta / s.count;
+    s.m2 += delta * (y - s.mean);
+}
+
+void wxDVStatisticsAggregator::Add(double x, double y) {
+    Locate(x);
+    AddLocated(y, m_yearFirstDay + m_dayOfYear);
+}
+
+void wxDVStatisticsAggregator::AddLocated(double y, long day) {
+    Stats *b = 0;
+    switch (m_bucket) {
+        case MONTH: {
+            int m = 0;
+            while (m < 11 && m_dayOfYear >= m_monthStarts[m + 1])
+                m++;
+            b = GetBucket(m_year, m, m_yearStart + 24.0 * m_monthStarts[m],
+                          m_yearStart + 24.0 * m_monthStarts[m + 1]);
+            break;
+        }
+        case WEEK: {
+            int w = m_dayOfYear / 7;
+            b = GetBucket(m_year, w, m_yearStart + 168.0 * w,
+                          std::min(m_yearStart + 168.0 * (w + 1), m_yearStart + m_yearHours));
+            break;
         }
-        if (StDevCounter > 0.0) {
-            StDev = StDev / StDevCounter;
-            StDev = sqrt(StDev);
+        case DAY:
+            b = GetBucket(m_year, m_dayOfYear, m_yearStart + 24.0 * m_dayOfYear,
+                          m_yearStart + 24.0 * (m_dayOfYear + 1));
+            break;
+        case HOUR_OF_DAY: {
+            int h = (int) (m_hourOfYear - 24.0 * m_dayOfYear);
+            if (h > 23) h = 23;
+            if (h < 0) h = 0;
+            b = &m_buckets[h];
+            break;
         }
+    }
 
-        //Summarize the daily Min and Max values into average daily min and max values for the month.
-        for (size_t j = 0; j < 31; j++) {
-            if (DayMaxs[j] >
-                0)    //Not every month will have 31 days and endpoints may be missing some days in the month, as denoted by a 0 maximum value
-            {
-                AvgDailyMin += DayMins[j];
-                AvgDailyMax += DayMaxs[j];
-                DayCounter += 1.0;
-            }
+    Accumulate(*b, y, day);
+    Accumulate(m_total, y, day);
+}
+
+void wxDVStatisticsAggregator::Add(wxDVTimeSeriesDataSet *d) {
+    const wxDVCalendarIndex &cal = d->GetCalendarIndex();
+    if (cal.GetFirstCalendarYear() != m_firstCalendarYear) {
+        size_t len = d->Length();
+        for (size_t i = 0; i < len; i++) {
+            wxRealPoint p(d->At(i));
+            Add(p.x, p.y);
         }
-        if (DayCounter > 0.0) {
-            AvgDailyMax = AvgDailyMax / DayCounter;
-            AvgDailyMin = AvgDailyMin / DayCounter;
+        return;
+    }
+
+    // the calendar position only changes from one day to the next
+    for (size_t k = 0; k < cal.Days(); k++) {
+        const wxDVCalendarIndex::Day &day = cal.At(k);
+        size_t end = cal.End(k);
+        if (day.first >= end) continue;
+
+        if (day.year != m_year || k == 0) {
+            double yearStart = cal.YearStart(day.year);
+            SetYear(day.year, yearStart, (long) floor(yearStart / 24.0 + 0.5));
         }
+        m_dayOfYear = day.dayOfYear;
 
-        sp = StatisticsPoint();
-        if (Offset < 672.0 && Offset > 0.0)    //xOffset is within number of hours in the shortest month
-        {
-            sp.x = currentMonth + Offset;
-        } else {
-            sp.x = currentMonth + ((nextMonth - currentMonth) / 2.0);    //Make x the middle of the month
+        long serial = m_yearFirstDay + m_dayOfYear;
+        for (size_t i = day.first; i < end; i++) {
+            wxRealPoint p(d->At(i));
+            m_hourOfYear = p.x - m_yearStart;
+            AddLocated(p.y, serial);
         }
-        sp.name = name;
-        sp.Max = RoundSignificant(max);
-        sp.Min = RoundSignificant(min);
-        sp.Sum = RoundSignificant(sum);
-        sp.Mean = RoundSignificant(avg);
-        sp.StDev = RoundSignificant(StDev);
-        sp.AvgDailyMax = RoundSignificant(AvgDailyMax);
-        sp.AvgDailyMin = RoundSignificant(AvgDailyMin);
+    }
+}
+
+void wxDVStatisticsAggregator::Finish() {
+    if (m_finished) return;
+    m_finished = true;
+
+    for (size_t i = 0; i < m_buckets.size(); i++)
+        if (m_buckets[i].count > 0)
+            FoldDay(m_buckets[i]);
+
+    if (m_total.count > 0) {
+        FoldDay(m_total);
+        m_total.start = m_buckets.empty() ? 0.0 : m_buckets.front().start;
+        m_total.end = m_buckets.empty() ? 0.0 : m_buckets.back().end;
+    }
+}
+
+// ******** Statistics data set *********** //
 
+wxDVStatisticsDataSet::wxDVStatisticsDataSet(wxDVTimeSeriesDataSet *d, bool compute)
+        : baseDataset(d), m_computed(false) {
+    if (compute) Compute();
+}
+
+void wxDVStatisticsDataSet::Compute() {
+    if (m_computed) return;
+    m_computed = true;
+
+    wxDVTimeSeriesDataSet *d = baseDataset;
+    size_t len = d->Length();
+    if (len == 0) return;
+
+    wxDVStatisticsAggregator agg(wxDVStatisticsAggregator::MONTH, wxDVCalendarIndex::CalendarYearFor(*d));
+    agg.Add(d);
+    agg.Finish();
+
+    // a last point at exactly the end of a year is 1/1 0:00 of the next
+    // year: don't show a month for it
+    size_t nmonths = agg.Count();
+    double maxHrs = d->At(len - 1).x;
+    if (nmonths > 1 && maxHrs > 0.0 && agg.At(nmonths - 1).start == maxHrs
+        && agg.At(nmonths - 1).index == 0 && agg.At(nmonths - 1).count == 1)
+        nmonths--;
+
+    bool multiYear = nmonths > 0 && agg.At(0).year != agg.At(nmonths - 1).year;
+
+    static const char *monthNames[12] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                         "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+    double offset = d->GetOffset();
+    m_sData.reserve(nmonths + 1);
+    for (size_t i = 0; i < nmonths; i++) {
+        const wxDVStatisticsAggregator::Stats &st = agg.At(i);
+
+        StatisticsPoint sp = StatisticsPoint();
+        if (offset < 672.0 && offset > 0.0)    //xOffset is within number of hours in the shortest month
+            sp.x = st.start + offset;
+        else
+            sp.x = st.start + ((st.end - st.start) / 2.0);    //Make x the middle of the month
+
+        sp.name = monthNames[st.index];
+        if (multiYear)
+            sp.name = "Year " + wxString::Format("%d", st.year - agg.At(0).year + 1) + ", " + sp.name;
+
+        sp.Max = RoundSignificant(st.max);
+        sp.Min = RoundSignificant(st.min);
+        sp.Sum = RoundSignificant(st.sum);
+        sp.Mean = RoundSignificant(st.mean);
+        sp.StDev = RoundSignificant(st.StDev());
+        sp.AvgDailyMax = RoundSignificant(st.AvgDailyMax());
+        sp.AvgDailyMin = RoundSignificant(st.AvgDailyMin());
         Append(sp);
     }
 
     //Append StatisticsPoint for totals over all months
+    const wxDVStatisticsAggregator::Stats &total = agg.Total();
+    StatisticsPoint sp = StatisticsPoint();
+    sp.x = maxHrs + 1.0;    //Make x one greater than the last x value in the dataset
+    sp.name = "Total";
+    sp.Max = RoundSignificant(total.max);
+    sp.Min = RoundSignificant(total.min);
+    sp.Sum = RoundSignificant(total.sum);
+    sp.Mean = RoundSignificant(total.mean);
+    sp.StDev = RoundSignificant(total.StDev());
+    sp.AvgDailyMax = RoundSignificant(total.AvgDailyMax());
+    sp.AvgDailyMin = RoundSignificant(total.AvgDailyMin());
+    Append(sp);
+}
 
-    AvgDailyMin = 0.0;
-    AvgDailyMax = 0.0;
-    avg = totalsum / totalcounter;
-
-    //Calculate standard deviation for the month's data
-    StDev = 0.0;
-    StDevCounter = 0.0;
-    for (size_t j = 0; j < d->Length(); j++) {
-        StDev += (d->At(j).y - avg) * (d->At(j).y - avg);
-        StDevCounter += 1.0;
+class StatisticsThread : public wxThread {
+    const std::vector<wxDVStatisticsDataSet *> *m_list;
+    size_t m_first, m_stride;
+public:
+    StatisticsThread(const std::vector<wxDVStatisticsDataSet *> *list, size_t first, size_t stride)
+            : wxThread(wxTHREAD_JOINABLE), m_list(list), m_first(first), m_stride(stride) {
     }
-    if (StDevCounter > 0.0) {
-        StDev = StDev / StDevCounter;
-        StDev = sqrt(StDev);
+
+    static void Run(const std::vector<wxDVStatisticsDataSet *> &list, size_t first, size_t stride) {
+        for (size_t i = first; i < list.size(); i += stride)
+            list[i]->Compute();
     }
 
-    //Summarize the daily Min and Max values into average daily min and max values for the month.
-    DayCounter = 0.0;
-    for (size_t j = 0; j < totalDayStats.size(); j++) {
-        AvgDailyMin += totalDayStats[j].x;
-        AvgDailyMax += totalDayStats[j].y;
-        DayCounter += 1.0;
+    virtual void *Entry() {
+        Run(*m_list, m_first, m_stride);
+        return 0;
     }
-    if (DayCounter > 0.0) {
-        AvgDailyMax = AvgDailyMax / DayCounter;
-        AvgDailyMin = AvgDailyMin / DayCounter;
+};
+
+void wxDVStatisticsDataSet::ComputeAll(const std::vector<wxDVStatisticsDataSet *> &all) {
+    std::vector<wxDVStatisticsDataSet *> list;
+    for (size_t i = 0; i < all.size(); i++)
+        if (!all[i]->IsComputed())
+            list.push_back(all[i]);
+
+    if (list.empty()) return;
+
+    // the data sets are interleaved over one thread per CPU
+    int ncpu = wxThread::GetCPUCount();
+    size_t nthreads = std::max((size_t) 1, std::min((size_t) std::max(ncpu, 1), list.size()));
+
+    std::vector<StatisticsThread *> threads;
+    for (size_t t = 1; t < nthreads; t++) {
+        StatisticsThread *th = new StatisticsThread(&list, t, nthreads);
+        if (th->Run() == wxTHREAD_NO_ERROR)
+            threads.push_back(th);
+        else {
+            delete th;
+            StatisticsThread::Run(list, t, nthreads);
+        }
     }
 
-    sp = StatisticsPoint();
-    sp.x = d->At(d->Length() - 1).x + 1.0;    //Make x one greater than the last x value in the dataset
-    sp.name = "Total";
-    sp.Max = RoundSignificant(totalmax);
-    sp.Min = RoundSignificant(totalmin);
-    sp.Sum = RoundSignificant(totalsum);
-    sp.Mean = RoundSignificant(avg);
-    sp.StDev = RoundSignificant(StDev);
-    sp.AvgDailyMax = RoundSignificant(AvgDailyMax);
-    sp.AvgDailyMin = RoundSignificant(AvgDailyMin);
+    // the calling thread takes the first share itself
+    StatisticsThread::Run(list, 0, nthreads);
 
-    Append(sp);
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i]->Wait();
+        delete threads[i];
+    }
 }
 
 double wxDVStatisticsDataSet::RoundSignificant(double ValueToRound, size_t NumSignifDigits) {
@@ -878,3 +878,408 @@ void *wxEasyCurlThread::Entry() {
 
 
 
+
+struct wxEasyCurlBatch::Transfer {
+    size_t index;
+    wxString url, file, proxy;
+    wxEasyCurlBatch::MultiThread *thread;
+    CURL *curl;
+    FILE *fp;
+    wxMemoryBuffer data;
+    double lastBytes;
+    CURLcode resultCode;
+    wxString error;
+    bool done;
+
+    Transfer(size_t i, const wxString &u, const wxString &f)
+            : index(i), url(u), file(f), thread(0), curl(0), fp(0),
+              lastBytes(-1), resultCode(CURLE_OK), done(false) {
+    }
+};
+
+extern "C" {
+int easycurl_batch_progress_func(void *ptr, double rDlTotal, double rDlNow,
+                                 double rUlTotal, double rUlNow);
+size_t easycurl_batch_stream_write(void *ptr, size_t size, size_t nmemb, void *stream);
+}; // extern "C"
+
+class wxEasyCurlBatch::MultiThread : public wxThread {
+public:
+    wxEasyCurlBatch *m_batch;
+    std::vector<Transfer *> m_queue;
+
+    bool m_threadDone;
+    wxMutex m_threadDoneLock;
+
+    bool m_canceled;
+    wxMutex m_canceledLock;
+
+    MultiThread(wxEasyCurlBatch *batch, const std::vector<Transfer *> &queue)
+            : wxThread(wxTHREAD_JOINABLE),
+              m_batch(batch),
+              m_queue(queue),
+              m_threadDone(false),
+              m_canceled(false) {
+    }
+
+    void IssueEvent(Transfer *t, int code, const wxString &msg, double bytes = 0.0, double total = 0.0) {
+        if (m_batch->m_handler != 0) {
+            wxEasyCurlEvent *evt = new wxEasyCurlEvent(m_batch->m_id, wxEASYCURL_EVENT,
+                                                       code, msg, t ? t->url : wxString(), bytes, total);
+            evt->SetIndex(t ? (int) t->index : -1);
+            wxQueueEvent(m_batch->m_handler, evt);
+        }
+    }
+
+    void IssueProgressEvent(Transfer *t, double rDlTotal, double rDlNow) {
+        // libcurl calls this very often, only report actual progress
+        if (rDlNow != t->lastBytes) {
+            t->lastBytes = rDlNow;
+            IssueEvent(t, wxEasyCurlEvent::PROGRESS, "progress", rDlNow, rDlTotal);
+        }
+    }
+
+    size_t Write(Transfer *t, void *p, size_t len) {
+        if (t->fp != 0)
+            return fwrite(p, 1, len, t->fp);
+
+        // increase memory buffer size in 1 MB increments as needed
+        if (t->data.GetDataLen() + len > t->data.GetBufSize())
+            t->data.SetBufSize(t->data.GetBufSize() + 1048576);
+
+        t->data.AppendData(p, len);
+        return len;
+    }
+
+    bool Begin(CURLM *multi, CURLSH *share, curl_slist *headers, Transfer *t) {
+        if (!t->file.IsEmpty()) {
+            t->fp = wxFopen(t->file, "wb");
+            if (t->fp == 0) {
+                t->resultCode = CURLE_WRITE_ERROR;
+                t->error = "could not open " + t->file + " for writing";
+                return false;
+            }
+        }
+
+        t->curl = curl_easy_init();
+        if (t->curl == 0) {
+            t->resultCode = CURLE_FAILED_INIT;
+            t->error = curl_easy_strerror(t->resultCode);
+            return false;
+        }
+
+        CURL *curl = t->curl;
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+        wxURI uri(t->url);
+        wxString encoded = uri.BuildURI();
+        curl_easy_setopt(curl, CURLOPT_URL, (const char *) encoded.c_str());
+
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, t);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, easycurl_batch_stream_write);
+
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0);
+        curl_easy_setopt(curl, CURLOPT_PROGRESSDATA, t);
+        curl_easy_setopt(curl, CURLOPT_PROGRESSFUNCTION, easycurl_batch_progress_func);
+
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, t);
+
+        if (!t->proxy.IsEmpty()) {
+            wxURI uri_proxy(t->proxy);
+            wxString encoded_proxy = uri_proxy.BuildURI();
+            curl_easy_setopt(curl, CURLOPT_PROXY, (const char *) encoded_proxy.ToAscii());
+        }
+
+        if (curl_multi_add_handle(multi, curl) != CURLM_OK) {
+            t->resultCode = CURLE_FAILED_INIT;
+            t->error = curl_easy_strerror(t->resultCode);
+            return false;
+        }
+
+        IssueEvent(t, wxEasyCurlEvent::STARTED, "started");
+        return true;
+    }
+
+    void End(CURLM *multi, Transfer *t) {
+        if (t->curl != 0) {
+            curl_multi_remove_handle(multi, t->curl);
+            curl_easy_cleanup(t->curl);
+            t->curl = 0;
+        }
+
+        if (t->fp != 0) {
+            if (fclose(t->fp) != 0 && t->resultCode == CURLE_OK) {
+                t->resultCode = CURLE_WRITE_ERROR;
+                t->error = "could not write " + t->file;
+            }
+            t->fp = 0;
+            // don't leave partial files behind
+            if (t->resultCode != CURLE_OK)
+                wxRemoveFile(t->file);
+        }
+
+        if (t->resultCode != CURLE_OK && t->error.IsEmpty())
+            t->error = curl_easy_strerror(t->resultCode);
+
+        m_batch->m_transfersLock.Lock();
+        t->done = true;
+        m_batch->m_transfersLock.Unlock();
+
+        IssueEvent(t, wxEasyCurlEvent::FINISHED, "finished");
+    }
+
+    virtual void *Entry() {
+        CURLM *multi = curl_multi_init();
+        CURLSH *share = curl_share_init();
+        if (multi == 0 || share == 0) {
+            for (size_t i = 0; i < m_queue.size(); i++) {
+                m_queue[i]->resultCode = CURLE_FAILED_INIT;
+                End(multi, m_queue[i]);
+            }
+        } else {
+            // all transfers run on this thread, so the shared
+            // DNS and TLS session caches need no locking
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+            curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, (long) m_batch->m_maxConnections);
+#ifdef CURLPIPE_MULTIPLEX
+            curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+
+            struct curl_slist *headers = NULL;
+            for (size_t i = 0; i < m_batch->m_httpHeaders.size(); i++)
+                headers = curl_slist_append(headers, (const char *) m_batch->m_httpHeaders[i].c_str());
+
+            size_t next = 0, active = 0;
+            int running = 0;
+            while (next < m_queue.size() || active > 0) {
+                if (IsCanceled())
+                    break;
+
+                // keep the multi handle filled up to the connection limit
+                while (next < m_queue.size() && active < (size_t) m_batch->m_maxConnections) {
+                    Transfer *t = m_queue[next++];
+                    if (Begin(multi, share, headers, t))
+                        active++;
+                    else
+                        End(multi, t);
+                }
+
+                curl_multi_perform(multi, &running);
+
+                int nmsgs = 0;
+                while (CURLMsg *msg = curl_multi_info_read(multi, &nmsgs)) {
+                    if (msg->msg != CURLMSG_DONE)
+                        continue;
+
+                    Transfer *t = 0;
+                    curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **) &t);
+                    if (t != 0) {
+                        t->resultCode = msg->data.result;
+                        End(multi, t);
+                        active--;
+                    }
+                }
+
+                if (active > 0)
+                    curl_multi_wait(multi, NULL, 0, 100, NULL);
+            }
+
+            // canceled: abort whatever is still queued or running
+            for (size_t i = 0; i < m_queue.size(); i++) {
+                if (!m_queue[i]->done) {
+                    if (m_queue[i]->resultCode == CURLE_OK)
+                        m_queue[i]->resultCode = CURLE_ABORTED_BY_CALLBACK;
+                    End(multi, m_queue[i]);
+                }
+            }
+
+            curl_slist_free_all(headers);
+        }
+
+        if (multi != 0) curl_multi_cleanup(multi);
+        if (share != 0) curl_share_cleanup(share);
+
+        m_threadDoneLock.Lock();
+        m_threadDone = true;
+        m_threadDoneLock.Unlock();
+
+        IssueEvent(0, wxEasyCurlEvent::BATCH_FINISHED, "finished");
+        return 0;
+    }
+
+    bool IsDone() {
+        wxMutexLocker _ml(m_threadDoneLock);
+        return m_threadDone;
+    }
+
+    bool IsCanceled() {
+        wxMutexLocker _ml(m_canceledLock);
+        return m_canceled;
+    }
+
+    void Cancel() {
+        wxMutexLocker _ml(m_canceledLock);
+        m_canceled = true;
+    }
+
+    virtual bool TestDestroy() { return IsCanceled(); }
+};
+
+extern "C" {
+int easycurl_batch_progress_func(void *userp, double rDlTotal, double rDlNow,
+                                 double, double) {
+    if (wxEasyCurlBatch::Transfer *t = static_cast<wxEasyCurlBatch::Transfer *>(userp)) {
+        t->thread->IssueProgressEvent(t, rDlTotal, rDlNow);
+        if (t->thread->IsCanceled())
+            return -1; // return non zero should cancel
+    }
+
+    return 0;
+}
+
+size_t easycurl_batch_stream_write(void *ptr, size_t size, size_t nmemb, void *userp) {
+    wxEasyCurlBatch::Transfer *t = static_cast<wxEasyCurlBatch::Transfer *>(userp);
+    if (t) return t->thread->Write(t, ptr, size * nmemb);
+    else return 0;
+}
+}; // extern "C"
+
+wxEasyCurlBatch::wxEasyCurlBatch(wxEvtHandler *handler, int id)
+        : m_thread(0), m_handler(handler), m_id(id), m_maxConnections(8) {
+}
+
+wxEasyCurlBatch::~wxEasyCurlBatch() {
+    Clear();
+}
+
+void wxEasyCurlBatch::Clear() {
+    if (m_thread) {
+        m_thread->Cancel();
+        m_thread->Wait();
+        delete m_thread;
+        m_thread = 0;
+    }
+
+    for (size_t i = 0; i < m_transfers.size(); i++)
+        delete m_transfers[i];
+    m_transfers.clear();
+}
+
+void wxEasyCurlBatch::SetEventHandler(wxEvtHandler *hh, int id) {
+    m_handler = hh;
+    m_id = id;
+}
+
+size_t wxEasyCurlBatch::Add(const wxString &url, const wxString &file) {
+    // the running transfer thread works on the list it was started with
+    wxCHECK_MSG(m_thread == 0 || IsFinished(), (size_t) -1, wxT("cannot add to a running wxEasyCurlBatch"));
+
+    // a finished batch is discarded when new urls are queued
+    if (m_thread != 0)
+        Clear();
+
+    wxString escaped_url(url);
+
+    for (StringHash::iterator it = gs_urlEscapes.begin();
+         it != gs_urlEscapes.end();
+         ++it)
+        escaped_url.Replace(it->first, it->second, true);
+
+    Transfer *t = new Transfer(m_transfers.size(), escaped_url, file);
+    t->proxy = wxEasyCurl::GetProxyForURL(escaped_url);
+
+    wxMutexLocker _lock(m_transfersLock);
+    m_transfers.push_back(t);
+    return t->index;
+}
+
+void wxEasyCurlBatch::Start() {
+    if (m_thread != 0)
+        return;
+
+    m_thread = new MultiThread(this, m_transfers);
+    for (size_t i = 0; i < m_transfers.size(); i++)
+        m_transfers[i]->thread = m_thread;
+
+    m_thread->Create();
+    m_thread->Run();
+}
+
+bool wxEasyCurlBatch::Wait(bool yield) {
+    while (m_thread != 0 && !IsFinished()) {
+        if (yield) wxTheApp->Yield(true);
+        wxMilliSleep(50);
+    }
+
+    for (size_t i = 0; i < m_transfers.size(); i++)
+        if (!Ok(i))
+            return false;
+
+    return true;
+}
+
+bool wxEasyCurlBatch::IsFinished() {
+    return (m_thread != 0 && m_thread->IsDone() && !m_thread->IsRunning());
+}
+
+void wxEasyCurlBatch::Cancel() {
+    if (m_thread != 0)
+        m_thread->Cancel();
+}
+
+wxEasyCurlBatch::Transfer *wxEasyCurlBatch::GetFinished(size_t i) {
+    wxMutexLocker _lock(m_transfersLock);
+    if (i < m_transfers.size() && m_transfers[i]->done)
+        return m_transfers[i];
+    else
+        return 0;
+}
+
+bool wxEasyCurlBatch::IsFinished(size_t i) {
+    return GetFinished(i) != 0;
+}
+
+bool wxEasyCurlBatch::Ok(size_t i) {
+    Transfer *t = GetFinished(i);
+    return t != 0 && t->resultCode == CURLE_OK;
+}
+
+wxString wxEasyCurlBatch::GetLastError(size_t i) {
+    Transfer *t = GetFinished(i);
+    return t != 0 ? t->error : wxString(wxEmptyString);
+}
+
+wxString wxEasyCurlBatch::GetDataAsString(size_t i) {
+    wxString d;
+    if (Transfer *t = GetFinished(i)) {
+        wxStringOutputStream sstream(&d);
+        sstream.Write(t->data.GetData(), t->data.GetDataLen());
+    }
+    return d;
+}
+
+wxImage wxEasyCurlBatch::GetDataAsImage(size_t i, wxBitmapType bittype) {
+    wxImage img;
+    if (Transfer *t = GetFinished(i)) {
+        wxMemoryInputStream stream(t->data.GetData(), t->data.GetDataLen());
+        img.LoadFile(stream, bittype);
+    }
+    return img;
+}
+
+bool wxEasyCurlBatch::WriteDataToFile(size_t i, const wxString &file) {
+    Transfer *t = GetFinished(i);
+    if (t == 0) return false;
+
+    wxFFileOutputStream ff(file, "wb");
+    if (ff.IsOk())
+        ff.Write(t->data.GetData(), t->data.GetDataLen());
+    return ff.IsOk();
+}
@@ -15,6 +15,15 @@
 #include <wx/debug.h>
 #include <wx/log.h>
 
+#include <deque>
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 /*! \class wxJSONReader
  \brief The JSON parser
 
@@ -167,6 +176,147 @@ static const wxChar* traceMask = _T("traceReader");
 static const wxChar* storeTraceMask = _T("StoreComment");
 #endif
 
+// a value read by the event parser and not yet reported to the handler:
+// the counterpart of the 'value' object in DoRead()
+struct wxJSONToken {
+    enum {
+        INVALID, NULLVAL, BOOL, INT, UINT, DOUBLE, STRING, MEMORYBUFF, CONTAINER
+    };
+    int type;
+    bool b;
+#if defined( wxJSON_64BIT_INT )
+    wxInt64 i;
+    wxUint64 u;
+#else
+    int i;
+    unsigned int u;
+#endif
+    double d;
+    wxString s;
+    std::string bytes; // memory buffer content
+
+    wxJSONToken() : type(INVALID) {}
+
+    bool IsValid() const { return type != INVALID; }
+
+    void Reset() {
+        if (type == STRING) s.clear();
+        if (type == MEMORYBUFF) bytes.clear();
+        type = INVALID;
+    }
+};
+
+// builds the wxJSONValue tree from the event parser: this is how
+// Parse( ..., wxJSONValue* ) is implemented unless comments are stored
+class wxJSONTreeBuilder : public wxJSONHandler {
+    wxJSONValue m_temp;
+    wxJSONValue *m_root;
+    std::vector<wxJSONValue *> m_stack;
+    std::deque<wxJSONValue> m_detached;
+    wxString m_key;
+    bool m_hasKey;
+
+    // the place where the next value goes
+    wxJSONValue *Slot() {
+        wxJSONValue *parent = m_stack.back();
+        if (parent->IsArray()) {
+            return &(parent->Append(wxJSONValue()));
+        } else if (m_hasKey) {
+            m_hasKey = false;
+            return &((*parent)[m_key]);
+        } else {
+            // the reader already reported the missing key: drop the value
+            m_detached.push_back(wxJSONValue());
+            return &m_detached.back();
+        }
+    }
+
+    bool Start(wxJSONType type) {
+        if (m_stack.empty()) {
+            // the root value keeps its content if it already has this type
+            m_root->SetType(type);
+            m_stack.push_back(m_root);
+        } else {
+            wxJSONValue *slot = Slot();
+            *slot = wxJSONValue(type);
+            m_stack.push_back(slot);
+        }
+        return true;
+    }
+
+    bool Store(const wxJSONValue &v) {
+        *Slot() = v;
+        return true;
+    }
+
+public:
+    wxJSONTreeBuilder(wxJSONValue *root)
+            : m_root(root ? root : &m_temp), m_hasKey(false) {
+    }
+
+    virtual bool StartObject() { return Start(wxJSONTYPE_OBJECT); }
+
+    virtual bool EndObject() {
+        m_stack.pop_back();
+        return true;
+    }
+
+    virtual bool StartArray() { return Start(wxJSONTYPE_ARRAY); }
+
+    virtual bool EndArray() {
+        m_stack.pop_back();
+        return true;
+    }
+
+    virtual bool Key(const wxString &key) {
+        m_key = key;
+        m_hasKey = true;
+        return true;
+    }
+
+    virtual bool Null() { return Store(wxJSONValue(wxJSONTYPE_NULL)); }
+
+    virtual bool Bool(bool b) { return Store(wxJSONValue(b)); }
+
+    // numbers in arrays are packed as long as the array is homogeneous
+    // (see wxJSONValue::AppendPackedInt())
+#if defined( wxJSON_64BIT_INT )
+
+    virtual bool Int(wxInt64 i) {
+        if (m_stack.back()->IsArray()) {
+            m_stack.back()->AppendPackedInt(i);
+            return true;
+        }
+        return Store(wxJSONValue(i));
+    }
+
+    virtual bool UInt(wxUint64 u) { return Store(wxJSONValue(u)); }
+
+#else
+    virtual bool Int( int i ) {
+        if ( m_stack.back()->IsArray() ) {
+            m_stack.back()->AppendPackedInt( i );
+            return true;
+        }
+        return Store( wxJSONValue( i ) );
+    }
+
+    virtual bool UInt( unsigned int u ) { return Store( wxJSONValue( u ) ); }
+#endif
+
+    virtual bool Double(double d) {
+        if (m_stack.back()->IsArray()) {
+            m_stack.back()->AppendPackedDouble(d);
+            return true;
+        }
+        return Store(wxJSONValue(d));
+    }
+
+    virtual bool String(const wxString &s) { return Store(wxJSONValue(s)); }
+
+    virtual bool MemoryBuff(const wxMemoryBuffer &b) { return Store(wxJSONValue(b)); }
+};
+
 //! Ctor
 /*!
  Construct a JSON parser object with the given parameters.
@@ -230,6 +380,9 @@ wxJSONReader::wxJSONReader(int flags, int maxErrors) {
     m_flags = flags;
     m_maxErrors = maxErrors;
     m_noUtf8 = false;
+    m_ptr = m_end = 0;
+    m_handler = 0;
+    m_stopped = false;
 
     m_skip_string_double_quotes = false; // normal behavior JSON strings start with " and end with "
 
@@ -314,11 +467,16 @@ wxJSONReader::Parse(const wxString &doc, wxJSONValue *val) {
     readBuff = utf8CB.data();
 #endif
 
-    // now construct the temporary memory input stream
     size_t len = strlen(readBuff);
-    wxMemoryInputStream is(readBuff, len);
-
-    int numErr = Parse(is, val);
+    int numErr;
+    if (m_flags & wxJSONREADER_STORE_COMMENTS) {
+        // comments are attached to tree nodes: use the stream reader
+        wxMemoryInputStream is(readBuff, len);
+        numErr = DoParse(is, val);
+    } else {
+        wxJSONTreeBuilder builder(val);
+        numErr = Parse(readBuff, len, builder);
+    }
 #if !defined( wxJSON_USE_UNICODE )
     m_noUtf8 = noUtf8_bak;
 #endif
@@ -328,6 +486,26 @@ wxJSONReader::Parse(const wxString &doc, wxJSONValue *val) {
 //! \overload Parse( const wxString&, wxJSONValue* )
 int
 wxJSONReader::Parse(wxInputStream &is, wxJSONValue *val) {
+    if (m_flags & wxJSONREADER_STORE_COMMENTS) {
+        return DoParse(is, val);
+    }
+
+    // read the whole stream once and parse the bytes in memory, which
+    // is much faster than the per-character stream calls of DoRead()
+    wxMemoryBuffer buff;
+    ReadAll(is, buff);
+    wxJSONTreeBuilder builder(val);
+    return Parse((const char *) buff.GetData(), buff.GetDataLen(), builder);
+}
+
+//! Parse a stream building the value tree directly
+/*!
+ This is the original tree-building parser. It is only used when comments
+ have to be stored in the values they refer to, because that needs the
+ tree nodes while parsing.
+ */
+int
+wxJSONReader::DoParse(wxInputStream &is, wxJSONValue *val) {
     // if val == 0 the 'temp' JSON value will be passed to DoRead()
     wxJSONValue temp;
     m_level = 0;
@@ -777,9 +955,7 @@ wxJSONReader::StoreValue(int ch, const wxString &key, wxJSONValue &value, wxJSON
             }
             wxLogTrace(traceMask, _T("(%s) appending value to parent array"),
                        __PRETTY_FUNCTION__);
-            parent.Append(value);
-            const wxJSONInternalArray *arr = wxJSONValueAsArray(parent);wxJSON_ASSERT(arr);
-            m_lastStored = &(arr->Last());
+            m_lastStored = &(parent.Append(value));
             m_lastStored->SetLineNo(m_lineNo);
         } else { wxJSON_ASSERT(0);  // should never happen
         }
@@ -2042,6 +2218,823 @@ wxJSONReader::DoStrto_ll(const wxString &str, wxUint64 *ui64, wxChar *sign) {
 
 #endif       // defined( wxJSON_64BIT_INT )
 
+//! Parse a JSON text held in memory, reporting values to a handler
+/*!
+ This is the event (SAX-style) interface of the parser: no wxJSONValue
+ objects are created, every value is passed to the \c handler as soon
+ as it is complete (see wxJSONHandler).
+ The grammar, the wxJSON extensions enabled by the parser's flags and
+ the error and warning messages are the same as for the tree-building
+ Parse() functions, which are implemented on top of this one.
+ Comments are recognized but never stored.
+
+ The text must be UTF-8 encoded (or ANSI if the reader was constructed
+ with wxJSONREADER_NOUTF8_STREAM in ANSI builds) and does not need to be
+ NULL terminated.
+
+ @param data    the first byte of the JSON text
+ @param len     the number of bytes of JSON text
+ @param handler the object that receives the values
+ @return the total number of errors encontered
+ */
+int
+wxJSONReader::Parse(const char *data, size_t len, wxJSONHandler &handler) {
+    m_level = 0;
+    m_depth = 0;
+    m_lineNo = 1;
+    m_colNo = 1;
+    m_peekChar = -1;
+    m_errors.clear();
+    m_warnings.clear();
+    m_comment.clear();
+
+    m_ptr = data;
+    m_end = data + len;
+    m_handler = &handler;
+    m_stopped = false;
+
+    int ch = SpanGetStart();
+    if (ch == '{' || ch == '[') {
+        SpanRead(ch == '{');
+    } else {
+        AddError(_T("Cannot find a start object/array character"));
+    }
+
+    m_ptr = m_end = 0;
+    m_handler = 0;
+    return m_errors.size();
+}
+
+//! \overload Parse( const char*, size_t, wxJSONHandler& )
+int
+wxJSONReader::Parse(const wxString &doc, wxJSONHandler &handler) {
+#if !defined( wxJSON_USE_UNICODE )
+    bool noUtf8_bak = m_noUtf8;
+    m_noUtf8 = true;
+    wxCharBuffer cb(doc.c_str());
+#else
+    wxCharBuffer cb = doc.ToUTF8();
+#endif
+    int numErr = Parse(cb.data(), strlen(cb.data()), handler);
+#if !defined( wxJSON_USE_UNICODE )
+    m_noUtf8 = noUtf8_bak;
+#endif
+    return numErr;
+}
+
+//! \overload Parse( const char*, size_t, wxJSONHandler& )
+int
+wxJSONReader::Parse(wxInputStream &is, wxJSONHandler &handler) {
+    wxMemoryBuffer buff;
+    ReadAll(is, buff);
+    return Parse((const char *) buff.GetData(), buff.GetDataLen(), handler);
+}
+
+//! Read the remaining content of a stream in large blocks
+bool
+wxJSONReader::ReadAll(wxInputStream &is, wxMemoryBuffer &buff) {
+    static const size_t blockSize = 65536;
+    wxFileOffset size = is.GetLength();
+    if (size != wxInvalidOffset && size > 0) {
+        buff.SetBufSize((size_t) size + 1);
+    }
+
+    while (is.IsOk() && !is.Eof()) {
+        char *p = (char *) buff.GetAppendBuf(blockSize);
+        is.Read(p, blockSize);
+        size_t n = is.LastRead();
+        buff.UngetAppendBuf(n);
+        if (n == 0) {
+            break;
+        }
+    }
+    return buff.GetDataLen() > 0;
+}
+
+//! Read a character from the byte span (see ReadChar())
+inline int
+wxJSONReader::SpanReadChar() {
+    if (m_ptr >= m_end) {
+        return -1;
+    }
+
+    unsigned char ch = (unsigned char) *m_ptr++;
+    if (ch == '\r') {
+        m_colNo = 1;
+        if (m_ptr < m_end && *m_ptr == '\n') {
+            ch = (unsigned char) *m_ptr++;
+        }
+    }
+    if (ch == '\n') {
+        ++m_lineNo;
+        m_colNo = 1;
+    } else {
+        ++m_colNo;
+    }
+    return (int) ch;
+}
+
+//! Peek a character from the byte span (see PeekChar())
+inline int
+wxJSONReader::SpanPeekChar() {
+    return m_ptr < m_end ? (int) (unsigned char) *m_ptr : -1;
+}
+
+//! Record the handler's result: FALSE stops the parser
+bool
+wxJSONReader::Emit(bool ok) {
+    if (!ok) {
+        m_stopped = true;
+    }
+    return ok;
+}
+
+//! Report a complete scalar value to the handler
+bool
+wxJSONReader::EmitValue(const wxJSONToken &value) {
+    switch (value.type) {
+        case wxJSONToken::NULLVAL:
+            return Emit(m_handler->Null());
+        case wxJSONToken::BOOL:
+            return Emit(m_handler->Bool(value.b));
+        case wxJSONToken::INT:
+            return Emit(m_handler->Int(value.i));
+        case wxJSONToken::UINT:
+            return Emit(m_handler->UInt(value.u));
+        case wxJSONToken::DOUBLE:
+            return Emit(m_handler->Double(value.d));
+        case wxJSONToken::STRING:
+            return Emit(m_handler->String(value.s));
+        case wxJSONToken::MEMORYBUFF: {
+            wxMemoryBuffer buff(value.bytes.size());
+            buff.AppendData(value.bytes.data(), value.bytes.size());
+            return Emit(m_handler->MemoryBuff(buff));
+        }
+        default:
+            // containers are reported when they are read
+            return true;
+    }
+}
+
+//! Returns the start of the document (see GetStart())
+int
+wxJSONReader::SpanGetStart() {
+    int ch = 0;
+    do {
+        switch (ch) {
+            case 0:
+                ch = SpanReadChar();
+                break;
+            case '{':
+                return ch;
+            case '[':
+                return ch;
+            case '/':
+                ch = SpanSkipComment();
+                break;
+            default:
+                ch = SpanReadChar();
+                break;
+        }
+    } while (ch >= 0);
+    return ch;
+}
+
+//! Reads an object or array and its values (see DoRead())
+/*!
+ The structure of this function is the same as DoRead(): scalar values
+ are kept in a wxJSONToken until the next separator or close character,
+ which is when DoRead() stores them in the parent; objects and arrays
+ are reported to the handler when they start.
+ */
+int
+wxJSONReader::SpanRead(bool isObject) {
+    ++m_level;
+    if (m_depth < m_level) {
+        m_depth = m_level;
+    }
+
+    if (!Emit(isObject ? m_handler->StartObject() : m_handler->StartArray())) {
+        return -1;
+    }
+
+    wxJSONToken value;
+    wxString key;
+
+    int ch = 0;
+    do {
+        if (m_stopped) {
+            return -1;
+        }
+
+        switch (ch) {
+            case 0:
+                ch = SpanReadChar();
+                break;
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+                ch = SpanSkipWhiteSpace();
+                break;
+            case -1:   // the EOF
+                break;
+            case '/':
+                ch = SpanSkipComment();
+                break;
+
+            case '{':
+            case '[':
+                if (isObject) {
+                    if (key.empty()) {
+                        AddError(ch == '{' ? _T("\'{\' is not allowed here (\'name\' is missing")
+                                           : _T("\'[\' is not allowed here (\'name\' is missing"));
+                    }
+                    if (value.IsValid()) {
+                        AddError(ch == '{' ? _T("\'{\' cannot follow a \'value\'")
+                                           : _T("\'[\' cannot follow a \'value\' text"));
+                    }
+                } else if (value.IsValid()) {
+                    AddError(ch == '{' ? _T("\'{\' cannot follow a \'value\' in JSON array")
+                                       : _T("\'[\' cannot follow a \'value\'"));
+                }
+
+                // the name goes right before the object/array it refers to
+                if (isObject && !key.empty() && !Emit(m_handler->Key(key))) {
+                    return -1;
+                }
+
+                value.Reset();
+                value.type = wxJSONToken::CONTAINER;
+                ch = SpanRead(ch == '{');
+                break;
+
+            case '}':
+            case ']':
+                if (ch == '}' && !isObject) {
+                    AddWarning(wxJSONREADER_MISSING,
+                               _T("Trying to close an array using the \'}\' (close-object) char"));
+                } else if (ch == ']' && isObject) {
+                    AddWarning(wxJSONREADER_MISSING,
+                               _T("Trying to close an object using the \']\' (close-array) char"));
+                }
+                SpanStoreValue(ch, key, value, isObject);
+                if (m_stopped
+                    || !Emit(isObject ? m_handler->EndObject() : m_handler->EndArray())) {
+                    return -1;
+                }
+                // as in DoRead(), '}' returns the next char and ']' returns ZERO
+                return ch == '}' ? SpanReadChar() : 0;
+
+            case ',':
+                SpanStoreValue(ch, key, value, isObject);
+                key.clear();
+                ch = SpanReadChar();
+                break;
+
+            case '\"':
+                ch = SpanReadString(value);
+                break;
+
+            case '\'':
+                ch = SpanReadMemoryBuff(value);
+                break;
+
+            case ':':   // key / value separator
+                if (!isObject) {
+                    AddError(_T("\':\' can only used in object's values"));
+                } else if (value.type != wxJSONToken::STRING) {
+                    AddError(_T("\':\' follows a value which is not of type \'string\'"));
+                } else if (!key.empty()) {
+                    AddError(_T("\':\' not allowed where a \'name\' string was already available"));
+                } else {
+                    key = value.s;
+                    value.Reset();
+                }
+                ch = SpanReadChar();
+                break;
+
+            default:
+                // no special char: it is a literal or a number
+                ch = SpanReadValue(ch, value);
+                break;
+        }
+    } while (ch >= 0);
+
+    if (m_stopped) {
+        return -1;
+    }
+
+    if (isObject) {
+        AddWarning(wxJSONREADER_MISSING, _T("\'}\' missing at end of file"));
+    } else {
+        AddWarning(wxJSONREADER_MISSING, _T("\']\' missing at end of file"));
+    }
+
+    SpanStoreValue(ch, key, value, isObject);
+    --m_level;
+
+    if (!m_stopped) {
+        Emit(isObject ? m_handler->EndObject() : m_handler->EndArray());
+    }
+    return ch;
+}
+
+//! Report the pending value to the handler (see StoreValue())
+void
+wxJSONReader::SpanStoreValue(int ch, const wxString &key, wxJSONToken &value, bool isObject) {
+    if (!value.IsValid() && key.empty()) {
+        // OK, if the char read is a close-object or close-array
+        if (ch != '}' && ch != ']') {
+            AddError(_T("key or value is missing for JSON value"));
+        }
+    } else if (isObject) {
+        if (!value.IsValid()) {
+            AddError(_T("cannot store the value: \'value\' is missing for JSON object type"));
+        } else if (key.empty()) {
+            AddError(_T("cannot store the value: \'key\' is missing for JSON object type"));
+        } else if (value.type != wxJSONToken::CONTAINER) {
+            if (Emit(m_handler->Key(key))) {
+                EmitValue(value);
+            }
+        }
+    } else {
+        if (!value.IsValid()) {
+            AddError(_T("cannot store the item: \'value\' is missing for JSON array type"));
+        }
+        if (!key.empty()) {
+            AddError(_T("cannot store the item: \'key\' (\'%s\') is not permitted in JSON array type"), key);
+        }
+        EmitValue(value);
+    }
+    value.Reset();
+}
+
+//! Skip all whitespaces (see SkipWhiteSpace())
+int
+wxJSONReader::SpanSkipWhiteSpace() {
+    int ch;
+    do {
+        ch = SpanReadChar();
+    } while (ch == ' ' || ch == '\n' || ch == '\t');
+    return ch;
+}
+
+//! Skip a comment (see SkipComment()); the comment text is not kept
+int
+wxJSONReader::SpanSkipComment() {
+    static const wxChar *warn =
+            _T("Comments may be tolerated in JSON text but they are not part of JSON syntax");
+
+    int ch = SpanReadChar();
+    if (ch < 0) {
+        return -1;
+    }
+
+    if (ch == '/') {         // C++ comment, read until end-of-line
+        AddWarning(wxJSONREADER_ALLOW_COMMENTS, warn);
+        while (ch >= 0 && ch != '\n' && ch != '\r') {
+            ch = SpanReadChar();
+        }
+    } else if (ch == '*') {     // C-style comment
+        AddWarning(wxJSONREADER_ALLOW_COMMENTS, warn);
+        while (ch >= 0) {
+            if (ch == '*' && SpanPeekChar() == '/') {
+                SpanReadChar();        // read the '/' char
+                ch = SpanReadChar();   // read the next char that will be returned
+                break;
+            }
+            ch = SpanReadChar();
+        }
+    } else {   // it is not a comment, return the character next the first '/'
+        AddError(_T("Strange '/' (did you want to insert a comment?)"));
+        while (ch >= 0) {
+            ch = SpanReadChar();
+            if (ch == '*' && SpanPeekChar() == '/') {
+                break;
+            }
+            if (ch == '\n') {
+                break;
+            }
+        }
+        ch = SpanReadChar();
+    }
+    return ch;
+}
+
+// appends the UTF-8 encoding of a \uXXXX escaped code unit
+static void AppendUTF8(std::string &buff, unsigned long l) {
+    if (l < 0x80) {
+        buff += (char) l;
+    } else if (l < 0x800) {
+        buff += (char) (0xC0 | (l >> 6));
+        buff += (char) (0x80 | (l & 0x3F));
+    } else {
+        buff += (char) (0xE0 | ((l >> 12) & 0x0F));
+        buff += (char) (0x80 | ((l >> 6) & 0x3F));
+        buff += (char) (0x80 | (l & 0x3F));
+    }
+}
+
+//! Read a string value (see ReadString())
+int
+wxJSONReader::SpanReadString(wxJSONToken &val) {
+    // the char last read is the opening qoutes (")
+    std::string utf8Buff;
+    bool ascii = true;
+
+    int ch = 0;
+    while (ch >= 0) {
+        // copy plain runs of characters in one go
+        const char *run = m_ptr;
+        while (m_ptr < m_end) {
+            unsigned char c = (unsigned char) *m_ptr;
+            if (c == '\"' || c == '\\' || c == '\r' || c == '\n') {
+                break;
+            }
+            if (c >= 0x80) {
+                ascii = false;
+            }
+            ++m_ptr;
+        }
+        if (m_ptr > run) {
+            utf8Buff.append(run, m_ptr - run);
+            m_colNo += (int) (m_ptr - run);
+        }
+
+        ch = SpanReadChar();
+        if (ch < 0) {
+            break;
+        }
+
+        if (ch == '\\') {    // an escape sequence
+            ch = SpanReadChar();
+            switch (ch) {
+                case -1:        // EOF
+                    break;
+                case 't':
+                    utf8Buff += '\t';
+                    break;
+                case 'n':
+                    utf8Buff += '\n';
+                    break;
+                case 'b':
+                    utf8Buff += '\b';
+                    break;
+                case 'r':
+                    utf8Buff += '\r';
+                    break;
+                case '\"':
+                    utf8Buff += '\"';
+                    break;
+                case '\\':
+                    utf8Buff += '\\';
+                    break;
+                case '/':
+                    utf8Buff += '/';
+                    break;
+                case 'f':
+                    utf8Buff += '\f';
+                    break;
+                case 'u': {
+                    char ues[8];
+                    for (int i = 0; i < 4; i++) {
+                        ch = SpanReadChar();
+                        if (ch < 0) {
+                            return ch;
+                        }
+                        ues[i] = (char) ch;
+                    }
+                    ues[4] = 0;
+
+                    unsigned long l;
+                    if (sscanf(ues, "%lx", &l) != 1) {
+                        AddError(_T("Invalid Unicode Escaped Sequence"));
+                    } else {
+                        AppendUTF8(utf8Buff, l);
+                        if (l >= 0x80) {
+                            ascii = false;
+                        }
+                    }
+                    break;
+                }
+                default:
+                    AddError(_T("Unknow escaped character \'\\%c\'"), ch);
+            }
+        } else if (ch == '\"') {
+            if (!m_skip_string_double_quotes) {
+                break;
+            }
+
+            // URDB V3 has double quotes embedded within JSON string (see ReadString())
+            int pc = SpanPeekChar();
+            if (pc == ':') {
+                break;
+            } else if (pc == ',') {
+                SpanReadChar(); // ','
+                pc = SpanPeekChar();
+                if (pc == '\n') {
+                    // actual end of string: give back the ','
+                    --m_ptr;
+                    break;
+                }
+                utf8Buff += '\"';
+            }
+            utf8Buff += '\"';
+        } else {
+            utf8Buff += (char) ch;
+        }
+    }
+
+    wxString s;
+    if (m_noUtf8) {
+        s = wxString::From8BitData(utf8Buff.data(), utf8Buff.size());
+    } else if (ascii) {
+        s = wxString::FromAscii(utf8Buff.data(), utf8Buff.size());
+    } else {
+        size_t convLen = wxConvUTF8.ToWChar(0, 0, utf8Buff.data(), utf8Buff.size());
+        if (convLen == wxCONV_FAILED) {
+            AddError(_T("String value: the UTF-8 stream is invalid"));
+            s.append(_T("<UTF-8 stream not valid>"));
+        } else {
+#if defined( wxJSON_USE_UNICODE )
+            s = wxString::FromUTF8(utf8Buff.data(), utf8Buff.size());
+#else
+            s = wxString::FromUTF8( utf8Buff.data(), utf8Buff.size());
+            if ( s.IsEmpty() )    {
+                wxMemoryBuffer mb;
+                mb.AppendData( utf8Buff.data(), utf8Buff.size());
+                int r = ConvertCharByChar( s, mb );
+                if ( r > 0 )    {
+                    AddWarning( 0, _T( "The string value contains unrepresentable Unicode characters"));
+                }
+            }
+#endif
+        }
+    }
+
+    if (!val.IsValid()) {
+        val.type = wxJSONToken::STRING;
+        val.s = s;
+    } else if (val.type == wxJSONToken::STRING) {
+        AddWarning(wxJSONREADER_MULTISTRING,
+                   _T("Multiline strings are not allowed by JSON syntax"));
+        val.s.append(s);
+    } else {
+        AddError(_T("String value \'%s\' cannot follow another value"), s);
+    }
+
+    // read the next char after the closing quotes and returns it
+    if (ch >= 0) {
+        ch = SpanReadChar();
+    }
+    return ch;
+}
+
+#if defined( wxJSON_64BIT_INT )
+
+// same as wxJSONReader::DoStrto_ll() for a byte range
+static bool SpanStrto_ll(const char *str, size_t strLen, wxUint64 *ui64, char *sign) {
+    static const char *uLongMax = "18446744073709551615";
+
+    size_t maxDigits = 20;
+    size_t index = 0;
+    if (strLen == 0) {
+        *ui64 = 0;
+        return true;
+    }
+    if (str[0] == '+' || str[0] == '-') {
+        *sign = str[0];
+        ++index;
+        ++maxDigits;
+    }
+    if (strLen > maxDigits) {
+        return false;
+    }
+    if (strLen == maxDigits) {
+        for (size_t i = index, j = 0; i < strLen - 1; i++, j++) {
+            if (str[i] < '0' || str[i] > '9' || str[i] > uLongMax[j]) {
+                return false;
+            }
+            if (str[i] < uLongMax[j]) {
+                break;
+            }
+        }
+    }
+
+    wxUint64 temp = 0;
+    for (size_t i = index; i < strLen; i++) {
+        if (str[i] < '0' || str[i] > '9') {
+            return false;
+        }
+        temp = temp * 10 + (wxUint64) (str[i] - '0');
+    }
+    *ui64 = temp;
+    return true;
+}
+
+#endif
+
+static bool TokenEquals(const std::string &s, const char *lit, bool nocase) {
+    size_t n = strlen(lit);
+    if (s.size() != n) {
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        char c = s[i];
+        if (nocase && c >= 'A' && c <= 'Z') {
+            c = c - 'A' + 'a';
+        }
+        if (c != lit[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//! Read a literal or a number (see ReadValue())
+int
+wxJSONReader::SpanReadValue(int ch, wxJSONToken &val) {
+    // read the token up to the next delimiter (see ReadToken())
+    const char *start = m_ptr - 1;
+    int nextCh = ch;
+    while (nextCh >= 0) {
+        if (nextCh == ' ' || nextCh == ',' || nextCh == ':' || nextCh == '['
+            || nextCh == ']' || nextCh == '{' || nextCh == '}' || nextCh == '\t'
+            || nextCh == '\n' || nextCh == '\r' || nextCh == '\b') {
+            break;
+        }
+        nextCh = SpanReadChar();
+    }
+
+    // the token ends before the delimiter just read (CR+LF is two bytes)
+    const char *stop = m_ptr;
+    if (nextCh >= 0) {
+        --stop;
+        if (nextCh == '\n' && stop > start && stop[-1] == '\r') {
+            --stop;
+        }
+    }
+    std::string s(start, stop - start);
+
+    if (val.IsValid()) {
+        AddError(_T("Value \'%s\' cannot follow a value: \',\' or \':\' missing?"),
+                 wxString::From8BitData(s.data(), s.size()));
+        return nextCh;
+    }
+
+    // first try the literal strings lowercase and nocase
+    if (TokenEquals(s, "null", false)) {
+        val.type = wxJSONToken::NULLVAL;
+        return nextCh;
+    } else if (TokenEquals(s, "null", true)) {
+        AddWarning(wxJSONREADER_CASE, _T("the \'null\' literal must be lowercase"));
+        val.type = wxJSONToken::NULLVAL;
+        return nextCh;
+    } else if (TokenEquals(s, "true", false)) {
+        val.type = wxJSONToken::BOOL;
+        val.b = true;
+        return nextCh;
+    } else if (TokenEquals(s, "true", true)) {
+        AddWarning(wxJSONREADER_CASE, _T("the \'true\' literal must be lowercase"));
+        val.type = wxJSONToken::BOOL;
+        val.b = true;
+        return nextCh;
+    } else if (TokenEquals(s, "false", false)) {
+        val.type = wxJSONToken::BOOL;
+        val.b = false;
+        return nextCh;
+    } else if (TokenEquals(s, "false", true)) {
+        AddWarning(wxJSONREADER_CASE, _T("the \'false\' literal must be lowercase"));
+        val.type = wxJSONToken::BOOL;
+        val.b = false;
+        return nextCh;
+    }
+
+    bool tSigned = true, tUnsigned = true;
+    if (ch == '+') {
+        tSigned = false;
+    } else if (ch == '-') {
+        tUnsigned = false;
+    } else if (ch < '0' || ch > '9') {
+        AddError(_T("Literal \'%s\' is incorrect (did you forget quotes?)"),
+                 wxString::From8BitData(s.data(), s.size()));
+        return nextCh;
+    }
+
+#if defined( wxJSON_64BIT_INT )
+    char sign = ' ';
+    wxUint64 ui64;
+    bool r = SpanStrto_ll(s.data(), s.size(), &ui64, &sign);
+    if (r && tSigned) {
+        // check overflow for signed long long (see Strtoll())
+        if (sign == '-' ? ui64 <= (wxUint64) LLONG_MAX + 1 : ui64 <= (wxUint64) LLONG_MAX) {
+            val.type = wxJSONToken::INT;
+            val.i = sign == '-' ? (wxInt64) (ui64 * -1) : (wxInt64) ui64;
+            return nextCh;
+        }
+    }
+    if (r && tUnsigned && sign != '-') {
+        val.type = wxJSONToken::UINT;
+        val.u = ui64;
+        return nextCh;
+    }
+#else
+    char *end = 0;
+    if ( tSigned ) {
+        errno = 0;
+        long l = strtol( s.c_str(), &end, 10 );
+        if ( errno == 0 && end == s.c_str() + s.size() ) {
+            val.type = wxJSONToken::INT;
+            val.i = (int) l;
+            return nextCh;
+        }
+    }
+    if ( tUnsigned ) {
+        errno = 0;
+        unsigned long ul = strtoul( s.c_str(), &end, 10 );
+        if ( errno == 0 && end == s.c_str() + s.size() ) {
+            val.type = wxJSONToken::UINT;
+            val.u = (unsigned int) ul;
+            return nextCh;
+        }
+    }
+#endif
+
+    // same conversion as wxString::ToDouble()
+    char *dend = 0;
+    errno = 0;
+    double d = strtod(s.c_str(), &dend);
+    if (errno == 0 && dend == s.c_str() + s.size()) {
+        val.type = wxJSONToken::DOUBLE;
+        val.d = d;
+        return nextCh;
+    }
+
+    // the value is not syntactically correct
+    AddError(_T("Literal \'%s\' is incorrect (did you forget quotes?)"),
+             wxString::From8BitData(s.data(), s.size()));
+    return nextCh;
+}
+
+//! Read a memory buffer type (see ReadMemoryBuff())
+int
+wxJSONReader::SpanReadMemoryBuff(wxJSONToken &val) {
+    static const wxChar *membuffError = _T("the \'memory buffer\' type contains %d invalid digits");
+
+    AddWarning(wxJSONREADER_MEMORYBUFF, _T("the \'memory buffer\' type is not valid JSON text"));
+
+    std::string buff;
+    int ch = 0;
+    int errors = 0;
+    while (ch >= 0) {
+        ch = SpanReadChar();
+        if (ch < 0 || ch == '\'') {
+            break;
+        }
+        // the conversion is done two chars at a time
+        unsigned char c1 = (unsigned char) ch;
+        ch = SpanReadChar();
+        if (ch < 0) {
+            break;
+        }
+        unsigned char c2 = (unsigned char) ch;
+        c1 -= '0';
+        c2 -= '0';
+        if (c1 > 9) {
+            c1 -= 7;
+        }
+        if (c2 > 9) {
+            c2 -= 7;
+        }
+        if (c1 > 15 || c2 > 15) {
+            ++errors;
+        } else {
+            buff += (char) ((c1 * 16) + c2);
+        }
+    }
+
+    if (errors > 0) {
+        wxString err;
+        err.Printf(membuffError, errors);
+        AddError(err);
+    }
+
+    if (!val.IsValid()) {
+        val.type = wxJSONToken::MEMORYBUFF;
+        val.bytes = buff;
+    } else if (val.type == wxJSONToken::MEMORYBUFF) {
+        val.bytes += buff;
+    } else {
+        AddError(_T("Memory buffer value cannot follow another value"));
+    }
+
+    if (ch >= 0) {
+        ch = SpanReadChar();
+    }
+    return ch;
+}
+
 /*
 {
 }
@@ -31,6 +31,28 @@ static const wxChar* compareTraceMask = wxT("sameas");
 static const wxChar* cowTraceMask = wxT("traceCOW");
 #endif
 
+// converts the packed elements of an array back to wxJSONValue objects:
+// this changes the referenced data so callers must COW() first
+static void UnpackRefData(wxJSONRefData *data) {
+    wxJSONPackedArray *packed = data->m_packed;
+    if (packed == 0) {
+        return;
+    }
+    data->m_packed = 0;
+    if (packed->m_type == wxJSONTYPE_INT) {
+        data->m_valArray.Alloc(packed->m_ints.size());
+        for (size_t i = 0; i < packed->m_ints.size(); i++) {
+            data->m_valArray.Add(wxJSONValue(packed->m_ints[i]));
+        }
+    } else {
+        data->m_valArray.Alloc(packed->m_doubles.size());
+        for (size_t i = 0; i < packed->m_doubles.size(); i++) {
+            data->m_valArray.Add(wxJSONValue(packed->m_doubles[i]));
+        }
+    }
+    delete packed;
+}
+
 double json_double(const wxJSONValue &jv, double defaultval, bool *Exists) {
     if (jv.IsNull()) {
         //if (Exists) *Exists = false;
@@ -139,6 +161,7 @@ wxJSONRefData::wxJSONRefData() {
     m_lineNo = -1;
     m_refCount = 1;
     m_memBuff = 0;
+    m_packed = 0;
 
 #if defined( WXJSON_USE_VALUE_COUNTER )
     m_progr = sm_progr;
@@ -153,6 +176,7 @@ wxJSONRefData::~wxJSONRefData() {
     if (m_memBuff) {
         delete m_memBuff;
     }
+    delete m_packed;
 }
 
 // Return the number of objects that reference this data.
@@ -1359,13 +1383,16 @@ wxJSONValueAsMap(const wxJSONValue &val) {
  To retreive values from an array or map JSON object use the \c Item() or ItemAt()
  memberfunctions or the subscript operator.
  If the stored value is not an array type, returns a NULL pointer.
+ A NULL pointer is also returned for packed arrays because their
+ elements are not stored as wxJSONValue objects.
  */
 const wxJSONInternalArray *
 wxJSONValueAsArray(const wxJSONValue &val) {
     wxJSONRefData *data = val.GetRefData();wxJSON_ASSERT(data);
 
     const wxJSONInternalArray *v = 0;
-    if (data->m_type == wxJSONTYPE_ARRAY) {
+    if (data->m_type == wxJSONTYPE_ARRAY && !data->m_packed) {
+        // the caller wants the array of values
         v = &(data->m_valArray);
     }
     return v;
@@ -1418,7 +1445,12 @@ wxJSONValue::Size() const {
 
     int size = -1;
     if (data->m_type == wxJSONTYPE_ARRAY) {
-        size = (int) data->m_valArray.GetCount();
+        if (data->m_packed) {
+            size = (int) (data->m_packed->m_type == wxJSONTYPE_INT
+                          ? data->m_packed->m_ints.size() : data->m_packed->m_doubles.size());
+        } else {
+            size = (int) data->m_valArray.GetCount();
+        }
     }
     if (data->m_type == wxJSONTYPE_OBJECT) {
         size = (int) data->m_valMap.size();
@@ -1469,8 +1501,11 @@ wxJSONValue::Append(const wxJSONValue &value) {
     wxJSONRefData *data = COW();wxJSON_ASSERT(data);
     if (data->m_type != wxJSONTYPE_ARRAY) {
         // we have to change the type of the actual object to the array type
-        SetType(wxJSONTYPE_ARRAY);
+        data = SetType(wxJSONTYPE_ARRAY);
     }
+    // a reference to the new element is returned so it must be a wxJSONValue
+    UnpackRefData(data);
+
     // we add the wxJSONValue object to the wxObjArray: note that the
     // array makes a copy of the JSON-value object by calling its
     // copy ctor thus using reference count
@@ -1631,6 +1666,163 @@ wxJSONValue::Cat(const wxChar *str) {
     return r;
 }
 
+//! Return TRUE if this array keeps its elements in packed form.
+/*!
+ A packed array only contains numbers of one type, either INT or DOUBLE,
+ and stores them in a contiguous buffer instead of one wxJSONValue per
+ element. This uses eight bytes per element instead of more than one hundred.
+ The wxJSONReader produces packed arrays for homogeneous arrays of numbers
+ unless comments are stored.
+
+ Packing is transparent: ItemAt(), Size() and the wxJSONWriter read the
+ buffer directly while the functions that return a reference or a pointer
+ to an element (Item(), the subscript operator, Append()) first convert
+ the array back to wxJSONValue elements (see Unpack()).
+ */
+bool
+wxJSONValue::IsPacked() const {
+    wxJSONRefData *data = GetRefData();
+    return data != 0 && data->m_packed != 0;
+}
+
+//! Convert a homogeneous array of numbers to the packed form.
+/*!
+ The function returns TRUE if the array is packed when it returns.
+ Arrays that are empty, contain values other than INT (signed) or
+ DOUBLE, mix the two types or have commented elements are not packed.
+ */
+bool
+wxJSONValue::Pack() {
+    wxJSONRefData *data = GetRefData();
+    if (data == 0 || data->m_type != wxJSONTYPE_ARRAY) {
+        return false;
+    }
+    if (data->m_packed) {
+        return true;
+    }
+
+    size_t size = data->m_valArray.GetCount();
+    if (size == 0) {
+        return false;
+    }
+    wxJSONType type = data->m_valArray.Item(0).GetType();
+    if (type != wxJSONTYPE_INT && type != wxJSONTYPE_DOUBLE) {
+        return false;
+    }
+    for (size_t i = 0; i < size; i++) {
+        const wxJSONValue &v = data->m_valArray.Item(i);
+        if (v.GetType() != type || v.GetCommentCount() > 0) {
+            return false;
+        }
+    }
+
+    data = COW();
+    wxJSONPackedArray *packed = new wxJSONPackedArray;
+    packed->m_type = type;
+    if (type == wxJSONTYPE_INT) {
+        packed->m_ints.reserve(size);
+        for (size_t i = 0; i < size; i++) {
+            packed->m_ints.push_back(data->m_valArray.Item(i).GetRefData()->m_value.VAL_INT);
+        }
+    } else {
+        packed->m_doubles.reserve(size);
+        for (size_t i = 0; i < size; i++) {
+            packed->m_doubles.push_back(data->m_valArray.Item(i).GetRefData()->m_value.m_valDouble);
+        }
+    }
+    data->m_valArray.Clear();
+    data->m_packed = packed;
+    return true;
+}
+
+//! Convert a packed array to an array of wxJSONValue elements.
+/*!
+ The function does nothing if the array is not packed.
+ */
+void
+wxJSONValue::Unpack() {
+    wxJSONRefData *data = GetRefData();
+    if (data && data->m_packed) {
+        UnpackRefData(COW());
+    }
+}
+
+//! Append an integer keeping the array packed if possible.
+/*!
+ If this value is an empty array or a packed array of INTs the integer
+ is stored in packed form, otherwise this function is the same as
+ Append( wxJSONPackedInt ).
+ Unlike Append() the function does not return a reference to the new
+ element because packed elements are not wxJSONValue objects.
+ */
+void
+wxJSONValue::AppendPackedInt(wxJSONPackedInt i) {
+    wxJSONRefData *data = COW();wxJSON_ASSERT(data);
+    if (data->m_type != wxJSONTYPE_ARRAY) {
+        data = SetType(wxJSONTYPE_ARRAY);
+    }
+    if (!data->m_packed && data->m_valArray.GetCount() == 0) {
+        data->m_packed = new wxJSONPackedArray;
+        data->m_packed->m_type = wxJSONTYPE_INT;
+    }
+    if (data->m_packed && data->m_packed->m_type == wxJSONTYPE_INT) {
+        data->m_packed->m_ints.push_back(i);
+    } else {
+        Append(wxJSONValue(i));
+    }
+}
+
+//! Append a double keeping the array packed if possible.
+/*!
+ \sa AppendPackedInt
+ */
+void
+wxJSONValue::AppendPackedDouble(double d) {
+    wxJSONRefData *data = COW();wxJSON_ASSERT(data);
+    if (data->m_type != wxJSONTYPE_ARRAY) {
+        data = SetType(wxJSONTYPE_ARRAY);
+    }
+    if (!data->m_packed && data->m_valArray.GetCount() == 0) {
+        data->m_packed = new wxJSONPackedArray;
+        data->m_packed->m_type = wxJSONTYPE_DOUBLE;
+    }
+    if (data->m_packed && data->m_packed->m_type == wxJSONTYPE_DOUBLE) {
+        data->m_packed->m_doubles.push_back(d);
+    } else {
+        Append(wxJSONValue(d));
+    }
+}
+
+//! Return the elements of a packed array of INTs.
+/*!
+ The function returns a NULL pointer if this value is not a packed
+ array of INTs or if it is empty. The number of elements is Size().
+ The pointer is valid until the array is modified.
+ */
+const wxJSONPackedInt *
+wxJSONValue::GetPackedInts() const {
+    wxJSONRefData *data = GetRefData();
+    if (data == 0 || data->m_packed == 0 || data->m_packed->m_type != wxJSONTYPE_INT
+        || data->m_packed->m_ints.empty()) {
+        return 0;
+    }
+    return &(data->m_packed->m_ints[0]);
+}
+
+//! Return the elements of a packed array of DOUBLEs.
+/*!
+ \sa GetPackedInts
+ */
+const double *
+wxJSONValue::GetPackedDoubles() const {
+    wxJSONRefData *data = GetRefData();
+    if (data == 0 || data->m_packed == 0 || data->m_packed->m_type != wxJSONTYPE_DOUBLE
+        || data->m_packed->m_doubles.empty()) {
+        return 0;
+    }
+    return &(data->m_packed->m_doubles[0]);
+}
+
 //! Remove the item at the specified index or key.
 /*!
  The function removes the item at index \c index or at the specified
@@ -1645,6 +1837,7 @@ wxJSONValue::Remove(int index) {
 
     bool r = false;
     if (data->m_type == wxJSONTYPE_ARRAY) {
+        UnpackRefData(data);
         data->m_valArray.RemoveAt(index);
         r = true;
     }
@@ -1698,6 +1891,9 @@ wxJSONValue::Item(unsigned index) {
     if (data->m_type != wxJSONTYPE_ARRAY) {
         data = SetType(wxJSONTYPE_ARRAY);
     }
+    // a reference to the element is returned so it must be a wxJSONValue
+    UnpackRefData(data);
+
     int size = Size();wxJSON_ASSERT(size >= 0);
     // if the desired element does not yet exist, we create as many
     // elements as needed; the new values will be 'null' values
@@ -1748,8 +1944,15 @@ wxJSONValue::ItemAt(unsigned index) const {
     wxJSONValue v(wxJSONTYPE_INVALID);
     if (data->m_type == wxJSONTYPE_ARRAY) {
         int size = Size();wxJSON_ASSERT(size >= 0);
-        if (index < (unsigned) size) {
+        if (index >= (unsigned) size) {
+            return v;
+        }
+        if (!data->m_packed) {
             v = data->m_valArray.Item(index);
+        } else if (data->m_packed->m_type == wxJSONTYPE_INT) {
+            v = data->m_packed->m_ints[index];
+        } else {
+            v = data->m_packed->m_doubles[index];
         }
     }
     return v;
@@ -1998,7 +2201,8 @@ wxJSONValue::Get(const wxString &key, const wxJSONValue &defaultValue) const {
  The function returns a pointer to the element at index \c index
  or a NULL pointer if \c index does not exist.
  A NULL pointer is also returned if the object does not contain an
- array nor a key/value map.
+ array nor a key/value map, or if it contains a packed array: its
+ elements are not wxJSONValue objects, use ItemAt() to read them.
  */
 wxJSONValue *
 wxJSONValue::Find(unsigned index) const {
@@ -2006,7 +2210,7 @@ wxJSONValue::Find(unsigned index) const {
 
     wxJSONValue *vp = 0;
 
-    if (data->m_type == wxJSONTYPE_ARRAY) {
+    if (data->m_type == wxJSONTYPE_ARRAY && !data->m_packed) {
         size_t size = data->m_valArray.GetCount();
         if (index < size) {
             vp = &(data->m_valArray.Item(index));
@@ -2155,8 +2359,7 @@ wxJSONValue::Dump(bool deep, int indent) const {
             case wxJSONTYPE_ARRAY:
                 size = Size();
                 for (int i = 0; i < size; i++) {
-                    const wxJSONValue *v = Find(i);wxJSON_ASSERT(v);
-                    sub = v->Dump(true, indent);
+                    sub = ItemAt(i).Dump(true, indent);
                     s.append(sub);
                 }
                 break;
@@ -2675,6 +2878,8 @@ wxJSONValue::SetType(wxJSONType type) {
             break;
         case wxJSONTYPE_ARRAY:
             data->m_valArray.Clear();
+            delete data->m_packed;
+            data->m_packed = 0;
             break;
         case wxJSONTYPE_OBJECT:
             data->m_valMap.clear();
@@ -2823,6 +3028,9 @@ wxJSONValue::CloneRefData(const wxJSONRefData *otherData) const {
     data->m_valString = other->m_valString;
     data->m_valArray = other->m_valArray;
     data->m_valMap = other->m_valMap;
+    if (other->m_packed) {
+        data->m_packed = new wxJSONPackedArray(*other->m_packed);
+    }
 
     // if the data contains a wxMemoryBuffer object, then we have
     // to make a deep copy of the buffer by allocating a new one because
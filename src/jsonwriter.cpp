@@ -19,6 +19,9 @@
 #include <wx/debug.h>
 #include <wx/log.h>
 
+#include <math.h>
+#include <string>
+
 #if wxUSE_LOG_TRACE
 static const wxChar* writerTraceMask = _T("traceWriter");
 #endif
@@ -305,6 +308,7 @@ wxJSONWriter::Write(const wxJSONValue &value, wxOutputStream &os) {
 void
 wxJSONWriter::SetDoubleFmtString(const char *fmt) {
     m_fmt = (char *) fmt;
+    m_defaultFmt = strcmp(fmt, "%.10g") == 0;
 }
 
 //! Perform the real write operation.
@@ -442,16 +446,23 @@ wxJSONWriter::DoWrite(wxOutputStream &os, const wxJSONValue &value, const wxStri
 
             // now iterate through all sub-items and call DoWrite() recursively
             size = value.Size();
-            for (int i = 0; i < size; i++) {
-                bool comma_tmp = false;
-                if (i < size - 1) {
-                    comma_tmp = true;
-                }
-                wxJSONValue v = value.ItemAt(i);
-                lastChar = DoWrite(os, v, 0, comma_tmp);
+            if (value.IsPacked()) {
+                lastChar = WritePackedArray(os, value);
                 if (lastChar < 0) {
                     return lastChar;
                 }
+            } else {
+                for (int i = 0; i < size; i++) {
+                    bool comma_tmp = false;
+                    if (i < size - 1) {
+                        comma_tmp = true;
+                    }
+                    wxJSONValue v = value.ItemAt(i);
+                    lastChar = DoWrite(os, v, 0, comma_tmp);
+                    if (lastChar < 0) {
+                        return lastChar;
+                    }
+                }
             }
             --m_level;
             lastChar = WriteIndent(os);
@@ -984,8 +995,7 @@ wxJSONWriter::WriteDoubleValue(wxOutputStream &os, const wxJSONValue &value) {
     char buffer[32];
     wxJSONRefData *data = value.GetRefData();
     wxASSERT(data);
-    snprintf(buffer, 32, m_fmt, data->m_value.m_valDouble);
-    size_t len = strlen(buffer);
+    size_t len = FormatDouble(buffer, data->m_value.m_valDouble);
     os.Write(buffer, len);
     if (os.GetLastError() != wxSTREAM_NO_ERROR) {
         r = -1;
@@ -993,6 +1003,106 @@ wxJSONWriter::WriteDoubleValue(wxOutputStream &os, const wxJSONValue &value) {
     return r;
 }
 
+//! Writes the elements of a packed array.
+/*!
+ The output is the same as calling DoWrite() for every element but
+ no wxJSONValue objects are created: the numbers are formatted into a
+ local buffer which is written to the stream in large blocks.
+ Packed elements never have comments.
+ Returns -1 on stream errors or the last character written.
+ */
+int
+wxJSONWriter::WritePackedArray(wxOutputStream &os, const wxJSONValue &value) {
+    // the indentation of the elements (see WriteIndent())
+    std::string indent;
+    if ((m_style & wxJSONWRITER_STYLED) && !(m_style & wxJSONWRITER_NO_INDENTATION)) {
+        if (m_style & wxJSONWRITER_TAB_INDENT) {
+            indent.assign(m_level, '\t');
+        } else {
+            indent.assign(m_indent + (m_step * m_level), ' ');
+        }
+    }
+    bool linefeeds = (m_style & wxJSONWRITER_STYLED) && !(m_style & wxJSONWRITER_NO_LINEFEEDS);
+
+    const wxJSONPackedInt *ints = value.GetPackedInts();
+    const double *doubles = value.GetPackedDoubles();
+    int size = value.Size();
+
+    static const size_t flushSize = 65536;
+    std::string buff;
+    buff.reserve(flushSize + 64 + indent.size());
+    char number[32];
+    for (int i = 0; i < size; i++) {
+        buff.append(indent);
+        size_t len = ints ? FormatInt(number, ints[i]) : FormatDouble(number, doubles[i]);
+        buff.append(number, len);
+        if (i < size - 1) {
+            buff += ',';
+        }
+        if (linefeeds) {
+            buff += '\n';
+        }
+        if (buff.size() >= flushSize || i == size - 1) {
+            os.Write(buff.data(), buff.size());
+            if (os.GetLastError() != wxSTREAM_NO_ERROR) {
+                return -1;
+            }
+            buff.clear();
+        }
+    }
+    return '\n';
+}
+
+//! Format an integer in decimal notation.
+/*!
+ The function writes the digits and the sign to \c buffer, which must
+ be at least 21 bytes long, and returns the number of chars written.
+ The string is not NULL terminated.
+ */
+size_t
+wxJSONWriter::FormatInt(char *buffer, wxJSONPackedInt i) {
+    char digits[24];
+    size_t n = 0;
+    // use the unsigned type so that the most negative value works too
+#if defined( wxJSON_64BIT_INT )
+    wxUint64 u = i < 0 ? (wxUint64) 0 - (wxUint64) i : (wxUint64) i;
+#else
+    unsigned long u = i < 0 ? 0UL - (unsigned long) i : (unsigned long) i;
+#endif
+    do {
+        digits[n++] = (char) ('0' + (u % 10));
+        u /= 10;
+    } while (u != 0);
+
+    size_t len = 0;
+    if (i < 0) {
+        buffer[len++] = '-';
+    }
+    while (n > 0) {
+        buffer[len++] = digits[--n];
+    }
+    return len;
+}
+
+//! Format a double using the format string (see SetDoubleFmtString()).
+/*!
+ Whole numbers below one billion, which the default "%.10g" format prints
+ without exponent or decimals, are formatted as integers: this is much
+ faster than snprintf().
+ The result is NULL terminated; \c buffer must be at least 32 bytes long.
+ Returns the number of chars written.
+ */
+size_t
+wxJSONWriter::FormatDouble(char *buffer, double d) {
+    if (m_defaultFmt && d > -1e9 && d < 1e9 && d == floor(d) && !(d == 0 && 1 / d < 0)) {
+        size_t len = FormatInt(buffer, (wxJSONPackedInt) d);
+        buffer[len] = 0;
+        return len;
+    }
+    snprintf(buffer, 32, m_fmt, d);
+    return strlen(buffer);
+}
+
 //! Writes a value of type BOOL.
 /*!
  This function is called for every value objects of BOOL type.
@@ -0,0 +1,235 @@
+/***********************************************************************************************************************
+*  WEX, Copyright (c) 2008-2017, Alliance for Sustainable Energy, LLC. All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+*  following conditions are met:
+*
+*  (1) Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+*  disclaimer.
+*
+*  (2) Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+*  following disclaimer in the documentation and/or other materials provided with the distribution.
+*
+*  (3) Neither the name of the copyright holder nor the names of any contributors may be used to endorse or promote
+*  products derived from this software without specific prior written permission from the respective party.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+*  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER, THE UNITED STATES GOVERNMENT, OR ANY CONTRIBUTORS BE LIABLE FOR
+*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+*  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+*  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+*  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************************************************************/
+
+#include <wx/thread.h>
+#include <wx/stopwatch.h>
+#include <wx/filename.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "wex/lkbatch.h"
+#include "wex/csv.h"
+
+#include <lk/absyn.h>
+#include <lk/parse.h>
+#include <lk/codegen.h>
+#include <lk/vm.h>
+#include <lk/env.h>
+#include <lk/stdlib.h>
+
+class wxLKBatchWorker : public wxThread {
+    wxLKBatchRunner &m_runner;
+    std::atomic<size_t> &m_next;
+public:
+    wxLKBatchWorker(wxLKBatchRunner &runner, std::atomic<size_t> &next)
+            : wxThread(wxTHREAD_JOINABLE), m_runner(runner), m_next(next) {}
+
+    virtual void *Entry() {
+        Work(m_runner, m_next);
+        return 0;
+    }
+
+    static void Work(wxLKBatchRunner &runner, std::atomic<size_t> &next) {
+        // each thread runs its own copy of the program
+        lk::bytecode bc(runner.m_bc);
+        lk::vm vm;
+
+        size_t i;
+        while ((i = next++) < runner.m_cases.size())
+            runner.RunCase(vm, bc, runner.m_cases[i]);
+    }
+};
+
+wxLKBatchRunner::wxLKBatchRunner(unsigned long libs)
+        : m_compiled(false), m_elapsed(0), m_threads(0) {
+    if (libs & wxLK_STDLIB_STRING)
+        RegisterLibrary(lk::stdlib_string());
+    if (libs & wxLK_STDLIB_MATH)
+        RegisterLibrary(lk::stdlib_math());
+    if (libs & wxLK_STDLIB_FILE)
+        RegisterLibrary(wxLKFileFunctions());
+}
+
+void wxLKBatchRunner::RegisterLibrary(lk::fcall_t *funcs, void *user_data) {
+    m_libs.push_back(funcs);
+    m_userData.push_back(user_data);
+}
+
+bool wxLKBatchRunner::Compile(const wxString &script, const wxString &workdir) {
+    m_compiled = false;
+    m_errors.Clear();
+
+    lk::input_string p(script);
+    lk::parser parse(p);
+    if (!workdir.IsEmpty() && wxDirExists(workdir))
+        parse.add_search_path(workdir);
+
+    std::unique_ptr<lk::node_t> tree(parse.script());
+
+    int i = 0;
+    while (i < parse.error_count())
+        m_errors += wxString(parse.error(i++)) + "\n";
+
+    if (parse.token() != lk::lexer::END)
+        m_errors += "parsing did not reach end of input\n";
+
+    if (parse.error_count() > 0 || parse.token() != lk::lexer::END)
+        return false;
+
+    lk::codegen cg;
+    if (!cg.generate(tree.get())) {
+        m_errors += "error in code generation: " + cg.error() + "\n";
+        return false;
+    }
+
+    m_bc = lk::bytecode();
+    cg.get(m_bc);
+    m_compiled = true;
+    return true;
+}
+
+size_t wxLKBatchRunner::AddCase(const lk::vardata_t &inputs) {
+    Case c;
+    c.inputs.copy(inputs);
+    c.ok = false;
+    m_cases.push_back(c);
+    return m_cases.size() - 1;
+}
+
+size_t wxLKBatchRunner::AddCases(wxCSVData &csv) {
+    size_t ncols = csv.NumCols();
+    for (size_t r = 1; r < csv.NumRows(); r++) {
+        lk::vardata_t inputs;
+        inputs.empty_hash();
+        for (size_t c = 0; c < ncols; c++) {
+            wxString name(csv.Get(0, c));
+            if (name.IsEmpty() || csv.IsEmpty(r, c))
+                continue;
+
+            double value;
+            if (csv.GetNumber(r, c, &value))
+                inputs.hash_item(name).assign(value);
+            else
+                inputs.hash_item(name).assign(csv.Get(r, c));
+        }
+        AddCase(inputs);
+    }
+
+    return csv.NumRows() > 0 ? csv.NumRows() - 1 : 0;
+}
+
+void wxLKBatchRunner::ClearCases() {
+    m_cases.clear();
+}
+
+void wxLKBatchRunner::RunCase(lk::vm &vm, lk::bytecode &bc, Case &c) {
+    c.result.empty_hash();
+    c.error.Clear();
+    c.ok = false;
+
+    lk::env_t env;
+    for (size_t i = 0; i < m_libs.size(); i++)
+        env.register_funcs(m_libs[i], m_userData[i]);
+
+    if (lk::varhash_t *h = c.inputs.hash())
+        for (lk::varhash_t::iterator it = h->begin(); it != h->end(); ++it)
+            env.assign(it->first, new lk::vardata_t(*it->second));
+
+    try {
+        vm.load(&bc);
+        vm.initialize(&env);
+        c.ok = vm.run(lk::vm::NORMAL);
+        if (!c.ok)
+            c.error = vm.error();
+    } catch (std::exception &e) {
+        c.error = e.what();
+    }
+
+    for (size_t i = 0; i < m_outputs.size(); i++)
+        if (lk::vardata_t *v = env.lookup(m_outputs[i], false))
+            c.result.hash_item(m_outputs[i]).copy(v->deref());
+}
+
+size_t wxLKBatchRunner::Run(int nthreads) {
+    if (!m_compiled)
+        return 0;
+
+    if (nthreads <= 0)
+        nthreads = wxThread::GetCPUCount();
+    nthreads = std::max(1, std::min(nthreads, (int) m_cases.size()));
+    m_threads = nthreads;
+
+    wxStopWatch sw;
+    std::atomic<size_t> next(0);
+
+    // the calling thread is the last worker
+    std::vector<wxLKBatchWorker *> workers;
+    for (int t = 0; t + 1 < nthreads; t++) {
+        wxLKBatchWorker *w = new wxLKBatchWorker(*this, next);
+        if (w->Create() == wxTHREAD_NO_ERROR && w->Run() == wxTHREAD_NO_ERROR)
+            workers.push_back(w);
+        else
+            delete w;
+    }
+
+    wxLKBatchWorker::Work(*this, next);
+
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t]->Wait();
+        delete workers[t];
+    }
+    m_threads = (int) workers.size() + 1;
+    m_elapsed = sw.Time();
+
+    size_t nok = 0;
+    for (size_t i = 0; i < m_cases.size(); i++)
+        if (m_cases[i].ok) nok++;
+
+    return nok;
+}
+
+void wxLKBatchRunner::GetResults(wxCSVData &csv) {
+    csv.Clear();
+    csv.Set(0, 0, "case");
+    for (size_t j = 0; j < m_outputs.size(); j++)
+        csv.Set(0, j + 1, m_outputs[j]);
+    csv.Set(0, m_outputs.size() + 1, "error");
+
+    for (size_t i = 0; i < m_cases.size(); i++) {
+        csv.Set(i + 1, 0, wxString::Format("%d", (int) i));
+        for (size_t j = 0; j < m_outputs.size(); j++)
+            if (lk::vardata_t *v = m_cases[i].result.lookup(m_outputs[j]))
+                csv.Set(i + 1, j + 1, v->as_string());
+        if (!m_cases[i].ok)
+            csv.Set(i + 1, m_outputs.size() + 1, m_cases[i].error);
+    }
+}
+
+bool wxLKBatchRunner::WriteResults(const wxString &file) {
+    wxCSVData csv;
+    GetResults(csv);
+    return csv.WriteFile(file);
+}
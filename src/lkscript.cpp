@@ -24,6 +24,8 @@
 
 #include <wx/app.h>
 #include <wx/thread.h>
+#include <wx/evtloop.h>
+#include <wx/utils.h>
 #include <wx/html/htmlwin.h>
 #include <wx/htmllbox.h>
 #include <wx/fontenum.h>
@@ -34,6 +36,7 @@
 #include <wx/tokenzr.h>
 #include <wx/simplebook.h>
 
+#include <algorithm>
 #include <memory>
 
 #include "wex/lkscript.h" // defines LK_USE_WXWIDGETS
@@ -1067,8 +1070,8 @@ void fcall_csvconv(lk::invoke_t &cxt) {
         if (as_1D && csv.NumRows() == 1 && csv.NumCols() > 0) {
             R.vec()->resize(csv.NumCols());
             for (size_t i = 0; i < csv.NumCols(); i++) {
-                if (as_numbers) R.index(i)->assign(wxAtof(csv(0, i)));
-                else R.index(i)->assign(csv(0, i));
+                if (as_numbers) R.index(i)->assign(wxAtof(csv.Get(0, i)));
+                else R.index(i)->assign(csv.Get(0, i));
             }
         } else if (csv.NumRows() > 0 && csv.NumCols() > 0) {
             R.vec()->resize(csv.NumRows());
@@ -1076,8 +1079,8 @@ void fcall_csvconv(lk::invoke_t &cxt) {
                 R.index(i)->empty_vector();
                 R.index(i)->resize(csv.NumCols());
                 for (size_t j = 0; j < csv.NumCols(); j++) {
-                    if (as_numbers) R.index(i)->index(j)->assign(wxAtof(csv(i, j)));
-                    else R.index(i)->index(j)->assign(csv(i, j));
+                    if (as_numbers) R.index(i)->index(j)->assign(wxAtof(csv.Get(i, j)));
+                    else R.index(i)->index(j)->assign(csv.Get(i, j));
                 }
             }
         }
@@ -1101,9 +1104,12 @@ void fcall_csvconv(lk::invoke_t &cxt) {
 void fcall_csvread(lk::invoke_t &cxt) {
     LK_DOC("csvread", "Read a CSV file into a 2D array (default) or a table. Options: "
                       "'skip' (header lines to skip), "
-                      "'numeric' (t/f to return numbers), "
+                      "'numeric' (t/f to return numbers, parsed without intermediate strings), "
                       "'delim' (character(s) to use as delimiters, default is comma), "
-                      "'table' (t/f to return a table assuming 1 header line with names)",
+                      "'table' (t/f to return a table assuming 1 header line with names), "
+                      "'cols' (array of column indices, or of names in table mode, to read), "
+                      "'rows' ([first,last] zero based range of data rows to read), "
+                      "'threads' (threads used to parse large numeric files, default is one per core)",
            "(string:file[, table:options]):array or table");
 
     lk::vardata_t &out = cxt.result();
@@ -1112,6 +1118,10 @@ void fcall_csvread(lk::invoke_t &cxt) {
     bool tonum = false;
     bool astable = false;
     wxUniChar sep(',');
+    size_t first_row = 0, last_row = (size_t) -1;
+    std::vector<size_t> col_indices;
+    wxArrayString col_names;
+    int nthreads = 0;
 
     if (cxt.arg_count() > 1 && cxt.arg(1).deref().type() == lk::vardata_t::HASH) {
         lk::vardata_t &opts = cxt.arg(1).deref();
@@ -1130,6 +1140,73 @@ void fcall_csvread(lk::invoke_t &cxt) {
             if (s.Len() > 0)
                 sep = s.at(0);
         }
+
+        if (lk::vardata_t *item = opts.lookup("cols")) {
+            lk::vardata_t &cols = item->deref();
+            if (cols.type() == lk::vardata_t::VECTOR) {
+                bool by_name = false;
+                for (size_t i = 0; i < cols.length(); i++)
+                    if (cols.index(i)->deref().type() != lk::vardata_t::NUMBER)
+                        by_name = true;
+                for (size_t i = 0; i < cols.length(); i++) {
+                    if (by_name) col_names.Add(cols.index(i)->as_string());
+                    else col_indices.push_back(cols.index(i)->as_unsigned());
+                }
+            }
+        }
+
+        if (lk::vardata_t *item = opts.lookup("rows")) {
+            lk::vardata_t &rows = item->deref();
+            if (rows.type() == lk::vardata_t::VECTOR && rows.length() > 0) {
+                first_row = rows.index(0)->as_unsigned();
+                if (rows.length() > 1)
+                    last_row = rows.index(1)->as_unsigned();
+            }
+        }
+
+        if (lk::vardata_t *item = opts.lookup("threads"))
+            nthreads = item->as_integer();
+    }
+
+    if (tonum) {
+        wxCSVNumericReader reader(sep);
+        reader.SetSkip(nskip, astable);
+        reader.SetRows(first_row, last_row);
+        if (col_names.size() > 0) reader.SetColumns(col_names);
+        else if (col_indices.size() > 0) reader.SetColumns(col_indices);
+        reader.SetThreads(nthreads);
+        if (!reader.ReadFile(cxt.arg(0).as_string())
+            || reader.NumCols() == 0) {
+            out.nullify();
+            return;
+        }
+
+        size_t nr = reader.NumRows();
+        size_t nc = reader.NumCols();
+        if (astable) {
+            const wxArrayString &names = reader.GetColumnNames();
+            out.empty_hash();
+            for (size_t c = 0; c < nc; c++) {
+                if (names[c].IsEmpty()) continue;
+
+                lk::vardata_t &it = out.hash_item(names[c]);
+                it.empty_vector();
+                it.resize(nr);
+                for (size_t i = 0; i < nr; i++)
+                    it.index(i)->assign(reader.At(i, c));
+            }
+        } else {
+            out.empty_vector();
+            out.vec()->resize(nr);
+            for (size_t i = 0; i < nr; i++) {
+                lk::vardata_t *row = out.index(i);
+                row->empty_vector();
+                row->vec()->resize(nc);
+                for (size_t j = 0; j < nc; j++)
+                    row->index(j)->assign(reader.At(i, j));
+            }
+        }
+        return;
     }
 
     wxCSVData csv;
@@ -1145,53 +1222,90 @@ void fcall_csvread(lk::invoke_t &cxt) {
     size_t nc = csv.NumCols();
 
     if (nskip >= nr) nskip = 0;
+    if (astable && nskip >= nr - 1) nskip = 0;
+
+    size_t row0 = nskip + (astable ? 1 : 0);
+    size_t row_begin = std::min(nr, row0 + first_row);
+    size_t row_end = nr;
+    if (last_row != (size_t) -1)
+        row_end = std::max(row_begin, std::min(nr, row0 + last_row + 1));
+
+    std::vector<size_t> cols(col_indices);
+    for (size_t i = 0; i < col_names.size(); i++)
+        for (size_t c = 0; c < nc; c++)
+            if (csv.Get(nskip, c) == col_names[i]) {
+                cols.push_back(c);
+                break;
+            }
+    if (col_indices.empty() && col_names.empty())
+        for (size_t c = 0; c < nc; c++)
+            cols.push_back(c);
 
     if (astable) {
-        if (nskip >= nr - 1) nskip = 0;
-
         out.empty_hash();
-        for (size_t c = 0; c < nc; c++) {
-            wxString name(csv(nskip, c));
+        for (size_t k = 0; k < cols.size(); k++) {
+            wxString name(csv.Get(nskip, cols[k]));
             if (name.IsEmpty()) continue;
 
             lk::vardata_t &it = out.hash_item(name);
             it.empty_vector();
-            it.resize(nr - 1 - nskip);
-            for (size_t i = 1 + nskip; i < nr; i++) {
-                if (tonum) it.index(i - 1 - nskip)->assign(wxAtof(csv(i, c)));
-                else it.index(i - 1 - nskip)->assign(csv(i, c));
-            }
+            it.resize(row_end - row_begin);
+            for (size_t i = row_begin; i < row_end; i++)
+                it.index(i - row_begin)->assign(csv.Get(i, cols[k]));
         }
     } else {
         out.empty_vector();
-        out.vec()->resize(nr - nskip);
-        for (size_t i = 0; i < nr - nskip; i++) {
-            lk::vardata_t *row = out.index(i);
+        out.vec()->resize(row_end - row_begin);
+        for (size_t i = row_begin; i < row_end; i++) {
+            lk::vardata_t *row = out.index(i - row_begin);
             row->empty_vector();
-            row->vec()->resize(nc);
+            row->vec()->resize(cols.size());
 
-            for (size_t j = 0; j < nc; j++) {
-                if (tonum) row->index(j)->assign(wxAtof(csv(i + nskip, j)));
-                else row->index(j)->assign(csv(i + nskip, j));
-            }
+            for (size_t j = 0; j < cols.size(); j++)
+                row->index(j)->assign(csv.Get(i, cols[j]));
         }
     }
 }
 
+static void csvwrite_cell(wxCSVWriter &csv, lk::vardata_t &v, bool numeric, int precision) {
+    lk::vardata_t &val = v.deref();
+    if (numeric && val.type() == lk::vardata_t::NUMBER)
+        csv.Number(val.as_number(), precision);
+    else
+        csv.Text(val.as_string());
+}
+
 void fcall_csvwrite(lk::invoke_t &cxt) {
     LK_DOC("csvwrite",
-           "Write a CSV file from a 2D array or table of arrays. Possible options: 'cols'=[column name list]",
+           "Write a CSV file from a 2D array or table of arrays. Possible options: 'cols'=[column name list], "
+           "'numeric'=t/F (write numbers directly with 'precision' significant digits, default 15)",
            "(string:file, array or table:data, [table:options]):boolean");
 
-    wxCSVData csv;
+    bool numeric = false;
+    int precision = 15;
+    lk::vardata_t *opt = 0;
+    if (cxt.arg_count() > 2 && cxt.arg(2).type() == lk::vardata_t::HASH) {
+        opt = &cxt.arg(2);
+        if (lk::vardata_t *x = opt->lookup("numeric"))
+            numeric = x->as_boolean();
+        if (lk::vardata_t *x = opt->lookup("precision"))
+            precision = x->as_integer();
+    }
+
+    wxFFileOutputStream file(cxt.arg(0).as_string());
+    if (!file.IsOk()) {
+        cxt.result().assign(0.0);
+        return;
+    }
 
+    // rows are padded to the same number of cells and quoted as wxCSVData writes them
+    wxCSVWriter csv(&file);
+    csv.SetStrictQuoting(false);
     lk::vardata_t &data = cxt.arg(1).deref();
     if (data.type() == lk::vardata_t::HASH) {
         std::vector<lk_string> colnames;
-        if (cxt.arg_count() > 2 && cxt.arg(2).type() == lk::vardata_t::HASH) {
-            lk::vardata_t &opt = cxt.arg(2);
-
-            if (lk::vardata_t *cl = opt.lookup("cols")) {
+        if (opt) {
+            if (lk::vardata_t *cl = opt->lookup("cols")) {
                 if (cl->type() == lk::vardata_t::VECTOR) {
                     for (size_t i = 0; i < cl->length(); i++) {
                         lk_string s = cl->index(i)->as_string();
@@ -1209,36 +1323,62 @@ void fcall_csvwrite(lk::invoke_t &cxt) {
                 colnames.push_back(it->first);
         }
 
-        size_t icol = 0;
-        for (std::vector<lk_string>::iterator it = colnames.begin();
-             it != colnames.end();
-             ++it) {
-            lk::varhash_t::iterator itdd = data.hash()->find(*it);
-            if (itdd != data.hash()->end()) {
-                csv(0, icol) = itdd->first;
-                lk::vardata_t &dd = *itdd->second;
-                if (dd.type() == lk::vardata_t::VECTOR) {
-                    for (size_t row = 0; row < dd.length(); row++)
-                        csv(1 + row, icol) = dd.index(row)->as_string();
-                } else
-                    csv(1, icol) = dd.as_string();
+        std::vector<lk::vardata_t *> cols;
+        size_t nrows = 0;
+        for (size_t i = 0; i < colnames.size(); i++) {
+            lk::vardata_t &dd = data.hash()->find(colnames[i])->second->deref();
+            cols.push_back(&dd);
+            nrows = std::max(nrows, dd.type() == lk::vardata_t::VECTOR ? dd.length() : (size_t) 1);
+        }
+
+        if (cols.size() > 0) {
+            for (size_t i = 0; i < colnames.size(); i++)
+                csv.Text(colnames[i]);
+            csv.EndRow();
+        }
 
-                icol++;
+        for (size_t row = 0; row < nrows; row++) {
+            for (size_t i = 0; i < cols.size(); i++) {
+                lk::vardata_t &dd = *cols[i];
+                if (dd.type() == lk::vardata_t::VECTOR) {
+                    if (row < dd.length()) csvwrite_cell(csv, *dd.index(row), numeric, precision);
+                    else csv.Text(0, 0);
+                } else if (row == 0)
+                    csvwrite_cell(csv, dd, numeric, precision);
+                else
+                    csv.Text(0, 0);
             }
+            csv.EndRow();
         }
     } else if (data.type() == lk::vardata_t::VECTOR) {
+        size_t ncols = 1;
         for (size_t r = 0; r < data.length(); r++) {
             lk::vardata_t &row = data.index(r)->deref();
+            if (row.type() == lk::vardata_t::VECTOR)
+                ncols = std::max(ncols, row.length());
+        }
+
+        for (size_t r = 0; r < data.length(); r++) {
+            lk::vardata_t &row = data.index(r)->deref();
+            size_t c = 0;
             if (row.type() == lk::vardata_t::VECTOR) {
-                for (size_t c = 0; c < row.length(); c++)
-                    csv(r, c) = row.index(c)->as_string();
-            } else
-                csv(r, 0) = row.as_string();
+                for (; c < row.length(); c++)
+                    csvwrite_cell(csv, *row.index(c), numeric, precision);
+            } else {
+                csvwrite_cell(csv, row, numeric, precision);
+                c++;
+            }
+            for (; c < ncols; c++)
+                csv.Text(0, 0);
+            csv.EndRow();
         }
-    } else
-        csv(0, 0) = data.as_string();
+    } else {
+        csvwrite_cell(csv, data, numeric, precision);
+        csv.EndRow();
+    }
 
-    cxt.result().assign(csv.WriteFile(cxt.arg(0).as_string()) ? 1.0 : 0.0);
+    csv.Flush();
+    cxt.result().assign(file.IsOk() ? 1.0 : 0.0);
 }
 
 void fcall_rand(lk::invoke_t &cxt) {
@@ -1335,7 +1475,7 @@ void fcall_out(lk::invoke_t &cxt) {
     wxString output;
     for (size_t i = 0; i < cxt.arg_count(); i++)
         output += cxt.arg(i).as_string();
-    lksc->OnOutput(output);
+    lksc->PostOutput(output);
 }
 
 void fcall_outln(lk::invoke_t &cxt) {
@@ -1346,7 +1486,7 @@ void fcall_outln(lk::invoke_t &cxt) {
     for (size_t i = 0; i < cxt.arg_count(); i++)
         output += cxt.arg(i).as_string();
     output += '\n';
-    lksc->OnOutput(output);
+    lksc->PostOutput(output);
 }
 
 lk::fcall_t *wxLKPlotFunctions() {
@@ -1600,10 +1740,92 @@ BEGIN_EVENT_TABLE(wxLKScriptCtrl, wxCodeEditCtrl)
                 EVT_TIMER(IDT_TIMER, wxLKScriptCtrl::OnTimer)
 END_EVENT_TABLE()
 
+// the script ctrl whose worker thread is the current thread, if any
+static thread_local wxLKScriptCtrl *s_workerCtrl = 0;
+
+// scripts running on a worker, whose nested event loop is on the stack
+static int s_workerRuns = 0;
+
+// Functions of main_thread libraries are registered through these forwarders,
+// one per function since an lk::fcall_t carries no state of its own, so the
+// table can't grow: functions beyond it get no forwarder and the scripts
+// that can call them are not run on a worker.
+static const int MAX_MAIN_THREAD_FUNCS = 128;
+static lk::fcall_t s_mainThreadFuncs[MAX_MAIN_THREAD_FUNCS];
+static lk::fcall_t s_mainThreadForwarders[MAX_MAIN_THREAD_FUNCS];
+static int s_numMainThreadFuncs = 0;
+
+template<int N>
+struct wxLKMainThreadCall {
+    static void Invoke(lk::invoke_t &cxt) {
+        if (s_workerCtrl != 0 && !cxt.doc_mode()) {
+            wxLKScriptCtrl::MainThreadCall call;
+            call.func = s_mainThreadFuncs[N];
+            call.cxt = &cxt;
+            s_workerCtrl->CallOnMainThread(&call);
+            if (call.error)
+                std::rethrow_exception(call.error);
+        } else
+            (*s_mainThreadFuncs[N])(cxt);
+    }
+};
+
+template<int N>
+struct wxLKMainThreadCallTable {
+    static void Fill(lk::fcall_t *table) {
+        table[N - 1] = &wxLKMainThreadCall<N - 1>::Invoke;
+        wxLKMainThreadCallTable<N - 1>::Fill(table);
+    }
+};
+
+template<>
+struct wxLKMainThreadCallTable<0> {
+    static void Fill(lk::fcall_t *) {}
+};
+
+static lk::fcall_t MainThreadForwarder(lk::fcall_t func) {
+    if (s_numMainThreadFuncs == 0)
+        wxLKMainThreadCallTable<MAX_MAIN_THREAD_FUNCS>::Fill(s_mainThreadForwarders);
+
+    for (int i = 0; i < s_numMainThreadFuncs; i++)
+        if (s_mainThreadFuncs[i] == func)
+            return s_mainThreadForwarders[i];
+
+    wxCHECK_MSG(s_numMainThreadFuncs < MAX_MAIN_THREAD_FUNCS, 0, "too many main thread script functions");
+
+    s_mainThreadFuncs[s_numMainThreadFuncs] = func;
+    return s_mainThreadForwarders[s_numMainThreadFuncs++];
+}
+
+class wxLKScriptWorker : public wxThread {
+    wxLKScriptCtrl *m_lcs;
+    bool m_ok;
+public:
+    wxLKScriptWorker(wxLKScriptCtrl *lcs)
+            : wxThread(wxTHREAD_JOINABLE), m_lcs(lcs), m_ok(false) {}
+
+    bool Ok() { return m_ok; }
+
+    virtual void *Entry() {
+        s_workerCtrl = m_lcs;
+        try {
+            m_ok = m_lcs->m_vm.run(lk::vm::NORMAL);
+        } catch (std::exception &e) {
+            m_lcs->PostOutput(wxString("Error: ") + e.what() + "\n");
+            m_ok = false;
+        } catch (...) {
+            m_ok = false;
+        }
+        s_workerCtrl = 0;
+        m_lcs->CallAfter(&wxLKScriptCtrl::OnWorkerFinished);
+        return 0;
+    }
+};
+
 wxLKScriptCtrl::wxLKScriptCtrl(wxWindow *parent, int id,
                                const wxPoint &pos, const wxSize &size, unsigned long libs)
         : wxCodeEditCtrl(parent, id, pos, size), m_timer(this, IDT_TIMER),
-          m_vm(this) {
+          m_callDone(m_callLock), m_vm(this) {
     m_syntaxCheckRequestId = m_syntaxCheckThreadId = 0;
     Bind(wxEVT_THREAD, &wxLKScriptCtrl::OnSyntaxCheckThreadFinished, this);
 
@@ -1616,6 +1838,12 @@ wxLKScriptCtrl::wxLKScriptCtrl(wxWindow *parent, int id,
     m_scriptRunning = false;
     m_stopScriptFlag = false;
 
+    m_threaded = false;
+    m_unforwarded = false;
+    m_workerLoop = 0;
+    m_workerDone = true;
+    m_instructionRate = 0;
+
     SetLanguage(LK);
     EnableCallTips(true);
 
@@ -1628,11 +1856,11 @@ wxLKScriptCtrl::wxLKScriptCtrl(wxWindow *parent, int id,
     if (libs & wxLK_STDLIB_MATH)
         RegisterLibrary(lk::stdlib_math(), "Math Functions");
     if (libs & wxLK_STDLIB_WXUI)
-        RegisterLibrary(lk::stdlib_wxui(), "User interface Functions");
+        RegisterLibrary(lk::stdlib_wxui(), "User interface Functions", 0, true);
     if (libs & wxLK_STDLIB_PLOT)
-        RegisterLibrary(wxLKPlotFunctions(), "Plotting Functions", this);
+        RegisterLibrary(wxLKPlotFunctions(), "Plotting Functions", this, true);
     if (libs & wxLK_STDLIB_MISC)
-        RegisterLibrary(wxLKMiscFunctions(), "Misc Functions", this);
+        RegisterLibrary(wxLKMiscFunctions(), "Misc Functions", this, true);
     if (libs & wxLK_STDLIB_FILE)
         RegisterLibrary(wxLKFileFunctions(), "Data File Functions", this);
     if (libs & wxLK_STDLIB_SOUT)
@@ -1669,8 +1897,36 @@ void wxLKScriptCtrl::OnOutput(const wxString &output) {
     wxLogStatus(output); // default behavior
 }
 
-void wxLKScriptCtrl::RegisterLibrary(lk::fcall_t *funcs, const wxString &group, void *user_data) {
-    m_env->register_funcs(funcs, user_data);
+void wxLKScriptCtrl::PostOutput(const wxString &output) {
+    if (s_workerCtrl != this) {
+        OnOutput(output);
+        return;
+    }
+
+    MainThreadCall *call = new MainThreadCall;
+    call->output = output;
+    call->async = true;
+    CallOnMainThread(call);
+}
+
+void wxLKScriptCtrl::RegisterLibrary(lk::fcall_t *funcs, const wxString &group, void *user_data,
+                                     bool main_thread) {
+    if (main_thread) {
+        std::vector<lk::fcall_t> forwarders;
+        for (size_t i = 0; funcs[i] != 0; i++) {
+            lk::fcall_t f = MainThreadForwarder(funcs[i]);
+            if (f == 0) {
+                f = funcs[i];
+                m_unforwarded = true;
+            }
+            forwarders.push_back(f);
+        }
+        forwarders.push_back(0);
+        m_mainThreadLibs.push_back(forwarders);
+        m_env->register_funcs(&m_mainThreadLibs.back()[0], user_data);
+    } else
+        m_env->register_funcs(funcs, user_data);
+
     libdata x;
     x.library = funcs;
     x.name = group;
@@ -2063,9 +2319,96 @@ void wxLKScriptCtrl::Stop() {
     m_stopScriptFlag = true;
 }
 
+size_t wxLKScriptCtrl::GetInstructionCount() {
+    return m_vm.counter();
+}
+
+void wxLKScriptCtrl::CallOnMainThread(MainThreadCall *call) {
+    wxMutexLocker lock(m_callLock);
+    // one pending event drains the whole queue
+    if (m_calls.empty())
+        CallAfter(&wxLKScriptCtrl::ProcessMainThreadCalls);
+    m_calls.push_back(call);
+
+    if (!call->async)
+        while (!call->done)
+            m_callDone.Wait();
+}
+
+void wxLKScriptCtrl::ProcessMainThreadCalls() {
+    std::vector<MainThreadCall *> calls;
+    {
+        wxMutexLocker lock(m_callLock);
+        calls.swap(m_calls);
+    }
+
+    for (size_t i = 0; i < calls.size(); i++) {
+        MainThreadCall *call = calls[i];
+        try {
+            if (call->func)
+                (*call->func)(*call->cxt);
+            else if (call->eval)
+                call->eval = OnEval(call->line);
+            else
+                OnOutput(call->output);
+        } catch (...) {
+            call->error = std::current_exception();
+        }
+
+        if (call->async)
+            delete call;
+        else {
+            // the worker owns the call and may release it as soon as it is done
+            wxMutexLocker lock(m_callLock);
+            call->done = true;
+            m_callDone.Broadcast();
+        }
+    }
+}
+
+bool wxLKScriptCtrl::EvalOnMainThread(int line) {
+    MainThreadCall call;
+    call.eval = true;
+    call.line = line;
+    CallOnMainThread(&call);
+    if (call.error)
+        std::rethrow_exception(call.error);
+    return call.eval;
+}
+
+bool wxLKScriptCtrl::RunOnWorker() {
+    wxLKScriptWorker worker(this);
+    if (worker.Create() != wxTHREAD_NO_ERROR
+        || worker.Run() != wxTHREAD_NO_ERROR)
+        return m_vm.run(lk::vm::NORMAL);
+
+    // the main thread serves the calls of the script until it finishes.
+    // windows other than this one could start another run or be closed
+    // under the nested loop, so they are disabled meanwhile
+    wxWindowDisabler disabler(wxGetTopLevelParent(this));
+    wxEventLoop loop;
+    s_workerRuns++;
+    m_workerDone = false;
+    m_workerLoop = &loop;
+    if (!m_workerDone)
+        loop.Run();
+    m_workerLoop = 0;
+    s_workerRuns--;
+
+    worker.Wait();
+    return worker.Ok();
+}
+
+void wxLKScriptCtrl::OnWorkerFinished() {
+    m_workerDone = true;
+    if (m_workerLoop != 0 && m_workerLoop->IsRunning())
+        m_workerLoop->Exit();
+}
+
 wxLKScriptCtrl::my_vm::my_vm(wxLKScriptCtrl *lcs)
         : lk::vm(), m_lcs(lcs) {
     m_counter = 0;
+    m_lastEval = 0;
 }
 
 bool wxLKScriptCtrl::my_vm::on_run(const lk::srcpos_t &a_sp) {
@@ -2073,6 +2416,19 @@ bool wxLKScriptCtrl::my_vm::on_run(const lk::srcpos_t &a_sp) {
     // constant is a power of two: so use bitwise operator for better performance
     // see https://en.wikipedia.org/wiki/Modulo_operation#Performance_issues
     if (0 == (m_counter++ & 1023)) {
+        if (s_workerCtrl == m_lcs) {
+            // running on the worker: no need to keep the UI alive from here,
+            // so only check for a stop request and call OnEval now and then
+            if (m_lcs->IsStopFlagSet())
+                return false;
+
+            wxLongLong now = wxGetLocalTimeMillis();
+            if (now - m_lastEval < 100)
+                return true;
+            m_lastEval = now;
+            return m_lcs->EvalOnMainThread(a_sp.line);
+        }
+
         wxYield();
         return m_lcs->OnEval(a_sp.line);
     } else return true;
@@ -2196,7 +2552,7 @@ wxString wxLKScriptCtrl::GetWorkDir() {
 }
 
 bool wxLKScriptCtrl::Execute() {
-    if (m_scriptRunning) {
+    if (m_scriptRunning || s_workerRuns > 0) {
         wxMessageBox("A script is already running.");
         return false;
     }
@@ -2227,13 +2583,23 @@ bool wxLKScriptCtrl::Execute() {
         success = false;
 
     m_vm.clrbrk();
+    m_vm.reset_counter();
     wxStopWatch sw;
     if (success) {
         if (GetBreakpoints().size() > 0) success = Debug(DEBUG_RUN);
+        else if (m_threaded && m_unforwarded) {
+            OnOutput("Too many main thread functions to run on a worker thread, running on the main thread.\n");
+            success = m_vm.run(lk::vm::NORMAL);
+        } else if (m_threaded) success = RunOnWorker();
         else success = m_vm.run(lk::vm::NORMAL);
     }
 
-    if (success) OnOutput(wxString::Format("Elapsed time: %.1lf seconds.\n", 0.001 * sw.Time()));
+    long msec = sw.Time();
+    m_instructionRate = msec > 0 ? 1000.0 * GetInstructionCount() / msec : 0.0;
+
+    if (success)
+        OnOutput(wxString::Format("Elapsed time: %.1lf seconds, %.2lf million instructions/sec.\n",
+                                  0.001 * msec, 1e-6 * m_instructionRate));
     else {
         if (wxYES ==
             wxMessageBox("An error occurred in the script:\n\n" + m_vm.error() + "\n\nBreak into the debugger?",
@@ -2376,7 +2742,7 @@ wxLKScriptWindow::wxLKScriptWindow(wxWindow *parent, int id, const wxPoint &pos,
 
     m_toolbar->Add(new wxMetroButton(this, wxID_ABOUT, "Functions"), 0, wxALL | wxEXPAND, 0);
     m_toolbar->Add(new wxMetroButton(this, wxID_HELP, "Help"), 0, wxALL | wxEXPAND, 0);
-    m_toolbar->Add(new wxMetroButton(this, wxID_CLOSE, "Close"), 0, wxALL | wxEXPAND, 0);
+    m_toolbar->Add(m_closeBtn = new wxMetroButton(this, wxID_CLOSE, "Close"), 0, wxALL | wxEXPAND, 0);
 
     m_stopBtn->Hide();
 
@@ -2592,6 +2958,10 @@ wxString wxLKScriptWindow::GetFileName() {
 }
 
 void wxLKScriptWindow::OnCommand(wxCommandEvent &evt) {
+    // accelerators still arrive while the buttons are disabled
+    if (m_script->IsScriptRunning() && (evt.GetId() == wxID_EXECUTE || evt.GetId() == wxID_CLOSE))
+        return;
+
     switch (evt.GetId()) {
         case wxID_NEW:
             CreateNewWindow();
@@ -2640,9 +3010,17 @@ void wxLKScriptWindow::OnHelp() {
 }
 
 bool wxLKScriptWindow::RunScript() {
+    if (m_script->IsScriptRunning())
+        return false;
+
     m_output->Clear();
     m_runBtn->Hide();
     m_stopBtn->Show();
+    m_closeBtn->Disable();
+    if (wxMenuBar *menu = GetMenuBar()) {
+        menu->Enable(wxID_EXECUTE, false);
+        menu->Enable(wxID_CLOSE, false);
+    }
     Layout();
     wxYield();
 
@@ -2655,6 +3033,11 @@ bool wxLKScriptWindow::RunScript() {
 
     m_stopBtn->Hide();
     m_runBtn->Show();
+    m_closeBtn->Enable();
+    if (wxMenuBar *menu = GetMenuBar()) {
+        menu->Enable(wxID_EXECUTE, true);
+        menu->Enable(wxID_CLOSE, true);
+    }
     Layout();
     return ok;
 }
@@ -31,9 +31,11 @@ wxPLColourMap::wxPLColourMap(double min, double max) {
     m_max = max;
     m_format = "%lg";
     m_reversed = false;
+    m_interpolate = false;
 }
 
 wxPLColourMap::wxPLColourMap(const wxPLColourMap &cpy) {
+    m_reversed = false;
     Copy(cpy);
 }
 
@@ -53,6 +55,8 @@ void wxPLColourMap::Copy(const wxPLColourMap &cpy) {
     m_max = cpy.m_max;
     m_format = cpy.m_format;
     m_colourList = cpy.m_colourList;
+    m_interpolate = cpy.m_interpolate;
+    m_lut.clear();
 }
 
 void wxPLColourMap::SetScaleMinMax(double min, double max) {
@@ -152,6 +156,7 @@ void wxPLColourMap::Render(wxPLOutputDevice &dc, const wxPLRealRect &geom) {
 
 wxColour wxPLColourMap::ColourForValue(double val) {
     if (m_colourList.size() == 0 || !(wxFinite(val))) return *wxBLACK;
+    if (m_max == m_min) return m_colourList.front();
 
     int position =
             (int) (((double) m_colourList.size()) * (
@@ -168,6 +173,84 @@ wxColour wxPLColourMap::ColourForValue(double val) {
         return m_colourList.back();
 }
 
+void wxPLColourMap::SetInterpolation(bool b) {
+    if (m_interpolate != b)
+        m_lut.clear();
+    m_interpolate = b;
+}
+
+void wxPLColourMap::BuildLookupTable() {
+    // a whole number of entries per colour so that without interpolation
+    // entry k has exactly the colour that ColourForValue picks for it
+    size_t ncol = m_colourList.size();
+    size_t per = ncol < 4096 ? 4096 / ncol : 1;
+    size_t len = ncol * per;
+
+    m_lut.resize(len);
+    for (size_t k = 0; k < len; k++) {
+        if (!m_interpolate) {
+            m_lut[k] = PackColour(m_colourList[k / per]);
+            continue;
+        }
+
+        // blend between the centers of neighbouring colours
+        double p = ((double) k + 0.5) / per - 0.5;
+        if (p < 0) p = 0;
+        if (p > ncol - 1) p = ncol - 1;
+        size_t i0 = (size_t) p;
+        size_t i1 = i0 + 1 < ncol ? i0 + 1 : i0;
+        double f = p - i0;
+        const wxColour &c0 = m_colourList[i0];
+        const wxColour &c1 = m_colourList[i1];
+        m_lut[k] = PackColour(wxColour((unsigned char) (c0.Red() + f * (c1.Red() - c0.Red()) + 0.5),
+                                       (unsigned char) (c0.Green() + f * (c1.Green() - c0.Green()) + 0.5),
+                                       (unsigned char) (c0.Blue() + f * (c1.Blue() - c0.Blue()) + 0.5),
+                                       (unsigned char) (c0.Alpha() + f * (c1.Alpha() - c0.Alpha()) + 0.5)));
+    }
+}
+
+void wxPLColourMap::ColoursForValues(const double *values, size_t n, wxUint32 *rgba) {
+    const wxUint32 black = PackColour(*wxBLACK);
+    if (m_colourList.size() == 0) {
+        for (size_t i = 0; i < n; i++)
+            rgba[i] = black;
+        return;
+    }
+
+    if (m_lut.size() == 0)
+        BuildLookupTable();
+
+    const wxUint32 *lut = &m_lut[0];
+    const double len = (double) m_lut.size();
+    const int last = (int) m_lut.size() - 1;
+
+    // index = (val - min) * scale + offset, with reversing folded in.  an
+    // empty range maps everything to the first colour, as ColourForValue does
+    double scale = m_max != m_min ? len / (m_max - m_min) : 0.0;
+    double offset = 0.0;
+    if (m_reversed && scale != 0.0) {
+        scale = -scale;
+        offset = len;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        double v = values[i];
+        if (!wxFinite(v)) {
+            rgba[i] = black;
+            continue;
+        }
+
+        double z = (v - m_min) * scale + offset;
+        int k = z <= 0 ? 0 : (z >= len ? last : (int) z);
+        rgba[i] = lut[k];
+    }
+}
+
+void wxPLColourMap::ColoursForValuesSlow(const double *values, size_t n, wxUint32 *rgba) {
+    for (size_t i = 0; i < n; i++)
+        rgba[i] = PackColour(ColourForValue(values[i]));
+}
+
 wxPLCoarseRainbowColourMap::wxPLCoarseRainbowColourMap(double min, double max)
         : wxPLColourMap(min, max) {
     m_colourList.push_back(wxColour(0, 0, 0));
@@ -23,6 +23,7 @@
 **********************************************************************************************************************/
 
 #include <wx/msgdlg.h>
+#include <wx/thread.h>
 
 #include "wex/plot/plcontourplot.h"
 #include "wex/plot/plcolourmap.h"
@@ -226,10 +227,18 @@ static void draw_tri_mesh(wxPLOutputDevice &dc, const wxPLDeviceMapping &map)
 void wxPLContourPlot::Draw(wxPLOutputDevice &dc, const wxPLDeviceMapping &map) {
     if (!m_cmap) return;
 
+    // map the level of every polygon in one call
+    std::vector<double> zv(m_cPolys.size() + 1);
+    std::vector<wxUint32> rgba(zv.size());
+    for (size_t i = 0; i < m_cPolys.size(); i++)
+        zv[i] = m_filled ? 0.5 * (m_cPolys[i].z + m_cPolys[i].zmax) : m_cPolys[i].z;
+    zv[m_cPolys.size()] = m_zMin;
+    m_cmap->ColoursForValues(&zv[0], zv.size(), &rgba[0]);
+
     if (!m_filled) {
         dc.NoBrush();
         for (size_t i = 0; i < m_cPolys.size(); i++) {
-            dc.Pen(m_cmap->ColourForValue(m_cPolys[i].z), 2);
+            dc.Pen(wxPLColourMap::UnpackColour(rgba[i]), 2);
 
             size_t n = m_cPolys[i].pts.size();
             std::vector<wxRealPoint> mapped(n);
@@ -242,7 +251,7 @@ void wxPLContourPlot::Draw(wxPLOutputDevice &dc, const wxPLDeviceMapping &map) {
         dc.NoPen();
         // background set to min
         // assume RebuildMask has been called
-        wxColor bgc(m_cmap->ColourForValue(m_zMin));
+        wxColor bgc(wxPLColourMap::UnpackColour(rgba[m_cPolys.size()]));
         dc.Brush(bgc);
         wxRealPoint pos, size;
         map.GetDeviceExtents(&pos, &size);
@@ -251,8 +260,7 @@ void wxPLContourPlot::Draw(wxPLOutputDevice &dc, const wxPLDeviceMapping &map) {
 
 //		int ipoly = 0;
         for (size_t i = 0; i < m_cPolys.size(); i++) {
-            double zmid = 0.5 * (m_cPolys[i].z + m_cPolys[i].zmax);
-            wxColour color(m_cmap->ColourForValue(zmid));
+            wxColour color(wxPLColourMap::UnpackColour(rgba[i]));
             dc.Pen(color, 2);
             dc.Brush(color);
 
@@ -528,8 +536,8 @@ static bool qhull_delaunay(int npoints, const double *x, const double *y,
 
 static int
 search(const wxMatrix<int> &tri, const std::vector<double> &x, const std::vector<double> &y, double xq, double yq) {
-    // TODO: http://www.geom.uiuc.edu/~bradb/qhull3.1/html/qh-faq.htm#vclosest
-    // this is a naive search - faster methods available for delaunay triangulation using the neighbors information
+    // naive linear scan over all triangles: used as the fallback for walk_search()
+    // and kept for benchmarking against it
     for (size_t i = 0; i < tri.Rows(); i++) {
         /*
         Get the vertices of triangle TRIANGLE.
@@ -572,6 +580,120 @@ search(const wxMatrix<int> &tri, const std::vector<double> &x, const std::vector
     return -1;
 }
 
+/* Visibility walk through the triangulation starting at triangle 'start'.
+ * neighbors(i,j) is the triangle across the edge from vertex j to vertex j+1
+ * of triangle i, or -1 on the convex hull.  At each step we cross an edge
+ * that separates the current triangle from the query point, so for nearby
+ * queries (consecutive grid cells) only a handful of triangles are visited.
+ * Returns -1 if the point is outside the hull, and falls back to the linear
+ * search if a degenerate triangle is hit. */
+static int walk_search(const wxMatrix<int> &tri, const wxMatrix<int> &neighbors,
+                       const std::vector<double> &x, const std::vector<double> &y,
+                       double xq, double yq, int start) {
+    int ntri = (int) tri.Rows();
+    if (ntri == 0) return -1;
+    if (start < 0 || start >= ntri) start = 0;
+
+    int cur = start;
+    for (int step = 0; step < ntri; step++) {
+        int v[3] = {tri(cur, 0), tri(cur, 1), tri(cur, 2)};
+
+        double area = (x[v[1]] - x[v[0]]) * (y[v[2]] - y[v[0]])
+                      - (y[v[1]] - y[v[0]]) * (x[v[2]] - x[v[0]]);
+        if (area == 0.0) break;
+        double sign = area > 0 ? 1.0 : -1.0;
+
+        int next = -2;
+        for (int k = 0; k < 3; k++) {
+            // rotate the starting edge so the walk can't cycle between two triangles
+            int j = (k + step) % 3;
+            int a = v[j];
+            int b = v[(j + 1) % 3];
+            double orient = (x[b] - x[a]) * (yq - y[a]) - (y[b] - y[a]) * (xq - x[a]);
+            if (sign * orient < 0.0) {
+                next = neighbors(cur, j);
+                break;
+            }
+        }
+
+        if (next == -2) return cur; // inside or on the boundary of this triangle
+        if (next < 0) return -1; // crossed the convex hull
+        cur = next;
+    }
+
+    return search(tri, x, y, xq, yq);
+}
+
+static double interp_at(const wxMatrix<int> &triangles, const std::vector<double> &x,
+                        const std::vector<double> &y, const std::vector<double> &z,
+                        int index, double xqq, double yqq) {
+    double zqq = std::numeric_limits<double>::quiet_NaN();
+    if (index < 0) return zqq;
+
+    int a = triangles(index, 0);
+    int b = triangles(index, 1);
+    int c = triangles(index, 2);
+
+    double d1 = sqrt(pow(xqq - x[a], 2) + pow(yqq - y[a], 2));
+    if (d1 == 0.0) zqq = z[a];
+
+    double d2 = sqrt(pow(xqq - x[b], 2) + pow(yqq - y[b], 2));
+    if (d2 == 0.0) zqq = z[b];
+
+    double d3 = sqrt(pow(xqq - x[c], 2) + pow(yqq - y[c], 2));
+    if (d3 == 0.0) zqq = z[c];
+
+    // calculate interpolated Z value
+    if (!std::isfinite(zqq)) {
+        d1 = 1.0 / d1;
+        d2 = 1.0 / d2;
+        d3 = 1.0 / d3;
+        zqq = (d1 * z[a] + d2 * z[b] + d3 * z[c]) / (d1 + d2 + d3);
+    }
+
+    return zqq;
+}
+
+// interpolates a band of query rows; bands are independent so they run in parallel
+struct GridDataRows {
+    const wxMatrix<int> *triangles, *neighbors;
+    const std::vector<double> *x, *y, *z;
+    const wxMatrix<double> *xq, *yq;
+    wxMatrix<double> *zinterp;
+    size_t row0, row1;
+    bool linear;
+
+    void Run() {
+        int last = 0;
+        for (size_t i = row0; i < row1; i++) {
+            for (size_t j = 0; j < xq->Cols(); j++) {
+                double xqq = (*xq)(i, j);
+                double yqq = (*yq)(i, j);
+
+                int index = linear
+                            ? search(*triangles, *x, *y, xqq, yqq)
+                            : walk_search(*triangles, *neighbors, *x, *y, xqq, yqq, last);
+                if (index >= 0) last = index;
+
+                (*zinterp)(i, j) = interp_at(*triangles, *x, *y, *z, index, xqq, yqq);
+            }
+        }
+    }
+};
+
+class GridDataThread : public wxThread {
+    GridDataRows *m_rows;
+public:
+    GridDataThread(GridDataRows *rows)
+            : wxThread(wxTHREAD_JOINABLE), m_rows(rows) {
+    }
+
+    virtual void *Entry() {
+        m_rows->Run();
+        return 0;
+    }
+};
+
 #include <wx/msgdlg.h>
 
 bool wxPLContourPlot::GridData(
@@ -580,7 +702,8 @@ bool wxPLContourPlot::GridData(
         const std::vector<double> &z,
         const wxMatrix<double> &xq,
         const wxMatrix<double> &yq,
-        wxMatrix<double> &zinterp) {
+        wxMatrix<double> &zinterp,
+        bool linear_search) {
     if (x.size() != y.size() || y.size() != z.size()) return false;
     if (xq.Rows() != yq.Rows() || xq.Cols() != yq.Cols()) return false;
 
@@ -605,39 +728,48 @@ bool wxPLContourPlot::GridData(
 
     zinterp.Resize(xq.Rows(), xq.Cols());
 
-    for (size_t i = 0; i < xq.Rows(); i++) {
-        for (size_t j = 0; j < xq.Cols(); j++) {
-            double xqq = xq(i, j);
-            double yqq = yq(i, j);
-            double zqq = std::numeric_limits<double>::quiet_NaN();
-
-            int index = search(triangles, x, y, xqq, yqq);
-            if (index >= 0) {
-                int a = triangles(index, 0);
-                int b = triangles(index, 1);
-                int c = triangles(index, 2);
-
-                double d1 = sqrt(pow(xqq - x[a], 2) + pow(yqq - y[a], 2));
-                if (d1 == 0.0) zqq = z[a];
-
-                double d2 = sqrt(pow(xqq - x[b], 2) + pow(yqq - y[b], 2));
-                if (d2 == 0.0) zqq = z[b];
-
-                double d3 = sqrt(pow(xqq - x[c], 2) + pow(yqq - y[c], 2));
-                if (d3 == 0.0) zqq = z[c];
-
-                // calculate interpolated Z value
-                if (!std::isfinite(zqq)) {
-                    d1 = 1.0 / d1;
-                    d2 = 1.0 / d2;
-                    d3 = 1.0 / d3;
-                    zqq = (d1 * z[a] + d2 * z[b] + d3 * z[c]) / (d1 + d2 + d3);
-                }
-            }
+    // split the query rows into one band per CPU for larger grids
+    size_t nrows = xq.Rows();
+    size_t nbands = 1;
+    if (xq.Cells() >= 4096) {
+        int ncpu = wxThread::GetCPUCount();
+        nbands = std::max((size_t) 1, std::min((size_t) std::max(ncpu, 1), nrows));
+    }
+
+    std::vector<GridDataRows> bands(nbands);
+    for (size_t b = 0; b < nbands; b++) {
+        GridDataRows &r = bands[b];
+        r.triangles = &triangles;
+        r.neighbors = &neighbors;
+        r.x = &x;
+        r.y = &y;
+        r.z = &z;
+        r.xq = &xq;
+        r.yq = &yq;
+        r.zinterp = &zinterp;
+        r.row0 = (nrows * b) / nbands;
+        r.row1 = (nrows * (b + 1)) / nbands;
+        r.linear = linear_search;
+    }
 
-            zinterp(i, j) = zqq;
+    std::vector<GridDataThread *> threads;
+    for (size_t b = 1; b < nbands; b++) {
+        GridDataThread *t = new GridDataThread(&bands[b]);
+        if (t->Run() == wxTHREAD_NO_ERROR)
+            threads.push_back(t);
+        else {
+            delete t;
+            bands[b].Run();
         }
     }
 
+    // the calling thread takes the first band itself
+    bands[0].Run();
+
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i]->Wait();
+        delete threads[i];
+    }
+
     return true;
 }
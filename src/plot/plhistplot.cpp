@@ -22,9 +22,276 @@
 *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 **********************************************************************************************************************/
 
+#include <algorithm>
+
 #include <wx/dc.h>
+#include <wx/math.h>
+
 #include "wex/plot/plhistplot.h"
 
+wxPLDistribution::wxPLDistribution(size_t exactLimit, size_t fineBins)
+        : m_exactLimit(exactLimit), m_fineBins(std::max(fineBins, (size_t) 2) & ~(size_t) 1) {
+    Clear();
+}
+
+void wxPLDistribution::Clear() {
+    m_exact = true;
+    m_count = m_zeros = 0;
+    m_min = m_max = 0.0;
+    m_values.clear();
+    m_fine.clear();
+    m_origin = m_width = 0.0;
+}
+
+void wxPLDistribution::Add(double y) {
+    if (!wxFinite(y)) return;
+
+    if (m_count == 0)
+        m_min = m_max = y;
+    else if (y < m_min)
+        m_min = y;
+    else if (y > m_max)
+        m_max = y;
+
+    m_count++;
+
+    if (m_exact) {
+        m_values.push_back(y);
+        if (y == 0.0) m_zeros++;
+        if (m_values.size() > m_exactLimit)
+            ToSketch();
+    } else if (y == 0.0)
+        m_zeros++;
+    else
+        AddFine(y);
+}
+
+void wxPLDistribution::Add(const std::vector<wxRealPoint> &data) {
+    if (m_exact && m_count + data.size() <= m_exactLimit)
+        m_values.reserve(m_count + data.size());
+
+    for (size_t i = 0; i < data.size(); i++)
+        Add(data[i].y);
+}
+
+void wxPLDistribution::Finish() {
+    if (m_exact)
+        std::sort(m_values.begin(), m_values.end());
+}
+
+void wxPLDistribution::ToSketch() {
+    // start with the values seen so far in the lower half of the bins
+    m_fine.assign(m_fineBins, 0.0);
+    m_origin = m_min;
+    m_width = (m_max - m_min) / (m_fineBins / 2);
+    if (m_width <= 0.0)
+        m_width = m_min != 0.0 ? fabs(m_min) * 1e-6 : 1e-6;
+
+    m_exact = false;
+    for (size_t i = 0; i < m_values.size(); i++)
+        if (m_values[i] != 0.0)
+            AddFine(m_values[i]);
+
+    std::vector<double>().swap(m_values);
+}
+
+void wxPLDistribution::AddFine(double y) {
+    size_t n = m_fineBins, half = m_fineBins / 2;
+
+    while (y < m_origin || y >= m_origin + n * m_width) {
+        // merge pairs of bins into the lower half
+        for (size_t j = 0; j < half; j++)
+            m_fine[j] = m_fine[2 * j] + m_fine[2 * j + 1];
+        for (size_t j = half; j < n; j++)
+            m_fine[j] = 0.0;
+        m_width *= 2;
+
+        if (y < m_origin) {
+            // and move them up to make room below
+            for (size_t j = 0; j < half; j++) {
+                m_fine[j + half] = m_fine[j];
+                m_fine[j] = 0.0;
+            }
+            m_origin -= half * m_width;
+        }
+    }
+
+    size_t k = (size_t) ((y - m_origin) / m_width);
+    if (k >= n) k = n - 1;
+    m_fine[k]++;
+}
+
+size_t wxPLDistribution::Count(bool ignoreZeros) const {
+    return ignoreZeros ? m_count - m_zeros : m_count;
+}
+
+void wxPLDistribution::Histogram(size_t nbins, bool ignoreZeros, std::vector<double> &counts,
+                                 std::vector<wxRealPoint> *ranges) const {
+    counts.clear();
+    if (ranges) ranges->clear();
+
+    if (m_count < 2 || nbins < 1 || m_min == m_max) return;
+
+    counts.resize(nbins, 0.0);
+    if (ranges) ranges->resize(nbins, wxRealPoint(m_max, m_min));
+
+    double span = m_max - m_min;
+
+    if (m_exact) {
+        for (size_t i = 0; i < m_values.size(); i++) {
+            double y = m_values[i];
+            if (ignoreZeros && y == 0.0) continue;
+
+            size_t index = nbins * (y - m_min) / span;
+            if (index >= nbins)
+                index--;
+
+            counts[index]++;
+            if (ranges) {
+                wxRealPoint &r = (*ranges)[index];
+                if (r.x > y) r.x = y;
+                if (r.y < y) r.y = y;
+            }
+        }
+        return;
+    }
+
+    // spread each fine bin over the bins it overlaps
+    for (size_t k = 0; k < m_fine.size(); k++) {
+        double c = m_fine[k];
+        if (c == 0.0) continue;
+
+        double lo = std::max(m_origin + k * m_width, m_min);
+        double hi = std::min(m_origin + (k + 1) * m_width, m_max);
+
+        size_t i0 = std::min((size_t) (nbins * (lo - m_min) / span), nbins - 1);
+        size_t i1 = std::min((size_t) (nbins * (hi - m_min) / span), nbins - 1);
+
+        double spread = 0.0;
+        for (size_t i = i0; hi > lo && i <= i1; i++) {
+            double binLo = std::max(lo, m_min + i * span / nbins);
+            double binHi = std::min(hi, m_min + (i + 1) * span / nbins);
+            if (binHi <= binLo) continue;
+
+            double part = c * (binHi - binLo) / (hi - lo);
+            counts[i] += part;
+            spread += part;
+            if (ranges) {
+                wxRealPoint &r = (*ranges)[i];
+                if (r.x > binLo) r.x = binLo;
+                if (r.y < binHi) r.y = binHi;
+            }
+        }
+
+        if (spread == 0.0) {
+            counts[i0] += c;
+            if (ranges) {
+                wxRealPoint &r = (*ranges)[i0];
+                if (r.x > lo) r.x = lo;
+                if (r.y < lo) r.y = lo;
+            }
+        }
+    }
+
+    if (!ignoreZeros && m_zeros > 0) {
+        size_t index = std::min((size_t) (nbins * (0.0 - m_min) / span), nbins - 1);
+        counts[index] += m_zeros;
+        if (ranges) {
+            wxRealPoint &r = (*ranges)[index];
+            if (r.x > 0.0) r.x = 0.0;
+            if (r.y < 0.0) r.y = 0.0;
+        }
+    }
+}
+
+void wxPLDistribution::Cdf(bool ignoreZeros, std::vector<wxRealPoint> &cdf) const {
+    cdf.clear();
+    size_t n = Count(ignoreZeros);
+    if (n == 0) return;
+
+    if (m_exact) {
+        // the sorted values, as the empirical CDF is usually defined
+        double last = n > 1 ? double(n - 1) : 1.0;
+        cdf.reserve(n);
+        for (size_t i = 0; i < m_values.size(); i++) {
+            if (ignoreZeros && m_values[i] == 0.0) continue;
+            cdf.push_back(wxRealPoint(m_values[i], 100 * double(cdf.size()) / last));
+        }
+        return;
+    }
+
+    // the upper edge of each non empty fine bin, and the zeros as a step
+    double total = double(n), cum = 0.0;
+    bool zerosDone = ignoreZeros || m_zeros == 0;
+
+    cdf.push_back(wxRealPoint(m_min, 0.0));
+    for (size_t k = 0; k < m_fine.size(); k++) {
+        double lo = m_origin + k * m_width, hi = lo + m_width;
+        double c = m_fine[k];
+
+        if (!zerosDone && hi > 0.0) {
+            if (lo < 0.0) {
+                double below = c * (0.0 - lo) / m_width;
+                cum += below;
+                c -= below;
+            }
+            cdf.push_back(wxRealPoint(0.0, 100 * cum / total));
+            cum += m_zeros;
+            cdf.push_back(wxRealPoint(0.0, 100 * cum / total));
+            zerosDone = true;
+        }
+
+        if (c == 0.0) continue;
+
+        cum += c;
+        cdf.push_back(wxRealPoint(std::max(std::min(hi, m_max), m_min), 100 * cum / total));
+    }
+
+    if (!zerosDone) {
+        cdf.push_back(wxRealPoint(0.0, 100 * cum / total));
+        cum += m_zeros;
+        cdf.push_back(wxRealPoint(0.0, 100 * cum / total));
+    }
+}
+
+double wxPLDistribution::Quantile(double p, bool ignoreZeros) const {
+    size_t n = Count(ignoreZeros);
+    if (n == 0) return 0.0;
+
+    p = std::max(0.0, std::min(1.0, p));
+
+    if (m_exact) {
+        // zeros are contiguous in the sorted values
+        size_t z0 = 0, skip = 0;
+        if (ignoreZeros) {
+            z0 = std::lower_bound(m_values.begin(), m_values.end(), 0.0) - m_values.begin();
+            skip = m_zeros;
+        }
+
+        double rank = p * (n - 1);
+        size_t i = (size_t) rank;
+        if (i >= n - 1) i = n - 1;
+        size_t j = std::min(i + 1, n - 1);
+        double a = m_values[i < z0 || !ignoreZeros ? i : i + skip];
+        double b = m_values[j < z0 || !ignoreZeros ? j : j + skip];
+        return a + (b - a) * (rank - i);
+    }
+
+    std::vector<wxRealPoint> cdf;
+    Cdf(ignoreZeros, cdf);
+
+    double pct = 100 * p;
+    for (size_t i = 1; i < cdf.size(); i++) {
+        if (cdf[i].y >= pct) {
+            const wxRealPoint &a = cdf[i - 1], &b = cdf[i];
+            if (b.y <= a.y) return b.x;
+            return a.x + (b.x - a.x) * (pct - a.y) / (b.y - a.y);
+        }
+    }
+
+    return cdf.back().x;
+}
+
 wxPLHistogramPlot::wxPLHistogramPlot() {
     Init();
 }
@@ -33,8 +300,7 @@ wxPLHistogramPlot::wxPLHistogramPlot(const std::vector<wxRealPoint> &data,
                                      const wxString &label)
         : wxPLPlottable(label) {
     Init();
-    m_data = data;
-    RecalculateHistogram();
+    SetData(data);
 }
 
 void wxPLHistogramPlot::Init() {
@@ -50,6 +316,15 @@ void wxPLHistogramPlot::Init() {
 
 void wxPLHistogramPlot::SetData(const std::vector<wxRealPoint> &data) {
     m_data = data;
+    m_dist.Clear();
+    m_dist.Add(m_data);
+    m_dist.Finish();
+    RecalculateHistogram();
+}
+
+void wxPLHistogramPlot::SetDistribution(const wxPLDistribution &dist) {
+    m_data.clear();
+    m_dist = dist;
     RecalculateHistogram();
 }
 
@@ -223,44 +498,23 @@ std::vector<wxRealPoint> wxPLHistogramPlot::GetExportableDataset(double, double,
 }
 
 void wxPLHistogramPlot::RecalculateHistogram() {
-    //This method builds histogram data. (basically, just groups and counts WPPlotData)
+    //This method builds histogram data. (basically, just groups and counts the data)
     //Histogram data is stored in a local array m_histData.
-    //Uses WPPlotData to build this data.
-
-    size_t index;
-    size_t DataCount = 0;
-
-    m_histData.clear();
-    m_histDataBinRanges.clear();
+    //The bins come from the distribution summary built in SetData, so the points aren't scanned again.
 
-    if (m_data.size() < 2 || m_numberOfBins < 1) return;
-
-    m_dataMin = m_data[0].y;
-    m_dataMax = m_data[0].y;
-    for (size_t i = 1; i < m_data.size(); i++) {
-        if (m_data[i].y < m_dataMin) m_dataMin = m_data[i].y;
-        if (m_data[i].y > m_dataMax) m_dataMax = m_data[i].y;
+    if (m_dist.Count() < 2 || m_numberOfBins < 1) {
+        m_histData.clear();
+        m_histDataBinRanges.clear();
+        return;
     }
 
-    if (m_dataMin == m_dataMax) return;
-
-    m_histData.resize(m_numberOfBins, 0.0);
-    m_histDataBinRanges.resize(m_numberOfBins, wxRealPoint(m_dataMax, m_dataMin));
-
-    for (size_t i = 0; i < m_data.size(); i++) {
-        if (!m_ignoreZeros || m_data[i].y != 0) DataCount++;
-        if (m_ignoreZeros && m_data[i].y == 0) continue;
+    m_dataMin = m_dist.Min();
+    m_dataMax = m_dist.Max();
 
-        index = m_numberOfBins * (m_data[i].y - m_dataMin) / (m_dataMax - m_dataMin);
-        if (index >= m_numberOfBins)
-            index--;
+    m_dist.Histogram(m_numberOfBins, m_ignoreZeros, m_histData, &m_histDataBinRanges);
+    if (m_histData.empty()) return;
 
-        if (index < m_histData.size()) {
-            m_histData[index]++;
-            if (m_histDataBinRanges[index].x > m_data[i].y) { m_histDataBinRanges[index].x = m_data[i].y; }
-            if (m_histDataBinRanges[index].y < m_data[i].y) { m_histDataBinRanges[index].y = m_data[i].y; }
-        }
-    }
+    size_t DataCount = m_dist.Count(m_ignoreZeros);
     //We now have a histogram...
 
     m_niceMax = 0;
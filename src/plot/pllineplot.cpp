@@ -22,6 +22,9 @@
 *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 **********************************************************************************************************************/
 
+#include <algorithm>
+#include <math.h>
+
 #include <wx/dc.h>
 #include "wex/plot/pllineplot.h"
 
@@ -71,6 +74,7 @@ void wxPLLinePlot::Init() {
     m_style = SOLID;
     m_marker = NO_MARKER;
     m_ignoreZeros = false;
+    m_decimate = false;
 }
 
 wxRealPoint wxPLLinePlot::At(size_t i) const {
@@ -89,6 +93,59 @@ void wxPLLinePlot::SetIgnoreZeros(bool value) {
     m_ignoreZeros = value;
 }
 
+void wxPLLinePlot::Decimate(const std::vector<wxRealPoint> &points, std::vector<wxRealPoint> &out, double pixel) {
+    out.clear();
+
+    size_t n = points.size();
+    if (n < 5 || pixel <= 0) {
+        out = points;
+        return;
+    }
+
+    // the column bucketing below only works if the device x
+    // coordinates never decrease, otherwise draw everything
+    for (size_t i = 1; i < n; i++) {
+        if (points[i].x < points[i - 1].x) {
+            out = points;
+            return;
+        }
+    }
+
+    // M4 reduction: for every pixel column keep the first, last, minimum and
+    // maximum points in their original order.  A polyline through these
+    // rasterizes to the same pixels as the polyline through all the points.
+    size_t i = 0;
+    while (i < n) {
+        double col = floor(points[i].x / pixel);
+        size_t idx[4] = {i, i, i, i}; // first, min, max, last
+        size_t j = i + 1;
+        while (j < n && floor(points[j].x / pixel) == col) {
+            if (points[j].y < points[idx[1]].y) idx[1] = j;
+            if (points[j].y > points[idx[2]].y) idx[2] = j;
+            idx[3] = j;
+            j++;
+        }
+
+        std::sort(idx, idx + 4);
+        for (size_t k = 0; k < 4; k++)
+            if (k == 0 || idx[k] != idx[k - 1])
+                out.push_back(points[idx[k]]);
+
+        i = j;
+    }
+}
+
+void wxPLLinePlot::DrawLines(wxPLOutputDevice &dc, std::vector<wxRealPoint> &points) {
+    if (!m_decimate) {
+        dc.Lines(points.size(), &points[0]);
+        return;
+    }
+
+    std::vector<wxRealPoint> reduced;
+    Decimate(points, reduced, dc.PixelSize());
+    dc.Lines(reduced.size(), &reduced[0]);
+}
+
 void wxPLLinePlot::DrawMarkers(wxPLOutputDevice &dc, std::vector<wxRealPoint> &points, double size) {
     if (m_marker == NO_MARKER) return;
 
@@ -184,7 +241,7 @@ void wxPLLinePlot::Draw(wxPLOutputDevice &dc, const wxPLDeviceMapping &map) {
             // segments of data that don't have any NaN values
             if (m_style != NO_LINE) {
                 LINE_PEN;
-                dc.Lines(points.size(), &points[0]);
+                DrawLines(dc, points);
             }
 
             MARKER_PEN;
@@ -196,7 +253,7 @@ void wxPLLinePlot::Draw(wxPLOutputDevice &dc, const wxPLDeviceMapping &map) {
     if (points.size() > 1) {
         if (m_style != NO_LINE) {
             LINE_PEN;
-            dc.Lines(points.size(), &points[0]);
+            DrawLines(dc, points);
         }
 
         MARKER_PEN;
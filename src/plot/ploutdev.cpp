@@ -29,11 +29,30 @@
 #include <wex/plot/ploutdev.h>
 #include <wex/plot/pltext.h>
 
+void wxPLOutputDevice::Image(const wxImage &img, double x, double y, double width, double height) {
+    int nx = img.GetWidth(), ny = img.GetHeight();
+    if (nx < 1 || ny < 1) return;
+
+    double cw = width / nx, ch = height / ny;
+    bool alpha = img.HasAlpha();
+    NoPen();
+    for (int j = 0; j < ny; j++) {
+        for (int i = 0; i < nx; i++) {
+            unsigned char a = alpha ? img.GetAlpha(i, j) : wxALPHA_OPAQUE;
+            if (a == wxALPHA_TRANSPARENT) continue;
+            Brush(wxColour(img.GetRed(i, j), img.GetGreen(i, j), img.GetBlue(i, j), a));
+            Rect(x + i * cw, y + j * ch, cw, ch);
+        }
+    }
+}
+
 wxPLPdfOutputDevice::wxPLPdfOutputDevice(wxPdfDocument &doc, double fontpnts)
         : wxPLOutputDevice(), m_pdf(doc) {
     m_fontRelSize = 0;
     m_fontPoint0 = fontpnts;
     m_pen = m_brush = true;
+    m_imageCount = 0;
+    m_fillAlpha = wxALPHA_OPAQUE;
     m_pdf.SetTextColour(*wxBLACK);
 }
 
@@ -121,6 +140,12 @@ void wxPLPdfOutputDevice::Brush(const wxColour &c, Style sty) {
     // currently, hatch and other patterns not supported
     m_pdf.SetFillColour(c);
     m_brush = true;
+
+    // translucent fills need a graphics state, only switch when it changes
+    if (c.Alpha() != m_fillAlpha) {
+        m_fillAlpha = c.Alpha();
+        m_pdf.SetAlpha(1, m_fillAlpha / 255.0);
+    }
 }
 
 void wxPLPdfOutputDevice::Line(double x1, double y1, double x2, double y2) {
@@ -223,6 +248,17 @@ void wxPLPdfOutputDevice::Measure(const wxString &text, double *width, double *h
     if (height) *height = m_pdf.GetFontSize();
 }
 
+void wxPLPdfOutputDevice::Image(const wxImage &img, double x, double y, double width, double height) {
+    // images are cached by name in the document, so each one needs a new name
+    m_pdf.Image(wxString::Format("plimage%d", ++m_imageCount), img, x, y, width, height);
+}
+
+double wxPLPdfOutputDevice::PixelSize() const {
+    // PDF output is resolution independent: keep a few columns
+    // per point so that zoomed-in viewers still see the extremes
+    return 0.25;
+}
+
 #define CAST(x) ((int)wxRound(m_scale*(x)))
 
 static void TranslateBrush(wxBrush *b, const wxColour &c, wxPLOutputDevice::Style sty) {
@@ -567,3 +603,14 @@ void wxPLGraphicsOutputDevice::Measure(const wxString &text, double *width, doub
         *width = (wxCoord) (w + 0.5) / m_scale;
 #endif
 }
+
+void wxPLGraphicsOutputDevice::Image(const wxImage &img, double x, double y, double width, double height) {
+    wxInterpolationQuality q = m_gc->GetInterpolationQuality();
+    m_gc->SetInterpolationQuality(wxINTERPOLATION_NONE);
+    m_gc->DrawBitmap(m_gc->CreateBitmapFromImage(img), SCALE(x), SCALE(y), SCALE(width), SCALE(height));
+    m_gc->SetInterpolationQuality(q);
+}
+
+double wxPLGraphicsOutputDevice::PixelSize() const {
+    return m_scale > 0 ? 1.0 / m_scale : 1.0;
+}
@@ -911,7 +911,7 @@ void wxPLPlot::WriteDataAsText(wxUniChar sep, wxOutputStream &os, bool visible_o
         plot = m_plots[i].plot;
 
         worldMin = 0.0;
-        worldMax = plot->At(plot->Len() - 1).x;
+        worldMax = plot->Len() > 0 ? plot->At(plot->Len() - 1).x : 0.0;
 
         //We only include the x column on a plot if we are including X and if its x header is different than the previous column's.
         if (i == 0) {
@@ -1051,7 +1051,7 @@ public:
     }
 };
 
-void wxPLPlot::Render(wxPLOutputDevice &dc, wxPLRealRect geom) {
+void wxPLPlot::Render(wxPLOutputDevice &dc, wxPLRealRect geom, int layers) {
 #define NORMAL_FONT(dc)  dc.TextPoints( 0 )
 #define TITLE_FONT(dc)   dc.TextPoints( +1 )
 #define LEGEND_FONT(dc)  dc.TextPoints( -1 )
@@ -1069,21 +1069,29 @@ void wxPLPlot::Render(wxPLOutputDevice &dc, wxPLRealRect geom) {
             SetAxis(m_plots[i].plot->SuggestYAxis(), m_plots[i].yap, m_plots[i].ppos);
     }
 
+    // layouts are always calculated, only the requested layers are drawn
+    bool draw_grid = (layers & LAYER_GRID) != 0;
+    bool draw_data = (layers & LAYER_DATA) != 0;
+    bool draw_axes = (layers & LAYER_AXES) != 0;
+    bool draw_legend = (layers & LAYER_LEGEND) != 0;
+
     // draw any side widgets first and remove the space from the total plot area
     if (m_sideWidgets[Y_LEFT] != 0) {
         wxRealPoint sz = m_sideWidgets[Y_LEFT]->GetBestSize(dc);
-        m_sideWidgets[Y_LEFT]->Render(dc,
-                                      wxPLRealRect(geom.x, geom.y,
-                                                   sz.x, geom.height));
+        if (draw_axes)
+            m_sideWidgets[Y_LEFT]->Render(dc,
+                                          wxPLRealRect(geom.x, geom.y,
+                                                       sz.x, geom.height));
         geom.width -= sz.x;
         geom.x += sz.x;
     }
 
     if (m_sideWidgets[Y_RIGHT] != 0) {
         wxRealPoint sz = m_sideWidgets[Y_RIGHT]->GetBestSize(dc);
-        m_sideWidgets[Y_RIGHT]->Render(dc,
-                                       wxPLRealRect(geom.x + geom.width - sz.x, geom.y,
-                                                    sz.x, geom.height));
+        if (draw_axes)
+            m_sideWidgets[Y_RIGHT]->Render(dc,
+                                           wxPLRealRect(geom.x + geom.width - sz.x, geom.y,
+                                                        sz.x, geom.height));
 
         geom.width -= sz.x;
     }
@@ -1117,7 +1125,8 @@ void wxPLPlot::Render(wxPLOutputDevice &dc, wxPLRealRect geom) {
         if (m_titleLayout == 0)
             m_titleLayout = new wxPLTextLayout(dc, m_title, wxPLTextLayout::CENTER);
 
-        m_titleLayout->Render(dc, box.x + box.width / 2 - m_titleLayout->Width() / 2, box.y, 0, false);
+        if (draw_axes)
+            m_titleLayout->Render(dc, box.x + box.width / 2 - m_titleLayout->Width() / 2, box.y, 0, false);
         box.y += m_titleLayout->Height() + text_space;
         box.height -= m_titleLayout->Height() + text_space;
     } else {
@@ -1291,19 +1300,21 @@ void wxPLPlot::Render(wxPLOutputDevice &dc, wxPLRealRect geom) {
     m_plotRects.clear();
     for (size_t pp = 0; pp < nyaxes; pp++) {
         wxPLRealRect rect(box.x, cur_plot_y_start, box.width, single_plot_height);
-        if (is_cartesian)
-            dc.Rect(rect);
-        else {
-            double radius = (box.width < box.height) ? box.width / 2.0 : box.height / 2.0;
-            wxRealPoint cntr(box.x + box.width / 2.0, box.y + box.height / 2.0);
-            dc.Circle(cntr, radius);
+        if (draw_grid) {
+            if (is_cartesian)
+                dc.Rect(rect);
+            else {
+                double radius = (box.width < box.height) ? box.width / 2.0 : box.height / 2.0;
+                wxRealPoint cntr(box.x + box.width / 2.0, box.y + box.height / 2.0);
+                dc.Circle(cntr, radius);
+            }
         }
         m_plotRects.push_back(rect);
         cur_plot_y_start += single_plot_height + plot_space;
     }
 
     // render grid lines
-    if (m_showCoarseGrid) {
+    if (draw_grid && m_showCoarseGrid) {
         dc.Pen(m_gridColour, 0.5,
                wxPLOutputDevice::SOLID, wxPLOutputDevice::MITER, wxPLOutputDevice::BUTT);
 
@@ -1311,7 +1322,7 @@ void wxPLPlot::Render(wxPLOutputDevice &dc, wxPLRealRect geom) {
         else DrawPolarGrid(dc, wxPLAxis::TickData::LARGE);
     }
 
-    if (m_showFineGrid) {
+    if (draw_grid && m_showFineGrid) {
         dc.Pen(m_gridColour, 0.5,
                wxPLOutputDevice::DOT, wxPLOutputDevice::MITER, wxPLOutputDevice::BUTT);
 
@@ -1326,10 +1337,11 @@ void wxPLPlot::Render(wxPLOutputDevice &dc, wxPLRealRect geom) {
                           m_plotRects[0].height * nyaxes + (nyaxes - 1) * plot_space);
 
     // draw annotations that are zorder 'back' (i.e. under the plots)
-    DrawAnnotations(dc, plotarea, wxPLAnnotation::BACK);
+    if (draw_grid)
+        DrawAnnotations(dc, plotarea, wxPLAnnotation::BACK);
 
     // render plots
-    for (size_t i = 0; i < m_plots.size(); i++) {
+    for (size_t i = 0; draw_data && i < m_plots.size(); i++) {
         wxPLAxis *xaxis = GetAxis(m_plots[i].xap);
         wxPLAxis *yaxis = GetAxis(m_plots[i].yap, m_plots[i].ppos);
         if (xaxis == 0 || yaxis == 0) continue; // this should never be encountered
@@ -1353,6 +1365,28 @@ void wxPLPlot::Render(wxPLOutputDevice &dc, wxPLRealRect geom) {
 
     dc.SetAntiAliasing(false);
 
+    // set up some polar plot values
+    wxPLRealRect rect1 = m_plotRects[0];
+    double pp_radius = (rect1.width < rect1.height) ? rect1.width / 2.0 : rect1.height / 2.0;
+    wxRealPoint pp_center(rect1.x + rect1.width / 2.0, rect1.y + rect1.height / 2.0);
+
+    if (draw_axes)
+        RenderAxes(dc, box, plotbox, nyaxes, is_cartesian, pp_radius, pp_center,
+                   yleft_max_label_width, yright_max_label_width);
+
+    if (draw_legend) {
+        LEGEND_FONT(dc);
+
+        DrawLegend(dc, (m_legendPos == FLOATING || legend_bottom || legend_right) ? geom : plotarea);
+
+        // draw annotations on the top
+        DrawAnnotations(dc, plotarea, wxPLAnnotation::FRONT);
+    }
+}
+
+void wxPLPlot::RenderAxes(wxPLOutputDevice &dc, const wxPLRealRect &box, const wxPLRealRect &plotbox,
+                          size_t nyaxes, bool is_cartesian, double pp_radius, const wxRealPoint &pp_center,
+                          double yleft_max_label_width, double yright_max_label_width) {
     // draw some axes
     AXIS_FONT(dc);
     dc.TextColour(m_axisColour);
@@ -1362,11 +1396,6 @@ void wxPLPlot::Render(wxPLOutputDevice &dc, wxPLRealRect geom) {
                             box.x, box.x + box.width,
                             -1 /*m_x1.axis == 0 ? m_plotRects[nyaxes-1].y+m_plotRects[nyaxes-1].height : -1 */);
 
-    // set up some polar plot values
-    wxPLRealRect rect1 = m_plotRects[0];
-    double pp_radius = (rect1.width < rect1.height) ? rect1.width / 2.0 : rect1.height / 2.0;
-    wxRealPoint pp_center(rect1.x + rect1.width / 2.0, rect1.y + rect1.height / 2.0);
-
     // render y axes
     for (size_t pp = 0; pp < nyaxes; pp++) {
         if (m_y1[pp].axis != 0 && m_y1[pp].axis->IsShown()) {
@@ -1453,13 +1482,6 @@ void wxPLPlot::Render(wxPLOutputDevice &dc, wxPLRealRect geom) {
                                    m_plotRects[pp].y + m_plotRects[pp].height / 2 - m_y2[pp].label->Width() / 2, -90,
                                    false);
     }
-
-    LEGEND_FONT(dc);
-
-    DrawLegend(dc, (m_legendPos == FLOATING || legend_bottom || legend_right) ? geom : plotarea);
-
-    // draw annotations on the top
-    DrawAnnotations(dc, plotarea, wxPLAnnotation::FRONT);
 }
 
 void wxPLPlot::DrawAnnotations(wxPLOutputDevice &dc, const wxPLRealRect &plotarea, wxPLAnnotation::ZOrder zo) {
@@ -33,6 +33,7 @@
 #include <wx/dcgraph.h>
 #include <wx/dcprint.h>
 #include <wx/dcclient.h>
+#include <wx/dcmemory.h>
 #include <wx/log.h>
 #include <wx/tokenzr.h>
 #include <wx/menu.h>
@@ -42,6 +43,7 @@
 #include <wx/dcsvg.h>
 #include <wx/tipwin.h>
 #include <wx/graphics.h>
+#include <wx/math.h>
 
 #include "wex/utils.h"
 #include "wex/plot/ploutdev.h"
@@ -98,14 +100,17 @@ wxPLPlotCtrl::wxPLPlotCtrl(wxWindow *parent, int id, const wxPoint &pos, const w
     m_anchorPoint = wxPoint(0, 0);
     m_currentPoint = wxPoint(0, 0);
     m_moveLegendMode = false;
-    m_moveLegendErase = false;
+    m_moveLegendDragged = false;
     m_highlightMode = false;
-    m_highlightErase = false;
+    m_highlightDragged = false;
     m_highlightLeftPercent = 0.0;
     m_highlightRightPercent = 0.0;
     m_highlightTopPercent = 0.0;
     m_highlightBottomPercent = 0.0;
     m_highlighting = HIGHLIGHT_DISABLE;
+    m_dirtyLayers = LAYER_ALL;
+    m_layerScale = 1.0;
+    m_layersSplit = false;
 
     m_contextMenu.Append(ID_COPY_DATA_CLIP, "Copy data to clipboard");
     m_contextMenu.Append(ID_SAVE_DATA_CSV, "Save data to CSV...");
@@ -365,7 +370,7 @@ wxSize wxPLPlotCtrl::DoGetBestSize() const {
     return wxScaleSize(500, 400); // default plot size
 }
 
-void wxPLPlotCtrl::Render(wxGraphicsContext &gc, wxRect geom, double fontpoints) {
+void wxPLPlotCtrl::Render(wxGraphicsContext &gc, wxRect geom, double fontpoints, int layers) {
     if (fontpoints <= 0)
         fontpoints = GetTextSize();
 
@@ -386,7 +391,144 @@ void wxPLPlotCtrl::Render(wxGraphicsContext &gc, wxRect geom, double fontpoints)
     rr.height = geom.height / scale;
 
     wxPLGraphicsOutputDevice odev(&gc, scale, fontpoints);
-    wxPLPlot::Render(odev, rr);
+    wxPLPlot::Render(odev, rr, layers);
+}
+
+void wxPLPlotCtrl::Refresh(bool eraseBackground, const wxRect *rect) {
+    // anything about the plot may have changed since the last paint
+    m_dirtyLayers = LAYER_ALL;
+    wxWindow::Refresh(eraseBackground, rect);
+}
+
+void wxPLPlotCtrl::RefreshLayers(int layers) {
+    // a legend inside the plot area and the annotations in front of the plots
+    // follow the axes, so they are redrawn whenever the axes may have changed
+    LegendPos lpos = GetLegendPosition();
+    bool legend_inside = IsLegendShown() && lpos != FLOATING && lpos != BOTTOM && lpos != RIGHT;
+    if ((layers & (LAYER_GRID | LAYER_AXES)) && (legend_inside || GetAnnotationCount() > 0))
+        layers |= LAYER_LEGEND;
+
+    m_dirtyLayers |= layers;
+    wxWindow::Refresh(false);
+}
+
+static double LayerScaleFactor(const wxWindow *win) {
+#ifdef __WXOSX__
+    // bitmaps carry their backing scale factor only on OSX
+    return win->GetContentScaleFactor();
+#else
+    (void) win;
+    return 1.0;
+#endif
+}
+
+static wxBitmap LayerBitmap(const wxImage &img, double scale) {
+#ifdef __WXOSX__
+    return wxBitmap(img, -1, scale);
+#else
+    (void) scale;
+    return wxBitmap(img);
+#endif
+}
+
+bool wxPLPlotCtrl::RenderOpaqueLayers(wxGraphicsRenderer *renderer, wxBitmap &bitmap, const wxSize &size, int layers) {
+    wxMemoryDC memdc(bitmap);
+    wxGraphicsContext *gc = renderer->CreateContext(memdc);
+    if (!gc)
+        return false;
+
+    gc->SetFont(GetFont(), *wxBLACK); // initialze font and background
+    gc->SetPen(*wxWHITE_PEN);
+    gc->SetBrush(*wxWHITE_BRUSH);
+    gc->DrawRectangle(0, 0, size.x, size.y);
+    Render(*gc, wxRect(0, 0, size.x, size.y), -1, layers);
+    delete gc;
+    return true;
+}
+
+bool wxPLPlotCtrl::RenderLayers(wxGraphicsRenderer *renderer, const wxSize &size) {
+    // the buffers are kept at the backing resolution of the window, so
+    // the plot stays sharp on HiDPI displays
+    double scale = LayerScaleFactor(this);
+    if (!m_composite.IsOk() || m_layerSize != size || m_layerScale != scale) {
+        m_composite.CreateScaled(size.x, size.y, 24, scale);
+        for (int i = 0; i < NLAYERS; i++) {
+            m_layers[i] = wxNullBitmap;
+            m_layerImages[i] = wxNullImage;
+        }
+        m_layerSize = size;
+        m_layerScale = scale;
+        m_layersSplit = false;
+        m_dirtyLayers = LAYER_ALL;
+    }
+
+    if (m_dirtyLayers == 0)
+        return true;
+
+    if (m_dirtyLayers == LAYER_ALL) {
+        // everything changed, so draw the plot in one pass straight into the
+        // composite. the layer buffers are only filled on a partial refresh
+        m_layersSplit = false;
+        if (!RenderOpaqueLayers(renderer, m_composite, size, LAYER_ALL))
+            return false;
+
+        m_dirtyLayers = 0;
+        return true;
+    }
+
+    if (!m_layersSplit) {
+        // the last paint went to the composite only
+        m_dirtyLayers = LAYER_ALL;
+        m_layersSplit = true;
+    }
+
+    wxRect geom(0, 0, size.x, size.y);
+    int pixw = wxRound(size.x * scale);
+    int pixh = wxRound(size.y * scale);
+    for (int i = 0; i < NLAYERS; i++) {
+        int layer = 1 << i;
+        if (!(m_dirtyLayers & layer))
+            continue;
+
+        if (i == 0) {
+            // the bottom layer is opaque and carries the background
+            if (!m_layers[i].IsOk())
+                m_layers[i].CreateScaled(size.x, size.y, 24, scale);
+
+            if (!RenderOpaqueLayers(renderer, m_layers[i], size, layer)) {
+                m_layersSplit = false;
+                m_dirtyLayers = LAYER_ALL;
+                return false;
+            }
+        } else {
+            // upper layers are drawn into a transparent image that is
+            // cleared in place on each use
+            wxImage &img = m_layerImages[i];
+            if (!img.IsOk()) {
+                img.Create(pixw, pixh, false);
+                img.InitAlpha();
+            }
+            memset(img.GetData(), 0, (size_t) pixw * pixh * 3);
+            memset(img.GetAlpha(), 0, (size_t) pixw * pixh);
+
+            if (wxGraphicsContext *gc = renderer->CreateContextFromImage(img)) {
+                gc->Scale(scale, scale);
+                gc->SetFont(GetFont(), *wxBLACK);
+                Render(*gc, geom, -1, layer);
+                delete gc; // flushes the drawing into the image
+            }
+            m_layers[i] = LayerBitmap(img, scale);
+        }
+    }
+
+    m_dirtyLayers = 0;
+
+    wxMemoryDC memdc(m_composite);
+    for (int i = 0; i < NLAYERS; i++)
+        if (m_layers[i].IsOk())
+            memdc.DrawBitmap(m_layers[i], 0, 0, i > 0);
+
+    return true;
 }
 
 //#define SHOW_RENDERER_INFO 1
@@ -401,24 +543,31 @@ void wxPLPlotCtrl::OnPaint(wxPaintEvent &) {
     if (!renderer)
         renderer = wxGraphicsRenderer::GetDefaultRenderer();
 
-    if (wxGraphicsContext *gc = renderer->CreateContext(pdc)) {
+    int width, height;
+    GetClientSize(&width, &height);
+    if (width < 1 || height < 1)
+        return;
+
 #ifdef SHOW_RENDERER_INFO
-        wxStopWatch sw;
+    wxStopWatch sw;
 #endif
-        int width, height;
-        GetClientSize(&width, &height);
-
-        gc->SetFont(GetFont(), *wxBLACK); // initialze font and background
-        gc->SetPen(*wxWHITE_PEN);
-        gc->SetBrush(*wxWHITE_BRUSH);
-        gc->DrawRectangle(0, 0, width, height);
-
-        Render(*gc, wxRect(0, 0, width, height));
+    if (RenderLayers(renderer, wxSize(width, height))) {
+        pdc.DrawBitmap(m_composite, 0, 0);
+
+        // dragging the legend or a highlight only redraws the overlay
+        bool legend = m_moveLegendMode && m_moveLegendDragged;
+        bool highlight = m_highlightMode && m_highlightDragged;
+        if (legend || highlight) {
+            if (wxGraphicsContext *gc = renderer->CreateContext(pdc)) {
+                if (legend) DrawLegendOutline(*gc);
+                if (highlight) DrawHighlightRegion(*gc);
+                delete gc;
+            }
+        }
 
 #ifdef SHOW_RENDERER_INFO
-        gc->DrawText("Using " + renderer->GetName() + wxString::Format(" in %d ms.", sw.Time()), 2, 2);
+        pdc.DrawText("Using " + renderer->GetName() + wxString::Format(" in %d ms.", (int) sw.Time()), 2, 2);
 #endif
-        delete gc;
     } else {
         pdc.SetBackground(wxBrush(GetBackgroundColour(), wxBRUSHSTYLE_SOLID));
         pdc.Clear();
@@ -435,18 +584,9 @@ void wxPLPlotCtrl::OnSize(wxSizeEvent &) {
 
 #define LEGEND_DOCK_THRESHOLD 10
 
-void wxPLPlotCtrl::DrawLegendOutline() {
-    wxClientDC dc(this);
-#ifdef PL_USE_OVERLAY
-    wxDCOverlay overlaydc(m_overlay, &dc);
-    overlaydc.Clear();
-    dc.SetPen(wxColour(100, 100, 100));
-    dc.SetBrush(wxColour(150, 150, 150, 150));
-#else
-    dc.SetLogicalFunction(wxINVERT);
-    dc.SetPen(wxPen(*wxBLACK, 2));
-    dc.SetBrush(*wxTRANSPARENT_BRUSH);
-#endif
+void wxPLPlotCtrl::DrawLegendOutline(wxGraphicsContext &gc) {
+    gc.SetPen(wxPen(wxColour(100, 100, 100), 2));
+    gc.SetBrush(wxColour(150, 150, 150, 150));
 
     double scale = wxGetScreenHDScale();
 
@@ -457,33 +597,29 @@ void wxPLPlotCtrl::DrawLegendOutline() {
     L.width *= scale;
     L.height *= scale;
 
-    dc.DrawRectangle(wxRect(L.x + diff.x, L.y + diff.y, L.width, L.height));
+    gc.DrawRectangle(L.x + diff.x, L.y + diff.y, L.width, L.height);
 
     int dockpix = (int) (LEGEND_DOCK_THRESHOLD * scale);
 
     wxSize client = GetClientSize();
-    if (m_currentPoint.x > client.x - dockpix) {
-        dc.SetBrush(*wxBLACK_BRUSH);
-        dc.DrawRectangle(client.x - dockpix, 0, dockpix, client.y);
-    } else if (m_currentPoint.y > client.y - dockpix) {
-        dc.SetBrush(*wxBLACK_BRUSH);
-        dc.DrawRectangle(0, client.y - dockpix, client.x, dockpix);
-    }
+    gc.SetPen(*wxTRANSPARENT_PEN);
+    gc.SetBrush(wxColour(0, 0, 0, 150));
+    if (m_currentPoint.x > client.x - dockpix)
+        gc.DrawRectangle(client.x - dockpix, 0, dockpix, client.y);
+    else if (m_currentPoint.y > client.y - dockpix)
+        gc.DrawRectangle(0, client.y - dockpix, client.x, dockpix);
 }
 
-void wxPLPlotCtrl::UpdateHighlightRegion() {
-    wxClientDC dc(this);
+void wxPLPlotCtrl::DrawHighlightRegion(wxGraphicsContext &gc) {
+    gc.SetPen(wxColour(100, 100, 100));
+    gc.SetBrush(wxColour(150, 150, 150, 150));
+    for (size_t i = 0; i < m_highlightRects.size(); i++)
+        gc.DrawRectangle(m_highlightRects[i].x, m_highlightRects[i].y,
+                         m_highlightRects[i].width, m_highlightRects[i].height);
+}
 
-#ifdef PL_USE_OVERLAY
-    wxDCOverlay overlaydc(m_overlay, &dc);
-    overlaydc.Clear();
-    dc.SetPen(wxColour(100, 100, 100));
-    dc.SetBrush(wxColour(150, 150, 150, 150));
-#else
-    dc.SetLogicalFunction(wxINVERT);
-    dc.SetPen(*wxTRANSPARENT_PEN);
-    dc.SetBrush(*wxBLACK_BRUSH);
-#endif
+void wxPLPlotCtrl::UpdateHighlightRegion() {
+    m_highlightRects.clear();
 
     double scale = wxGetScreenHDScale();
 
@@ -517,7 +653,7 @@ void wxPLPlotCtrl::UpdateHighlightRegion() {
                     highlight_width -= highlight_x + highlight_width - it->x - it->width;
             }
 
-            dc.DrawRectangle(wxRect(highlight_x, it->y, highlight_width, it->height));
+            m_highlightRects.push_back(wxRect(highlight_x, it->y, highlight_width, it->height));
         }
     } else {
         // rectangular (RECT or ZOOM) highlight on current plot
@@ -527,8 +663,7 @@ void wxPLPlotCtrl::UpdateHighlightRegion() {
             if (it->Contains((double) highlight_x, (double) highlight_y)) {
                 irect = it - prects.begin();
 
-                wxRect hrct(highlight_x, highlight_y, highlight_width, highlight_height);
-                dc.DrawRectangle(hrct);
+                m_highlightRects.push_back(wxRect(highlight_x, highlight_y, highlight_width, highlight_height));
                 break;
             }
         }
@@ -563,7 +698,7 @@ void wxPLPlotCtrl::OnLeftDown(wxMouseEvent &evt) {
     if (IsLegendShown()
         && GetLegendRect().Contains(pos)) {
         m_moveLegendMode = true;
-        m_moveLegendErase = false;
+        m_moveLegendDragged = false;
         m_anchorPoint = mousepos;
         CaptureMouse();
     } else if (m_highlighting != HIGHLIGHT_DISABLE) {
@@ -577,7 +712,7 @@ void wxPLPlotCtrl::OnLeftDown(wxMouseEvent &evt) {
 
         if (it != prects.end()) {
             m_highlightMode = true;
-            m_highlightErase = false;
+            m_highlightDragged = false;
             m_anchorPoint = mousepos;
             CaptureMouse();
         }
@@ -593,16 +728,6 @@ void wxPLPlotCtrl::OnLeftUp(wxMouseEvent &evt) {
     if (m_moveLegendMode) {
         m_moveLegendMode = false;
 
-#ifdef PL_USE_OVERLAY
-        wxClientDC dc(this);
-        wxDCOverlay overlaydc(m_overlay, &dc);
-        overlaydc.Clear();
-        m_overlay.Reset();
-#else
-        if (m_moveLegendErase)
-            DrawLegendOutline();
-#endif
-
         wxSize client = GetClientSize();
         wxPoint point = evt.GetPosition();
         wxPoint diff = ClientToScreen(point) - ClientToScreen(m_anchorPoint);
@@ -643,26 +768,17 @@ void wxPLPlotCtrl::OnLeftUp(wxMouseEvent &evt) {
         if (lpos != lpos0) {
             InvalidateLegend(); // also invalidate legend text layouts to recalculate shape
             Invalidate(); // recalculate all plot positions if legend snap changed.
-        }
-
-        Refresh(); // redraw with the legend in the new spot
+            Refresh();
+        } else
+            RefreshLayers(LAYER_LEGEND); // redraw with the legend in the new spot
 
         // issue event regarding the move of the legend
         wxCommandEvent e(wxEVT_PLOT_LEGEND, GetId());
         e.SetEventObject(this);
         GetEventHandler()->ProcessEvent(e);
     } else if (m_highlighting != HIGHLIGHT_DISABLE && m_highlightMode) {
-#ifdef PL_USE_OVERLAY
-        wxClientDC dc(this);
-        wxDCOverlay overlaydc(m_overlay, &dc);
-        overlaydc.Clear();
-        m_overlay.Reset();
-#else
-        if (m_highlightErase)
-            UpdateHighlightRegion();
-#endif
-
         m_highlightMode = false;
+        wxWindow::Refresh(false); // remove the highlight overlay
 
         wxCoord diffx = abs(ClientToScreen(evt.GetPosition()).x - ClientToScreen(m_anchorPoint).x);
         wxCoord diffy = abs(ClientToScreen(evt.GetPosition()).y - ClientToScreen(m_anchorPoint).y);
@@ -705,7 +821,7 @@ void wxPLPlotCtrl::OnLeftUp(wxMouseEvent &evt) {
                 ay->SetWorld(max - (max - min) * 0.01 * bottom, max - (max - min) * 0.01 * top);
 
                 Invalidate();
-                Refresh();
+                RefreshLayers(LAYER_GRID | LAYER_DATA | LAYER_AXES);
 
                 wxCommandEvent e(wxEVT_PLOT_ZOOM, GetId());
                 e.SetEventObject(this);
@@ -721,25 +837,14 @@ void wxPLPlotCtrl::OnRightDown(wxMouseEvent &) {
 
 void wxPLPlotCtrl::OnMotion(wxMouseEvent &evt) {
     if (m_moveLegendMode) {
-#ifndef PL_USE_OVERLAY
-        if (m_moveLegendErase)
-            DrawLegendOutline();
-#endif
-
         m_currentPoint = evt.GetPosition();
-
-        DrawLegendOutline();
-        m_moveLegendErase = true;
+        m_moveLegendDragged = true;
+        wxWindow::Refresh(false); // the cached layers are unchanged, only the overlay moves
     } else if (m_highlightMode) {
-#ifndef PL_USE_OVERLAY
-        if (m_highlightErase)
-            UpdateHighlightRegion();
-#endif
-
         m_currentPoint = evt.GetPosition();
-
         UpdateHighlightRegion();
-        m_highlightErase = true;
+        m_highlightDragged = true;
+        wxWindow::Refresh(false);
     }
 
     //TODO:  see if we can get the below functionality to display point coordinates in a tool tip working correctly.
@@ -815,9 +920,10 @@ void wxPLPlotCtrl::OnMotion(wxMouseEvent &evt) {
 }
 
 void wxPLPlotCtrl::OnMouseCaptureLost(wxMouseCaptureLostEvent &) {
-    if (m_moveLegendMode) {
+    if (m_moveLegendMode || m_highlightMode) {
         m_moveLegendMode = false;
-        Refresh();
+        m_highlightMode = false;
+        wxWindow::Refresh(false);
     }
 }
 
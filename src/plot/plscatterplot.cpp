@@ -23,6 +23,7 @@
 **********************************************************************************************************************/
 
 #include <algorithm>
+#include <cmath>
 
 #include <wx/dc.h>
 
@@ -36,6 +37,7 @@ wxPLScatterPlot::wxPLScatterPlot() {
     m_scale = false;
     m_antiAliasing = false;
     m_drawLineOfPerfectAgreement = false;
+    InitDensity();
 }
 
 wxPLScatterPlot::wxPLScatterPlot(const std::vector<wxRealPoint> &data,
@@ -51,12 +53,37 @@ wxPLScatterPlot::wxPLScatterPlot(const std::vector<wxRealPoint> &data,
     m_scale = scale;
     m_antiAliasing = false;
     m_drawLineOfPerfectAgreement = false;
+    InitDensity();
 }
 
 wxPLScatterPlot::~wxPLScatterPlot() {
     // nothing to do currently
 }
 
+void wxPLScatterPlot::InitDensity() {
+    m_densityMode = DENSITY_OFF;
+    m_densityThreshold = 20000;
+    m_densityCell = CELL_SQUARE;
+    m_densityCellSize = 5;
+    m_densityOutliers = 2;
+    m_densityCmap = 0;
+}
+
+void wxPLScatterPlot::SetDensityMode(DensityMode mode, size_t threshold) {
+    m_densityMode = mode;
+    m_densityThreshold = threshold;
+}
+
+void wxPLScatterPlot::SetDensityCells(DensityCell shape, double pixels, size_t outliers) {
+    m_densityCell = shape;
+    m_densityCellSize = pixels;
+    m_densityOutliers = outliers;
+}
+
+void wxPLScatterPlot::SetDensityColourMap(wxPLColourMap *cmap) {
+    m_densityCmap = cmap;
+}
+
 void wxPLScatterPlot::SetColourMap(wxPLColourMap *cmap) {
     m_cmap = cmap;
 }
@@ -85,38 +112,203 @@ size_t wxPLScatterPlot::Len() const {
     return m_data.size();
 }
 
-void wxPLScatterPlot::Draw(wxPLOutputDevice &dc, const wxPLDeviceMapping &map) {
-    dc.Pen(m_colour, 1);
-    dc.Brush(m_colour);
+const wxUint32 *wxPLScatterPlot::MapColours(std::vector<wxUint32> &rgba) {
+    size_t len = Len();
+    if (!m_cmap || len == 0 || m_colours.size() != len)
+        return 0;
+
+    rgba.resize(len);
+    m_cmap->ColoursForValues(&m_colours[0], len, &rgba[0]);
+    return &rgba[0];
+}
+
+void wxPLScatterPlot::DrawMarker(wxPLOutputDevice &dc, const wxPLDeviceMapping &map, size_t i,
+                                 const wxUint32 *zrgba, wxUint32 &current, bool has_sizes) {
+    double rad = m_radius;
+
+    if (has_sizes) {
+        rad = m_sizes[i];
+        if (rad < 1) rad = 1;
+    }
+
+    if (zrgba && zrgba[i] != current) {
+        current = zrgba[i];
+        wxColour C(wxPLColourMap::UnpackColour(current));
+        dc.Pen(C, 1);
+        dc.Brush(C);
+    }
+
+    dc.Circle(map.ToDevice(At(i)), rad);
+}
+
+#define DENSITY_LEVELS 64
+
+bool wxPLScatterPlot::DrawDensity(wxPLOutputDevice &dc, const wxPLDeviceMapping &map) {
+    size_t len = Len();
+    if (m_densityMode == DENSITY_AUTO && len <= m_densityThreshold)
+        return false;
+
+    double cell = m_densityCellSize * dc.PixelSize();
+    if (cell <= 0)
+        return false;
 
     wxRealPoint min = map.GetWorldMinimum();
     wxRealPoint max = map.GetWorldMaximum();
+    wxRealPoint pos, size;
+    map.GetDeviceExtents(&pos, &size);
 
-    size_t len = Len();
-    wxPLColourMap *zcmap = 0;
-    if (m_cmap && m_colours.size() == len)
-        zcmap = m_cmap;
+    // hexagonal cells are the union of two rectangular lattices of cell centers,
+    // the second offset by half a cell in each direction.  a point goes to the
+    // nearest center, which makes the cells regular pointy-top hexagons.
+    bool hex = (m_densityCell == CELL_HEX);
+    double sx = cell;
+    double sy = hex ? cell * sqrt(3.0) : cell;
+    int ncols = (int) (size.x / sx) + 2;
+    int nrows = (int) (size.y / sy) + 2;
+    size_t ngrid = (size_t) ncols * nrows;
 
-    bool has_sizes = (m_sizes.size() == len);
+    std::vector<unsigned int> counts(hex ? 2 * ngrid : ngrid, 0);
+    std::vector<int> cells(len, -1);
+    size_t nvisible = 0;
 
     for (size_t i = 0; i < len; i++) {
         const wxRealPoint p = At(i);
-        if (p.x >= min.x && p.x <= max.x
-            && p.y >= min.y && p.y <= max.y) {
-            double rad = m_radius;
-
-            if (has_sizes) {
-                rad = m_sizes[i];
-                if (rad < 1) rad = 1;
-            }
-
-            if (zcmap) {
-                wxColour C(zcmap->ColourForValue(m_colours[i]));
-                dc.Pen(C, 1);
-                dc.Brush(C);
-            }
-
-            dc.Circle(map.ToDevice(p), rad);
+        if (!(p.x >= min.x && p.x <= max.x
+              && p.y >= min.y && p.y <= max.y))
+            continue;
+
+        wxRealPoint d(map.ToDevice(p));
+        double fx = (d.x - pos.x) / sx;
+        double fy = (d.y - pos.y) / sy;
+
+        size_t c;
+        if (hex) {
+            int ix1 = (int) floor(fx + 0.5), iy1 = (int) floor(fy + 0.5);
+            int ix2 = (int) floor(fx), iy2 = (int) floor(fy);
+            double d1 = (fx - ix1) * (fx - ix1) + 3 * (fy - iy1) * (fy - iy1);
+            double d2 = (fx - ix2 - 0.5) * (fx - ix2 - 0.5) + 3 * (fy - iy2 - 0.5) * (fy - iy2 - 0.5);
+            if (d1 <= d2)
+                c = (size_t) std::max(0, std::min(iy1, nrows - 1)) * ncols + std::max(0, std::min(ix1, ncols - 1));
+            else
+                c = ngrid + (size_t) std::max(0, std::min(iy2, nrows - 1)) * ncols
+                    + std::max(0, std::min(ix2, ncols - 1));
+        } else {
+            int ix = std::max(0, std::min((int) floor(fx), ncols - 1));
+            int iy = std::max(0, std::min((int) floor(fy), nrows - 1));
+            c = (size_t) iy * ncols + ix;
+        }
+
+        cells[i] = (int) c;
+        counts[c]++;
+        nvisible++;
+    }
+
+    if (m_densityMode == DENSITY_AUTO && nvisible <= m_densityThreshold)
+        return false;
+
+    unsigned int maxcount = 0;
+    for (size_t c = 0; c < counts.size(); c++)
+        if (counts[c] > maxcount)
+            maxcount = counts[c];
+
+    // group the cells by colour so the brush changes once per level
+    std::vector<std::vector<size_t> > levels(DENSITY_LEVELS);
+    double lmax = maxcount > 1 ? log((double) maxcount) : 1.0;
+    for (size_t c = 0; c < counts.size(); c++) {
+        if (counts[c] == 0 || counts[c] <= m_densityOutliers)
+            continue;
+
+        int l = (int) (log((double) counts[c]) / lmax * (DENSITY_LEVELS - 1) + 0.5);
+        levels[std::max(0, std::min(l, DENSITY_LEVELS - 1))].push_back(c);
+    }
+
+    // the colour map scale is in log10 of the count, so that the same count
+    // gets the same colour however dense the densest cell is and the map can
+    // be shown as the legend
+    wxUint32 lrgba[DENSITY_LEVELS];
+    if (m_densityCmap) {
+        double lvals[DENSITY_LEVELS];
+        for (int l = 0; l < DENSITY_LEVELS; l++)
+            lvals[l] = lmax * l / (DENSITY_LEVELS - 1) / log(10.0);
+        m_densityCmap->ColoursForValues(lvals, DENSITY_LEVELS, lrgba);
+    }
+
+    dc.NoPen();
+    for (int l = 0; l < DENSITY_LEVELS; l++) {
+        if (levels[l].empty())
+            continue;
+
+        double t = (double) l / (DENSITY_LEVELS - 1);
+        wxColour C;
+        if (m_densityCmap)
+            C = wxPLColourMap::UnpackColour(lrgba[l]);
+        else {
+            // the plot colour, faint for the sparsest cells.  shading by alpha
+            // rather than tinting lets the cells of several series blend where
+            // they overlap instead of the last one hiding the others
+            double f = 0.2 + 0.8 * t;
+            C = wxColour(m_colour.Red(), m_colour.Green(), m_colour.Blue(),
+                         (unsigned char) (255 * f));
+        }
+        dc.Brush(C);
+
+        for (size_t k = 0; k < levels[l].size(); k++) {
+            size_t c = levels[l][k];
+            if (hex) {
+                bool offset = (c >= ngrid);
+                if (offset) c -= ngrid;
+                double cx = pos.x + ((c % ncols) + (offset ? 0.5 : 0.0)) * sx;
+                double cy = pos.y + ((c / ncols) + (offset ? 0.5 : 0.0)) * sy;
+                double r = sy / 3;
+                wxRealPoint pts[6] = {
+                        wxRealPoint(cx, cy - r),
+                        wxRealPoint(cx + sx / 2, cy - r / 2),
+                        wxRealPoint(cx + sx / 2, cy + r / 2),
+                        wxRealPoint(cx, cy + r),
+                        wxRealPoint(cx - sx / 2, cy + r / 2),
+                        wxRealPoint(cx - sx / 2, cy - r / 2)
+                };
+                dc.Polygon(6, pts);
+            } else
+                dc.Rect(pos.x + (c % ncols) * sx, pos.y + (c / ncols) * sy, sx, sy);
+        }
+    }
+
+    // points in sparse cells are drawn individually
+    dc.Pen(m_colour, 1);
+    dc.Brush(m_colour);
+
+    std::vector<wxUint32> rgba;
+    const wxUint32 *zrgba = MapColours(rgba);
+    wxUint32 current = wxPLColourMap::PackColour(m_colour);
+    bool has_sizes = (m_sizes.size() == len);
+
+    for (size_t i = 0; i < len; i++)
+        if (cells[i] >= 0 && counts[cells[i]] <= m_densityOutliers)
+            DrawMarker(dc, map, i, zrgba, current, has_sizes);
+
+    return true;
+}
+
+void wxPLScatterPlot::Draw(wxPLOutputDevice &dc, const wxPLDeviceMapping &map) {
+    wxRealPoint min = map.GetWorldMinimum();
+    wxRealPoint max = map.GetWorldMaximum();
+
+    if (m_densityMode == DENSITY_OFF || !DrawDensity(dc, map)) {
+        dc.Pen(m_colour, 1);
+        dc.Brush(m_colour);
+
+        size_t len = Len();
+        std::vector<wxUint32> rgba;
+        const wxUint32 *zrgba = MapColours(rgba);
+        wxUint32 current = wxPLColourMap::PackColour(m_colour);
+        bool has_sizes = (m_sizes.size() == len);
+
+        for (size_t i = 0; i < len; i++) {
+            const wxRealPoint p = At(i);
+            if (p.x >= min.x && p.x <= max.x
+                && p.y >= min.y && p.y <= max.y)
+                DrawMarker(dc, map, i, zrgba, current, has_sizes);
         }
     }
 
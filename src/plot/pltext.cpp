@@ -549,6 +549,11 @@ static bool inflate_builtin_fonts() {
     return gs_inflatedFontData.size() == nfonts;
 }
 
+#include <wx/hashmap.h>
+
+#include <list>
+#include <unordered_map>
+
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
@@ -568,10 +573,27 @@ struct ft_face_info {
     wxString file;
     font_data *builtin;
     wxMemoryBuffer data;
+    FT_F26Dot6 size; // last size set on the face
+    unsigned int dpi;
+
+    ft_face_info() : face(0), builtin(0), size(0), dpi(0) {}
 };
 
 static std::vector<ft_face_info> ft_faces;
 
+// FT_Set_Char_Size can rerun the hinting setup of the font, so skip it
+// when the face is already at the requested size
+static FT_Error ft_set_size(int ifnt, FT_F26Dot6 size, unsigned int dpi) {
+    ft_face_info &fi = ft_faces[ifnt];
+    if (fi.size == size && fi.dpi == dpi)
+        return 0;
+
+    FT_Error err = FT_Set_Char_Size(fi.face, size, 0, dpi, dpi);
+    fi.size = err ? 0 : size;
+    fi.dpi = dpi;
+    return err;
+}
+
 static bool check_freetype_init() {
     if (ft_library == 0) {
         FT_Error err = FT_Init_FreeType(&ft_library);
@@ -727,17 +749,20 @@ unsigned char blend(int alpha, int color1, int color2) {
 // double tmp = pow(input1, GAMMA) * alpha + pow(input2, GAMMA) * (1.0 - alpha);
 // double output = pow(tmp, 1.0/GAMMA);
 
+#ifdef SUBPIXEL_RENDERING
+#define FT_GLYPH_BPP 3
+#else
+#define FT_GLYPH_BPP 1
+#endif
+
+// src holds the w x h pixel coverage of a glyph, FT_GLYPH_BPP bytes per pixel
 static void wxFreeTypeGlyph(unsigned char *rgb, unsigned char *alpha,
                             size_t width, size_t height,
                             unsigned char R, unsigned char G, unsigned char B,
-                            FT_Bitmap *bitmap, int x, int y) {
+                            const unsigned char *src, int pitch, int w, int h, int x, int y) {
     FT_Int i, j, p, q;
-    FT_Int x_max = x + bitmap->width
-                       #ifdef SUBPIXEL_RENDERING
-                       / 3
-#endif
-    ;
-    FT_Int y_max = y + bitmap->rows;
+    FT_Int x_max = x + w;
+    FT_Int y_max = y + h;
 
     for (i = x, p = 0; i < x_max; i++, p++) {
         for (j = y, q = 0; j < y_max; j++, q++) {
@@ -758,10 +783,10 @@ static void wxFreeTypeGlyph(unsigned char *rgb, unsigned char *alpha,
             alpha[ index ] =  A;// alpha_correct( A, A );
             */
 #ifdef SUBPIXEL_RENDERING
-            int pixpos = (q * bitmap->pitch + 3 * p);
-            unsigned char f_r = bitmap->buffer[pixpos];
-            unsigned char f_g = bitmap->buffer[pixpos + 1];
-            unsigned char f_b = bitmap->buffer[pixpos + 2];
+            int pixpos = (q * pitch + 3 * p);
+            unsigned char f_r = src[pixpos];
+            unsigned char f_g = src[pixpos + 1];
+            unsigned char f_b = src[pixpos + 2];
 
             // use green as alpha for overall intensity: http://alienryderflex.com/sub_pixel/
 
@@ -790,7 +815,7 @@ static void wxFreeTypeGlyph(unsigned char *rgb, unsigned char *alpha,
 #endif
 
 #else
-            unsigned char A = bitmap->buffer[q * bitmap->pitch + p];
+            unsigned char A = src[q * pitch + p];
             if (A > 0)
             {
                 rgb[3 * index] = R;
@@ -814,6 +839,199 @@ static wxRealPoint rotate2d(
             sin(rad) * P.x + cos(rad) * P.y);
 }
 
+// Rendered glyphs are kept process wide, packed into atlas pages and keyed
+// by everything that changes their pixels: face, size, resolution,
+// rotation, character and the sub pixel offset of the pen, so cached text
+// is identical to text rendered directly.  Axis labels, legends and tables
+// draw the same few strings over and over at whole pixel positions, so
+// almost every glyph after the first paint is a cache hit.
+
+struct ft_glyph_key {
+    int face;
+    FT_F26Dot6 size;
+    unsigned int dpi;
+    int angle; // hundredths of a degree
+    wxUniChar::value_type ch;
+    int phase; // x and y pen offset in 1/64 pixel, 6 bits each
+
+    bool operator==(const ft_glyph_key &rhs) const {
+        return ch == rhs.ch && face == rhs.face && size == rhs.size
+               && dpi == rhs.dpi && angle == rhs.angle && phase == rhs.phase;
+    }
+};
+
+struct ft_glyph_key_hash {
+    size_t operator()(const ft_glyph_key &k) const {
+        size_t h = (size_t) k.ch;
+        h = h * 31 + (size_t) k.face;
+        h = h * 31 + (size_t) k.size;
+        h = h * 31 + (size_t) k.dpi;
+        h = h * 31 + (size_t) k.angle;
+        return h * 31 + (size_t) k.phase;
+    }
+};
+
+struct ft_glyph {
+    FT_UInt index;
+    FT_Vector advance;
+    int left, top; // bitmap offset from the whole pixel pen position
+    int page; // -1 for glyphs without pixels
+    int x, y, width, height; // location in the atlas page
+};
+
+struct ft_atlas_page {
+    int width, height;
+    int shelf_x, shelf_y, shelf_height;
+    std::vector<unsigned char> pixels;
+};
+
+static const int FT_ATLAS_PAGE_SIZE = 512;
+static const size_t FT_ATLAS_MAX_PAGES = 16;
+static const size_t FT_MEASURE_CACHE_SIZE = 1024;
+
+static const size_t FT_MAX_ADVANCES = 65536;
+
+static bool ft_cache_enabled = true;
+static std::unordered_map<ft_glyph_key, ft_glyph, ft_glyph_key_hash> ft_glyphs;
+static std::vector<ft_atlas_page> ft_atlas;
+
+// measuring loads glyphs without the LCD target of drawing, which can hint
+// them to other advances, so measured glyphs are kept apart
+typedef std::unordered_map<ft_glyph_key, std::pair<FT_UInt, FT_Vector>, ft_glyph_key_hash> ft_advance_map;
+static ft_advance_map ft_advances;
+
+struct ft_measure_key {
+    int face;
+    FT_F26Dot6 size;
+    unsigned int dpi;
+    wxString text;
+
+    bool operator==(const ft_measure_key &rhs) const {
+        return face == rhs.face && size == rhs.size && dpi == rhs.dpi && text == rhs.text;
+    }
+};
+
+struct ft_measure_key_hash {
+    size_t operator()(const ft_measure_key &k) const {
+        return ((wxStringHash()(k.text) * 31 + (size_t) k.face) * 31 + (size_t) k.size) * 31 + (size_t) k.dpi;
+    }
+};
+
+// least recently used strings at the back
+typedef std::list<std::pair<ft_measure_key, wxSize> > ft_measure_list;
+static ft_measure_list ft_measured;
+static std::unordered_map<ft_measure_key, ft_measure_list::iterator, ft_measure_key_hash> ft_measured_index;
+
+void wxFreeTypeClearCache() {
+    ft_glyphs.clear();
+    ft_atlas.clear();
+    ft_advances.clear();
+    ft_measured.clear();
+    ft_measured_index.clear();
+}
+
+void wxFreeTypeEnableCache(bool enable) {
+    if (!enable)
+        wxFreeTypeClearCache();
+    ft_cache_enabled = enable;
+}
+
+size_t wxFreeTypeCacheMemory() {
+    size_t bytes = 0;
+    for (size_t i = 0; i < ft_atlas.size(); i++)
+        bytes += ft_atlas[i].pixels.size();
+    return bytes;
+}
+
+// finds room for a w x h bitmap on the shelves of the last page, starting a
+// new shelf or page as needed
+static int ft_atlas_alloc(int w, int h, int *x, int *y) {
+    if (ft_atlas.size() > 0) {
+        ft_atlas_page &pg = ft_atlas.back();
+        if (pg.shelf_x + w > pg.width) {
+            pg.shelf_y += pg.shelf_height;
+            pg.shelf_x = pg.shelf_height = 0;
+        }
+
+        if (pg.shelf_x + w <= pg.width && pg.shelf_y + h <= pg.height) {
+            *x = pg.shelf_x;
+            *y = pg.shelf_y;
+            pg.shelf_x += w;
+            pg.shelf_height = std::max(pg.shelf_height, h);
+            return (int) ft_atlas.size() - 1;
+        }
+    }
+
+    if (ft_atlas.size() >= FT_ATLAS_MAX_PAGES)
+        return -1;
+
+    // glyphs larger than a page get a page of their own
+    ft_atlas_page pg;
+    pg.width = std::max(w, FT_ATLAS_PAGE_SIZE);
+    pg.height = std::max(h, FT_ATLAS_PAGE_SIZE);
+    pg.shelf_x = w;
+    pg.shelf_y = 0;
+    pg.shelf_height = h;
+    pg.pixels.resize((size_t) pg.width * pg.height * FT_GLYPH_BPP, 0);
+    ft_atlas.push_back(pg);
+
+    *x = *y = 0;
+    return (int) ft_atlas.size() - 1;
+}
+
+// renders a glyph with the transform already set on the face
+static bool ft_render_glyph(FT_Face face, FT_UInt index, unsigned int mode, ft_glyph *g) {
+    if (FT_Load_Glyph(face, index, mode))
+        return false;
+
+    g->index = index;
+    g->advance = face->glyph->advance;
+
+    if (FT_Render_Glyph(face->glyph,
+#ifdef SUBPIXEL_RENDERING
+                        FT_RENDER_MODE_LCD
+#else
+                        FT_RENDER_MODE_NORMAL
+#endif
+    ))
+        return false;
+
+    FT_Bitmap &bmp = face->glyph->bitmap;
+    g->left = face->glyph->bitmap_left;
+    g->top = face->glyph->bitmap_top;
+    g->width = (int) bmp.width / FT_GLYPH_BPP;
+    g->height = (int) bmp.rows;
+    g->page = -1;
+    g->x = g->y = 0;
+    return true;
+}
+
+// false if the glyph has pixels that could not be stored
+static bool ft_store_glyph(FT_Face face, ft_glyph *g) {
+    if (g->width <= 0 || g->height <= 0)
+        return true;
+
+    if (ft_atlas.size() >= FT_ATLAS_MAX_PAGES
+        && ft_atlas.back().shelf_y + ft_atlas.back().shelf_height + g->height > ft_atlas.back().height) {
+        // full: start over rather than track the use of every glyph
+        ft_glyphs.clear();
+        ft_atlas.clear();
+    }
+
+    g->page = ft_atlas_alloc(g->width, g->height, &g->x, &g->y);
+    if (g->page < 0)
+        return false;
+
+    ft_atlas_page &pg = ft_atlas[g->page];
+    FT_Bitmap &bmp = face->glyph->bitmap;
+    size_t row = (size_t) g->width * FT_GLYPH_BPP;
+    for (int r = 0; r < g->height; r++)
+        memcpy(&pg.pixels[((size_t) (g->y + r) * pg.width + g->x) * FT_GLYPH_BPP],
+               bmp.buffer + r * bmp.pitch, row);
+
+    return true;
+}
+
 void wxFreeTypeDraw(wxDC &dc, const wxPoint &pos, int ifnt, double points, unsigned int dpi,
                     const wxString &text, const wxColour &c, double angle) {
     wxRealPoint offset(0, 0);
@@ -907,7 +1125,12 @@ void wxFreeTypeDraw(wxImage *img, bool init_img, const wxPoint &pos,
         img->InitAlpha();
 
     FT_Face face = ft_faces[ifnt].face;
-    FT_Error err = FT_Set_Char_Size(face, (int) (points * 64.0), 0, dpi, dpi);
+    FT_F26Dot6 char_size = (FT_F26Dot6) (points * 64.0);
+    ft_glyph_key key;
+    key.face = ifnt;
+    key.size = char_size;
+    key.dpi = dpi;
+    key.angle = (int) floor(angle * 100.0 + 0.5);
 
     unsigned char R = c.Red();
     unsigned char G = c.Green();
@@ -947,10 +1170,54 @@ void wxFreeTypeDraw(wxImage *img, bool init_img, const wxPoint &pos,
     pen.x = (int) (origin.x * 64);
     pen.y = (int) ((size.y - origin.y) * 64.0);
 
+    unsigned int mode = FT_LOAD_DEFAULT;
+
+    if (angle != 0.0) // see: http://chanae.walon.org/pub/ttf/ttf_glyphs.htm
+        mode |= FT_LOAD_NO_HINTING;
+
+#ifdef SUBPIXEL_RENDERING
+    mode |= FT_LOAD_TARGET_LCD;
+#endif
+
+    // kerning is scaled to the size set on the face
+    if (use_kerning && ft_set_size(ifnt, char_size, dpi))
+        return;
+
     for (wxString::const_iterator it = text.begin(); it != text.end(); ++it) {
-        FT_Set_Transform(face, &matrix, &pen);
+        key.ch = (*it).GetValue();
+
+        // glyphs are rendered at the sub pixel offset of the pen and placed
+        // at its whole pixel position
+        FT_Pos px = pen.x, py = pen.y;
+        key.phase = (int) ((px & 63) | ((py & 63) << 6));
+
+        ft_glyph tmp;
+        ft_glyph *g = 0;
+        if (ft_cache_enabled) {
+            std::unordered_map<ft_glyph_key, ft_glyph, ft_glyph_key_hash>::iterator found = ft_glyphs.find(key);
+            if (found != ft_glyphs.end())
+                g = &found->second;
+        }
+
+        bool rendered = false;
+        if (!g) {
+            if (ft_set_size(ifnt, char_size, dpi))
+                return;
+
+            FT_Vector phase;
+            phase.x = px & 63;
+            phase.y = py & 63;
+            FT_Set_Transform(face, &matrix, &phase);
+            if (!ft_render_glyph(face, FT_Get_Char_Index(face, *it), mode, &tmp))
+                continue;
+
+            rendered = true;
+            g = &tmp;
+            if (ft_cache_enabled && ft_store_glyph(face, &tmp))
+                ft_glyphs[key] = tmp;
+        }
 
-        glyph_index = FT_Get_Char_Index(face, *it);
+        glyph_index = g->index;
 
         /* retrieve kerning distance and move pen position */
         if (use_kerning && previous && glyph_index) {
@@ -961,35 +1228,22 @@ void wxFreeTypeDraw(wxImage *img, bool init_img, const wxPoint &pos,
             pen.y += delta.y >> 6;
         }
 
-        unsigned int mode = FT_LOAD_DEFAULT;
-
-        if (angle != 0.0) // see: http://chanae.walon.org/pub/ttf/ttf_glyphs.htm
-            mode |= FT_LOAD_NO_HINTING;
-
-#ifdef SUBPIXEL_RENDERING
-        mode |= FT_LOAD_TARGET_LCD;
-#endif
-        err = FT_Load_Glyph(face, glyph_index, mode);
-        if (err) continue;
-
-        err = FT_Render_Glyph(face->glyph,
-#ifdef SUBPIXEL_RENDERING
-                              FT_RENDER_MODE_LCD
-#else
-                FT_RENDER_MODE_NORMAL
-#endif
-        );
-
-        if (err) continue;
-
-        wxFreeTypeGlyph(rgb, alpha, size.x, size.y, R, G, B,
-                        &face->glyph->bitmap,
-                        face->glyph->bitmap_left,
-                        size.y - face->glyph->bitmap_top);
+        int x = (int) ((px >> 6) + g->left);
+        int y = (int) (size.y - ((py >> 6) + g->top));
+        if (g->page >= 0) {
+            ft_atlas_page &pg = ft_atlas[g->page];
+            wxFreeTypeGlyph(rgb, alpha, size.x, size.y, R, G, B,
+                            &pg.pixels[((size_t) g->y * pg.width + g->x) * FT_GLYPH_BPP],
+                            pg.width * FT_GLYPH_BPP, g->width, g->height, x, y);
+        } else if (rendered && g->width > 0 && g->height > 0) {
+            FT_Bitmap &bmp = face->glyph->bitmap;
+            wxFreeTypeGlyph(rgb, alpha, size.x, size.y, R, G, B,
+                            bmp.buffer, bmp.pitch, g->width, g->height, x, y);
+        }
 
         // increment pen pos
-        pen.x += face->glyph->advance.x;
-        pen.y += face->glyph->advance.y;
+        pen.x += g->advance.x;
+        pen.y += g->advance.y;
 
         previous = glyph_index;
     }
@@ -1003,22 +1257,66 @@ wxSize wxFreeTypeMeasure(int fnt, double points, unsigned int dpi, const wxStrin
         fnt = 0;
 
     FT_Face face = ft_faces[fnt].face;
+    FT_F26Dot6 char_size = (FT_F26Dot6) (points * 64.0);
+
+    ft_measure_key mkey;
+    if (ft_cache_enabled) {
+        mkey.face = fnt;
+        mkey.size = char_size;
+        mkey.dpi = dpi;
+        mkey.text = text;
+        std::unordered_map<ft_measure_key, ft_measure_list::iterator, ft_measure_key_hash>::iterator found
+                = ft_measured_index.find(mkey);
+        if (found != ft_measured_index.end()) {
+            ft_measured.splice(ft_measured.begin(), ft_measured, found->second);
+            return found->second->second;
+        }
+    }
 
-    FT_Error err = FT_Set_Char_Size(face, (int) (points * 64.0), 0, dpi, dpi);
+    FT_Error err = ft_set_size(fnt, char_size, dpi);
     if (err)
         return wxSize(0, 0);
 
-    FT_Set_Transform(face, 0, 0);
+    if (ft_advances.size() > FT_MAX_ADVANCES)
+        ft_advances.clear();
+
+    ft_glyph_key key;
+    key.face = fnt;
+    key.size = char_size;
+    key.dpi = dpi;
+    key.angle = key.phase = 0;
 
     FT_UInt previous, glyph_index;
     int pen_x = 0;
     int pen_y = 0;
 //	int px_ascent = ((double)face->ascender) / ((double)face->units_per_EM) * points * dpi / 72.0;
     bool use_kerning = (FT_HAS_KERNING(face) > 0);
+    bool transform_set = false;
     previous = 0;
     for (wxString::const_iterator it = text.begin(); it != text.end(); ++it) {
-        FT_ULong uchar = (*it);
-        glyph_index = FT_Get_Char_Index(face, uchar);
+        key.ch = (*it).GetValue();
+
+        FT_Vector advance;
+        ft_advance_map::iterator found = ft_advances.find(key);
+        if (found != ft_advances.end()) {
+            glyph_index = found->second.first;
+            advance = found->second.second;
+        } else {
+            if (!transform_set) {
+                FT_Set_Transform(face, 0, 0);
+                transform_set = true;
+            }
+
+            FT_ULong uchar = (*it);
+            glyph_index = FT_Get_Char_Index(face, uchar);
+
+            err = FT_Load_Glyph(face, glyph_index, FT_LOAD_DEFAULT);
+            if (err) continue;
+
+            advance = face->glyph->advance;
+            if (ft_cache_enabled)
+                ft_advances[key] = std::make_pair(glyph_index, advance);
+        }
 
         /* retrieve kerning distance and move pen position */
         if (use_kerning && previous && glyph_index) {
@@ -1027,19 +1325,27 @@ wxSize wxFreeTypeMeasure(int fnt, double points, unsigned int dpi, const wxStrin
             pen_x += delta.x >> 6;
         }
 
-        err = FT_Load_Glyph(face, glyph_index, FT_LOAD_DEFAULT);
-        if (err) continue;
-
         // increment pen pos
-        pen_x += face->glyph->advance.x >> 6;
-        pen_y += face->glyph->advance.y >> 6; // not useful for now (?)
+        pen_x += advance.x >> 6;
+        pen_y += advance.y >> 6; // not useful for now (?)
 
         // save current glyph for next kerning
         previous = glyph_index;
     }
 
-    return wxSize(abs(pen_x),
-                  ((double) (face->ascender - face->descender)) / ((double) face->units_per_EM) * points * dpi / 72.0);
+    wxSize size(abs(pen_x),
+                ((double) (face->ascender - face->descender)) / ((double) face->units_per_EM) * points * dpi / 72.0);
+
+    if (ft_cache_enabled) {
+        ft_measured.push_front(std::make_pair(mkey, size));
+        ft_measured_index[mkey] = ft_measured.begin();
+        if (ft_measured.size() > FT_MEASURE_CACHE_SIZE) {
+            ft_measured_index.erase(ft_measured.back().first);
+            ft_measured.pop_back();
+        }
+    }
+
+    return size;
 }
 
 #include <wx/dcbuffer.h>
@@ -23,6 +23,7 @@
 **********************************************************************************************************************/
 
 #include <algorithm>
+#include <cstring>
 
 #include <wx/textctrl.h>
 #include <wx/datstrm.h>
@@ -51,6 +52,176 @@
 static wxColour g_uiSelectColor(135, 135, 135);
 static wxChar g_text_delimeter('\n');
 
+// Version 2 forms are encoded into and decoded from a single memory buffer.
+// Integers are little endian like wxDataOutputStream, doubles are IEEE
+// 754 doubles, and strings are a byte count followed by UTF-8 text.
+// Property and object type names are repeated in every form object, so
+// they are written once in a table ahead of the objects and referred to
+// by index.
+class wxUIFormWriter {
+    std::vector<unsigned char> m_data;
+    std::vector<wxString> m_names;
+    std::unordered_map<wxString, wxUint32, wxStringHash, wxStringEqual> m_nameIndex;
+
+    void Append(const void *data, size_t len) {
+        if (len > 0) m_data.insert(m_data.end(), (const unsigned char *) data, (const unsigned char *) data + len);
+    }
+
+public:
+    wxUIFormWriter() {
+        m_data.reserve(16384);
+    }
+
+    size_t Tell() { return m_data.size(); }
+
+    void Write8(wxUint8 v) { m_data.push_back(v); }
+
+    void Write32(wxUint32 v) {
+        unsigned char b[4] = {(unsigned char) v, (unsigned char) (v >> 8),
+                              (unsigned char) (v >> 16), (unsigned char) (v >> 24)};
+        Append(b, 4);
+    }
+
+    // overwrite a 32 bit value reserved earlier at 'pos'
+    void Patch32(size_t pos, wxUint32 v) {
+        for (size_t i = 0; i < 4; i++)
+            m_data[pos + i] = (unsigned char) (v >> (8 * i));
+    }
+
+    void WriteDouble(double d) {
+        wxUint64 u;
+        memcpy(&u, &d, sizeof(u));
+        Write32((wxUint32) (u & 0xffffffff));
+        Write32((wxUint32) (u >> 32));
+    }
+
+    void WriteData(const void *data, size_t len) {
+        Write32((wxUint32) len);
+        Append(data, len);
+    }
+
+    void WriteString(const wxString &s) {
+        const wxScopedCharBuffer utf8(s.utf8_str());
+        WriteData(utf8.data(), utf8.length());
+    }
+
+    void WriteName(const wxString &name) {
+        std::unordered_map<wxString, wxUint32, wxStringHash, wxStringEqual>::iterator it = m_nameIndex.find(name);
+        if (it != m_nameIndex.end()) {
+            Write32(it->second);
+        } else {
+            wxUint32 idx = (wxUint32) m_names.size();
+            m_names.push_back(name);
+            m_nameIndex[name] = idx;
+            Write32(idx);
+        }
+    }
+
+    // writes the payload size, the name table and the data written so far
+    void Flush(wxOutputStream &out) {
+        std::vector<unsigned char> body;
+        body.swap(m_data);
+        for (size_t i = 0; i < m_names.size(); i++)
+            WriteString(m_names[i]);
+
+        std::vector<unsigned char> table;
+        table.swap(m_data);
+        Write32((wxUint32) (4 + table.size() + body.size()));
+        Write32((wxUint32) m_names.size());
+        Append(table.empty() ? 0 : &table[0], table.size());
+        Append(body.empty() ? 0 : &body[0], body.size());
+        out.Write(&m_data[0], m_data.size());
+        m_data.clear();
+    }
+};
+
+// Reads from a version 2 payload.  Reading past the end of the data yields
+// zeros and empty strings and leaves the reader not Ok()
+class wxUIFormReader {
+    const unsigned char *m_start, *m_pos, *m_end;
+    bool m_ok;
+    std::vector<wxString> m_names;
+    wxString m_noName;
+
+    bool Has(size_t n) {
+        if (m_ok && (size_t) (m_end - m_pos) >= n) return true;
+        m_ok = false;
+        m_pos = m_end;
+        return false;
+    }
+
+public:
+    wxUIFormReader(const void *data, size_t len)
+            : m_start((const unsigned char *) data), m_pos(m_start), m_end(m_start + len), m_ok(true) {
+    }
+
+    bool Ok() { return m_ok; }
+
+    size_t Tell() { return m_pos - m_start; }
+
+    void Seek(size_t pos) {
+        if (pos <= (size_t) (m_end - m_start)) m_pos = m_start + pos;
+        else Has(pos - (m_pos - m_start));
+    }
+
+    wxUint8 Read8() {
+        if (!Has(1)) return 0;
+        return *m_pos++;
+    }
+
+    wxUint32 Read32() {
+        if (!Has(4)) return 0;
+        wxUint32 v = (wxUint32) m_pos[0] | ((wxUint32) m_pos[1] << 8)
+                     | ((wxUint32) m_pos[2] << 16) | ((wxUint32) m_pos[3] << 24);
+        m_pos += 4;
+        return v;
+    }
+
+    double ReadDouble() {
+        wxUint64 lo = Read32();
+        wxUint64 hi = Read32();
+        wxUint64 u = lo | (hi << 32);
+        double d;
+        memcpy(&d, &u, sizeof(d));
+        return d;
+    }
+
+    const unsigned char *ReadData(size_t *len) {
+        *len = Read32();
+        if (!Has(*len)) {
+            *len = 0;
+            return 0;
+        }
+        const unsigned char *p = m_pos;
+        m_pos += *len;
+        return p;
+    }
+
+    wxString ReadString() {
+        size_t len;
+        const unsigned char *p = ReadData(&len);
+        return len > 0 ? wxString::FromUTF8((const char *) p, len) : wxString();
+    }
+
+    void ReadNames() {
+        size_t n = Read32();
+        if (n > (size_t) (m_end - m_pos) / 4) {
+            Has(m_end - m_pos + 1);
+            return;
+        }
+        m_names.reserve(n);
+        for (size_t i = 0; i < n && m_ok; i++)
+            m_names.push_back(ReadString());
+    }
+
+    const wxString &ReadName() {
+        size_t idx = Read32();
+        if (idx < m_names.size()) return m_names[idx];
+        m_ok = false;
+        return m_noName;
+    }
+};
+
 class wxUIButtonObject : public wxUIObject {
 public:
     wxUIButtonObject() {
@@ -923,6 +1094,7 @@ wxUIProperty::wxUIProperty(const wxUIProperty &copy)
           m_colour(copy.m_colour),
           m_string(copy.m_string),
           m_image(copy.m_image),
+          m_imageData(copy.m_imageData),
           m_strList(copy.m_strList),
           m_namedOptions(copy.m_namedOptions) {
     // Do not copy over the update interface list
@@ -1047,6 +1219,7 @@ void wxUIProperty::Set(const wxImage &img) {
     if (m_pReference) m_pReference->Set(img);
     else {
         m_image = img;
+        m_imageData = wxMemoryBuffer();
         ValueChanged();
     }
 }
@@ -1124,7 +1297,43 @@ wxArrayString wxUIProperty::GetStringList() {
 
 wxImage wxUIProperty::GetImage() {
     if (m_pReference) return m_pReference->GetImage();
-    else return m_image;
+
+    if (m_imageData.GetDataLen() > 0) {
+        // decode images from version 2 forms the first time they are used.
+        // the buffer may be shared with copies of this property, so it is
+        // released rather than modified
+        wxMemoryInputStream in(m_imageData.GetData(), m_imageData.GetDataLen());
+        m_image = wxImage();
+        wxPNGHandler().LoadFile(&m_image, in, false);
+        m_imageData = wxMemoryBuffer();
+    }
+
+    return m_image;
+}
+
+void wxUIProperty::SetImageData(const void *png, size_t len) {
+    if (m_pReference) m_pReference->SetImageData(png, len);
+    else {
+        m_image = wxImage();
+        m_imageData = wxMemoryBuffer(len);
+        m_imageData.AppendData(png, len);
+        ValueChanged();
+    }
+}
+
+wxMemoryBuffer wxUIProperty::GetImageData() {
+    if (m_pReference) return m_pReference->GetImageData();
+
+    if (m_imageData.GetDataLen() > 0 || !m_image.IsOk())
+        return m_imageData;
+
+    wxMemoryOutputStream out;
+    wxPNGHandler().SaveFile(&m_image, out, false);
+    size_t len = out.GetSize();
+    wxMemoryBuffer png(len);
+    out.CopyTo(png.GetWriteBuf(len), len);
+    png.UngetWriteBuf(len);
+    return png;
 }
 
 void wxUIProperty::Write(wxOutputStream &_o) {
@@ -1223,6 +1432,95 @@ bool wxUIProperty::Read(wxInputStream &_i) {
 }
 
 
+void wxUIProperty::WriteBuffer(wxUIFormWriter &out) {
+    int type = GetType();
+    out.Write8((wxUint8) type);
+    switch (type) {
+        case DOUBLE:
+            out.WriteDouble(GetDouble());
+            break;
+        case BOOLEAN:
+            out.Write8(GetBoolean() ? 1 : 0);
+            break;
+        case INTEGER:
+            out.Write32(GetInteger());
+            break;
+        case STRING:
+            out.WriteString(GetString());
+            break;
+        case COLOUR: {
+            wxColour c = GetColour();
+            out.Write8(c.Red());
+            out.Write8(c.Green());
+            out.Write8(c.Blue());
+            out.Write8(c.Alpha());
+        }
+            break;
+        case STRINGLIST: {
+            wxArrayString list = GetStringList();
+            out.Write32(list.Count());
+            for (size_t i = 0; i < list.Count(); i++)
+                out.WriteString(list[i]);
+        }
+            break;
+        case IMAGE: {
+            wxMemoryBuffer png = GetImageData();
+            out.WriteData(png.GetData(), png.GetDataLen());
+        }
+            break;
+    }
+}
+
+bool wxUIProperty::ReadBuffer(wxUIFormReader &in) {
+    wxUint8 type = in.Read8();
+
+    if (m_pReference)
+        m_pReference->m_type = type;
+    else
+        m_type = type;
+
+    wxUint8 r, g, b, a;
+    switch (type) {
+        case DOUBLE:
+            Set(in.ReadDouble());
+            break;
+        case BOOLEAN:
+            Set(in.Read8() != 0 ? true : false);
+            break;
+        case INTEGER:
+            Set((int) in.Read32());
+            break;
+        case STRING:
+            Set(in.ReadString());
+            break;
+        case COLOUR:
+            r = in.Read8();
+            g = in.Read8();
+            b = in.Read8();
+            a = in.Read8();
+            Set(wxColour(r, g, b, a));
+            break;
+        case STRINGLIST: {
+            wxArrayString list;
+            size_t count = in.Read32();
+            for (size_t i = 0; i < count && in.Ok(); i++)
+                list.Add(in.ReadString());
+            Set(list);
+        }
+            break;
+        case IMAGE: {
+            // keep the PNG data, it is only decoded when the image is needed
+            size_t len;
+            const unsigned char *png = in.ReadData(&len);
+            if (len > 0) SetImageData(png, len);
+            else Set(wxImage());
+        }
+            break;
+    }
+
+    return in.Ok();
+}
+
 void wxUIProperty::Write_text(wxOutputStream &_o, wxString &ui_path) {
     wxExtTextOutputStream out(_o, wxEOL_UNIX);
     wxString s = wxEmptyString;
@@ -1395,6 +1693,7 @@ wxUIObject::wxUIObject() {
     m_nativeObject = 0;
     m_visible = true;
     m_toolTip = wxEmptyString;
+    m_ownerForm = 0;
     AddProperty("Name", new wxUIProperty(wxString::Format("object %d", ++g_idCounter)));
     AddProperty("X", new wxUIProperty((int) 9));
     AddProperty("Y", new wxUIProperty((int) 9));
@@ -1412,6 +1711,7 @@ void wxUIObject::DeleteProperties() {
     for (size_t i = 0; i < m_properties.size(); i++)
         delete m_properties[i].prop;
     m_properties.clear();
+    m_propertyIndex.clear();
 }
 
 wxWindow *wxUIObject::AssignNative(wxWindow *win) {
@@ -1477,6 +1777,16 @@ wxString wxUIObject::GetName() {
     return Property("Name").GetString();
 }
 
+void wxUIObject::SetOwnerForm(wxUIFormData *form) {
+    wxUIProperty *name = FindProperty("Name");
+    if (name != 0 && m_ownerForm != 0)
+        name->RemoveUpdateInterface(m_ownerForm);
+
+    m_ownerForm = form;
+    if (name != 0 && m_ownerForm != 0)
+        name->AddUpdateInterface("Name", m_ownerForm);
+}
+
 void wxUIObject::SetTip(const wxString &str) {
     Property("Tool tip").Set(str);
 
@@ -1528,22 +1838,21 @@ wxSize wxUIObject::GetSize() {
 
 static wxUIProperty gs_nullProp;
 
-wxUIProperty &wxUIObject::Property(const wxString &name) {
-    wxString lowered = name.Lower();
-    for (size_t i = 0; i < m_properties.size(); i++)
-        if (lowered == m_properties[i].lowered)
-            return *m_properties[i].prop;
+wxUIProperty *wxUIObject::FindProperty(const wxString &name) {
+    std::unordered_map<wxString, size_t, wxStringHash, wxStringEqual>::iterator it = m_propertyIndex.find(name);
+    if (it == m_propertyIndex.end())
+        it = m_propertyIndex.find(name.Lower());
 
-    return gs_nullProp;
+    return it != m_propertyIndex.end() ? m_properties[it->second].prop : 0;
 }
 
-bool wxUIObject::HasProperty(const wxString &name) {
-    wxString lowered = name.Lower();
-    for (size_t i = 0; i < m_properties.size(); i++)
-        if (lowered == m_properties[i].lowered)
-            return true;
+wxUIProperty &wxUIObject::Property(const wxString &name) {
+    wxUIProperty *p = FindProperty(name);
+    return p != 0 ? *p : gs_nullProp;
+}
 
-    return false;
+bool wxUIObject::HasProperty(const wxString &name) {
+    return FindProperty(name) != 0;
 }
 
 int wxUIObject::GetTabOrder() {
@@ -1592,6 +1901,34 @@ bool wxUIObject::Read(wxInputStream &_i) {
     return in.Read8() == code;
 }
 
+void wxUIObject::WriteBuffer(wxUIFormWriter &out) {
+    out.Write8(m_visible ? 1 : 0);
+
+    out.Write32(m_properties.size());
+    for (size_t i = 0; i < m_properties.size(); i++) {
+        out.WriteName(m_properties[i].name);
+        m_properties[i].prop->WriteBuffer(out);
+    }
+}
+
+bool wxUIObject::ReadBuffer(wxUIFormReader &in) {
+    m_visible = in.Read8() != 0;
+
+    size_t n = in.Read32();
+    for (size_t i = 0; i < n && in.Ok(); i++) {
+        const wxString &name = in.ReadName();
+        if (wxUIProperty *p = FindProperty(name))
+            p->ReadBuffer(in);
+        else {
+            // property no longer defined for this type, skip its value
+            wxUIProperty unused;
+            unused.ReadBuffer(in);
+        }
+    }
+
+    return in.Ok();
+}
+
 void wxUIObject::Write_text(wxOutputStream &_o, wxString &ui_path) {
     wxExtTextOutputStream out(_o, wxEOL_UNIX);
     out.PutChar(g_text_delimeter);
@@ -1633,6 +1970,18 @@ void wxUIObject::AddProperty(const wxString &name, wxUIProperty *prop) {
     x.lowered = name.Lower();
     x.prop = prop;
     m_properties.push_back(x);
+
+    // names are case insensitive and the first property added with a name wins
+    if (m_propertyIndex.find(x.lowered) == m_propertyIndex.end()) {
+        m_propertyIndex[x.lowered] = m_properties.size() - 1;
+        m_propertyIndex[x.name] = m_properties.size() - 1;
+
+        // the name of an object in a form is replaced, e.g. by Copy()
+        if (m_ownerForm != 0 && x.lowered == "name") {
+            prop->AddUpdateInterface("Name", m_ownerForm);
+            m_ownerForm->OnPropertyChanged("Name", prop);
+        }
+    }
 }
 
 void wxUIObject::OnPropertyChanged(const wxString &, wxUIProperty *) {
@@ -1995,9 +2344,12 @@ wxUIFormData::wxUIFormData() {
     m_name = "untitled form";
     m_width = 500;
     m_height = 300;
+    m_nameIndexValid = false;
 }
 
 wxUIFormData::wxUIFormData(const wxUIFormData &rhs) {
+    m_formWindow = 0;
+    m_nameIndexValid = false;
     Copy(rhs);
 }
 
@@ -2013,7 +2365,7 @@ void wxUIFormData::Copy(const wxUIFormData &rhs) {
     m_width = rhs.m_width;
     m_height = rhs.m_height;
     for (size_t i = 0; i < rhs.m_objects.size(); i++)
-        m_objects.push_back(rhs.m_objects[i]->Duplicate());
+        Add(rhs.m_objects[i]->Duplicate());
 }
 
 wxUIFormData *wxUIFormData::Duplicate() const {
@@ -2025,6 +2377,11 @@ bool wxUIFormData::GetMetaData(const wxString &,
     return false;
 }
 
+void wxUIFormData::OnPropertyChanged(const wxString &id, wxUIProperty *) {
+    if (id == "Name")
+        m_nameIndexValid = false;
+}
+
 // build/destroy native interface as needed
 void wxUIFormData::Attach(wxWindow *form) {
     Detach();
@@ -2084,13 +2441,98 @@ void wxUIFormData::Write(wxOutputStream &_O) {
     out.Write8(0xd7);
 }
 
+void wxUIFormData::WriteV2(wxOutputStream &_O) {
+    wxDataOutputStream out(_O);
+
+    out.Write8(0xd7); // code
+    out.Write8(2); // version
+
+    wxUIFormWriter buf;
+    buf.WriteString(m_name);
+    buf.Write32(m_width);
+    buf.Write32(m_height);
+
+    buf.Write32(m_objects.size());
+
+    for (size_t i = 0; i < m_objects.size(); i++) {
+        buf.WriteName(m_objects[i]->GetTypeName());
+
+        // objects are sized so that unknown types can be skipped
+        size_t pos = buf.Tell();
+        buf.Write32(0);
+        m_objects[i]->WriteBuffer(buf);
+        buf.Patch32(pos, (wxUint32) (buf.Tell() - pos - 4));
+    }
+
+    buf.Flush(_O);
+
+    out.Write8(0xd7);
+}
+
+static bool ReadFormPayload(wxInputStream &is, size_t len, std::vector<unsigned char> &data) {
+    // the length comes from the file, so check it against the stream
+    // before allocating, or grow the buffer as the data arrives
+    wxFileOffset total = is.GetLength();
+    wxFileOffset pos = is.TellI();
+    if (total != wxInvalidOffset && pos != wxInvalidOffset) {
+        if ((wxFileOffset) len > total - pos)
+            return false;
+
+        data.resize(len);
+        return len == 0 || is.Read(&data[0], len).LastRead() == len;
+    }
+
+    const size_t chunk = 65536;
+    while (data.size() < len) {
+        size_t at = data.size();
+        size_t n = std::min(chunk, len - at);
+        data.resize(at + n);
+        if (is.Read(&data[at], n).LastRead() != n)
+            return false;
+    }
+    return true;
+}
+
 bool wxUIFormData::Read(wxInputStream &_I) {
     DeleteAll();
 
     wxDataInputStream in(_I);
 
     wxUint8 code = in.Read8();
-    in.Read8(); // version
+    wxUint8 ver = in.Read8();
+
+    if (ver >= 2) {
+        if (ver > 2) return false;
+
+        // read the whole payload at once and decode it from memory
+        size_t len = in.Read32();
+        std::vector<unsigned char> data;
+        if (!ReadFormPayload(_I, len, data))
+            return false;
+
+        wxUIFormReader buf(data.empty() ? 0 : &data[0], len);
+        buf.ReadNames();
+
+        m_name = buf.ReadString();
+        m_width = buf.Read32();
+        m_height = buf.Read32();
+
+        bool ok = true;
+        size_t n = buf.Read32();
+        for (size_t i = 0; i < n && buf.Ok(); i++) {
+            wxString type = buf.ReadName();
+            size_t size = buf.Read32();
+            size_t end = buf.Tell() + size;
+            if (wxUIObject *obj = Create(type))
+                ok = obj->ReadBuffer(buf) && ok;
+            else
+                ok = false;
+
+            buf.Seek(end);
+        }
+
+        return (in.Read8() == code && ok && buf.Ok());
+    }
 
     m_name = in.ReadString();
     m_width = in.Read32();
@@ -2185,6 +2627,8 @@ wxUIObject *wxUIFormData::Create(const wxString &type, const wxRect &geom, const
 void wxUIFormData::Add(wxUIObject *obj) {
     if (std::find(m_objects.begin(), m_objects.end(), obj) == m_objects.end()) {
         m_objects.push_back(obj);
+        obj->SetOwnerForm(this);
+        m_nameIndexValid = false;
         if (m_formWindow != 0)
             obj->CreateNative(m_formWindow);
     }
@@ -2195,6 +2639,7 @@ void wxUIFormData::Delete(wxUIObject *obj) {
     if (it != m_objects.end()) {
         delete (*it);
         m_objects.erase(it);
+        m_nameIndexValid = false;
     }
 }
 
@@ -2202,14 +2647,20 @@ void wxUIFormData::DeleteAll() {
     for (size_t i = 0; i < m_objects.size(); i++)
         delete m_objects[i];
     m_objects.clear();
+    m_nameIndex.clear();
+    m_nameIndexValid = false;
 }
 
 wxUIObject *wxUIFormData::Find(const wxString &name) {
-    for (size_t i = 0; i < m_objects.size(); i++)
-        if (m_objects[i]->GetName() == name)
-            return m_objects[i];
+    if (!m_nameIndexValid) {
+        m_nameIndex.clear();
+        for (size_t i = 0; i < m_objects.size(); i++)
+            m_nameIndex.insert(std::make_pair(m_objects[i]->GetName(), m_objects[i]));
+        m_nameIndexValid = true;
+    }
 
-    return 0;
+    std::unordered_map<wxString, wxUIObject *, wxStringHash, wxStringEqual>::iterator it = m_nameIndex.find(name);
+    return it != m_nameIndex.end() ? it->second : 0;
 }
 
 wxArrayString wxUIFormData::ListAll() {
@@ -2254,6 +2705,7 @@ void wxUIFormData::Raise(wxUIObject *obj) {
         m_objects[i] = m_objects[i - 1];
 
     m_objects[0] = obj;
+    m_nameIndexValid = false;
 }
 
 // form properties
@@ -60,6 +60,7 @@ public:
             args.Add(argv[i]);
 
         bool run = args.Index("-run") >= 0;
+        bool threaded = args.Index("-threaded") >= 0;
 
         wxInitAllImageHandlers();
 
@@ -73,7 +74,7 @@ public:
 
         if (args.size() > 1) {
             for (size_t i = 1; i < args.size(); i++) {
-                if (args[i] == "-run") continue;
+                if (args[i] == "-run" || args[i] == "-threaded") continue;
 
                 if (!wxFileExists(args[i])) {
                     wxMessageBox("The script does not exist:\n\n" + args[i]);
@@ -81,6 +82,7 @@ public:
                 }
 
                 wxLKScriptWindow *sw = wxLKScriptWindow::CreateNewWindow(!run);
+                sw->GetEditor()->SetThreaded(threaded);
                 if (sw->Load(args[i])) {
                     if (run) {
                         if (sw->RunScript()) // if run OK, close window
@@ -439,6 +439,44 @@ void TestContourPlot() {
 
 }
 
+void BenchContourGridData() {
+    // scattered simulation results interpolated onto a 200x200 grid,
+    // comparing the linear triangle scan with the neighbor walk
+    wxMTRand rng(1234);
+    const size_t np = 3000;
+    std::vector<double> xdata(np), ydata(np), zdata(np);
+    for (size_t i = 0; i < np; i++) {
+        xdata[i] = rng.rand(10.0);
+        ydata[i] = rng.rand(5.0);
+        zdata[i] = ::sin(xdata[i]) * ::cos(ydata[i]);
+    }
+
+    wxMatrix<double> XX, YY, Z1, Z2;
+    wxPLContourPlot::MeshGrid(0, 10, 200, 0, 5, 200, XX, YY);
+
+    wxStopWatch sw;
+    wxPLContourPlot::GridData(xdata, ydata, zdata, XX, YY, Z1, true);
+    long ms_linear = sw.Time();
+
+    sw.Start();
+    wxPLContourPlot::GridData(xdata, ydata, zdata, XX, YY, Z2);
+    long ms_walk = sw.Time();
+
+    size_t ndiff = 0;
+    for (size_t i = 0; i < Z1.Rows(); i++)
+        for (size_t j = 0; j < Z1.Cols(); j++)
+            if (Z1(i, j) != Z2(i, j) && !(wxIsNaN(Z1(i, j)) && wxIsNaN(Z2(i, j))))
+                ndiff++;
+
+    wxShowTextMessageDialog(wxString::Format("%d points, %dx%d grid\n"
+                                             "linear search: %ld ms\n"
+                                             "walk search, %d cpus: %ld ms\n"
+                                             "cells that differ: %d",
+                                             (int) np, (int) XX.Rows(), (int) XX.Cols(),
+                                             ms_linear, wxThread::GetCPUCount(), ms_walk, (int) ndiff),
+                            "wxPLContourPlot::GridData benchmark");
+}
+
 void TestWaveAnnualEnergyPlot() {
     wxFrame *frame = new wxFrame(0, wxID_ANY, wxT("Wave Annual energy"), wxDefaultPosition,
                                  wxScaleSize(600, 500));
@@ -1176,6 +1214,503 @@ void TestDView(wxWindow *parent) {
     frame->Show();
 }
 
+void BenchDVArrayDataSet() {
+    // one year of 1-minute data, compared across the wxDVArrayDataSet storage modes
+    const size_t n = 525600;
+    const int nrep = 20;
+    std::vector<double> data(n);
+    for (size_t i = 0; i < n; i++)
+        data[i] = ::sin(i * 0.001) * 10000;
+
+    const char *names[] = {"points", "y double", "y float"};
+    wxArrayString lines;
+    for (int st = wxDVArrayDataSet::STORE_POINTS; st <= wxDVArrayDataSet::STORE_Y_FLOAT; st++) {
+        wxDVArrayDataSet ds("bench", "kW", 0.5, 1.0 / 60.0, data);
+        ds.SetStorage((wxDVArrayDataSet::Storage) st);
+
+        wxStopWatch sw;
+        double sum = 0;
+        for (int rep = 0; rep < nrep; rep++)
+            for (size_t i = 0; i < ds.Length(); i++) {
+                wxRealPoint p = ds.At(i);
+                sum += p.x + p.y;
+            }
+        long ms = sw.Time();
+
+        lines.Add(wxString::Format("%s: %.1lf MB, At() %.1lf M/s (checksum %lg)", names[st],
+                                   ds.GetMemoryUsage() / 1048576.0,
+                                   ms > 0 ? nrep * n / (0.001 * ms) / 1e6 : 0.0, sum));
+    }
+
+    wxShowTextMessageDialog(wxJoin(lines, '\n'), "wxDVArrayDataSet storage benchmark");
+}
+
+#include "wex/plot/pltext.h"
+
+void BenchFreeTypeLabels() {
+    // axis tick labels as a plot redraws them, with and without the glyph cache
+    wxArrayString labels;
+    for (int i = 0; i <= 20; i++)
+        labels.Add(wxString::Format("%d", i * 250));
+    labels.Add("Energy (kWh)");
+    labels.Add("Hour of day");
+
+    const int nrep = 200;
+    wxArrayString lines;
+    for (int cache = 0; cache < 2; cache++) {
+        wxFreeTypeEnableCache(cache == 1);
+        for (int angle = 0; angle <= 90; angle += 90) {
+            wxStopWatch sw;
+            int n = 0;
+            for (int rep = 0; rep < nrep; rep++)
+                for (size_t i = 0; i < labels.size(); i++) {
+                    wxRealPoint offset;
+                    wxImage img(wxFreeTypeDraw(&offset, 0, 10, 96, labels[i], *wxBLACK, angle));
+                    if (img.IsOk()) n++;
+                }
+            long ms = sw.Time();
+            lines.Add(wxString::Format("cache %s, angle %d: %.0lf labels/s", cache ? "on" : "off", angle,
+                                       ms > 0 ? n / (0.001 * ms) : 0.0));
+        }
+    }
+    lines.Add(wxString::Format("glyph atlas: %.1lf KB", wxFreeTypeCacheMemory() / 1024.0));
+
+    wxShowTextMessageDialog(wxJoin(lines, '\n'), "FreeType label benchmark");
+}
+
+#include "wex/lkbatch.h"
+
+void BenchLKBatch() {
+    // a small sweep: each case integrates a damped oscillator for its own parameters
+    wxLKBatchRunner batch;
+    if (!batch.Compile("y = 0; v = 1; for( i=0;i<20000;i++ ) { v = v - dt*(k*y + c*v); y = y + dt*v; }\n"
+                       "peak = max( abs(y), abs(v) );")) {
+        wxShowTextMessageDialog(batch.GetCompileErrors(), "LK batch benchmark");
+        return;
+    }
+
+    for (int i = 0; i < 256; i++) {
+        lk::vardata_t inputs;
+        inputs.empty_hash();
+        inputs.hash_item("k").assign(1.0 + 0.1 * (i % 16));
+        inputs.hash_item("c").assign(0.01 * (i / 16));
+        inputs.hash_item("dt").assign(0.001);
+        batch.AddCase(inputs);
+    }
+
+    wxArrayString outputs;
+    outputs.Add("y");
+    outputs.Add("v");
+    outputs.Add("peak");
+    batch.SetOutputs(outputs);
+
+    wxArrayString lines;
+    long ms1 = 0;
+    int ncpu = wxThread::GetCPUCount();
+    for (int nt = 1; nt <= ncpu; nt = (nt * 2 > ncpu && nt < ncpu) ? ncpu : nt * 2) {
+        size_t nok = batch.Run(nt);
+        long ms = batch.GetElapsedMillis();
+        if (nt == 1) ms1 = ms;
+        lines.Add(wxString::Format("%d threads: %ld ms, %.2lfx, %d/%d cases ok", batch.GetThreadCount(), ms,
+                                   ms > 0 ? (double) ms1 / ms : 0.0, (int) nok, (int) batch.NumCases()));
+    }
+
+    wxShowTextMessageDialog(wxJoin(lines, '\n'), "LK batch benchmark");
+}
+
+void BenchColourMap() {
+    // one year of 1-minute values through a fine colour map, one at a time and in one batch
+    const size_t n = 525600;
+    const int nrep = 10;
+    std::vector<double> values(n);
+    for (size_t i = 0; i < n; i++)
+        values[i] = ::sin(i * 0.001) * 100;
+
+    wxPLFineRainbowColourMap cmap(-100, 100);
+    std::vector<wxUint32> rgba(n);
+
+    wxArrayString lines;
+    wxStopWatch sw;
+    unsigned long sum = 0;
+    for (int rep = 0; rep < nrep; rep++)
+        for (size_t i = 0; i < n; i++)
+            sum += cmap.ColourForValue(values[i]).Red();
+    long ms = sw.Time();
+    lines.Add(wxString::Format("ColourForValue: %.1lf M values/s (checksum %lu)",
+                               ms > 0 ? nrep * n / (0.001 * ms) / 1e6 : 0.0, sum));
+
+    for (int interp = 0; interp < 2; interp++) {
+        cmap.SetInterpolation(interp == 1);
+        sw.Start();
+        sum = 0;
+        for (int rep = 0; rep < nrep; rep++) {
+            cmap.ColoursForValues(&values[0], n, &rgba[0]);
+            sum += rgba[rep] >> 24;
+        }
+        ms = sw.Time();
+        lines.Add(wxString::Format("ColoursForValues%s: %.1lf M values/s (checksum %lu)",
+                                   interp ? ", interpolated" : "",
+                                   ms > 0 ? nrep * n / (0.001 * ms) / 1e6 : 0.0, sum));
+    }
+
+    wxShowTextMessageDialog(wxJoin(lines, '\n'), "Colour map benchmark");
+}
+
+#include <wx/mstream.h>
+
+void BenchUIForm() {
+    // an input page with several hundred objects, loaded from its binary form
+    wxUIObjectTypeProvider::RegisterBuiltinTypes();
+    const char *types[] = {"Label", "Numeric", "TextEntry", "Choice", "CheckBox", "Button"};
+    const int nobj = 600;
+
+    wxMemoryOutputStream out;
+    {
+        wxUIFormData form;
+        form.SetSize(1200, 3000);
+        for (int i = 0; i < nobj; i++)
+            form.Create(types[i % 6], wxRect(10 + 200 * (i % 6), 10 + 30 * (i / 6), 180, 24),
+                        wxString::Format("var_%d", i));
+        form.WriteV2(out);
+    }
+
+    wxMemoryInputStream in(out);
+    wxUIFormData form;
+    wxStopWatch sw;
+    form.Read(in);
+    long ms_load = sw.Time();
+
+    wxArrayString lines;
+    lines.Add(wxString::Format("load %d objects: %ld ms", nobj, ms_load));
+
+    const int nrep = 50;
+    sw.Start();
+    int found = 0;
+    for (int rep = 0; rep < nrep; rep++)
+        for (int i = 0; i < nobj; i++)
+            if (form.Find(wxString::Format("var_%d", i))) found++;
+    long ms = sw.Time();
+    lines.Add(wxString::Format("Find: %.0lf lookups/s (%d found)", ms > 0 ? found / (0.001 * ms) : 0.0, found));
+
+    sw.Start();
+    for (int rep = 0; rep < nrep; rep++)
+        for (int i = 0; i < nobj; i++)
+            if (wxUIObject *o = form.Find(wxString::Format("var_%d", i))) {
+                // not every type has a caption, and Property() hands out a
+                // shared dummy for names an object doesn't have
+                if (o->HasProperty("Caption"))
+                    o->Property("Caption").Set(wxString::Format("value %d", rep));
+                o->Property("Tool Tip").Set("updated");
+            }
+    ms = sw.Time();
+    lines.Add(wxString::Format("bulk property updates: %.0lf objects/s", ms > 0 ? nrep * nobj / (0.001 * ms) : 0.0));
+
+    wxFrame *frm = new wxFrame(0, wxID_ANY, "form");
+    wxBitmap bit(1200, 3000);
+    wxMemoryDC dc(bit);
+    std::vector<wxUIObject *> objs = form.GetObjects();
+    sw.Start();
+    for (int rep = 0; rep < 10; rep++)
+        for (size_t i = 0; i < objs.size(); i++)
+            objs[i]->Draw(frm, dc, objs[i]->GetGeometry());
+    ms = sw.Time();
+    dc.SelectObject(wxNullBitmap);
+    frm->Destroy();
+    lines.Add(wxString::Format("repaint: %.1lf ms per page", ms / 10.0));
+
+    wxShowTextMessageDialog(wxJoin(lines, '\n'), "UI form benchmark");
+}
+
+void BenchFormLoader() {
+    // loads every form in a directory as stored, then again after
+    // converting it to the current binary format
+    wxString dir = wxDirSelector("Choose a directory of .ui forms");
+    if (dir.IsEmpty()) return;
+
+    wxUIObjectTypeProvider::RegisterBuiltinTypes();
+
+    wxArrayString files;
+    wxDir::GetAllFiles(dir, &files, "*.ui");
+
+    std::vector<wxMemoryBuffer> stored, converted;
+    size_t stored_bytes = 0, converted_bytes = 0;
+    for (size_t i = 0; i < files.Count(); i++) {
+        wxFFileInputStream in(files[i]);
+        if (!in.IsOk()) continue;
+
+        wxMemoryOutputStream mem;
+        mem.Write(in);
+        wxMemoryBuffer buf(mem.GetSize());
+        mem.CopyTo(buf.GetWriteBuf(mem.GetSize()), mem.GetSize());
+        buf.UngetWriteBuf(mem.GetSize());
+
+        wxMemoryInputStream min(buf.GetData(), buf.GetDataLen());
+        wxUIFormData form;
+        if (!form.Read(min)) continue;
+
+        wxMemoryOutputStream out;
+        form.WriteV2(out);
+        wxMemoryBuffer conv(out.GetSize());
+        out.CopyTo(conv.GetWriteBuf(out.GetSize()), out.GetSize());
+        conv.UngetWriteBuf(out.GetSize());
+
+        stored.push_back(buf);
+        converted.push_back(conv);
+        stored_bytes += buf.GetDataLen();
+        converted_bytes += conv.GetDataLen();
+    }
+
+    wxArrayString lines;
+    lines.Add(wxString::Format("%d forms loaded, %d skipped (unknown object types or unreadable)",
+                               (int) stored.size(), (int) (files.Count() - stored.size())));
+
+    const int nrep = 5;
+    for (int pass = 0; pass < 2; pass++) {
+        std::vector<wxMemoryBuffer> &forms = pass == 0 ? stored : converted;
+        wxStopWatch sw;
+        size_t nobj = 0;
+        for (int rep = 0; rep < nrep; rep++) {
+            for (size_t i = 0; i < forms.size(); i++) {
+                wxMemoryInputStream in(forms[i].GetData(), forms[i].GetDataLen());
+                wxUIFormData form;
+                form.Read(in);
+                nobj += form.GetObjects().size();
+            }
+        }
+        long ms = sw.Time();
+        lines.Add(wxString::Format("%s: %.1lf ms per load of all forms, %d objects, %.1lf kB",
+                                   pass == 0 ? "as stored" : "version 2", ms / (double) nrep,
+                                   (int) (nobj / nrep),
+                                   (pass == 0 ? stored_bytes : converted_bytes) / 1024.0));
+    }
+
+    // the image decoding deferred by the version 2 loads above
+    wxStopWatch sw;
+    int nimg = 0;
+    for (size_t i = 0; i < converted.size(); i++) {
+        wxMemoryInputStream in(converted[i].GetData(), converted[i].GetDataLen());
+        wxUIFormData form;
+        form.Read(in);
+        std::vector<wxUIObject *> objs = form.GetObjects();
+        for (size_t j = 0; j < objs.size(); j++) {
+            wxArrayString props = objs[j]->Properties();
+            for (size_t k = 0; k < props.Count(); k++) {
+                wxUIProperty &p = objs[j]->Property(props[k]);
+                if (p.GetType() == wxUIProperty::IMAGE && p.GetImage().IsOk())
+                    nimg++;
+            }
+        }
+    }
+    lines.Add(wxString::Format("version 2 with all %d images decoded: %ld ms", nimg, sw.Time()));
+
+    wxShowTextMessageDialog(wxJoin(lines, '\n'), "Form loader benchmark");
+}
+
+#include <wx/socket.h>
+#include <wx/ffile.h>
+#include "wex/easycurl.h"
+
+// Stand-in HTTP server on the loopback interface for TestEasyCurlBatch.
+//   /data/N   200 with N kB of SandboxHttpBody(N)
+//   /slow     200 that trickles a few bytes at a time for up to a minute
+//   otherwise 404
+static wxString SandboxHttpBody(int n) {
+    wxString body;
+    for (int i = 0; i < n * 1024; i++)
+        body += (wxChar) ('a' + (i * 7 + n) % 26);
+    return body;
+}
+
+class SandboxHttpConnection : public wxThread {
+    wxSocketBase *m_sock;
+public:
+    SandboxHttpConnection(wxSocketBase *sock) : wxThread(wxTHREAD_DETACHED), m_sock(sock) {}
+
+    void Send(const wxString &text) {
+        wxScopedCharBuffer buf = text.utf8_str();
+        m_sock->Write(buf.data(), buf.length());
+    }
+
+    virtual void *Entry() {
+        std::string request;
+        char buf[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 65536) {
+            m_sock->Read(buf, sizeof(buf));
+            if (m_sock->Error() || m_sock->LastCount() == 0) break;
+            request.append(buf, m_sock->LastCount());
+        }
+
+        wxString path = wxString(request).BeforeFirst('\n').AfterFirst(' ').BeforeFirst(' ');
+        long n = 0;
+        if (path.StartsWith("/data/") && path.Mid(6).ToLong(&n) && n > 0) {
+            wxString body = SandboxHttpBody(n);
+            Send(wxString::Format("HTTP/1.1 200 OK\r\nContent-Length: %d\r\nConnection: close\r\n\r\n",
+                                  (int) body.Len()) + body);
+        } else if (path == "/slow") {
+            Send("HTTP/1.1 200 OK\r\nContent-Length: 1000000\r\nConnection: close\r\n\r\n");
+            for (int i = 0; i < 600 && !m_sock->Error(); i++) {
+                Send("0123456789");
+                wxMilliSleep(100);
+            }
+        } else
+            Send("HTTP/1.1 404 Not Found\r\nContent-Length: 9\r\nConnection: close\r\n\r\nnot found");
+
+        m_sock->Close();
+        delete m_sock;
+        return 0;
+    }
+};
+
+class SandboxHttpServer : public wxThread {
+    wxSocketServer *m_server;
+    bool m_stop;
+    wxMutex m_stopLock;
+public:
+    SandboxHttpServer() : wxThread(wxTHREAD_JOINABLE), m_stop(false) {
+        wxIPV4address addr;
+        addr.LocalHost();
+        addr.Service(0);
+        m_server = new wxSocketServer(addr, wxSOCKET_BLOCK | wxSOCKET_REUSEADDR);
+    }
+
+    virtual ~SandboxHttpServer() { delete m_server; }
+
+    bool IsOk() { return m_server->IsOk(); }
+
+    unsigned short GetPort() {
+        wxIPV4address addr;
+        m_server->GetLocal(addr);
+        return addr.Service();
+    }
+
+    void Stop() {
+        wxMutexLocker _lock(m_stopLock);
+        m_stop = true;
+    }
+
+    bool IsStopped() {
+        wxMutexLocker _lock(m_stopLock);
+        return m_stop;
+    }
+
+    virtual void *Entry() {
+        while (!IsStopped()) {
+            if (m_server->WaitForAccept(0, 100)) {
+                if (wxSocketBase *sock = m_server->Accept(false)) {
+                    sock->SetFlags(wxSOCKET_BLOCK);
+                    SandboxHttpConnection *conn = new SandboxHttpConnection(sock);
+                    if (conn->Run() != wxTHREAD_NO_ERROR) {
+                        delete conn;
+                        delete sock;
+                    }
+                }
+            }
+        }
+        return 0;
+    }
+};
+
+void TestEasyCurlBatch() {
+    // downloads, failures and cancellation against a local server
+    wxSocketBase::Initialize();
+
+    SandboxHttpServer *server = new SandboxHttpServer;
+    if (!server->IsOk() || server->Run() != wxTHREAD_NO_ERROR) {
+        wxMessageBox("Could not start the local HTTP server.");
+        delete server;
+        return;
+    }
+
+    wxString base = wxString::Format("http://127.0.0.1:%d", (int) server->GetPort());
+
+    // a port that was just released has nothing listening on it
+    int closedPort = 0;
+    {
+        wxIPV4address addr;
+        addr.LocalHost();
+        addr.Service(0);
+        wxSocketServer tmp(addr, wxSOCKET_BLOCK);
+        tmp.GetLocal(addr);
+        closedPort = addr.Service();
+    }
+
+    wxString tmpdir = wxFileName::GetTempDir() + "/wexsandbox_curlbatch";
+    wxFileName::Mkdir(tmpdir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+
+    wxArrayString lines;
+    int nfail = 0;
+#define CHECK(cond, msg) do { bool _ok = (cond); if (!_ok) nfail++; lines.Add(wxString(_ok ? "pass: " : "FAIL: ") + (msg)); } while(0)
+
+    wxEasyCurlBatch batch;
+    batch.SetMaxConnections(4);
+    std::vector<size_t> mem, files;
+    for (int i = 1; i <= 12; i++)
+        mem.push_back(batch.Add(base + wxString::Format("/data/%d", i)));
+    for (int i = 1; i <= 4; i++)
+        files.push_back(batch.Add(base + wxString::Format("/data/%d", 20 + i),
+                                  tmpdir + wxString::Format("/file%d.txt", i)));
+    size_t notfound = batch.Add(base + "/nothing/here");
+    size_t refused = batch.Add(wxString::Format("http://127.0.0.1:%d/data/1", closedPort));
+    size_t badfile = batch.Add(base + "/data/1", tmpdir + "/no/such/dir/file.txt");
+
+    wxStopWatch sw;
+    batch.Start();
+    bool allok = batch.Wait(true);
+    lines.Add(wxString::Format("%d transfers in %d ms", (int) batch.Count(), (int) sw.Time()));
+
+    CHECK(!allok, "Wait() reports the failed transfers");
+    for (size_t i = 0; i < mem.size(); i++)
+        CHECK(batch.Ok(mem[i]) && batch.GetDataAsString(mem[i]) == SandboxHttpBody(i + 1),
+              wxString::Format("memory download %d", (int) i + 1));
+    for (size_t i = 0; i < files.size(); i++) {
+        wxString text;
+        wxFFile ff(tmpdir + wxString::Format("/file%d.txt", (int) i + 1));
+        CHECK(batch.Ok(files[i]) && ff.IsOpened() && ff.ReadAll(&text) && text == SandboxHttpBody(21 + i),
+              wxString::Format("file download %d", (int) i + 1));
+    }
+    CHECK(batch.Ok(notfound) && batch.GetDataAsString(notfound) == "not found",
+          "404 delivers the response body like wxEasyCurl");
+    CHECK(!batch.Ok(refused) && !batch.GetLastError(refused).IsEmpty(),
+          "refused connection fails: " + batch.GetLastError(refused));
+    CHECK(!batch.Ok(badfile) && !wxFileExists(tmpdir + "/no/such/dir/file.txt"),
+          "unwritable file fails: " + batch.GetLastError(badfile));
+
+    // cancel transfers that would otherwise run for a minute
+    wxEasyCurlBatch slow;
+    for (int i = 0; i < 4; i++)
+        slow.Add(base + "/slow", i % 2 ? tmpdir + wxString::Format("/slow%d.txt", i) : wxString());
+    slow.Start();
+    wxMilliSleep(500);
+    sw.Start();
+    slow.Cancel();
+    bool slowok = slow.Wait(true);
+    long cancel_ms = sw.Time();
+    CHECK(!slowok && cancel_ms < 5000, wxString::Format("cancel stops the batch in %d ms", (int) cancel_ms));
+    for (int i = 0; i < 4; i++)
+        CHECK(slow.IsFinished(i) && !slow.Ok(i)
+              && (i % 2 == 0 || !wxFileExists(tmpdir + wxString::Format("/slow%d.txt", i))),
+              wxString::Format("canceled transfer %d is failed and leaves no file", i));
+
+    // a finished batch can be reused
+    size_t again = batch.Add(base + "/data/3");
+    batch.Start();
+    CHECK(batch.Wait(true) && batch.Count() == 1 && batch.GetDataAsString(again) == SandboxHttpBody(3),
+          "finished batch is cleared and reused");
+
+#undef CHECK
+
+    server->Stop();
+    server->Wait();
+    delete server;
+
+    for (int i = 1; i <= 4; i++)
+        wxRemoveFile(tmpdir + wxString::Format("/file%d.txt", i));
+    wxFileName::Rmdir(tmpdir);
+
+    lines.Insert(nfail == 0 ? "all checks passed" : wxString::Format("%d checks FAILED", nfail), 0);
+    wxShowTextMessageDialog(wxJoin(lines, '\n'), "wxEasyCurlBatch test");
+}
+
 #include <wex/numeric.h>
 #include <wex/exttext.h>
 
@@ -1365,6 +1900,14 @@ public:
         TestWaveAnnualEnergyPlot();
 
 //		TestPLPlot(0);
+//		BenchDVArrayDataSet();
+//		BenchLKBatch();
+//		BenchColourMap();
+//		BenchUIForm();
+//		BenchFormLoader();
+//		TestEasyCurlBatch();
+//		BenchFreeTypeLabels();
+//		BenchContourGridData();
 //		TestPLPolarPlot(0);
 //		TestPLBarPlot(0);
 //		TestStackedBarPlot(0);